@@ -12,6 +12,23 @@ enum class PinMode : uint8_t { Input, InputPullup, Output };
  */
 enum class PinState : uint8_t { Low = 0, High = 1 };
 
+/**
+ * @brief Enumeration for GPIO interrupt trigger edges.
+ */
+enum class PinEdge : uint8_t { Rising, Falling, Change };
+
+/**
+ * @brief Handler invoked from interrupt context when an armed edge occurs.
+ */
+using PinInterruptHandler = void (*)(void *arg);
+
+/**
+ * @brief Get the bit selecting a pin in a bulk pin mask.
+ * @param pin The GPIO pin number.
+ * @return Bitmask with only the bit for the given pin set.
+ */
+constexpr uint64_t pinToMask(uint8_t pin) { return uint64_t{1} << pin; }
+
 /**
  * @brief Interface for GPIO operations.
  *
@@ -41,6 +58,37 @@ public:
    */
   virtual PinState digitalRead(uint8_t pin) = 0;
 
+  /**
+   * @brief Read the levels of several GPIO pins in one operation.
+   * @param pinMask Bitmask of the pins to sample, bit n selects GPIO n.
+   * @return Bitmask of the sampled pins that read High. Bits outside of
+   * pinMask are always 0.
+   */
+  virtual uint64_t readPins(uint64_t pinMask) = 0;
+
+  /**
+   * @brief Write the same digital value to several GPIO pins in one operation.
+   * @param pinMask Bitmask of the pins to drive, bit n selects GPIO n.
+   * @param value The value to write to all selected pins (High or Low).
+   */
+  virtual void writePins(uint64_t pinMask, PinState value) = 0;
+
+  /**
+   * @brief Arm an edge interrupt on a GPIO pin.
+   * @param pin The GPIO pin number.
+   * @param edge The edge that triggers the interrupt.
+   * @param handler Handler to invoke, runs in interrupt context.
+   * @param arg Argument passed to the handler.
+   */
+  virtual void attachPinInterrupt(uint8_t pin, PinEdge edge,
+                                  PinInterruptHandler handler, void *arg) = 0;
+
+  /**
+   * @brief Disarm the edge interrupt of a GPIO pin.
+   * @param pin The GPIO pin number.
+   */
+  virtual void detachPinInterrupt(uint8_t pin) = 0;
+
   // Virtual destructor
   virtual ~IGpio() = default;
 };
@@ -0,0 +1,79 @@
+#ifndef IKEYSCANNER_H
+#define IKEYSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <interfaces/IGpio.h>
+#include <submodules/Config/KeyScannerConfig.h>
+
+/**
+ * @brief Interface for key scanner engines.
+ *
+ * Every engine reads its keys in its own way (matrix, direct pins, shift
+ * registers, ...) but reports them the same way: a packed bitmap with one bit
+ * per key index, little endian, and the changes of each scan as a batch.
+ */
+class IKeyScanner
+{
+public:
+  /// @brief A single key transition detected by a scan.
+  struct KeyChange
+  {
+    uint16_t keyIndex;
+    bool pressed;
+  };
+
+  /// @brief Callback receiving all key transitions of one scan at once.
+  using KeyChangeBatchCallback = std::function<void(
+      const KeyChange *changes, size_t count, uint32_t scanSequence)>;
+
+  /// @brief Callback receiving a single key transition.
+  using KeyChangeCallback = std::function<void(uint16_t keyIndex, bool pressed)>;
+
+  virtual ~IKeyScanner() = default;
+
+  virtual void registerOnKeyChangeCallback(const KeyChangeCallback &callback) = 0;
+  virtual void clearOnKeyChangeCallback() = 0;
+  virtual void registerOnKeyChangeBatchCallback(const KeyChangeBatchCallback &callback) = 0;
+  virtual void clearOnKeyChangeBatchCallback() = 0;
+  virtual uint32_t getScanSequence() const = 0;
+  virtual void setDebounce(KeyScannerConfig::DebounceMode mode, uint8_t windowScans) = 0;
+  virtual uint32_t copyPublishedBitmap(uint8_t *dest, size_t destSize) const = 0;
+  virtual uint32_t getPublishedVersion() const = 0;
+  virtual const size_t getBitMapSize() const = 0;
+  virtual bool hasPressedKeys() const = 0;
+
+  /**
+   * @brief Prepares the keys to wake the caller on the next key press.
+   * @param wakeHandler Handler invoked from interrupt context on a press.
+   * @param arg Argument passed to the handler.
+   * @return True if idle was entered. False if a key is currently pressed or
+   * the engine cannot detect presses without scanning.
+   */
+  virtual bool enterIdle(PinInterruptHandler wakeHandler, void *arg) = 0;
+  virtual void exitIdle() = 0;
+  virtual bool isIdle() const = 0;
+
+  /**
+   * @brief Scans all keys and updates key states.
+   * @return Number of keys that changed state in this scan.
+   */
+  virtual size_t updateKeyState() = 0;
+
+  /**
+   * @brief Rescans only the drive lines that have held keys, all other keys
+   * keep their state. Engines that read all keys at once do a full scan.
+   * @return Number of keys that changed state in this scan.
+   */
+  virtual size_t updateHeldKeyState() = 0;
+
+  /**
+   * @brief Checks whether the last scan sampled any key different from its
+   * debounced state, including bounces the debouncer held back.
+   * @return True if keys were changing during the last scan.
+   */
+  virtual bool sawKeyActivity() const = 0;
+};
+
+#endif
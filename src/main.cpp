@@ -6,6 +6,7 @@
 #include <submodules/Storage/PreferencesStorage.h>
 #include <system/TaskManager.h>
 #include <submodules/ArduinoLogSink.h>
+#include <submodules/EventChannel.h>
 #include <submodules/Logger.h>
 
 // temp local definitions for testing
@@ -23,9 +24,9 @@ static PreferencesStorage prefStorage("Esp32HidStorage");
 TaskManager::Platform platform = {espGpio, espNow, prefStorage};
 static TaskManager *taskManager;
 
-static void keyPrintCallback(const Event &event);
-static void bitMapPrintCallback(const Event &event);
-static void hidPrintCallback(const Event &event);
+static void keyPrintCallback(const RawKeyEvent &keyEvent);
+static void bitMapPrintCallback(const RawBitmapEvent &bitMapEvent);
+static void hidPrintCallback(const HidBitmapEvent &hidEvent);
 
 static void setKeyboardConfig();
 static void setHostConfig();
@@ -59,9 +60,9 @@ void setup()
   WiFi.mode(WIFI_STA);
   WiFi.disconnect();
 
-  EventRegistry::registerHandler(EventType::RawKey, keyPrintCallback);
-  EventRegistry::registerHandler(EventType::RawBitmap, bitMapPrintCallback);
-  EventRegistry::registerHandler(EventType::HidBitmap, hidPrintCallback);
+  RawKeyChannel::subscribe<keyPrintCallback>();
+  RawBitmapChannel::subscribe<bitMapPrintCallback>();
+  HidBitmapChannel::subscribe<hidPrintCallback>();
 
   if (taskManager != nullptr)
   {
@@ -77,18 +78,9 @@ void setup()
 
 void loop() {}
 
-static void keyPrintCallback(const Event &event)
+static void keyPrintCallback(const RawKeyEvent &keyEvent)
 {
-  if (event.type != EventType::RawKey)
-  {
-    logger.warn("Received wrong event type");
-    return;
-  }
-
-  RawKeyEvent keyEvent;
-  keyEvent = event.rawKeyEvt;
-
-  uint8_t keyIndex = keyEvent.keyIndex;
+  uint16_t keyIndex = keyEvent.keyIndex;
   bool state = keyEvent.state;
 
   ConfigManager *configPointer = taskManager->getConfigManagerPointer();
@@ -106,35 +98,29 @@ static void keyPrintCallback(const Event &event)
   }
 }
 
-static void bitMapPrintCallback(const Event &event)
+static void bitMapPrintCallback(const RawBitmapEvent &bitMapEvent)
 {
   static std::vector<uint8_t> lastBitmap = {0};
 
-  RawBitmapEvent bitMapEvent;
-  bitMapEvent = event.rawBitmapEvt;
-
-  if (memcmp(lastBitmap.data(), bitMapEvent.bitMapData, bitMapEvent.bitmapSize) != 0)
+  if (memcmp(lastBitmap.data(), bitMapEvent.data(), bitMapEvent.bitmapSize) != 0)
   {
     std::string debugStr = "Bitmap change: Size " + std::to_string(bitMapEvent.bitmapSize) + " Data:";
     for (size_t i = 0; i < bitMapEvent.bitmapSize; i++)
     {
-      debugStr += " " + std::to_string(bitMapEvent.bitMapData[i]);
+      debugStr += " " + std::to_string(bitMapEvent.data()[i]);
     }
     logger.info("%s", debugStr.c_str());
 
-    lastBitmap.assign(bitMapEvent.bitMapData, bitMapEvent.bitMapData + bitMapEvent.bitmapSize);
+    lastBitmap.assign(bitMapEvent.data(), bitMapEvent.data() + bitMapEvent.bitmapSize);
   }
 }
 
-static void hidPrintCallback(const Event &event)
+static void hidPrintCallback(const HidBitmapEvent &hidEvent)
 {
-  HidBitmapEvent hidEvent;
-  hidEvent = event.hidBitmapEvt;
-
   std::string debugStr = "HID Bitmap: Size " + std::to_string(hidEvent.bitmapSize) + " Data:";
   for (size_t i = 0; i < hidEvent.bitmapSize; i++)
   {
-    debugStr += " " + std::to_string(hidEvent.bitMapData[i]);
+    debugStr += " " + std::to_string(hidEvent.data()[i]);
   }
   logger.info("%s", debugStr.c_str());
 }
@@ -1,12 +1,19 @@
 #include <modules/EventBusTask.h>
+#include <esp_timer.h>
+#include <submodules/EventChannel.h>
 #include <submodules/Logger.h>
+#include <submodules/PayloadPool.h>
+#include <system/SystemConfig.h>
 
 static Logger log(EventBusTask::NAMESPACE);
 
 // Initialize static member variable
 EventBusTask *EventBusTask::instance = nullptr;
+const EventRegistry::HandlerTimer EventBusTask::handlerTimer{EventBusTask::nowUs, EventBusTask::recordHandler};
 
-EventBusTask::EventBusTask()
+static_assert(EventRegistry::HANDLER_SLOTS == EVENT_BUS_HANDLER_SLOTS, "One stats slot per handler");
+
+EventBusTask::EventBusTask() : workerCount(EVENTBUS_WORKERS)
 {
   if (instance != nullptr)
   {
@@ -27,18 +34,109 @@ EventBusTask::~EventBusTask()
 void EventBusTask::taskEntry(void *param)
 {
   EventBusTask *instance = static_cast<EventBusTask *>(param);
-  Event event;
 
   while (true)
   {
-    if (xQueueReceive(instance->localQueue, &event, portMAX_DELAY))
+    // One notification may stand for several pushes, drain them in batches
+    // of one type each. The bus owns the events, handlers only borrow them.
+    // Wakes up without one too, to close the stats window in time.
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STATS_INTERVAL_US / 1000));
+    if (instance->stopping.load())
+      break;
+    size_t drained = instance->lanes.drain(instance->batch, MAX_BATCH_SIZE, MAX_DRAIN_EVENTS,
+                                           [instance](Event *events, size_t count)
+                                           {
+                                             log.debug("Processing %u events of type %d", count,
+                                                       static_cast<uint8_t>(events[0].type));
+                                             uint32_t dispatchUs = nowUs();
+                                             for (size_t i = 0; i < count; i++)
+                                               instance->stats.recordDispatch(events[i].type,
+                                                                              dispatchUs - events[i].enqueuedUs);
+                                             EventRegistry::deliverBatch(events, count);
+                                           });
+
+    if (nowUs() - instance->statsWindowStartUs.load() >= STATS_INTERVAL_US)
+      instance->publishStats();
+
+    // Events may be left, come back for them after the other tasks ran
+    if (drained == MAX_DRAIN_EVENTS)
+    {
+      xTaskNotifyGive(instance->eventBusHandle);
+      taskYIELD();
+    }
+  }
+
+  // Every batch taken from the lanes was released, stop() clears the rest
+  instance->busRunning.store(false);
+  vTaskDelete(nullptr);
+}
+
+// Worker loop, runs offloaded handlers until none has work left
+void EventBusTask::workerEntry(void *param)
+{
+  Worker *worker = static_cast<Worker *>(param);
+  EventBusTask *owner = worker->owner;
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (owner->stoppingWorkers.load())
+      break;
+    owner->pool.work(worker->index);
+  }
+
+  // work() released every batch it took, stopWorkers() clears the rest
+  owner->workersRunning.fetch_sub(1);
+  vTaskDelete(nullptr);
+}
+
+void EventBusTask::wakeWorker(void *arg)
+{
+  xTaskNotifyGive(static_cast<Worker *>(arg)->handle);
+}
+
+bool EventBusTask::startWorkers()
+{
+  static constexpr size_t CORE_COUNT = sizeof(CORE_EVENTBUS_WORKERS) / sizeof(CORE_EVENTBUS_WORKERS[0]);
+
+  stoppingWorkers.store(false);
+  for (size_t i = 0; i < workerCount; i++)
+  {
+    Worker &worker = workers[i];
+    BaseType_t core = CORE_EVENTBUS_WORKERS[i % CORE_COUNT];
+    worker = {this, i, nullptr};
+    if (pool.addWorker(static_cast<uint8_t>(core), wakeWorker, &worker) < 0)
+      return false;
+    workersRunning.fetch_add(1);
+    BaseType_t result = xTaskCreatePinnedToCore(
+        EventBusTask::workerEntry, "EventBusWorker", STACK_EVENTBUS_WORKER, &worker,
+        PRIORITY_EVENTBUS_WORKER, &worker.handle, core);
+    if (result != pdPASS)
     {
-      log.debug("Processing event of type %d", static_cast<uint8_t>(event.type));
-      const auto handlers = EventRegistry::getHandler(event.type);
-      for (auto callback : handlers)
-        callback(event);
+      workersRunning.fetch_sub(1);
+      worker.handle = nullptr;
+      return false;
     }
   }
+  return true;
+}
+
+void EventBusTask::stopWorkers()
+{
+  // A worker inside work() finishes and releases the batch in hand first
+  stoppingWorkers.store(true);
+  for (size_t i = 0; i < workerCount; i++)
+  {
+    if (workers[i].handle != nullptr)
+      xTaskNotifyGive(workers[i].handle);
+  }
+  while (workersRunning.load() != 0)
+    vTaskDelay(1);
+  for (size_t i = 0; i < workerCount; i++)
+    workers[i].handle = nullptr;
+
+  // Batches nobody will run anymore
+  pool.clear();
 }
 
 // Event pushing helper functions
@@ -52,27 +150,121 @@ bool EventBusTask::staticPushCallback(const Event &event)
   return false;
 }
 
+bool EventBusTask::staticOffloadCallback(EventType type, EventRegistry::BatchCallback handler, uint32_t coreMask,
+                                         const Event *events, size_t count)
+{
+  // Called from the bus task, which owns the pool's producer side
+  if (instance == nullptr)
+    return false;
+  return instance->pool.submit(type, handler, coreMask, events, count);
+}
+
 bool EventBusTask::pushToQueue(const Event &event)
 {
-  if (localQueue != nullptr)
+  size_t core = xPortGetCoreID();
+  TaskHandle_t handle = eventBusHandle;
+  Event stamped = event;
+  stamped.enqueuedUs = nowUs();
+  EventLanes::PushResult result;
+  if (handle == nullptr || !lanes.push(stamped, &result))
   {
-    return xQueueSend(localQueue, &event, 0) == pdTRUE;
+    stats.recordDrop(event.type, core);
+    return false;
   }
-  return false;
+  if (result.evicted)
+    stats.recordDrop(event.type, core);
+  stats.recordPush(event.type, core, result.pending);
+  xTaskNotifyGive(handle);
+  return true;
 }
 
-// Task lifecycle methods
+// Stats helper functions
 
-void EventBusTask::start(TaskParameters params)
+uint32_t EventBusTask::nowUs()
 {
-  log.setMode(Logger::LogMode::Global);
+  return static_cast<uint32_t>(esp_timer_get_time());
+}
+
+void EventBusTask::recordHandler(EventType type, size_t slot, uint32_t elapsedUs)
+{
+  if (instance != nullptr)
+    instance->stats.recordHandler(type, slot, elapsedUs);
+}
+
+void EventBusTask::publishStats()
+{
+  uint32_t now = nowUs();
+  uint32_t windowUs = now - statsWindowStartUs.load();
+  statsWindowStartUs.store(now);
+  EventBusSnapshot *snapshot = static_cast<EventBusSnapshot *>(
+      PayloadPool::forType(EventType::BusStats).allocate(sizeof(EventBusSnapshot)));
+  if (snapshot == nullptr)
+  {
+    // The window is lost, the next one still starts on time
+    log.error("Failed to allocate bus stats event");
+    stats.reset();
+    return;
+  }
+  stats.collect(windowUs, *snapshot);
 
-  localQueue = xQueueCreate(32, sizeof(Event));
-  if (!localQueue)
+  for (size_t t = 0; t < EVENT_TYPE_COUNT; t++)
+  {
+    const EventBusTypeStats &type = snapshot->types[t];
+    if (type.pushed == 0 && type.dropped == 0)
+      continue;
+    float avgLatencyUs = type.dispatched ? static_cast<float>(type.totalLatencyUs) / type.dispatched : 0.0f;
+    log.debug("Bus type %u pushed %u dropped %u high water %u, latency avg %.1f us p99 <%u us max %u us, "
+              "handler p99 <%u us",
+              t, type.pushed, type.dropped, type.highWater, avgLatencyUs,
+              ScanTimingStats::percentileUs(type.latencyBuckets, 99), type.maxLatencyUs,
+              ScanTimingStats::percentileUs(type.handlerBuckets, 99));
+  }
+
+  // Pushed like any other event, it shows up in the next window
+  if (!BusStatsChannel::publish({snapshot}))
+    log.error("Failed to push bus stats event to EventRegistry");
+}
+
+void EventBusTask::setLaneConfig(EventType type, const EventLanes::LaneConfig &config)
+{
+  if (eventBusHandle != nullptr)
+  {
+    log.warn("Lane config of type %d ignored while EventBusTask is running", static_cast<uint8_t>(type));
+    return;
+  }
+  lanes.configure(type, config);
+}
+
+EventLanes::LaneStats EventBusTask::getLaneStats(EventType type) const
+{
+  return lanes.getStats(type);
+}
+
+void EventBusTask::setWorkerCount(size_t count)
+{
+  if (eventBusHandle != nullptr)
   {
-    log.error("Failed to create EventBusTask queue");
+    log.warn("Worker count ignored while EventBusTask is running");
     return;
   }
+  workerCount = count < WorkStealingPool::MAX_WORKERS ? count : WorkStealingPool::MAX_WORKERS;
+}
+
+WorkStealingPool::Stats EventBusTask::getOffloadStats() const
+{
+  return pool.getStats();
+}
+
+void EventBusTask::getBusStats(EventBusSnapshot &out) const
+{
+  stats.snapshot(nowUs() - statsWindowStartUs.load(), out);
+}
+
+// Task lifecycle methods
+
+void EventBusTask::start(TaskParameters params)
+{
+  log.setMode(Logger::LogMode::Global);
 
   log.info("Starting EventBusTask with stack size %u, priority %d, core affinity %d",
            params.stackSize, params.priority, params.coreAffinity);
@@ -81,16 +273,31 @@ void EventBusTask::start(TaskParameters params)
     log.warn("EventBusTask already running");
     return;
   }
+  stats.reset();
+  statsWindowStartUs.store(nowUs());
+  stopping.store(false);
+  busRunning.store(true);
   BaseType_t result = xTaskCreatePinnedToCore(
       EventBusTask::taskEntry, EventBusTask::NAMESPACE, params.stackSize, this,
       params.priority, &eventBusHandle, params.coreAffinity);
 
   if (result != pdPASS)
   {
+    busRunning.store(false);
     eventBusHandle = nullptr;
     log.error("Failed to create EventBusTask");
     return;
   }
+
+  // Without workers the bus task runs offloaded handlers itself
+  if (startWorkers())
+    EventRegistry::registerOffloadCallback(staticOffloadCallback);
+  else
+  {
+    log.error("Failed to create EventBusTask workers, offloaded handlers run on the bus");
+    stopWorkers();
+  }
+  EventRegistry::registerHandlerTimer(&handlerTimer);
   EventRegistry::registerPushCallback(staticPushCallback);
 }
 
@@ -102,15 +309,21 @@ void EventBusTask::stop()
     log.info("Stop called but EventBusTask is not running");
     return;
   }
-  vTaskDelete(eventBusHandle);
+  EventRegistry::clearPushCallback();
+  EventRegistry::registerOffloadCallback(nullptr);
+  EventRegistry::registerHandlerTimer(nullptr);
+
+  // The bus task finishes the batch it dispatches, which may still offload
+  // to the workers, so they stop after it
+  stopping.store(true);
+  xTaskNotifyGive(eventBusHandle);
+  while (busRunning.load())
+    vTaskDelay(1);
   eventBusHandle = nullptr;
+  stopWorkers();
 
-  if (localQueue)
-  {
-    vQueueDelete(localQueue);
-    localQueue = nullptr;
-  }
-  EventRegistry::clearPushCallback();
+  // Events nobody will dispatch anymore
+  lanes.clear();
 }
 
 void EventBusTask::restart(TaskParameters params)
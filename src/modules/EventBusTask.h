@@ -1,15 +1,25 @@
 #ifndef EVENTBUSTASK_H
 #define EVENTBUSTASK_H
 
+#include <atomic>
 #include <interfaces/ITask.h>
+#include <submodules/EventBusStats.h>
+#include <submodules/EventLanes.h>
 #include <submodules/EventRegistry.h>
-#include <queue.h>
+#include <submodules/WorkStealingPool.h>
 
 class EventBusTask : public ITask
 {
 public:
   static constexpr const char *NAMESPACE = "EventBusTask";
 
+  // Most events handed to the handlers in one batch
+  static constexpr size_t MAX_BATCH_SIZE = 32;
+  // Most events dispatched per wakeup before yielding to other tasks
+  static constexpr size_t MAX_DRAIN_EVENTS = 64;
+  // Window of the bus counters, published as a BusStats event once it closes
+  static constexpr uint64_t STATS_INTERVAL_US = 5000000;
+
   EventBusTask();
   ~EventBusTask();
 
@@ -17,15 +27,88 @@ public:
   void stop() override;
   void restart(TaskParameters params) override;
 
+  /**
+   * @brief Configure the lane of an event type, see EventLanes. Only while
+   * the task is stopped.
+   * @param type The event type.
+   * @param config Priority, depth, coalescing and drop policy of the lane.
+   */
+  void setLaneConfig(EventType type, const EventLanes::LaneConfig &config);
+
+  /**
+   * @brief Gets the depth, drop and coalesce counters of a lane.
+   * @param type The event type.
+   * @return Snapshot of the counters.
+   */
+  EventLanes::LaneStats getLaneStats(EventType type) const;
+
+  /**
+   * @brief Set the number of workers running offloaded handlers, see
+   * EventRegistry::registerOffloadHandler. Only while the task is stopped.
+   * @param count Number of workers, at most WorkStealingPool::MAX_WORKERS.
+   * With none, offloaded handlers run on the bus task.
+   */
+  void setWorkerCount(size_t count);
+
+  /**
+   * @brief Gets the counters of the offloaded handlers.
+   * @return Snapshot of the counters.
+   */
+  WorkStealingPool::Stats getOffloadStats() const;
+
+  /**
+   * @brief Gets the counters of the current window per event type: pushes,
+   * drops, high water mark, push to dispatch latency and handler times. The
+   * window is also published as a BusStats event every STATS_INTERVAL_US.
+   * @param out Snapshot to fill.
+   */
+  void getBusStats(EventBusSnapshot &out) const;
+
 private:
-  QueueHandle_t localQueue = nullptr;
+  struct Worker
+  {
+    EventBusTask *owner;
+    size_t index;
+    TaskHandle_t handle;
+  };
+
+  // Pending events, the task is notified after every push
+  EventLanes lanes;
   TaskHandle_t eventBusHandle = nullptr;
+  // Batch popped from the lanes, kept off the task stack
+  Event batch[MAX_BATCH_SIZE];
+  // Runs offloaded handlers on the worker tasks
+  WorkStealingPool pool;
+  Worker workers[WorkStealingPool::MAX_WORKERS];
+  size_t workerCount;
+  // Set to stop the tasks, each finishes the batch in hand, then deletes
+  // itself and clears its running flag or count
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> stoppingWorkers{false};
+  std::atomic<bool> busRunning{false};
+  std::atomic<uint8_t> workersRunning{0};
+  // Counters of the current stats window
+  EventBusStats stats;
+  // Start of the window, moved on by the bus task alone. A 32-bit timestamp
+  // like Event::enqueuedUs, differences stay right across the wrap.
+  std::atomic<uint32_t> statsWindowStartUs{0};
+  static const EventRegistry::HandlerTimer handlerTimer;
   static EventBusTask *instance;
 
   static void taskEntry(void *param);
+  static void workerEntry(void *param);
+  static void wakeWorker(void *arg);
+  bool startWorkers();
+  void stopWorkers();
+  // Close the stats window, publish it and start the next one
+  void publishStats();
+  static uint32_t nowUs();
+  static void recordHandler(EventType type, size_t slot, uint32_t elapsedUs);
 
   static bool staticPushCallback(const Event &event);
   bool pushToQueue(const Event &event);
+  static bool staticOffloadCallback(EventType type, EventRegistry::BatchCallback handler, uint32_t coreMask,
+                                    const Event *events, size_t count);
 };
 
 #endif
\ No newline at end of file
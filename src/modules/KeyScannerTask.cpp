@@ -1,8 +1,16 @@
 #include <modules/KeyScannerTask.h>
+#include <submodules/EventChannel.h>
+#include <submodules/KeyFastPath.h>
 #include <submodules/Logger.h>
+#include <submodules/PayloadPool.h>
+#include <esp_attr.h>
 
 static Logger log(KeyScannerTask::NAMESPACE);
 
+// Every scan loop feeds the fast path as the producer of its first matrix
+static_assert(KeyFastPath::MAX_PRODUCERS >= KeyScannerConfig::MAX_MATRIX_COUNT,
+              "One fast path producer per scan loop");
+
 // Initialize static member variable
 KeyScannerTask *KeyScannerTask::instance = nullptr;
 
@@ -25,17 +33,21 @@ KeyScannerTask::~KeyScannerTask()
   // more later if needed
 }
 
-void KeyScannerTask::keyEventCallback(uint16_t keyIndex, bool state)
+void KeyScannerTask::keyEventCallback(uint16_t keyIndex, bool state, uint32_t scanSequence,
+                                      uint32_t scanUs, size_t producer)
 {
-  RawKeyEvent rKeyEvent{keyIndex, state};
-  Event event{};
-  event.type = EventType::RawKey;
-  event.rawKeyEvt = rKeyEvent;
-  event.cleanup = cleanupRawKeyEvent;
-  if (!EventRegistry::pushEvent(event))
+  RawKeyEvent rKeyEvent{};
+  rKeyEvent.keyIndex = keyIndex;
+  rKeyEvent.state = state;
+  rKeyEvent.scanSequence = scanSequence;
+  rKeyEvent.timestamps.scanUs = scanUs;
+
+  // Low latency consumers first, the bus still carries the event for
+  // everyone else
+  KeyFastPath::push(producer, rKeyEvent);
+  if (!RawKeyChannel::publish(rKeyEvent))
   {
     log.error("Failed to push key event to EventRegistry");
-    event.cleanup(&event);
   }
   else
   {
@@ -43,22 +55,30 @@ void KeyScannerTask::keyEventCallback(uint16_t keyIndex, bool state)
   }
 }
 
-void KeyScannerTask::sendBitMapEvent(uint8_t bitmapSize, uint8_t *bitMap)
+void KeyScannerTask::keyChangeBatchCallback(const IKeyScanner::KeyChange *changes, size_t count,
+                                            uint32_t scanSequence, uint16_t keyOffset,
+                                            uint32_t scanUs, size_t producer)
 {
-  RawBitmapEvent rBitmapEvent{};
-  rBitmapEvent.bitmapSize = bitmapSize;
-  rBitmapEvent.bitMapData = static_cast<uint8_t *>(malloc(bitmapSize));
-  memcpy(rBitmapEvent.bitMapData, bitMap, bitmapSize);
+  log.debug("Scan %u changed %u keys", scanSequence, count);
+  for (size_t i = 0; i < count; i++)
+    keyEventCallback(keyOffset + changes[i].keyIndex, changes[i].pressed, scanSequence, scanUs,
+                     producer);
+  // One wake-up per scan for the whole burst
+  KeyFastPath::flush(producer);
+}
 
-  Event event{};
-  event.type = EventType::RawBitmap;
-  event.rawBitmapEvt = rBitmapEvent;
-  event.cleanup = cleanupRawBitmapEvent;
+void KeyScannerTask::sendBitMapEvent(uint16_t bitmapSize, uint8_t *bitMap)
+{
+  RawBitmapEvent bitmapEvent{};
+  if (!bitmapEvent.assign(EventType::RawBitmap, bitMap, bitmapSize))
+  {
+    log.warn("Bitmap pool exhausted, dropped bitmap event");
+    return;
+  }
 
-  if (!EventRegistry::pushEvent(event))
+  if (!RawBitmapChannel::publish(bitmapEvent))
   {
     log.error("Failed to push bitmap event to EventRegistry");
-    event.cleanup(&event);
   }
   else
   {
@@ -66,6 +86,117 @@ void KeyScannerTask::sendBitMapEvent(uint8_t bitmapSize, uint8_t *bitMap)
   }
 }
 
+template <typename Scanner>
+void KeyScannerTask::sendBitmapSnapshot(Scanner *const *allScanners, const KeyScannerConfig &config,
+                                        std::vector<uint8_t> &bitmap)
+{
+  // Every matrix fills the bytes of its key range, the scanners of other
+  // tasks publish theirs consistently
+  for (size_t m = 0; m < config.getMatrixCount(); m++)
+  {
+    size_t offset = config.getKeyOffset(m) / 8;
+    if (offset >= bitmap.size())
+      break;
+    allScanners[m]->copyPublishedBitmap(
+        bitmap.data() + offset, std::min(allScanners[m]->getBitMapSize(), bitmap.size() - offset));
+  }
+  sendBitMapEvent(static_cast<uint16_t>(bitmap.size()), bitmap.data());
+  log.debug("Bitmap sent");
+}
+
+void IRAM_ATTR KeyScannerTask::wakeInterruptHandler(void *arg)
+{
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(static_cast<TaskHandle_t>(arg), &higherPriorityTaskWoken);
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void KeyScannerTask::scanTimerCallback(void *arg)
+{
+  // Runs in the esp_timer task once the next scan deadline is reached
+  xTaskNotifyGive(static_cast<TaskHandle_t>(arg));
+}
+
+void KeyScannerTask::publishScanStats(KeyScannerTask *task, const ScanTimingSnapshot &stats)
+{
+  portENTER_CRITICAL(&task->statsLock);
+  task->publishedStats[stats.matrix] = stats;
+  task->statsAvailable[stats.matrix] = true;
+  portEXIT_CRITICAL(&task->statsLock);
+
+  ScanTimingSnapshot *statsCopy = static_cast<ScanTimingSnapshot *>(
+      PayloadPool::forType(EventType::ScanStats).allocate(sizeof(ScanTimingSnapshot)));
+  if (statsCopy == nullptr)
+  {
+    log.error("Failed to allocate scan stats event");
+    return;
+  }
+  memcpy(statsCopy, &stats, sizeof(ScanTimingSnapshot));
+
+  if (!ScanStatsChannel::publish({statsCopy}))
+  {
+    log.error("Failed to push scan stats event to EventRegistry");
+  }
+
+  if (stats.scanCount == 0)
+    return;
+  float avgRefreshRateHz = stats.scanCount * 1000000.0f / stats.windowUs;
+  float avgJitterUs = static_cast<float>(stats.totalJitterUs) / stats.scanCount;
+  float avgDurationUs = static_cast<float>(stats.totalDurationUs) / stats.scanCount;
+  log.debug("Matrix %u keyscan rate %.2f Hz (scheduled avg %.2f Hz, active period %u us), "
+            "jitter avg %.1f us p99 <%u us max %u us, scan avg %.1f us p99 <%u us max %u us, missed %u",
+            stats.matrix, avgRefreshRateHz, stats.averageRateHz, stats.periodUs,
+            avgJitterUs, ScanTimingStats::percentileUs(stats.jitterBuckets, 99), stats.maxJitterUs,
+            avgDurationUs, ScanTimingStats::percentileUs(stats.durationBuckets, 99), stats.maxDurationUs,
+            stats.missedDeadlines);
+}
+
+bool KeyScannerTask::getScanStats(ScanTimingSnapshot &out, size_t matrix)
+{
+  if (matrix >= KeyScannerConfig::MAX_MATRIX_COUNT)
+    return false;
+  portENTER_CRITICAL(&statsLock);
+  bool available = statsAvailable[matrix];
+  if (available)
+    out = publishedStats[matrix];
+  portEXIT_CRITICAL(&statsLock);
+  return available;
+}
+
+template <typename Scanner>
+void KeyScannerTask::waitForKeyPress(KeyScannerTask *task, Scanner *const *allScanners,
+                                     const std::vector<size_t> &group, bool sendsBitmap,
+                                     std::vector<uint8_t> &bitmap, uint32_t bitmapSendInterval)
+{
+  // Drop wake-ups left over from the previous idle period
+  ulTaskNotifyTake(pdTRUE, 0);
+
+  // Every matrix of the group has to be able to wake the task
+  size_t idleCount = 0;
+  for (; idleCount < group.size(); idleCount++)
+    if (!allScanners[group[idleCount]]->enterIdle(wakeInterruptHandler, xTaskGetCurrentTaskHandle()))
+      break;
+  if (idleCount < group.size())
+  {
+    for (size_t i = 0; i < idleCount; i++)
+      allScanners[group[i]]->exitIdle();
+    return;
+  }
+  log.debug("No activity, waiting for key press");
+
+  // Block until a sense line interrupt fires, keep sending the (all released)
+  // bitmap at its usual rate meanwhile
+  TickType_t bitmapTicks = sendsBitmap
+                               ? std::max<TickType_t>(pdMS_TO_TICKS(bitmapSendInterval / 1000), 1)
+                               : portMAX_DELAY;
+  while (ulTaskNotifyTake(pdTRUE, bitmapTicks) == 0)
+    sendBitmapSnapshot(allScanners, task->scanConfig, bitmap);
+
+  for (size_t m : group)
+    allScanners[m]->exitIdle();
+  log.debug("Woke up on key press");
+}
+
 void KeyScannerTask::taskEntry(void *arg)
 {
   KeyScannerTask *task = static_cast<KeyScannerTask *>(arg);
@@ -85,64 +216,320 @@ void KeyScannerTask::taskEntry(void *arg)
     log.error("KeyScannerConfig not available, aborting task");
     vTaskDelete(nullptr);
   }
-  KeyScannerConfig localConfig = *configPtr;
-
-  IGpio &gpio = *task->gpioRef;
+  task->scanConfig = *configPtr;
+  const KeyScannerConfig &localConfig = task->scanConfig;
 
   // Store pin vectors locally so their data() pointers remain valid
   pinType rowPins = localConfig.getRowPins();
   pinType colPins = localConfig.getColPins();
 
-  KeyScanner keyScanner =
-      KeyScanner(gpio, rowPins.data(), colPins.data(),
-                 localConfig.getRowsCount(), localConfig.getColCount());
-  log.debug("Initialized KeyScanner with %d rows and %d columns",
-            localConfig.getRowsCount(), localConfig.getColCount());
+  // Boards with a fixed matrix get the scanner specialized for it, as long as
+  // the stored config describes that matrix
+  if (runBoardScanner<BoardProfile>(task, localConfig, rowPins.data(), colPins.data()))
+    return;
+
+  // Everything else gets the engine for the topology of each matrix
+  if (!setupMatrices(task))
+  {
+    log.error("Could not create key scanner for the config, aborting task");
+    vTaskDelete(nullptr);
+  }
+  startMatrixTasks(task);
+
+  std::vector<size_t> group;
+  for (size_t m = 0; m < task->matrices.size(); m++)
+    if (!task->matrices[m].ownTask)
+      group.push_back(m);
+  runScanLoop(task, task->scannerPtrs.data(), group, task->scanTimer, true);
+}
+
+bool KeyScannerTask::setupMatrices(KeyScannerTask *task)
+{
+  const KeyScannerConfig &config = task->scanConfig;
+  task->matrices.clear();
+  task->scanners.clear();
+  task->scannerPtrs.clear();
+  for (size_t m = 0; m < config.getMatrixCount(); m++)
+    task->matrices.push_back(config.getMatrix(m));
+
+  // The main matrix always runs in this task
+  task->matrices[0].ownTask = false;
+
+  for (size_t m = 0; m < task->matrices.size(); m++)
+  {
+    const KeyScannerConfig::ScanMatrix &matrix = task->matrices[m];
+    std::unique_ptr<IKeyScanner> scanner = KeyScannerFactory::create(*task->gpioRef, matrix);
+    if (!scanner)
+      return false;
+    log.debug("Initialized matrix %u, %s scanner with %d row and %d column pins, keys %u-%u at %u Hz%s",
+              m, KeyScannerFactory::getTopologyName(matrix.topology), matrix.rowPins.size(),
+              matrix.colPins.size(), config.getKeyOffset(m),
+              config.getKeyOffset(m) + matrix.getKeyCount() - 1, matrix.refreshRate,
+              matrix.ownTask ? " in its own task" : "");
+    task->scannerPtrs.push_back(scanner.get());
+    task->scanners.push_back(std::move(scanner));
+  }
+  return true;
+}
+
+void KeyScannerTask::startMatrixTasks(KeyScannerTask *task)
+{
+  // Filled completely before the first task starts, the tasks keep pointers
+  // into the vector
+  task->matrixTasks.clear();
+  for (size_t m = 0; m < task->matrices.size(); m++)
+    if (task->matrices[m].ownTask)
+      task->matrixTasks.push_back({task, m, nullptr, nullptr});
+
+  for (MatrixTask &matrixTask : task->matrixTasks)
+  {
+    int8_t core = task->matrices[matrixTask.matrix].coreAffinity;
+    BaseType_t coreAffinity = core < 0 ? task->taskParams.coreAffinity : core;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        matrixTaskEntry, "KeyScanMatrix", task->taskParams.stackSize, &matrixTask,
+        task->taskParams.priority, &matrixTask.handle, coreAffinity);
+    if (result != pdPASS)
+    {
+      log.error("Failed to create task of matrix %u", matrixTask.matrix);
+      matrixTask.handle = nullptr;
+    }
+  }
+}
+
+void KeyScannerTask::matrixTaskEntry(void *arg)
+{
+  MatrixTask *matrixTask = static_cast<MatrixTask *>(arg);
+  KeyScannerTask *task = matrixTask->task;
+  std::vector<size_t> group{matrixTask->matrix};
+  runScanLoop(task, task->scannerPtrs.data(), group, matrixTask->timer, false);
+}
+
+template <typename Profile>
+bool KeyScannerTask::runBoardScanner(KeyScannerTask *task, const KeyScannerConfig &config,
+                                     const uint8_t *rowPins, const uint8_t *colPins)
+{
+  if constexpr (Profile::FIXED_MATRIX)
+  {
+    if (config.getTopology() != KeyScannerConfig::ScanTopology::Matrix ||
+        config.getRowsCount() != Profile::MATRIX_ROWS ||
+        config.getColCount() != Profile::MATRIX_COLS ||
+        config.getScanOrder() != KeyScannerConfig::ScanOrder::RowMajor ||
+        config.isGhostFilterEnabled() || config.getMatrixCount() != 1)
+    {
+      log.warn("Config does not match the %dx%d board matrix, using runtime KeyScanner",
+               Profile::MATRIX_ROWS, Profile::MATRIX_COLS);
+      return false;
+    }
 
-  keyScanner.registerOnKeyChangeCallback(keyEventCallback);
-  log.debug("Registered key event callback with KeyScanner");
+    using BoardScanner = StaticKeyScanner<Profile::MATRIX_ROWS, Profile::MATRIX_COLS>;
+    BoardScanner keyScanner(*task->gpioRef, rowPins, colPins);
+    log.debug("Initialized StaticKeyScanner<%d, %d>, row-major scan",
+              Profile::MATRIX_ROWS, Profile::MATRIX_COLS);
+    BoardScanner *const allScanners[] = {&keyScanner};
+    task->exitBoardScannerIdle = [](void *scanner)
+    {
+      BoardScanner *boardScanner = static_cast<BoardScanner *>(scanner);
+      if (boardScanner->isIdle())
+        boardScanner->exitIdle();
+    };
+    task->boardScanner = &keyScanner;
+    std::vector<size_t> group{0};
+    runScanLoop(task, allScanners, group, task->scanTimer, true);
+    task->boardScanner = nullptr;
+    return true;
+  }
+  return false;
+}
+
+template <typename Scanner>
+void KeyScannerTask::runScanLoop(KeyScannerTask *task, Scanner *const *allScanners,
+                                 const std::vector<size_t> &group, esp_timer_handle_t &timer,
+                                 bool sendsBitmap)
+{
+  const KeyScannerConfig &localConfig = task->scanConfig;
+
+  // Per matrix scan rate, deadline source and statistics. Reserved up front,
+  // the key change callbacks point into the entries.
+  struct MatrixScan
+  {
+    Scanner *scanner;
+    size_t matrix;
+    ScanRateScheduler scheduler;
+    ScanTimingStats timingStats;
+    uint32_t scanStartUs; // Start of the scan in progress, stamped on its key events
+  };
+  std::vector<MatrixScan> matrixScans;
+  matrixScans.reserve(group.size());
+
+  // Matrices of the group share one deadline clock, the first has priority
+  ScanDeadlineScheduler deadlines(SCAN_GUARD_US);
+
+  for (size_t m : group)
+  {
+    uint16_t refreshRate = localConfig.getMatrix(m).refreshRate;
+    Scanner &keyScanner = *allScanners[m];
+
+    // Convert the debounce window to whole scans at the refresh rate, rounding up
+    uint32_t debounceScans = (localConfig.getDebounceTime() * refreshRate + 999) / 1000;
+    keyScanner.setDebounce(localConfig.getDebounceMode(),
+                           static_cast<uint8_t>(std::min<uint32_t>(debounceScans, UINT8_MAX)));
+    log.debug("Matrix %u debounce mode %d over %u scans", m,
+              static_cast<uint8_t>(localConfig.getDebounceMode()), debounceScans);
+
+    // Scan at the refresh rate while keys change, slower in between if the
+    // config asks for it
+    ScanRateScheduler scheduler(refreshRate, localConfig.getIdleRefreshRate(),
+                                localConfig.getHeldKeyRefreshRate(),
+                                localConfig.getBoostHoldOffTime());
+    log.debug("Matrix %u scan rate %u Hz, idle %u Hz after %u ms, held keys %u Hz", m,
+              refreshRate, localConfig.getIdleRefreshRate(), localConfig.getBoostHoldOffTime(),
+              localConfig.getHeldKeyRefreshRate());
+    deadlines.addSource(scheduler.getTickPeriodUs());
+    matrixScans.push_back({&keyScanner, m, scheduler, ScanTimingStats(1000000 / refreshRate), 0});
+  }
+
+  // The first matrix of a group belongs to no other scan loop
+  const size_t producer = group.front();
+  for (MatrixScan &matrixScan : matrixScans)
+  {
+    uint16_t keyOffset = localConfig.getKeyOffset(matrixScan.matrix);
+    uint32_t &scanStartUs = matrixScan.scanStartUs;
+    matrixScan.scanner->registerOnKeyChangeBatchCallback(
+        [keyOffset, &scanStartUs, producer](const IKeyScanner::KeyChange *changes, size_t count,
+                                            uint32_t scanSequence)
+        { keyChangeBatchCallback(changes, count, scanSequence, keyOffset, scanStartUs, producer); });
+  }
+  log.debug("Registered key event callbacks of %u matrices", matrixScans.size());
 
   std::vector<uint8_t> localBitmap;
   localBitmap.assign(localConfig.getBitmapSize(), 0);
 
-  const uint32_t keyScanInterval = 1000000 / localConfig.getRefreshRate();
   const uint32_t bitmapSendInterval = 1000000 / localConfig.getBitmapSendRate();
 
-  uint64_t lastScanTime = esp_timer_get_time();
-  uint64_t lastBitmapTime = lastScanTime;
-  uint64_t lastLogTime = lastScanTime;
-  uint32_t timesExecuted = 0;
+  // Idle is entered after as long without activity as this many scans at the
+  // refresh rate of the first matrix take, however fast the scheduler scans
+  // meanwhile
+  const uint64_t idleQuietUs = static_cast<uint64_t>(IDLE_QUIET_SCANS) * 1000000 /
+                               localConfig.getMatrix(group.front()).refreshRate;
+
+  // A one-shot timer fires at the next scan deadline, the task blocks until
+  // then instead of polling the clock
+  esp_timer_create_args_t timerArgs{};
+  timerArgs.callback = scanTimerCallback;
+  timerArgs.arg = xTaskGetCurrentTaskHandle();
+  timerArgs.dispatch_method = ESP_TIMER_TASK;
+  timerArgs.name = "keyscan";
+  if (esp_timer_create(&timerArgs, &timer) != ESP_OK)
+  {
+    log.error("Failed to create scan timer, aborting task");
+    timer = nullptr;
+    vTaskDelete(nullptr);
+  }
+
+  ScanTimingSnapshot statsSnapshot{};
+
+  uint64_t now = esp_timer_get_time();
+  deadlines.reset(now);
+  for (MatrixScan &matrixScan : matrixScans)
+  {
+    matrixScan.scheduler.reset(now);
+    matrixScan.timingStats.reset(now);
+  }
+  uint64_t lastBitmapTime = now;
+  uint64_t lastStatsTime = now;
+  uint64_t lastBusyTime = now;
 
   for (;;)
   {
-    uint64_t time = esp_timer_get_time();
+    // Scan every matrix that is due, highest priority first
+    size_t source;
+    while ((source = deadlines.nextDue(now)) != ScanDeadlineScheduler::NONE)
+    {
+      MatrixScan &matrixScan = matrixScans[source];
+      Scanner &keyScanner = *matrixScan.scanner;
+
+      uint64_t scanStart = esp_timer_get_time();
+      matrixScan.scanStartUs = static_cast<uint32_t>(scanStart);
+      size_t changeCount = matrixScan.scheduler.nextScan() == ScanRateScheduler::ScanKind::Full
+                               ? keyScanner.updateKeyState()
+                               : keyScanner.updateHeldKeyState();
+      uint64_t scanEnd = esp_timer_get_time();
+      ScanDeadlineScheduler::Completion completion = deadlines.complete(source, scanStart, scanEnd);
+      matrixScan.timingStats.recordMissedDeadlines(completion.missedDeadlines);
+      matrixScan.timingStats.recordScan(completion.jitterUs,
+                                        static_cast<uint32_t>(scanEnd - scanStart));
+
+      // Follow the activity with the scan rate, a new rate restarts the
+      // deadlines of the matrix from now
+      bool keysHeld = keyScanner.hasPressedKeys();
+      if (matrixScan.scheduler.update(scanEnd, keyScanner.sawKeyActivity(), keysHeld))
+        deadlines.setPeriod(source, matrixScan.scheduler.getTickPeriodUs(), scanEnd);
 
-    if (time - lastScanTime >= keyScanInterval - 1)
+      // Stop polling once nothing changed and nothing was held for a while
+      if (changeCount > 0 || keysHeld)
+        lastBusyTime = scanEnd;
+      now = scanEnd;
+    }
+
+    if (sendsBitmap && now - lastBitmapTime >= bitmapSendInterval)
     {
-      keyScanner.updateKeyState();
-      timesExecuted++;
-      lastScanTime = time;
+      sendBitmapSnapshot(allScanners, localConfig, localBitmap);
+      lastBitmapTime = now;
+    }
+
+    if (now - lastBusyTime >= idleQuietUs)
+    {
+      // Close the statistics windows, idle time is not scan time
+      for (MatrixScan &matrixScan : matrixScans)
+      {
+        matrixScan.timingStats.snapshot(now, statsSnapshot);
+        statsSnapshot.averageRateHz = matrixScan.scheduler.getAverageRateHz(now);
+        statsSnapshot.matrix = static_cast<uint8_t>(matrixScan.matrix);
+        publishScanStats(task, statsSnapshot);
+      }
 
-      if (time - lastBitmapTime >= bitmapSendInterval - 1)
+      waitForKeyPress(task, allScanners, group, sendsBitmap, localBitmap, bitmapSendInterval);
+
+      // Restart the schedule from now at the refresh rate and scan right away,
+      // the idle period does not count as missed deadlines
+      now = esp_timer_get_time();
+      for (size_t i = 0; i < matrixScans.size(); i++)
       {
-        keyScanner.copyPublishedBitmap(localBitmap.data(), localBitmap.size());
-        uint8_t bitmapSize = static_cast<uint8_t>(keyScanner.getBitMapSize());
-        sendBitMapEvent(bitmapSize, localBitmap.data());
-        lastBitmapTime = time;
-        log.debug("Bitmap sent");
+        matrixScans[i].scheduler.reset(now);
+        deadlines.setPeriod(i, matrixScans[i].scheduler.getTickPeriodUs(), now);
+        matrixScans[i].timingStats.reset(now);
       }
+      deadlines.reset(now);
+      lastBitmapTime = now;
+      lastStatsTime = now;
+      lastBusyTime = now;
+      continue;
+    }
 
-      if (time - lastLogTime >= 5000000)
+    if (now - lastStatsTime >= STATS_INTERVAL_US)
+    {
+      for (MatrixScan &matrixScan : matrixScans)
       {
-        float avgUpdateInterval = (time - lastLogTime) / timesExecuted;
-        float avgRefreshRateHz = timesExecuted / 5;
-        log.debug("Average Keyscan update rate (Hz): %.2f, interval (uS): %.1f", avgRefreshRateHz, avgUpdateInterval);
-        lastLogTime = time;
-        timesExecuted = 0;
+        matrixScan.timingStats.snapshot(now, statsSnapshot);
+        statsSnapshot.averageRateHz = matrixScan.scheduler.getAverageRateHz(now);
+        statsSnapshot.matrix = static_cast<uint8_t>(matrixScan.matrix);
+        publishScanStats(task, statsSnapshot);
+        matrixScan.timingStats.reset(now);
+        matrixScan.scheduler.resetAverage(now);
       }
+      lastStatsTime = now;
+    }
+
+    // Sleep until the next deadline, a due matrix waiting for a gap becomes
+    // runnable after the scan due then
+    uint64_t wake = deadlines.getNextWakeUs(now);
+    now = esp_timer_get_time();
+    if (wake > now)
+    {
+      esp_timer_start_once(timer, wake - now);
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      now = esp_timer_get_time();
     }
-    else
-      vPortYield();
   }
 }
 
@@ -160,6 +547,8 @@ void KeyScannerTask::start(TaskParameters params)
 
   log.info("Starting KeyScannerTask with stack size %u, priority %d, core affinity %d",
            params.stackSize, params.priority, params.coreAffinity);
+  // Matrices with a task of their own start with the same parameters
+  taskParams = params;
 
   BaseType_t result = xTaskCreatePinnedToCore(
       taskEntry, KeyScannerTask::NAMESPACE, params.stackSize, this,
@@ -179,8 +568,45 @@ void KeyScannerTask::stop()
     log.info("Stop called but KeyScannerTask is not running");
     return;
   }
+
+  // A task blocked in waitForKeyPress() leaves its scanners idle: wake
+  // interrupts armed with its handle and drive lines low. Hold the tasks
+  // still and disarm them before the tasks go.
+  for (MatrixTask &matrixTask : matrixTasks)
+    if (matrixTask.handle != nullptr)
+      vTaskSuspend(matrixTask.handle);
+  vTaskSuspend(keyScannerTaskHandle);
+  for (IKeyScanner *scanner : scannerPtrs)
+    if (scanner->isIdle())
+      scanner->exitIdle();
+  if (boardScanner != nullptr)
+    exitBoardScannerIdle(boardScanner);
+  boardScanner = nullptr;
+
+  for (MatrixTask &matrixTask : matrixTasks)
+  {
+    if (matrixTask.timer != nullptr)
+    {
+      esp_timer_stop(matrixTask.timer);
+      esp_timer_delete(matrixTask.timer);
+    }
+    if (matrixTask.handle != nullptr)
+      vTaskDelete(matrixTask.handle);
+  }
+  matrixTasks.clear();
+  if (scanTimer != nullptr)
+  {
+    esp_timer_stop(scanTimer);
+    esp_timer_delete(scanTimer);
+    scanTimer = nullptr;
+  }
   vTaskDelete(keyScannerTaskHandle);
   keyScannerTaskHandle = nullptr;
+
+  // No task uses the scanners anymore
+  scannerPtrs.clear();
+  scanners.clear();
+  matrices.clear();
 }
 
 void KeyScannerTask::restart(TaskParameters params)
@@ -2,32 +2,125 @@
 #define KEYSCANNERTASK_H
 
 #include <interfaces/ITask.h>
-#include <submodules/KeyScanner.h>
+#include <interfaces/IKeyScanner.h>
+#include <submodules/KeyScannerFactory.h>
+#include <submodules/StaticKeyScanner.h>
 #include <submodules/Config/ConfigManager.h>
 #include <submodules/Config/KeyScannerConfig.h>
 #include <submodules/EventRegistry.h>
+#include <submodules/ScanDeadlineScheduler.h>
+#include <submodules/ScanRateScheduler.h>
+#include <submodules/ScanTimingStats.h>
+#include <system/BoardProfile.h>
 #include <queue.h>
+#include <esp_timer.h>
 
 class KeyScannerTask : public ITask
 {
 public:
     static constexpr const char *NAMESPACE = "KeyScannerTask";
 
+    // Time without changes and without held keys, in scans at the refresh
+    // rate, before the task stops polling and waits for a key press interrupt
+    static constexpr uint32_t IDLE_QUIET_SCANS = 250;
+
+    // Margin a lower priority matrix keeps before the next scan of a higher
+    // priority one in the same task, covers the timer wake-up latency
+    static constexpr uint32_t SCAN_GUARD_US = 20;
+
+    // Length of a scan timing statistics window
+    static constexpr uint64_t STATS_INTERVAL_US = 5000000;
+
     KeyScannerTask(ConfigManager *configManager, IGpio &gpio);
     ~KeyScannerTask();
     void start(TaskParameters params) override;
     void stop() override;
     void restart(TaskParameters params) override;
 
+    /**
+     * @brief Get the scan timing statistics of the last completed window.
+     * @param out Snapshot to fill.
+     * @param matrix Index of the matrix, 0 is the main matrix.
+     * @return true if a window has completed since the task started.
+     */
+    bool getScanStats(ScanTimingSnapshot &out, size_t matrix = 0);
+
 private:
+    // A matrix scanned in a task of its own
+    struct MatrixTask
+    {
+        KeyScannerTask *task;
+        size_t matrix;
+        TaskHandle_t handle;
+        esp_timer_handle_t timer;
+    };
+
     ConfigManager *configManager = nullptr;
     IGpio *gpioRef = nullptr;
+    TaskParameters taskParams{};
     TaskHandle_t keyScannerTaskHandle = nullptr;
+    esp_timer_handle_t scanTimer = nullptr;
+
+    // Snapshot of the config and the scanners of all its matrices, set up by
+    // the main scan task before it starts the matrix tasks. The matrices hold
+    // the pins the scanners point to.
+    KeyScannerConfig scanConfig;
+    std::vector<KeyScannerConfig::ScanMatrix> matrices;
+    std::vector<std::unique_ptr<IKeyScanner>> scanners;
+    std::vector<IKeyScanner *> scannerPtrs;
+    std::vector<MatrixTask> matrixTasks;
+    // StaticKeyScanner of the board profile, it lives on the stack of the main
+    // scan task, and how to take it out of idle from stop()
+    void *boardScanner = nullptr;
+    void (*exitBoardScannerIdle)(void *scanner) = nullptr;
+
+    // Last completed statistics window per matrix, written by the scan tasks,
+    // read by getScanStats
+    ScanTimingSnapshot publishedStats[KeyScannerConfig::MAX_MATRIX_COUNT]{};
+    bool statsAvailable[KeyScannerConfig::MAX_MATRIX_COUNT]{};
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
     static KeyScannerTask *instance;
 
     static void taskEntry(void *param);
-    static void keyEventCallback(uint16_t keyIndex, bool state);
-    static void sendBitMapEvent(uint8_t bitmapSize, uint8_t *bitMap);
+    static void matrixTaskEntry(void *param);
+    static void keyEventCallback(uint16_t keyIndex, bool state, uint32_t scanSequence,
+                                 uint32_t scanUs, size_t producer);
+    static void keyChangeBatchCallback(const IKeyScanner::KeyChange *changes, size_t count,
+                                       uint32_t scanSequence, uint16_t keyOffset,
+                                       uint32_t scanUs, size_t producer);
+    static void sendBitMapEvent(uint16_t bitmapSize, uint8_t *bitMap);
+    template <typename Scanner>
+    static void sendBitmapSnapshot(Scanner *const *allScanners, const KeyScannerConfig &config,
+                                   std::vector<uint8_t> &bitmap);
+    static void wakeInterruptHandler(void *arg);
+    static void scanTimerCallback(void *arg);
+    static void publishScanStats(KeyScannerTask *task, const ScanTimingSnapshot &stats);
+    template <typename Scanner>
+    static void waitForKeyPress(KeyScannerTask *task, Scanner *const *allScanners,
+                                const std::vector<size_t> &group, bool sendsBitmap,
+                                std::vector<uint8_t> &bitmap, uint32_t bitmapSendInterval);
+
+    // Create the scanners of all matrices and start the tasks of the matrices
+    // that want one, returns false if a scanner could not be created
+    static bool setupMatrices(KeyScannerTask *task);
+    static void startMatrixTasks(KeyScannerTask *task);
+
+    // Scan with the StaticKeyScanner of the board profile, returns false
+    // without scanning if the profile has no fixed matrix or the config
+    // does not match it
+    template <typename Profile>
+    static bool runBoardScanner(KeyScannerTask *task, const KeyScannerConfig &config,
+                                const uint8_t *rowPins, const uint8_t *colPins);
+
+    // Deadline driven scan loop shared by the static scanner and the engines
+    // behind IKeyScanner. Scans the matrices of the group, allScanners holds
+    // the scanners of every matrix of the config so the loop sending the
+    // bitmap can copy all of them into it.
+    template <typename Scanner>
+    static void runScanLoop(KeyScannerTask *task, Scanner *const *allScanners,
+                            const std::vector<size_t> &group, esp_timer_handle_t &timer,
+                            bool sendsBitmap);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <modules/MasterTask.h>
+#include <submodules/EventChannel.h>
 #include <submodules/Logger.h>
+#include <esp_timer.h>
 
 static Logger log(MasterTask::NAMESPACE);
 
@@ -36,10 +38,72 @@ void MasterTask::taskEntry(void *arg)
   task->protocol->onConfigReceived(configReceiveCallback);
   log.debug("Registered TransportProtocol callbacks");
 
+  uint32_t secondsSinceStats = 0;
   for (;;)
   {
     // Todo: Implement config updates here
     vTaskDelay(pdMS_TO_TICKS(1000));
+
+    if (++secondsSinceStats >= LATENCY_INTERVAL_S)
+    {
+      publishLatencyStats(task);
+      secondsSinceStats = 0;
+    }
+  }
+}
+
+void MasterTask::publishLatencyStats(MasterTask *task)
+{
+  KeyLatencySnapshot stats{};
+  {
+    std::lock_guard<std::mutex> lock(task->latencyMutex);
+    task->latencyStats.snapshot(stats);
+    task->latencyStats.reset();
+    task->publishedLatency = stats;
+    task->latencyAvailable = true;
+  }
+
+  if (stats.eventCount == 0)
+    return;
+  for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+  {
+    float avgUs = static_cast<float>(stats.totalUs[stage]) / stats.eventCount;
+    log.debug("Key latency %s avg %.1f us p99 <%u us max %u us over %u events",
+              KeyLatencyStats::getStageName(static_cast<LatencyStage>(stage)), avgUs,
+              ScanTimingStats::percentileUs(stats.buckets[stage], 99), stats.maxUs[stage],
+              stats.eventCount);
+  }
+}
+
+bool MasterTask::getLatencyStats(KeyLatencySnapshot &out)
+{
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  if (latencyAvailable)
+    out = publishedLatency;
+  return latencyAvailable;
+}
+
+void MasterTask::pushHidBitmapEvent(const std::vector<uint8_t> &bitmap, const RawKeyEvent *source)
+{
+  HidBitmapEvent hidBitmapEvt{};
+  if (!hidBitmapEvt.assign(EventType::HidBitmap, bitmap.data(), static_cast<uint16_t>(bitmap.size())))
+  {
+    log.error("Failed to allocate HID bitmap event");
+    return;
+  }
+  if (source != nullptr)
+  {
+    hidBitmapEvt.scanSequence = source->scanSequence;
+    hidBitmapEvt.timestamps = source->timestamps;
+  }
+
+  if (!HidBitmapChannel::publish(hidBitmapEvt))
+  {
+    log.error("Failed to push HID bitmap event to EventRegistry");
+  }
+  else
+  {
+    log.info("Pushed HID bitmap event of size %d", hidBitmapEvt.bitmapSize);
   }
 }
 
@@ -105,6 +169,8 @@ void MasterTask::pairReceiveCallback(uint8_t sourceId)
 
 void MasterTask::keyReceiveCallback(RawKeyEvent &keyEvent, uint8_t senderId)
 {
+  keyEvent.timestamps.rxUs = static_cast<uint32_t>(esp_timer_get_time());
+
   if (instance->hidMapper.doesMapExist(senderId) == false)
   {
     instance->protocol->requestConfig(senderId);
@@ -112,39 +178,21 @@ void MasterTask::keyReceiveCallback(RawKeyEvent &keyEvent, uint8_t senderId)
     return;
   }
 
-  instance->hidMapper.mapIndexToHidBitmap(keyEvent.keyIndex, keyEvent.state, senderId);
-  log.debug("Pushed key event from device ID %u to HidMapper", senderId);
-
-  std::vector<uint8_t> currentBitmap{0};
-  currentBitmap.resize(hidMapper.getBitmapSize());
-  hidMapper.copyBitmap(currentBitmap.data(), currentBitmap.size());
-  if (memcmp(oldBitmap.data(), currentBitmap.data(), currentBitmap.size()) != 0)
+  // Only a changed HID bit produces a new report, it carries the timestamps
+  // of the key event that caused it
+  if (instance->hidMapper.mapKeyEventToHidBitmap(keyEvent, senderId))
   {
-    // Push HID Event
     log.info("Hid Map changed, pushing HidEvent");
-    HidBitmapEvent hidBitmapEvt{};
-    hidBitmapEvt.bitmapSize = static_cast<uint8_t>(currentBitmap.size());
-    hidBitmapEvt.bitMapData = static_cast<uint8_t *>(malloc(currentBitmap.size()));
-    memcpy(hidBitmapEvt.bitMapData, currentBitmap.data(), currentBitmap.size());
-
-    Event hidEvent{};
-    hidEvent.type = EventType::HidBitmap;
-    hidEvent.hidBitmapEvt = hidBitmapEvt;
-    hidEvent.cleanup = cleanupHidBitmapEvent;
-
-    if (!EventRegistry::pushEvent(hidEvent))
-    {
-      log.error("Failed to push HID bitmap event to EventRegistry");
-      hidEvent.cleanup(&hidEvent);
-    }
-    else
-    {
-      log.info("Pushed HID bitmap event of size %d", hidBitmapEvt.bitmapSize);
-    }
+    hidMapper.copyBitmap(oldBitmap.data(), oldBitmap.size());
+    pushHidBitmapEvent(oldBitmap, &keyEvent);
   }
   else
     log.info("No change to Hid Map");
-  oldBitmap = currentBitmap;
+  log.debug("Pushed key event from device ID %u to HidMapper", senderId);
+
+  uint32_t hidUs = static_cast<uint32_t>(esp_timer_get_time());
+  std::lock_guard<std::mutex> lock(instance->latencyMutex);
+  instance->latencyStats.record(keyEvent, senderId, hidUs);
 };
 
 void MasterTask::bitmapReceiveCallback(RawBitmapEvent &bitmapEvent, uint8_t senderId)
@@ -153,10 +201,12 @@ void MasterTask::bitmapReceiveCallback(RawBitmapEvent &bitmapEvent, uint8_t send
   {
     instance->protocol->requestConfig(senderId);
     log.warn("No HID map for device ID %u, requested config", senderId);
+    bitmapEvent.release(EventType::RawBitmap);
     return;
   }
 
-  instance->hidMapper.mapBitmapToHidBitmap(bitmapEvent.bitMapData, bitmapEvent.bitmapSize, senderId);
+  instance->hidMapper.mapBitmapToHidBitmap(bitmapEvent.data(), bitmapEvent.bitmapSize, senderId);
+  bitmapEvent.release(EventType::RawBitmap);
   log.debug("Pushed bitmap event from device ID %u to HidMapper", senderId);
 
   std::vector<uint8_t> currentBitmap{0};
@@ -164,27 +214,8 @@ void MasterTask::bitmapReceiveCallback(RawBitmapEvent &bitmapEvent, uint8_t send
   hidMapper.copyBitmap(currentBitmap.data(), currentBitmap.size());
   if (memcmp(oldBitmap.data(), currentBitmap.data(), currentBitmap.size()) != 0)
   {
-    // Push HID Event
     log.info("Hid Map changed, pushing HidEvent");
-    HidBitmapEvent hidBitmapEvt{};
-    hidBitmapEvt.bitmapSize = static_cast<uint8_t>(currentBitmap.size());
-    hidBitmapEvt.bitMapData = static_cast<uint8_t *>(malloc(currentBitmap.size()));
-    memcpy(hidBitmapEvt.bitMapData, currentBitmap.data(), currentBitmap.size());
-
-    Event hidEvent{};
-    hidEvent.type = EventType::HidBitmap;
-    hidEvent.hidBitmapEvt = hidBitmapEvt;
-    hidEvent.cleanup = cleanupHidBitmapEvent;
-
-    if (!EventRegistry::pushEvent(hidEvent))
-    {
-      log.error("Failed to push HID bitmap event to EventRegistry");
-      hidEvent.cleanup(&hidEvent);
-    }
-    else
-    {
-      log.info("Pushed HID bitmap event of size %d", hidBitmapEvt.bitmapSize);
-    }
+    pushHidBitmapEvent(currentBitmap, nullptr);
   }
   else
     log.debug("No change to Hid Map");
@@ -6,8 +6,10 @@
 #include <submodules/TransportProtocol.h>
 #include <submodules/EventRegistry.h>
 #include <submodules/HidMapper.h>
+#include <submodules/KeyLatencyStats.h>
 #include <submodules/Config/ConfigManager.h>
 #include <submodules/Config/KeyScannerConfig.h>
+#include <mutex>
 #include <vector>
 
 class MasterTask : public ITask
@@ -15,12 +17,22 @@ class MasterTask : public ITask
 public:
     static constexpr const char *NAMESPACE = "MasterTask";
 
+    // Length of a key latency statistics window in seconds
+    static constexpr uint32_t LATENCY_INTERVAL_S = 10;
+
     MasterTask(ITransport &transport);
     ~MasterTask();
     void start(TaskParameters params) override;
     void stop() override;
     void restart(TaskParameters params) override;
 
+    /**
+     * @brief Get the key latency statistics of the last completed window.
+     * @param out Snapshot to fill.
+     * @return true if a window has completed since the task started.
+     */
+    bool getLatencyStats(KeyLatencySnapshot &out);
+
 private:
     TaskHandle_t masterTaskHandle = nullptr;
     ITransport *transportRef = nullptr;
@@ -30,7 +42,16 @@ private:
     static HidMapper hidMapper;
     static std::vector<uint8_t> oldBitmap;
 
+    // Latency of received key events, recorded by the transport callbacks and
+    // published once per window by the task
+    KeyLatencyStats latencyStats;
+    KeyLatencySnapshot publishedLatency{};
+    bool latencyAvailable = false;
+    std::mutex latencyMutex;
+
     static void taskEntry(void *arg);
+    static void publishLatencyStats(MasterTask *task);
+    static void pushHidBitmapEvent(const std::vector<uint8_t> &bitmap, const RawKeyEvent *source);
     static void pairReceiveCallback(uint8_t sourceId);
     static void keyReceiveCallback(RawKeyEvent &keyEvent, uint8_t senderId);
     static void bitmapReceiveCallback(RawBitmapEvent &bitmapEvent, uint8_t senderId);
@@ -0,0 +1,363 @@
+#include <modules/RingBusTask.h>
+#include <submodules/Logger.h>
+#include <system/SystemConfig.h>
+
+static Logger log(RingBusTask::NAMESPACE);
+
+// Initialize static member variable
+RingBusTask *RingBusTask::instance = nullptr;
+
+RingBusTask::RingBusTask()
+{
+  if (instance != nullptr)
+  {
+    log.warn("RingBusTask instance already exists, replacing");
+    delete instance;
+  }
+  instance = this;
+  for (Subscriber &subscriber : subscribers)
+    subscriber.owner = this;
+}
+
+RingBusTask::~RingBusTask()
+{
+  stop();
+  instance = nullptr;
+}
+
+// Supervisor loop, woken by every change of the registered handlers
+void RingBusTask::supervisorEntry(void *param)
+{
+  RingBusTask *instance = static_cast<RingBusTask *>(param);
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (instance->stopping.load())
+      break;
+    instance->reconcile();
+  }
+
+  // Retiring subscribers notify the supervisor, it goes last
+  instance->stopSubscribers();
+  instance->supervisorRunning.store(false);
+  vTaskDelete(nullptr);
+}
+
+// Subscriber loop, one per handler
+void RingBusTask::subscriberEntry(void *param)
+{
+  Subscriber &subscriber = *static_cast<Subscriber *>(param);
+  RingBusTask *owner = subscriber.owner;
+  EventRing &ring = owner->ring;
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (owner->stopping.load())
+      break;
+    int id = subscriber.id.load();
+    if (id < 0)
+      continue;
+
+    if (subscriber.retiring.load())
+    {
+      // The handler is gone, what it did not take is released
+      ring.unsubscribe(id);
+      subscriber.id.store(-1);
+      subscriber.retiring.store(false);
+      subscriber.used.store(false);
+      xTaskNotifyGive(subscriber.owner->supervisorHandle);
+      continue;
+    }
+
+    size_t drained = 0;
+    size_t count;
+    while (drained < MAX_DRAIN_EVENTS && (count = ring.poll(id, subscriber.events, MAX_BATCH_SIZE)) > 0)
+    {
+      deliver(subscriber, subscriber.events, count);
+      drained += count;
+    }
+
+    // Events may be left, come back for them after the other tasks ran
+    if (drained >= MAX_DRAIN_EVENTS)
+    {
+      xTaskNotifyGive(subscriber.handle);
+      taskYIELD();
+    }
+  }
+
+  // Every batch taken from the ring was released, stop() unsubscribes
+  owner->subscribersRunning.fetch_sub(1);
+  vTaskDelete(nullptr);
+}
+
+void RingBusTask::deliver(Subscriber &subscriber, Event *events, size_t count)
+{
+  if (subscriber.callback != nullptr)
+  {
+    for (size_t i = 0; i < count; i++)
+      subscriber.callback(events[i]);
+  }
+  else
+  {
+    // Batch handlers take runs of one type
+    for (size_t first = 0; first < count;)
+    {
+      size_t end = first + 1;
+      while (end < count && events[end].type == events[first].type)
+        end++;
+      subscriber.batchCallback(events + first, end - first);
+      first = end;
+    }
+  }
+
+  // Handlers only borrow the events, as on EventBusTask
+  for (size_t i = 0; i < count; i++)
+    if (events[i].cleanup)
+      events[i].cleanup(&events[i]);
+}
+
+void RingBusTask::reconcile()
+{
+  struct Wanted
+  {
+    EventRegistry::EventCallback callback;
+    EventRegistry::BatchCallback batchCallback;
+    uint32_t typeMask;
+    bool running;
+  };
+
+  // One subscriber per distinct handler, taking every type it is registered for
+  Wanted wanted[EventRing::MAX_SUBSCRIBERS];
+  size_t wantedCount = 0;
+  auto want = [&](EventRegistry::EventCallback callback, EventRegistry::BatchCallback batchCallback,
+                  EventType type)
+  {
+    for (size_t i = 0; i < wantedCount; i++)
+    {
+      if (wanted[i].callback == callback && wanted[i].batchCallback == batchCallback)
+      {
+        wanted[i].typeMask |= EventRing::typeBit(type);
+        return;
+      }
+    }
+    if (wantedCount == EventRing::MAX_SUBSCRIBERS)
+    {
+      log.error("More than %u handlers, a handler of type %d is not run", EventRing::MAX_SUBSCRIBERS,
+                static_cast<uint8_t>(type));
+      return;
+    }
+    wanted[wantedCount++] = {callback, batchCallback, EventRing::typeBit(type), false};
+  };
+
+  for (size_t t = 0; t < (size_t)EventType::COUNT; t++)
+  {
+    EventType type = static_cast<EventType>(t);
+    for (EventRegistry::EventCallback callback : EventRegistry::getHandler(type))
+      want(callback, nullptr, type);
+    for (EventRegistry::BatchCallback batchCallback : EventRegistry::getBatchHandler(type))
+      want(nullptr, batchCallback, type);
+    // Every handler has a task of its own here, offloaded ones included
+    for (EventRegistry::BatchCallback batchCallback : EventRegistry::getOffloadHandler(type))
+      want(nullptr, batchCallback, type);
+  }
+
+  // Retype the subscribers still wanted, retire the others
+  for (Subscriber &subscriber : subscribers)
+  {
+    if (!subscriber.used.load() || subscriber.retiring.load())
+      continue;
+
+    Wanted *match = nullptr;
+    for (size_t i = 0; i < wantedCount && match == nullptr; i++)
+      if (wanted[i].callback == subscriber.callback && wanted[i].batchCallback == subscriber.batchCallback)
+        match = &wanted[i];
+
+    if (match == nullptr)
+    {
+      subscriber.retiring.store(true);
+      xTaskNotifyGive(subscriber.handle);
+      continue;
+    }
+    match->running = true;
+    if (match->typeMask != subscriber.typeMask)
+    {
+      subscriber.typeMask = match->typeMask;
+      ring.setTypeMask(subscriber.id.load(), match->typeMask);
+    }
+  }
+
+  // Retiring subscribers notify the supervisor once their slot is free
+  for (size_t i = 0; i < wantedCount; i++)
+    if (!wanted[i].running && !startSubscriber(wanted[i].callback, wanted[i].batchCallback, wanted[i].typeMask))
+      log.warn("No subscriber free yet for a handler of types 0x%x", wanted[i].typeMask);
+}
+
+bool RingBusTask::startSubscriber(EventRegistry::EventCallback callback,
+                                  EventRegistry::BatchCallback batchCallback, uint32_t typeMask)
+{
+  for (Subscriber &subscriber : subscribers)
+  {
+    if (subscriber.used.load())
+      continue;
+
+    if (subscriber.handle == nullptr)
+    {
+      subscribersRunning.fetch_add(1);
+      BaseType_t result = xTaskCreatePinnedToCore(
+          RingBusTask::subscriberEntry, RingBusTask::NAMESPACE, STACK_RINGBUS_SUBSCRIBER, &subscriber,
+          subscriberParams.priority, &subscriber.handle, subscriberParams.coreAffinity);
+      if (result != pdPASS)
+      {
+        subscribersRunning.fetch_sub(1);
+        subscriber.handle = nullptr;
+        log.error("Failed to create RingBusTask subscriber");
+        return false;
+      }
+    }
+
+    int id = ring.subscribe(typeMask, policy, wakeSubscriber, &subscriber);
+    if (id < 0)
+      return false;
+    subscriber.callback = callback;
+    subscriber.batchCallback = batchCallback;
+    subscriber.typeMask = typeMask;
+    subscriber.used.store(true);
+    subscriber.id.store(id);
+    // Events may have come before the id was stored
+    xTaskNotifyGive(subscriber.handle);
+    return true;
+  }
+  return false;
+}
+
+void RingBusTask::stopSubscribers()
+{
+  // A subscriber inside deliver() finishes and releases the batch in hand first
+  for (Subscriber &subscriber : subscribers)
+    if (subscriber.handle != nullptr)
+      xTaskNotifyGive(subscriber.handle);
+  while (subscribersRunning.load() != 0)
+    vTaskDelay(1);
+}
+
+const RingBusTask::Subscriber *RingBusTask::findSubscriber(EventRegistry::EventCallback callback,
+                                                           EventRegistry::BatchCallback batchCallback) const
+{
+  for (const Subscriber &subscriber : subscribers)
+    if (subscriber.used.load() && subscriber.callback == callback && subscriber.batchCallback == batchCallback)
+      return &subscriber;
+  return nullptr;
+}
+
+void RingBusTask::wakeSubscriber(void *arg)
+{
+  Subscriber *subscriber = static_cast<Subscriber *>(arg);
+  xTaskNotifyGive(subscriber->handle);
+}
+
+// Event pushing helper functions
+
+bool RingBusTask::staticPushCallback(const Event &event)
+{
+  if (instance == nullptr)
+    return false;
+  // The ring never refuses an event, one nobody takes is released there
+  instance->ring.publish(event);
+  return true;
+}
+
+void RingBusTask::staticChangeCallback(EventType type)
+{
+  if (instance != nullptr && instance->supervisorHandle != nullptr)
+    xTaskNotifyGive(instance->supervisorHandle);
+}
+
+void RingBusTask::setOverflowPolicy(EventRing::OverflowPolicy policy)
+{
+  this->policy = policy;
+}
+
+EventRing::SubscriberStats RingBusTask::getStats(EventRegistry::EventCallback callback) const
+{
+  const Subscriber *subscriber = findSubscriber(callback, nullptr);
+  return subscriber != nullptr ? ring.getStats(subscriber->id.load()) : EventRing::SubscriberStats{};
+}
+
+EventRing::SubscriberStats RingBusTask::getStats(EventRegistry::BatchCallback callback) const
+{
+  const Subscriber *subscriber = findSubscriber(nullptr, callback);
+  return subscriber != nullptr ? ring.getStats(subscriber->id.load()) : EventRing::SubscriberStats{};
+}
+
+// Task lifecycle methods
+
+void RingBusTask::start(TaskParameters params)
+{
+  log.setMode(Logger::LogMode::Global);
+
+  log.info("Starting RingBusTask with stack size %u, priority %d, core affinity %d",
+           params.stackSize, params.priority, params.coreAffinity);
+  if (supervisorHandle != nullptr)
+  {
+    log.warn("RingBusTask already running");
+    return;
+  }
+  subscriberParams = params;
+  stopping.store(false);
+  supervisorRunning.store(true);
+  BaseType_t result = xTaskCreatePinnedToCore(
+      RingBusTask::supervisorEntry, RingBusTask::NAMESPACE, params.stackSize, this,
+      params.priority, &supervisorHandle, params.coreAffinity);
+
+  if (result != pdPASS)
+  {
+    supervisorRunning.store(false);
+    supervisorHandle = nullptr;
+    log.error("Failed to create RingBusTask");
+    return;
+  }
+  EventRegistry::registerChangeCallback(staticChangeCallback);
+  EventRegistry::registerPushCallback(staticPushCallback);
+  // Pick up the handlers registered before the start
+  xTaskNotifyGive(supervisorHandle);
+}
+
+void RingBusTask::stop()
+{
+  log.info("Stopping RingBusTask");
+  if (supervisorHandle == nullptr)
+  {
+    log.info("Stop called but RingBusTask is not running");
+    return;
+  }
+  EventRegistry::clearPushCallback();
+  EventRegistry::registerChangeCallback(nullptr);
+
+  stopping.store(true);
+  xTaskNotifyGive(supervisorHandle);
+  while (supervisorRunning.load())
+    vTaskDelay(1);
+  supervisorHandle = nullptr;
+
+  for (Subscriber &subscriber : subscribers)
+  {
+    if (subscriber.handle == nullptr)
+      continue;
+    subscriber.handle = nullptr;
+
+    // Events nobody will dispatch anymore
+    ring.unsubscribe(subscriber.id.exchange(-1));
+    subscriber.retiring.store(false);
+    subscriber.used.store(false);
+  }
+}
+
+void RingBusTask::restart(TaskParameters params)
+{
+  log.info("Restarting RingBusTask");
+  if (supervisorHandle != nullptr)
+    stop();
+  start(params);
+}
@@ -0,0 +1,112 @@
+#ifndef RINGBUSTASK_H
+#define RINGBUSTASK_H
+
+#include <atomic>
+#include <interfaces/ITask.h>
+#include <submodules/EventRegistry.h>
+#include <submodules/EventRing.h>
+
+/**
+ * @brief Event bus backend running every handler on its own task.
+ *
+ * Pushed events are written once into an EventRing. Every distinct callback
+ * registered in the EventRegistry, per-event or batch, gets a subscriber
+ * task with its own cursor over the ring, so a slow handler only falls
+ * behind itself and skips events by its overflow policy instead of holding
+ * up the others. A supervisor task follows registrations and starts, retypes
+ * or retires subscriber tasks to match.
+ *
+ * Handlers see the same contract as on EventBusTask: they borrow the events,
+ * batch handlers get runs of one type, and a handler that keeps an event
+ * shares it. They no longer run one after the other, so handlers that
+ * depend on each other's order must stay on EventBusTask.
+ */
+class RingBusTask : public ITask
+{
+public:
+  static constexpr const char *NAMESPACE = "RingBusTask";
+
+  static constexpr size_t RING_CAPACITY = 64;
+  // Most events handed to a handler in one batch
+  static constexpr size_t MAX_BATCH_SIZE = 16;
+  // Most events a subscriber handles per wakeup before yielding
+  static constexpr size_t MAX_DRAIN_EVENTS = 64;
+
+  RingBusTask();
+  ~RingBusTask();
+
+  void start(TaskParameters params) override;
+  void stop() override;
+  void restart(TaskParameters params) override;
+
+  /**
+   * @brief Set the overflow policy of subscribers started from now on.
+   * @param policy What a subscriber skips when it falls a full ring behind.
+   */
+  void setOverflowPolicy(EventRing::OverflowPolicy policy);
+
+  /**
+   * @brief Gets the counters of the subscriber running a handler.
+   * @param callback The per-event handler.
+   * @return Snapshot of the counters, all zero if it has no subscriber.
+   */
+  EventRing::SubscriberStats getStats(EventRegistry::EventCallback callback) const;
+
+  /**
+   * @brief Gets the counters of the subscriber running a batch handler.
+   * @param callback The batch handler.
+   * @return Snapshot of the counters, all zero if it has no subscriber.
+   */
+  EventRing::SubscriberStats getStats(EventRegistry::BatchCallback callback) const;
+
+private:
+  // Subscriber tasks outlive their handlers and wait for the next one, a
+  // producer may still be about to wake them
+  struct Subscriber
+  {
+    RingBusTask *owner = nullptr;
+    EventRegistry::EventCallback callback = nullptr;
+    EventRegistry::BatchCallback batchCallback = nullptr;
+    uint32_t typeMask = 0;
+    TaskHandle_t handle = nullptr;
+    // Ring subscriber id, -1 while the task has no handler
+    std::atomic<int> id{-1};
+    // Set by the supervisor, the task unsubscribes and goes idle
+    std::atomic<bool> retiring{false};
+    // Runs a handler, cleared by the task once it went idle
+    std::atomic<bool> used{false};
+    // Events taken from the ring, kept off the task stack
+    Event events[MAX_BATCH_SIZE];
+  };
+
+  EventRing ring{RING_CAPACITY};
+  Subscriber subscribers[EventRing::MAX_SUBSCRIBERS];
+  EventRing::OverflowPolicy policy = EventRing::OverflowPolicy::DropOldest;
+  TaskParameters subscriberParams{};
+  TaskHandle_t supervisorHandle = nullptr;
+  // Set to stop the tasks. The supervisor stops the subscribers, which
+  // finish the batch in hand, then deletes itself and clears running.
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> supervisorRunning{false};
+  std::atomic<uint8_t> subscribersRunning{0};
+  static RingBusTask *instance;
+
+  static void supervisorEntry(void *param);
+  static void subscriberEntry(void *param);
+  static void wakeSubscriber(void *arg);
+
+  static bool staticPushCallback(const Event &event);
+  static void staticChangeCallback(EventType type);
+
+  // Match the subscriber tasks to the handlers in the EventRegistry
+  void reconcile();
+  // Stop every subscriber task and wait for them, on the supervisor
+  void stopSubscribers();
+  bool startSubscriber(EventRegistry::EventCallback callback, EventRegistry::BatchCallback batchCallback,
+                       uint32_t typeMask);
+  const Subscriber *findSubscriber(EventRegistry::EventCallback callback,
+                                   EventRegistry::BatchCallback batchCallback) const;
+  static void deliver(Subscriber &subscriber, Event *events, size_t count);
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <modules/SlaveTask.h>
 #include <submodules/Logger.h>
+#include <esp_timer.h>
 
 static Logger log(SlaveTask::NAMESPACE);
 
@@ -26,9 +27,15 @@ void SlaveTask::taskEntry(void *arg)
 {
   SlaveTask *task = static_cast<SlaveTask *>(arg);
 
-  EventRegistry::registerHandler(EventType::RawKey, eventBusCallback);
-  EventRegistry::registerHandler(EventType::RawBitmap, eventBusCallback);
-  log.debug("Registered EventBus callbacks");
+  // Key events come through the fast path, or the bus if it is off or has no
+  // free consumer slot
+  if (task->useKeyFastPath)
+    task->fastPathConsumer = KeyFastPath::attach(wakeTask, task);
+  if (task->fastPathConsumer < 0)
+    EventRegistry::registerBatchHandler(EventType::RawKey, keyBatchCallback);
+  RawBitmapChannel::subscribe<bitmapCallback>();
+  log.debug("Registered EventBus callbacks, key events through the %s",
+            task->fastPathConsumer < 0 ? "event bus" : "fast path");
 
   task->protocol->onPairingConfirmation(pairConfirmCallback);
   task->protocol->onConfigReceived(configReceiveCallback);
@@ -48,40 +55,52 @@ void SlaveTask::taskEntry(void *arg)
       continue;
     }
 
-    // If connected, process key events from the queue
-    // Wait for key events with a timeout of 1.5 seconds to allow periodic
-    // connection checks and potential reconnections
-    Event event;
-    if (xQueueReceive(task->localQueue, &event, pdMS_TO_TICKS(1500)))
+    // If connected, wait for key events and queued events, both notify the
+    // task. Time out after 1.5 seconds to allow periodic connection checks and
+    // potential reconnections
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1500));
+
+    // Key transitions straight from the scan loops go out first. The fast
+    // path hands them over where the bus would have, busUs marks that.
+    RawKeyEvent keys[FAST_PATH_BATCH];
+    size_t keyCount;
+    while ((keyCount = KeyFastPath::poll(task->fastPathConsumer, keys, FAST_PATH_BATCH)) > 0)
     {
-      // Process KeyEvent
-      if (event.type == EventType::RawKey)
+      uint32_t busUs = static_cast<uint32_t>(esp_timer_get_time());
+      for (size_t i = 0; i < keyCount; i++)
       {
-        task->protocol->sendKeyEvent(event.rawKeyEvt);
-        log.debug("Sent key event to master");
+        keys[i].timestamps.busUs = busUs;
+        task->sendKeyEvent(keys[i]);
       }
+    }
+
+    Event received;
+    while (xQueueReceive(task->localQueue, &received, 0))
+    {
+      // Released once sent
+      EventRef event = EventRef::adopt(received);
+
+      // Process KeyEvent
+      if (event->type == EventType::RawKey)
+        task->sendKeyEvent(event->rawKeyEvt);
 
       // Process BitMapEvent
-      if (event.type == EventType::RawBitmap)
+      if (event->type == EventType::RawBitmap)
       {
-        task->protocol->sendBitmapEvent(event.rawBitmapEvt);
+        task->protocol->sendBitmapEvent(event->rawBitmapEvt);
         log.debug("Sent bitmap event to master");
       }
-
-      // Clean up event resources
-      if (event.cleanup)
-      {
-        event.cleanup(&event);
-        log.debug("Cleaned up event resources");
-      }
-      else
-      {
-        log.debug("No cleanup function for event");
-      }
     }
   }
 }
 
+void SlaveTask::sendKeyEvent(RawKeyEvent keyEvent)
+{
+  keyEvent.timestamps.txUs = static_cast<uint32_t>(esp_timer_get_time());
+  protocol->sendKeyEvent(keyEvent);
+  log.debug("Sent key event to master");
+}
+
 void SlaveTask::start(TaskParameters params)
 {
   log.setMode(Logger::LogMode::Global);
@@ -104,13 +123,15 @@ void SlaveTask::start(TaskParameters params)
 
   protocol = new TransportProtocol(*transportRef);
 
+  TaskHandle_t handle = nullptr;
   BaseType_t result = xTaskCreatePinnedToCore(
       taskEntry, SlaveTask::NAMESPACE, params.stackSize, this,
-      params.priority, &slaveTaskHandle, params.coreAffinity);
+      params.priority, &handle, params.coreAffinity);
 
-  if (result != pdPASS)
+  if (result == pdPASS)
+    slaveTaskHandle = handle;
+  else
   {
-    slaveTaskHandle = nullptr;
     log.error("Failed to create SlaveTask!");
     delete (protocol);
     protocol = nullptr;
@@ -126,6 +147,13 @@ void SlaveTask::stop()
     return;
   }
 
+  // Waits until no scan loop is inside push or flush on our slot
+  KeyFastPath::detach(fastPathConsumer);
+  fastPathConsumer = -1;
+
+  TaskHandle_t handle = slaveTaskHandle.exchange(nullptr);
+  vTaskDelete(handle);
+
   if (localQueue)
     vQueueDelete(localQueue);
   localQueue = nullptr;
@@ -133,9 +161,6 @@ void SlaveTask::stop()
   if (protocol)
     delete protocol;
   protocol = nullptr;
-
-  vTaskDelete(slaveTaskHandle);
-  slaveTaskHandle = nullptr;
 }
 
 void SlaveTask::restart(TaskParameters params)
@@ -146,19 +171,57 @@ void SlaveTask::restart(TaskParameters params)
   start(params);
 }
 
-void SlaveTask::eventBusCallback(const Event &evt)
+void SlaveTask::setKeyFastPath(bool enabled)
 {
-  if (SlaveTask::instance == nullptr)
+  useKeyFastPath = enabled;
+}
+
+void SlaveTask::wakeTask(void *arg)
+{
+  TaskHandle_t handle = static_cast<SlaveTask *>(arg)->slaveTaskHandle.load();
+  if (handle != nullptr)
+    xTaskNotifyGive(handle);
+}
+
+void SlaveTask::enqueue(EventRef event)
+{
+  if (xQueueSend(SlaveTask::instance->localQueue, &event.get(), pdMS_TO_TICKS(10)) == pdTRUE)
+  {
+    event.release();
+    wakeTask(SlaveTask::instance);
+  }
+}
+
+void SlaveTask::bitmapCallback(const RawBitmapEvent &bitmap)
+{
+  if (SlaveTask::instance == nullptr || SlaveTask::instance->localQueue == nullptr)
+  {
+    log.error("SlaveTask not ready in bitmapCallback");
+    return;
+  }
+
+  // The bus releases its reference after dispatch, the queue keeps its own
+  enqueue(RawBitmapChannel::share(bitmap));
+  log.debug("Bitmap event pushed to SlaveTask queue");
+}
+
+void SlaveTask::keyBatchCallback(const Event *events, size_t count)
+{
+  if (SlaveTask::instance == nullptr || SlaveTask::instance->localQueue == nullptr)
   {
-    log.error("SlaveTask instance is null in eventBusCallback");
+    log.error("SlaveTask not ready in keyBatchCallback");
     return;
   }
 
-  if (SlaveTask::instance->localQueue != nullptr)
+  // The whole burst left the bus at once
+  uint32_t busUs = static_cast<uint32_t>(esp_timer_get_time());
+  for (size_t i = 0; i < count; i++)
   {
-    xQueueSend(SlaveTask::instance->localQueue, &evt, pdMS_TO_TICKS(10));
-    log.debug("Event pushed to SlaveTask queue");
+    RawKeyEvent stamped = RawKeyChannel::payload(events[i]);
+    stamped.timestamps.busUs = busUs;
+    enqueue(RawKeyChannel::share(stamped));
   }
+  log.debug("Pushed %u key events to SlaveTask queue", count);
 }
 
 void SlaveTask::pairConfirmCallback(uint8_t sourceId)
@@ -4,13 +4,18 @@
 #include <interfaces/ITask.h>
 #include <interfaces/ITransport.h>
 #include <submodules/TransportProtocol.h>
+#include <submodules/EventChannel.h>
 #include <submodules/EventRegistry.h>
+#include <submodules/KeyFastPath.h>
 #include <queue.h>
+#include <atomic>
 
 class SlaveTask : public ITask
 {
 public:
     static constexpr const char *NAMESPACE = "SlaveTask";
+    // Key events taken from the fast path at a time
+    static constexpr size_t FAST_PATH_BATCH = 8;
 
     SlaveTask(ITransport &transport, ConfigManager *config);
     ~SlaveTask();
@@ -18,8 +23,16 @@ public:
     void stop() override;
     void restart(TaskParameters params) override;
 
+    /**
+     * @brief Take key events through KeyFastPath instead of the event bus.
+     * Applies from the next start, on by default.
+     * @param enabled True for the fast path, false for the bus.
+     */
+    void setKeyFastPath(bool enabled);
+
 private:
-    TaskHandle_t slaveTaskHandle = nullptr;
+    // Read by wakeTask() from scan loops and bus tasks on either core
+    std::atomic<TaskHandle_t> slaveTaskHandle{nullptr};
     QueueHandle_t localQueue = nullptr;
     ITransport *transportRef = nullptr;
     TransportProtocol *protocol = nullptr;
@@ -27,9 +40,17 @@ private:
     static SlaveTask *instance;
 
     bool connected = false;
+    bool useKeyFastPath = true;
+    // KeyFastPath consumer slot, -1 while key events come from the bus
+    int fastPathConsumer = -1;
 
     static void taskEntry(void *arg);
-    static void eventBusCallback(const Event &evt);
+    static void bitmapCallback(const RawBitmapEvent &bitmap);
+    // Queue a shared event, its reference is released if the queue is full
+    static void enqueue(EventRef event);
+    static void wakeTask(void *arg);
+    void sendKeyEvent(RawKeyEvent keyEvent);
+    static void keyBatchCallback(const Event *events, size_t count);
     static void pairConfirmCallback(uint8_t sourceId);
     static void configReceiveCallback(ConfigManager *config, uint8_t senderId);
     static void configRequestCallback(uint8_t senderId);
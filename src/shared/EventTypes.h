@@ -1,6 +1,7 @@
 #ifndef EVENTTYPES_H
 #define EVENTTYPES_H
 #include <cstdlib>
+#include <cstring>
 #include <stdint.h>
 
 enum class EventType : uint8_t
@@ -9,25 +10,114 @@ enum class EventType : uint8_t
   RawBitmap,
   HidBitmap,
   ConfigUpdate,
+  ScanStats,
+  BusStats,
   COUNT
 };
 
+// Microsecond timestamps of a key transition at each stage on its way to the
+// HID report. Scan, bus and tx are taken on the clock of the scanning device,
+// rx on the clock of the receiving one. They wrap after about 71 minutes, stage
+// latencies are unsigned differences and survive the wrap.
+struct KeyEventTimestamps
+{
+  uint32_t scanUs; // Start of the scan that detected the transition
+  uint32_t busUs;  // Event bus delivered the event to the transport task
+  uint32_t txUs;   // Event handed to the transport
+  uint32_t rxUs;   // Event received from the transport
+};
+
 struct RawKeyEvent
 {
   uint16_t keyIndex;
   bool state;
+  uint32_t scanSequence; // Scan that detected the transition
+  KeyEventTimestamps timestamps;
 };
 
-struct RawBitmapEvent
+// Drop a reference to a payload, the last one returns it to the pool of its
+// event type, see submodules/PayloadPool.h
+void releaseEventPayload(EventType type, void *payload);
+// Take another reference to a payload so one more holder can share it
+void retainEventPayload(EventType type, void *payload);
+// Take a payload block of an event type, nullptr if its pool refused
+void *allocateEventPayload(EventType type, size_t size);
+
+// Bitmaps up to this many bytes travel inside the event, 256 keys. HidMapper
+// bitmaps always fit.
+static constexpr uint16_t INLINE_BITMAP_SIZE = 32;
+
+// Bitmap stored inline when it fits, larger ones spill to a payload block the
+// event owns. Events are copied by value through the queues, so the data is
+// always reached through data(), never through a stored pointer.
+struct BitmapPayload
+{
+  uint16_t bitmapSize;
+  union
+  {
+    uint8_t inlineData[INLINE_BITMAP_SIZE];
+    uint8_t *spilledData;
+  };
+
+  bool isInline() const { return bitmapSize <= INLINE_BITMAP_SIZE; }
+  uint8_t *data() { return isInline() ? inlineData : spilledData; }
+  const uint8_t *data() const { return isInline() ? inlineData : spilledData; }
+
+  // Copy a bitmap in, false if it had to spill and the pool of type refused
+  bool assign(EventType type, const uint8_t *bitmap, uint16_t size)
+  {
+    bitmapSize = size;
+    if (!isInline())
+    {
+      spilledData = static_cast<uint8_t *>(allocateEventPayload(type, size));
+      if (spilledData == nullptr)
+      {
+        bitmapSize = 0;
+        return false;
+      }
+    }
+    memcpy(data(), bitmap, size);
+    return true;
+  }
+
+  // Share a spilled bitmap with one more holder, inline ones are copied
+  void retain(EventType type) const
+  {
+    if (!isInline())
+      retainEventPayload(type, spilledData);
+  }
+
+  // Drop the reference to a spilled bitmap, inline ones need nothing
+  void release(EventType type)
+  {
+    if (!isInline())
+      releaseEventPayload(type, spilledData);
+    bitmapSize = 0;
+  }
+};
+
+struct RawBitmapEvent : BitmapPayload
 {
-  uint8_t bitmapSize;
-  uint8_t *bitMapData;
 };
 
-struct HidBitmapEvent
+struct HidBitmapEvent : BitmapPayload
 {
-  uint8_t bitmapSize;
-  uint8_t *bitMapData;
+  uint32_t scanSequence;         // Scan of the key event that changed the bitmap, 0 for bitmap updates
+  KeyEventTimestamps timestamps; // Timestamps of that key event
+};
+
+struct ScanTimingSnapshot;
+
+struct ScanStatsEvent
+{
+  ScanTimingSnapshot *stats; // Pool copy, see submodules/ScanTimingStats.h
+};
+
+struct EventBusSnapshot;
+
+struct BusStatsEvent
+{
+  EventBusSnapshot *stats; // Pool copy, see submodules/EventBusStats.h
 };
 
 struct Event
@@ -41,11 +131,17 @@ struct Event
     RawKeyEvent rawKeyEvt;
     RawBitmapEvent rawBitmapEvt;
     HidBitmapEvent hidBitmapEvt;
+    ScanStatsEvent scanStatsEvt;
+    BusStatsEvent busStatsEvt;
   };
+
+  uint32_t enqueuedUs; // Set by the event bus on push, for its dispatch latency
 };
 
 inline void cleanupRawKeyEvent(Event *event) { return; }
-inline void cleanupRawBitmapEvent(Event *event) { free(event->rawBitmapEvt.bitMapData); }
-inline void cleanupHidBitmapEvent(Event *event) { free(event->hidBitmapEvt.bitMapData); }
+inline void cleanupRawBitmapEvent(Event *event) { event->rawBitmapEvt.release(EventType::RawBitmap); }
+inline void cleanupHidBitmapEvent(Event *event) { event->hidBitmapEvt.release(EventType::HidBitmap); }
+inline void cleanupScanStatsEvent(Event *event) { releaseEventPayload(EventType::ScanStats, event->scanStatsEvt.stats); }
+inline void cleanupBusStatsEvent(Event *event) { releaseEventPayload(EventType::BusStats, event->busStatsEvt.stats); }
 
 #endif
\ No newline at end of file
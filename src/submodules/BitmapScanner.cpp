@@ -0,0 +1,74 @@
+#include <submodules/BitmapScanner.h>
+#include <algorithm>
+
+BitmapScanner::BitmapScanner(size_t keyCount)
+    : bitmapSize((keyCount + 7) / 8), bitmapWords((keyCount + 31) / 32),
+      pipeline(keyCount)
+{
+  // Initialize double buffers and size them appropriately
+  keyMapSwapBufferA.resize(bitmapWords);
+  keyMapSwapBufferB.resize(bitmapWords);
+
+  // Set initial buffer pointers
+  workingBuffer = keyMapSwapBufferA.data();
+  publishedBuffer = keyMapSwapBufferB.data();
+}
+
+size_t BitmapScanner::updateKeyState()
+{
+  return scan(false);
+}
+
+size_t BitmapScanner::updateHeldKeyState()
+{
+  return scan(true);
+}
+
+size_t BitmapScanner::scan(bool heldOnly)
+{
+  if (idle)
+    exitIdle();
+
+  // Clear the working buffer for fresh scan
+  memset(workingBuffer, 0, bitmapWords * sizeof(uint32_t));
+
+  if (heldOnly)
+    sampleHeldKeys();
+  else
+    sampleKeys();
+
+  return pipeline.finish(workingBuffer, publishedBuffer);
+}
+
+bool BitmapScanner::hasPressedKeys() const
+{
+  for (size_t word = 0; word < bitmapWords; word++)
+  {
+    if (publishedBuffer[word] != 0)
+      return true;
+  }
+  return false;
+}
+
+void BitmapScanner::swapBuffers()
+{
+  // Swap the working and published buffer pointers
+  std::swap(workingBuffer, publishedBuffer);
+}
+
+void BitmapScanner::publishBuffer()
+{
+  // Hand the published buffer to readers on other tasks
+  pipeline.publish(publishedBuffer);
+}
+
+void BitmapScanner::mergeRowBits(uint16_t bitIndex, uint32_t bits, uint8_t bitCount)
+{
+  // OR a run of up to 32 key bits into the working buffer, splitting it across
+  // two words when it straddles a word boundary
+  size_t word = bitIndex / 32;
+  uint8_t shift = bitIndex % 32;
+  workingBuffer[word] |= bits << shift;
+  if (shift != 0 && shift + bitCount > 32)
+    workingBuffer[word + 1] |= bits >> (32 - shift);
+}
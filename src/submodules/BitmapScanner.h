@@ -0,0 +1,187 @@
+#ifndef BITMAPSCANNER_H
+#define BITMAPSCANNER_H
+
+#include <cstdint>
+#include <cstring>
+#include <interfaces/IKeyScanner.h>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <submodules/ScanPipeline.h>
+#include <vector>
+
+/**
+ * @brief Common part of all scanner engines.
+ *
+ * Owns the double buffered key bitmap and runs the ScanPipeline over it,
+ * which debounces, reports and publishes each scan. An engine only implements sampleKeys(), which ORs the raw key
+ * samples of one scan into the cleared working buffer, and the idle handling
+ * if its wiring allows waking on a key press.
+ */
+class BitmapScanner : public IKeyScanner
+{
+public:
+  /**
+   * @brief Registers a callback function to be invoked on key state changes.
+   * @param callback The callback function taking keyIndex and pressed state.
+   */
+  void registerOnKeyChangeCallback(const KeyChangeCallback &callback) override
+  {
+    pipeline.registerOnKeyChangeCallback(callback);
+  }
+
+  /**
+   * @brief Clears the registered key change callback.
+   */
+  void clearOnKeyChangeCallback() override { pipeline.clearOnKeyChangeCallback(); }
+
+  /**
+   * @brief Registers a callback receiving all key changes of a scan in one
+   * call. It is only invoked for scans that changed at least one key.
+   * @param callback The callback function taking the changes, their count and
+   * the sequence number of the scan.
+   */
+  void registerOnKeyChangeBatchCallback(const KeyChangeBatchCallback &callback) override
+  {
+    pipeline.registerOnKeyChangeBatchCallback(callback);
+  }
+
+  /**
+   * @brief Clears the registered batch key change callback.
+   */
+  void clearOnKeyChangeBatchCallback() override { pipeline.clearOnKeyChangeBatchCallback(); }
+
+  /**
+   * @brief Gets the sequence number of the last completed scan.
+   * @return Number of scans since construction.
+   */
+  uint32_t getScanSequence() const override { return pipeline.getScanSequence(); }
+
+  /**
+   * @brief Configures the debounce filter applied to every scan.
+   * @param mode Debounce mode, see KeyScannerConfig::DebounceMode.
+   * @param windowScans Debounce window in scans, 0 or 1 disables filtering.
+   */
+  void setDebounce(KeyScannerConfig::DebounceMode mode, uint8_t windowScans) override
+  {
+    pipeline.setDebounce(mode, windowScans);
+  }
+
+  /**
+   * @brief Copies the published key state bitmap to the provided destination
+   * buffer. Safe to call from any task while the scanner runs, the copy is
+   * always the complete state of one scan.
+   * @param dest Pointer to the destination buffer.
+   * @param destSize Size of the destination buffer in bytes.
+   * @return Version of the copied bitmap, see getPublishedVersion().
+   */
+  uint32_t copyPublishedBitmap(uint8_t *dest, size_t destSize) const override
+  {
+    return pipeline.copyPublishedBitmap(dest, destSize);
+  }
+
+  /**
+   * @brief Gets the version of the published bitmap, incremented on every scan
+   * that changed a key. Safe to call from any task.
+   * @return Number of bitmap changes since construction.
+   */
+  uint32_t getPublishedVersion() const override { return pipeline.getPublishedVersion(); }
+
+  /**
+   * @brief Gets the size of the key state bitmap in bytes.
+   * @return Size of the bitmap in bytes.
+   */
+  const size_t getBitMapSize() const override { return bitmapSize; }
+
+  /**
+   * @brief Checks whether any key is pressed in the published state.
+   * @return True if at least one key is held.
+   */
+  bool hasPressedKeys() const override;
+
+  /**
+   * @brief Engines without a way to detect a press between scans never idle.
+   * @return Always false.
+   */
+  bool enterIdle(PinInterruptHandler wakeHandler, void *arg) override { return false; }
+
+  /**
+   * @brief Leaves idle, nothing to do for engines that never idle.
+   */
+  void exitIdle() override { idle = false; }
+
+  /**
+   * @brief Checks whether the scanner is waiting for a wake interrupt.
+   * @return True between enterIdle() and exitIdle().
+   */
+  bool isIdle() const override { return idle; }
+
+  /**
+   * @brief Scans all keys and updates key states.
+   *
+   * This method should be called periodically to detect key state changes.
+   * @return Number of keys that changed state in this scan.
+   */
+  size_t updateKeyState() override;
+
+  /**
+   * @brief Rescans only the drive lines that have held keys, see
+   * sampleHeldKeys().
+   * @return Number of keys that changed state in this scan.
+   */
+  size_t updateHeldKeyState() override;
+
+  /**
+   * @brief Checks whether the last scan sampled any key different from its
+   * debounced state, including bounces the debouncer held back.
+   * @return True if keys were changing during the last scan.
+   */
+  bool sawKeyActivity() const override { return pipeline.sawKeyActivity(); }
+
+protected:
+  /**
+   * @brief Constructor for BitmapScanner.
+   * @param keyCount Number of keys, the bitmap holds one bit per key.
+   */
+  BitmapScanner(size_t keyCount);
+
+  // Buffer pointers refer to the object's own vectors
+  BitmapScanner(const BitmapScanner &) = delete;
+  BitmapScanner &operator=(const BitmapScanner &) = delete;
+
+  // OR the raw samples of one scan into workingBuffer, which is cleared
+  virtual void sampleKeys() = 0;
+
+  // Like sampleKeys(), but only needs to sample lines with held keys and fill
+  // in the published state for the rest. Engines without separate lines
+  // sample everything.
+  virtual void sampleHeldKeys() { sampleKeys(); }
+
+  // Size of the bitmap representing key states in bytes and in 32-bit words.
+  size_t bitmapSize;
+  size_t bitmapWords;
+
+  // True while the engine waits for a wake interrupt.
+  bool idle = false;
+
+  // Buffers for storing key states. Used for double buffering to avoid
+  // read/write conflicts. Stored as 32-bit words so rows can be merged a word
+  // at a time; the byte view (little endian) is the published bitmap layout.
+  std::vector<uint32_t> keyMapSwapBufferA;
+  std::vector<uint32_t> keyMapSwapBufferB;
+
+  // Pointers to the current working and published buffers. Both are only
+  // touched by the scanning task.
+  uint32_t *workingBuffer;
+  uint32_t *publishedBuffer;
+
+  void swapBuffers();
+  void publishBuffer();
+  void mergeRowBits(uint16_t bitIndex, uint32_t bits, uint8_t bitCount);
+
+private:
+  // Debounces, reports and publishes each scan.
+  ScanPipeline pipeline;
+
+  size_t scan(bool heldOnly);
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <submodules/Config/KeyScannerConfig.h>
 #include <submodules/Logger.h>
+#include <algorithm>
 
 static Logger log("KeyScannerConfig");
 
@@ -10,7 +11,7 @@ void KeyScannerConfig::setPins(uint8_t *rowPinData, uint8_t rowSize,
   rowCount = rowSize;
   colPins.assign(colPinData, colPinData + colSize);
   colCount = colSize;
-  bitmapSize = (rowCount * colCount + 7) / 8;
+  updateBitmapSize();
 }
 
 void KeyScannerConfig::setRefreshRate(uint16_t rate)
@@ -34,6 +35,169 @@ void KeyScannerConfig::setBitmapSendFrequency(uint16_t frequency)
   bitMapSendRate = frequency;
 }
 
+void KeyScannerConfig::setScanOrder(ScanOrder order)
+{
+  if (order >= ScanOrder::Count)
+  {
+    log.warn("Scan order %d is invalid", static_cast<uint8_t>(order));
+    return;
+  }
+  scanOrder = order;
+}
+
+void KeyScannerConfig::setTopology(ScanTopology topology)
+{
+  if (topology >= ScanTopology::Count)
+  {
+    log.warn("Scan topology %d is invalid", static_cast<uint8_t>(topology));
+    return;
+  }
+  this->topology = topology;
+  updateBitmapSize();
+}
+
+void KeyScannerConfig::setShiftRegisterCount(uint8_t count)
+{
+  shiftRegisterCount = count;
+  updateBitmapSize();
+}
+
+uint16_t KeyScannerConfig::getTopologyKeyCount(ScanTopology topology, size_t rows, size_t cols,
+                                               uint8_t shiftRegisters)
+{
+  switch (topology)
+  {
+  case ScanTopology::DirectPins:
+    return cols;
+  case ScanTopology::ShiftRegister:
+    return shiftRegisters * 8;
+  case ScanTopology::DuplexMatrix:
+    return 2 * rows * cols;
+  default:
+    return rows * cols;
+  }
+}
+
+uint16_t KeyScannerConfig::ScanMatrix::getKeyCount() const
+{
+  return getTopologyKeyCount(topology, rowPins.size(), colPins.size(), shiftRegisterCount);
+}
+
+uint16_t KeyScannerConfig::getMainKeyCount() const
+{
+  return getTopologyKeyCount(topology, rowCount, colCount, shiftRegisterCount);
+}
+
+uint16_t KeyScannerConfig::getKeyOffset(size_t index) const
+{
+  // Ranges start on a byte so every matrix bitmap lands in the shared bitmap
+  // with a plain copy
+  uint16_t offset = 0;
+  uint16_t keyCount = getMainKeyCount();
+  for (size_t i = 0; i < index && i < extraMatrices.size(); i++)
+  {
+    offset += (keyCount + 7) / 8 * 8;
+    keyCount = extraMatrices[i].getKeyCount();
+  }
+  return offset;
+}
+
+uint16_t KeyScannerConfig::getKeyCount() const
+{
+  if (extraMatrices.empty())
+    return getMainKeyCount();
+  return getKeyOffset(extraMatrices.size()) + extraMatrices.back().getKeyCount();
+}
+
+KeyScannerConfig::ScanMatrix KeyScannerConfig::getMatrix(size_t index) const
+{
+  if (index > 0)
+    return index <= extraMatrices.size() ? extraMatrices[index - 1] : ScanMatrix{};
+
+  ScanMatrix mainMatrix;
+  mainMatrix.topology = topology;
+  mainMatrix.scanOrder = scanOrder;
+  mainMatrix.rowPins = rowPins;
+  mainMatrix.colPins = colPins;
+  mainMatrix.shiftRegisterCount = shiftRegisterCount;
+  mainMatrix.ghostFilter = ghostFilter;
+  mainMatrix.refreshRate = refreshRate;
+  return mainMatrix;
+}
+
+bool KeyScannerConfig::isValidMatrix(const ScanMatrix &matrix) const
+{
+  return matrix.topology < ScanTopology::Count && matrix.scanOrder < ScanOrder::Count &&
+         matrix.rowPins.size() <= MAX_PIN_COUNT && matrix.colPins.size() <= MAX_PIN_COUNT &&
+         matrix.refreshRate >= MIN_REFRESH_RATE && matrix.refreshRate <= MAX_REFRESH_RATE &&
+         matrix.getKeyCount() > 0;
+}
+
+void KeyScannerConfig::addMatrix(const ScanMatrix &matrix)
+{
+  if (getMatrixCount() >= MAX_MATRIX_COUNT)
+  {
+    log.warn("Cannot add more than %d matrices", MAX_MATRIX_COUNT);
+    return;
+  }
+  if (!isValidMatrix(matrix))
+  {
+    log.warn("Matrix with topology %d, %zu row and %zu column pins at %d Hz is invalid",
+             static_cast<uint8_t>(matrix.topology), matrix.rowPins.size(),
+             matrix.colPins.size(), matrix.refreshRate);
+    return;
+  }
+  extraMatrices.push_back(matrix);
+  if (getKeyCount() > MAX_KEY_COUNT)
+  {
+    log.warn("Matrix would grow the key space beyond %d keys", MAX_KEY_COUNT);
+    extraMatrices.pop_back();
+    return;
+  }
+  updateBitmapSize();
+}
+
+void KeyScannerConfig::clearExtraMatrices()
+{
+  extraMatrices.clear();
+  updateBitmapSize();
+}
+
+size_t KeyScannerConfig::getMapTailSize() const
+{
+  size_t keyCount = getMainKeyCount();
+  return keyCount > getLegacyMapSize() ? keyCount - getLegacyMapSize() : 0;
+}
+
+void KeyScannerConfig::setDebounce(DebounceMode mode, uint8_t timeMs)
+{
+  if (mode >= DebounceMode::Count || timeMs > MAX_DEBOUNCE_TIME)
+  {
+    log.warn("Debounce mode %d with %d ms is invalid (max %d ms)",
+             static_cast<uint8_t>(mode), timeMs, MAX_DEBOUNCE_TIME);
+    return;
+  }
+  debounceMode = mode;
+  debounceTime = timeMs;
+}
+
+void KeyScannerConfig::setAdaptiveScan(uint16_t idleRate, uint16_t holdOffMs,
+                                       uint16_t heldKeyRate)
+{
+  bool idleValid = idleRate == 0 || (idleRate >= MIN_REFRESH_RATE && idleRate <= MAX_REFRESH_RATE);
+  bool heldValid = heldKeyRate == 0 ||
+                   (heldKeyRate >= MIN_REFRESH_RATE && heldKeyRate <= MAX_REFRESH_RATE);
+  if (!idleValid || !heldValid || holdOffMs > MAX_BOOST_HOLD_OFF_TIME)
+  {
+    log.warn("Adaptive scan with idle rate %d Hz, hold-off %d ms and held key rate %d Hz is invalid",
+             idleRate, holdOffMs, heldKeyRate);
+    return;
+  }
+  idleRefreshRate = idleRate;
+  boostHoldOffTime = holdOffMs;
+  heldKeyRefreshRate = heldKeyRate;
+}
+
 void KeyScannerConfig::setLocalToHidMap(uint8_t *mapData, size_t mapSize)
 {
   if (mapSize > MAX_KEY_COUNT)
@@ -44,7 +208,7 @@ void KeyScannerConfig::setLocalToHidMap(uint8_t *mapData, size_t mapSize)
   localToHidMap.assign(mapData, mapData + mapSize);
 }
 
-void KeyScannerConfig::updateHIDCodeForIndex(uint8_t localKeyIndex, uint8_t hidCode)
+void KeyScannerConfig::updateHIDCodeForIndex(uint16_t localKeyIndex, uint8_t hidCode)
 {
   if (localKeyIndex >= localToHidMap.size())
   {
@@ -162,9 +326,11 @@ size_t KeyScannerConfig::packSerialized(uint8_t *output, size_t size) const
   memcpy(output + totalWrite, &colCount, objSize);
   totalWrite += objSize;
 
-  // Serialize bitmapSize
-  objSize = sizeof(bitmapSize);
-  memcpy(output + totalWrite, &bitmapSize, objSize);
+  // Serialize bitmapSize. The stored field is one byte wide, it is derived
+  // from rowCount and colCount on load and only kept for the layout.
+  uint8_t legacyBitmapSize = static_cast<uint8_t>(std::min<uint16_t>(bitmapSize, UINT8_MAX));
+  objSize = sizeof(legacyBitmapSize);
+  memcpy(output + totalWrite, &legacyBitmapSize, objSize);
   totalWrite += objSize;
 
   // Serialize rowPins
@@ -187,9 +353,112 @@ size_t KeyScannerConfig::packSerialized(uint8_t *output, size_t size) const
   memcpy(output + totalWrite, &bitMapSendRate, objSize);
   totalWrite += objSize;
 
-  // Serialize localToHidMap
-  objSize = rowCount * colCount;
-  memcpy(output + totalWrite, localToHidMap.data(), objSize);
+  // Serialize localToHidMap, one entry per key. A shorter map is padded
+  // with zeroes so the layout always matches rowCount and colCount. Entries
+  // beyond rowCount * colCount follow after the topology fields.
+  objSize = getLegacyMapSize();
+  size_t mapBytes = std::min(objSize, localToHidMap.size());
+  memcpy(output + totalWrite, localToHidMap.data(), mapBytes);
+  memset(output + totalWrite + mapBytes, 0, objSize - mapBytes);
+  totalWrite += objSize;
+
+  // Serialize scanOrder
+  objSize = sizeof(scanOrder);
+  memcpy(output + totalWrite, &scanOrder, objSize);
+  totalWrite += objSize;
+
+  // Serialize debounceMode
+  objSize = sizeof(debounceMode);
+  memcpy(output + totalWrite, &debounceMode, objSize);
+  totalWrite += objSize;
+
+  // Serialize debounceTime
+  objSize = sizeof(debounceTime);
+  memcpy(output + totalWrite, &debounceTime, objSize);
+  totalWrite += objSize;
+
+  // Serialize topology
+  objSize = sizeof(topology);
+  memcpy(output + totalWrite, &topology, objSize);
+  totalWrite += objSize;
+
+  // Serialize shiftRegisterCount
+  objSize = sizeof(shiftRegisterCount);
+  memcpy(output + totalWrite, &shiftRegisterCount, objSize);
+  totalWrite += objSize;
+
+  // Serialize the rest of localToHidMap, padded like the first part
+  objSize = getMapTailSize();
+  size_t mapOffset = getLegacyMapSize();
+  mapBytes = localToHidMap.size() > mapOffset
+                 ? std::min(objSize, localToHidMap.size() - mapOffset)
+                 : 0;
+  memcpy(output + totalWrite, localToHidMap.data() + mapOffset, mapBytes);
+  memset(output + totalWrite + mapBytes, 0, objSize - mapBytes);
+  totalWrite += objSize;
+
+  // Serialize ghostFilter
+  objSize = sizeof(ghostFilter);
+  memcpy(output + totalWrite, &ghostFilter, objSize);
+  totalWrite += objSize;
+
+  // Serialize idleRefreshRate
+  objSize = sizeof(idleRefreshRate);
+  memcpy(output + totalWrite, &idleRefreshRate, objSize);
+  totalWrite += objSize;
+
+  // Serialize boostHoldOffTime
+  objSize = sizeof(boostHoldOffTime);
+  memcpy(output + totalWrite, &boostHoldOffTime, objSize);
+  totalWrite += objSize;
+
+  // Serialize heldKeyRefreshRate
+  objSize = sizeof(heldKeyRefreshRate);
+  memcpy(output + totalWrite, &heldKeyRefreshRate, objSize);
+  totalWrite += objSize;
+
+  // Serialize extraMatrices, count first, then each matrix with its pin
+  // counts ahead of its pins
+  uint8_t extraCount = static_cast<uint8_t>(extraMatrices.size());
+  objSize = sizeof(extraCount);
+  memcpy(output + totalWrite, &extraCount, objSize);
+  totalWrite += objSize;
+  for (const ScanMatrix &matrix : extraMatrices)
+  {
+    const uint8_t header[] = {static_cast<uint8_t>(matrix.topology),
+                              static_cast<uint8_t>(matrix.scanOrder),
+                              static_cast<uint8_t>(matrix.rowPins.size()),
+                              static_cast<uint8_t>(matrix.colPins.size()),
+                              matrix.shiftRegisterCount,
+                              matrix.ghostFilter,
+                              matrix.ownTask,
+                              static_cast<uint8_t>(matrix.coreAffinity)};
+    objSize = sizeof(header);
+    memcpy(output + totalWrite, header, objSize);
+    totalWrite += objSize;
+
+    objSize = sizeof(matrix.refreshRate);
+    memcpy(output + totalWrite, &matrix.refreshRate, objSize);
+    totalWrite += objSize;
+
+    objSize = matrix.rowPins.size();
+    memcpy(output + totalWrite, matrix.rowPins.data(), objSize);
+    totalWrite += objSize;
+
+    objSize = matrix.colPins.size();
+    memcpy(output + totalWrite, matrix.colPins.data(), objSize);
+    totalWrite += objSize;
+  }
+
+  // Serialize the part of localToHidMap of the extra matrices, padded like
+  // the rest
+  objSize = getExtraMapSize();
+  mapOffset = getMainKeyCount();
+  mapBytes = localToHidMap.size() > mapOffset
+                 ? std::min(objSize, localToHidMap.size() - mapOffset)
+                 : 0;
+  memcpy(output + totalWrite, localToHidMap.data() + mapOffset, mapBytes);
+  memset(output + totalWrite + mapBytes, 0, objSize - mapBytes);
   totalWrite += objSize;
 
   return totalWrite;
@@ -212,6 +481,9 @@ size_t KeyScannerConfig::unpackSerialized(const uint8_t *input, size_t size)
     return 0;
   }
 
+  // Only configs that store extra matrices have any
+  extraMatrices.clear();
+
   // Deserialize rowCount
   objSize = sizeof(rowCount);
   memcpy(&rowCount, input + totalRead, objSize);
@@ -222,10 +494,10 @@ size_t KeyScannerConfig::unpackSerialized(const uint8_t *input, size_t size)
   memcpy(&colCount, input + totalRead, objSize);
   totalRead += objSize;
 
-  // Deserialize bitmapSize
-  objSize = sizeof(bitmapSize);
-  memcpy(&bitmapSize, input + totalRead, objSize);
+  // Skip the one byte bitmapSize field, the size is derived from the matrix
+  objSize = sizeof(uint8_t);
   totalRead += objSize;
+  updateBitmapSize();
 
   // Resize vectors BEFORE copying data into them
   rowPins.resize(rowCount);
@@ -255,6 +527,159 @@ size_t KeyScannerConfig::unpackSerialized(const uint8_t *input, size_t size)
   memcpy(localToHidMap.data(), input + totalRead, objSize);
   totalRead += objSize;
 
+  // Fields below were appended later, configs stored before they existed end
+  // here and keep the defaults
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize scanOrder
+  objSize = sizeof(scanOrder);
+  memcpy(&scanOrder, input + totalRead, objSize);
+  totalRead += objSize;
+  if (scanOrder >= ScanOrder::Count)
+    scanOrder = ScanOrder::RowMajor;
+
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize debounceMode
+  objSize = sizeof(debounceMode);
+  memcpy(&debounceMode, input + totalRead, objSize);
+  totalRead += objSize;
+  if (debounceMode >= DebounceMode::Count)
+    debounceMode = DebounceMode::Deferred;
+
+  // Deserialize debounceTime
+  objSize = sizeof(debounceTime);
+  memcpy(&debounceTime, input + totalRead, objSize);
+  totalRead += objSize;
+  if (debounceTime > MAX_DEBOUNCE_TIME)
+    debounceTime = DEFAULT_DEBOUNCE_TIME;
+
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize topology
+  objSize = sizeof(topology);
+  memcpy(&topology, input + totalRead, objSize);
+  totalRead += objSize;
+  if (topology >= ScanTopology::Count)
+    topology = ScanTopology::Matrix;
+
+  // Deserialize shiftRegisterCount
+  objSize = sizeof(shiftRegisterCount);
+  memcpy(&shiftRegisterCount, input + totalRead, objSize);
+  totalRead += objSize;
+  updateBitmapSize();
+
+  // Deserialize the rest of localToHidMap
+  objSize = getMapTailSize();
+  if (totalRead + objSize > ownSize)
+  {
+    log.error("Stored HID map is shorter than the %d keys of the topology", getKeyCount());
+    return totalRead;
+  }
+  localToHidMap.resize(getLegacyMapSize() + objSize);
+  memcpy(localToHidMap.data() + getLegacyMapSize(), input + totalRead, objSize);
+  totalRead += objSize;
+
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize ghostFilter
+  uint8_t storedGhostFilter = 0;
+  objSize = sizeof(storedGhostFilter);
+  memcpy(&storedGhostFilter, input + totalRead, objSize);
+  totalRead += objSize;
+  ghostFilter = (storedGhostFilter == 1);
+
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize idleRefreshRate
+  objSize = sizeof(idleRefreshRate);
+  memcpy(&idleRefreshRate, input + totalRead, objSize);
+  totalRead += objSize;
+  if (idleRefreshRate > MAX_REFRESH_RATE)
+    idleRefreshRate = 0;
+
+  // Deserialize boostHoldOffTime
+  objSize = sizeof(boostHoldOffTime);
+  memcpy(&boostHoldOffTime, input + totalRead, objSize);
+  totalRead += objSize;
+  if (boostHoldOffTime > MAX_BOOST_HOLD_OFF_TIME)
+    boostHoldOffTime = DEFAULT_BOOST_HOLD_OFF_TIME;
+
+  // Deserialize heldKeyRefreshRate
+  objSize = sizeof(heldKeyRefreshRate);
+  memcpy(&heldKeyRefreshRate, input + totalRead, objSize);
+  totalRead += objSize;
+  if (heldKeyRefreshRate > MAX_REFRESH_RATE)
+    heldKeyRefreshRate = 0;
+
+  if (totalRead >= ownSize)
+    return totalRead;
+
+  // Deserialize extraMatrices, a matrix that does not fit the stored size
+  // or is invalid drops it and all following ones
+  uint8_t extraCount = 0;
+  objSize = sizeof(extraCount);
+  memcpy(&extraCount, input + totalRead, objSize);
+  totalRead += objSize;
+  extraMatrices.clear();
+  for (uint8_t i = 0; i < extraCount; i++)
+  {
+    uint8_t header[8];
+    objSize = sizeof(header);
+    if (totalRead + objSize + sizeof(uint16_t) > ownSize)
+      break;
+    memcpy(header, input + totalRead, objSize);
+    totalRead += objSize;
+
+    ScanMatrix matrix;
+    matrix.topology = static_cast<ScanTopology>(header[0]);
+    matrix.scanOrder = static_cast<ScanOrder>(header[1]);
+    matrix.shiftRegisterCount = header[4];
+    matrix.ghostFilter = (header[5] == 1);
+    matrix.ownTask = (header[6] == 1);
+    matrix.coreAffinity = static_cast<int8_t>(header[7]);
+
+    objSize = sizeof(matrix.refreshRate);
+    memcpy(&matrix.refreshRate, input + totalRead, objSize);
+    totalRead += objSize;
+
+    objSize = header[2] + header[3];
+    if (totalRead + objSize > ownSize)
+      break;
+    matrix.rowPins.assign(input + totalRead, input + totalRead + header[2]);
+    matrix.colPins.assign(input + totalRead + header[2], input + totalRead + objSize);
+    totalRead += objSize;
+
+    if (getMatrixCount() >= MAX_MATRIX_COUNT || !isValidMatrix(matrix))
+      break;
+    extraMatrices.push_back(matrix);
+  }
+  if (extraMatrices.size() != extraCount)
+  {
+    log.error("Stored matrix %zu of %d is invalid, dropping it and all after it",
+              extraMatrices.size() + 1, extraCount);
+    extraMatrices.clear();
+    updateBitmapSize();
+    return totalRead;
+  }
+  updateBitmapSize();
+
+  // Deserialize the part of localToHidMap of the extra matrices
+  objSize = getExtraMapSize();
+  if (totalRead + objSize > ownSize)
+  {
+    log.error("Stored HID map is shorter than the %d keys of all matrices", getKeyCount());
+    return totalRead;
+  }
+  localToHidMap.resize(getMainKeyCount() + objSize);
+  memcpy(localToHidMap.data() + getMainKeyCount(), input + totalRead, objSize);
+  totalRead += objSize;
+
   return totalRead;
 }
 
@@ -265,11 +690,25 @@ size_t KeyScannerConfig::getSerializedSize() const
   // rowCount * colCount acts as localToHidMap size metadata
   // First field for total config size information
   return sizeof(size_t) + sizeof(rowCount) + sizeof(colCount) +
-         sizeof(bitmapSize) + rowCount + colCount +
-         sizeof(refreshRate) + sizeof(bitMapSendRate) + localToHidMap.size();
+         sizeof(uint8_t) + rowCount + colCount +
+         sizeof(refreshRate) + sizeof(bitMapSendRate) + rowCount * colCount +
+         sizeof(scanOrder) + sizeof(debounceMode) + sizeof(debounceTime) +
+         sizeof(topology) + sizeof(shiftRegisterCount) + getMapTailSize() +
+         sizeof(ghostFilter) + sizeof(idleRefreshRate) + sizeof(boostHoldOffTime) +
+         sizeof(heldKeyRefreshRate) + sizeof(uint8_t) + getExtraMatricesSize() +
+         getExtraMapSize();
+}
+
+size_t KeyScannerConfig::getExtraMatricesSize() const
+{
+  // Eight one byte fields and the refresh rate per matrix, then its pins
+  size_t size = 0;
+  for (const ScanMatrix &matrix : extraMatrices)
+    size += 8 + sizeof(matrix.refreshRate) + matrix.rowPins.size() + matrix.colPins.size();
+  return size;
 }
 
-uint8_t KeyScannerConfig::getHIDCodeForIndex(uint8_t localKeyIndex) const
+uint8_t KeyScannerConfig::getHIDCodeForIndex(uint16_t localKeyIndex) const
 {
   if (localKeyIndex >= localToHidMap.size())
   {
@@ -18,6 +18,65 @@ using countType = uint8_t;
  */
 class KeyScannerConfig : public IConfig
 {
+public:
+  // Which matrix lines are driven during a scan. Diode matrices only conduct in
+  // one direction, so Auto must only be used on diode-less matrices.
+  enum class ScanOrder : uint8_t
+  {
+    RowMajor,    // Drive rows, sense columns
+    ColumnMajor, // Drive columns, sense rows
+    Auto,        // Drive whichever has fewer lines
+    Count
+  };
+
+  // How the keys are wired, selects the scanner engine. The pin lists are
+  // interpreted per topology:
+  //  Matrix:        rowPins drive, colPins sense, rowCount * colCount keys
+  //  DirectPins:    colPins are the key pins, rowPins are unused
+  //  ShiftRegister: rowPins are load and clock, colPins[0] is the data pin,
+  //                 8 keys per register of the chain
+  //  DuplexMatrix:  like Matrix with two keys per crossing
+  enum class ScanTopology : uint8_t
+  {
+    Matrix,
+    DirectPins,
+    ShiftRegister,
+    DuplexMatrix,
+    Count
+  };
+
+  // How raw samples are filtered before key changes are reported.
+  enum class DebounceMode : uint8_t
+  {
+    None,     // Report every sampled change
+    Eager,    // Report a change immediately, then ignore the key for the window
+    Deferred, // Report a change once the key was stable for the window
+    Count
+  };
+
+  // A further set of keys scanned next to the main matrix, e.g. a macro
+  // cluster on pins of its own. The pins are interpreted per topology like
+  // those of the main matrix. Its keys follow the main matrix in the key
+  // index space, see getKeyOffset().
+  struct ScanMatrix
+  {
+    ScanTopology topology = ScanTopology::Matrix;
+    ScanOrder scanOrder = ScanOrder::RowMajor;
+    pinType rowPins{};
+    pinType colPins{};
+    uint8_t shiftRegisterCount = 0;
+    bool ghostFilter = false;
+    uint16_t refreshRate = 100;
+    bool ownTask = false;      // Scan in a task of its own instead of next to the main matrix
+    int8_t coreAffinity = -1;  // Core of that task, -1 for the core of the main scan task
+
+    /**
+     * @brief Get the number of keys of the matrix.
+     * @return Number of keys of the topology.
+     */
+    uint16_t getKeyCount() const;
+  };
+
 private:
   // Key matrix configuration parameters
   IStorage *storage = nullptr;
@@ -28,22 +87,60 @@ private:
   pinType colPins{};
 
   // Key scanning parameters
-  uint8_t bitmapSize = 0;
+  uint16_t bitmapSize = 0;
   uint16_t refreshRate = 100;
   uint16_t bitMapSendRate = 5;
+  ScanOrder scanOrder = ScanOrder::RowMajor;
+  DebounceMode debounceMode = DebounceMode::Deferred;
+  uint8_t debounceTime = DEFAULT_DEBOUNCE_TIME;
+  ScanTopology topology = ScanTopology::Matrix;
+  uint8_t shiftRegisterCount = 0;
+  bool ghostFilter = false;
+
+  // Adaptive scan rate, see setAdaptiveScan(). refreshRate is the active rate.
+  uint16_t idleRefreshRate = 0;
+  uint16_t boostHoldOffTime = DEFAULT_BOOST_HOLD_OFF_TIME;
+  uint16_t heldKeyRefreshRate = 0;
+
+  // Matrices scanned in addition to the main one, see addMatrix()
+  std::vector<ScanMatrix> extraMatrices{};
 
   // Local index to HID code mapping
   std::vector<uint8_t> localToHidMap{};
 
+  // Recalculate bitmapSize after the key count changed
+  void updateBitmapSize() { bitmapSize = (getKeyCount() + 7) / 8; }
+
+  // Number of HID map entries stored in the original map field, the entries
+  // of the rest of the main matrix and those of the extra matrices are
+  // stored after the fields that were appended later
+  size_t getLegacyMapSize() const { return rowCount * colCount; }
+  size_t getMapTailSize() const;
+  size_t getExtraMapSize() const { return getKeyCount() - getMainKeyCount(); }
+  size_t getExtraMatricesSize() const;
+
+  // Keys of the main matrix, described by the top level fields
+  uint16_t getMainKeyCount() const;
+  static uint16_t getTopologyKeyCount(ScanTopology topology, size_t rows, size_t cols,
+                                      uint8_t shiftRegisters);
+  bool isValidMatrix(const ScanMatrix &matrix) const;
+
   // Configuration constraints
   static constexpr const uint16_t MIN_REFRESH_RATE = 1;
   static constexpr const uint16_t MAX_REFRESH_RATE = 1000;
   static constexpr const uint16_t MIN_BITMAP_REFRESH_RATE = 1;
   static constexpr const uint16_t MAX_BITMAP_REFRESH_RATE = 500;
+  static constexpr const uint8_t MAX_DEBOUNCE_TIME = 100;
+  static constexpr const uint8_t DEFAULT_DEBOUNCE_TIME = 5;
+  static constexpr const uint16_t MAX_BOOST_HOLD_OFF_TIME = 10000;
+  static constexpr const uint16_t DEFAULT_BOOST_HOLD_OFF_TIME = 250;
   static constexpr const size_t MAX_PIN_COUNT = 20;
-  static constexpr const size_t MAX_KEY_COUNT = 128;
+  static constexpr const size_t MAX_KEY_COUNT = 4096; // Key indexes are 16 bit
 
 public:
+  // Main matrix included
+  static constexpr const size_t MAX_MATRIX_COUNT = 4;
+
   // Definition of the configuration structure
   struct KeyCfgParams
   {
@@ -80,6 +177,63 @@ public:
    */
   void setBitmapSendFrequency(uint16_t frequency);
 
+  /**
+   * @brief Set which matrix lines are driven during a scan.
+   * @param order Scan order, see ScanOrder.
+   */
+  void setScanOrder(ScanOrder order);
+
+  /**
+   * @brief Set the debounce filter.
+   * @param mode Debounce mode, see DebounceMode.
+   * @param timeMs Debounce window in milliseconds (0-100).
+   */
+  void setDebounce(DebounceMode mode, uint8_t timeMs);
+
+  /**
+   * @brief Set how the keys are wired.
+   * @param topology Scan topology, see ScanTopology.
+   */
+  void setTopology(ScanTopology topology);
+
+  /**
+   * @brief Set the length of the shift register chain, only used by the
+   * ShiftRegister topology.
+   * @param count Number of 8-bit registers in the chain.
+   */
+  void setShiftRegisterCount(uint8_t count);
+
+  /**
+   * @brief Enable ghost key suppression, for matrices without diodes.
+   * @param enabled True to filter every scan.
+   */
+  void setGhostFilter(bool enabled) { ghostFilter = enabled; }
+
+  /**
+   * @brief Configure the adaptive scan rate. Scans run at the idle rate and
+   * switch to the refresh rate for the hold-off time after any key change.
+   * @param idleRate Idle scan rate in Hz (1-1000), 0 always scans at the
+   * refresh rate.
+   * @param holdOffMs Time after the last change the refresh rate is kept, in
+   * milliseconds (0-10000).
+   * @param heldKeyRate Rate in Hz (1-1000) at which lines with held keys are
+   * rescanned outside the hold-off time, 0 disables it.
+   */
+  void setAdaptiveScan(uint16_t idleRate, uint16_t holdOffMs, uint16_t heldKeyRate = 0);
+
+  /**
+   * @brief Add a matrix scanned next to the main one. Its key range starts at
+   * the next byte boundary after the keys of the previous matrix.
+   * @param matrix Matrix to add, refused if the pins do not fit the topology,
+   * the rate is out of range or the key space would overflow.
+   */
+  void addMatrix(const ScanMatrix &matrix);
+
+  /**
+   * @brief Remove all matrices but the main one.
+   */
+  void clearExtraMatrices();
+
   /**
    * @brief Set the local to HID mapping.
    * @param mapData Array of local to HID mapping data.
@@ -92,7 +246,7 @@ public:
    * @param localKeyIndex Local key index to update.
    * @param hidCode New HID code to set.
    */
-  void updateHIDCodeForIndex(uint8_t localKeyIndex, uint8_t hidCode);
+  void updateHIDCodeForIndex(uint16_t localKeyIndex, uint8_t hidCode);
 
   /**
    * @brief Set the entire key scanner configuration.
@@ -128,7 +282,7 @@ public:
    * @brief Get the bitmap size.
    * @return Bitmap size.
    */
-  uint8_t getBitmapSize() const { return bitmapSize; }
+  uint16_t getBitmapSize() const { return bitmapSize; }
 
   /**
    * @brief Get the refresh rate.
@@ -142,6 +296,88 @@ public:
    */
   uint16_t getBitmapSendRate() const { return bitMapSendRate; }
 
+  /**
+   * @brief Get the scan order.
+   * @return Which matrix lines are driven during a scan.
+   */
+  ScanOrder getScanOrder() const { return scanOrder; }
+
+  /**
+   * @brief Get the debounce mode.
+   * @return How raw samples are filtered.
+   */
+  DebounceMode getDebounceMode() const { return debounceMode; }
+
+  /**
+   * @brief Get the debounce window.
+   * @return Debounce window in milliseconds.
+   */
+  uint8_t getDebounceTime() const { return debounceTime; }
+
+  /**
+   * @brief Get how the keys are wired.
+   * @return Scan topology.
+   */
+  ScanTopology getTopology() const { return topology; }
+
+  /**
+   * @brief Get the length of the shift register chain.
+   * @return Number of 8-bit registers.
+   */
+  uint8_t getShiftRegisterCount() const { return shiftRegisterCount; }
+
+  /**
+   * @brief Get whether ghost keys are suppressed.
+   * @return True if ghost key suppression is enabled.
+   */
+  bool isGhostFilterEnabled() const { return ghostFilter; }
+
+  /**
+   * @brief Get the idle scan rate.
+   * @return Idle scan rate in Hz, 0 if the scan rate does not adapt.
+   */
+  uint16_t getIdleRefreshRate() const { return idleRefreshRate; }
+
+  /**
+   * @brief Get how long the refresh rate is kept after a key change.
+   * @return Hold-off time in milliseconds.
+   */
+  uint16_t getBoostHoldOffTime() const { return boostHoldOffTime; }
+
+  /**
+   * @brief Get the rescan rate of lines with held keys.
+   * @return Rate in Hz, 0 if held keys are not rescanned.
+   */
+  uint16_t getHeldKeyRefreshRate() const { return heldKeyRefreshRate; }
+
+  /**
+   * @brief Get the size of the key index space of all matrices.
+   * @return Number of key indexes, the bitmap holds one bit per index.
+   */
+  uint16_t getKeyCount() const;
+
+  /**
+   * @brief Get the number of matrices, the main one included.
+   * @return Number of matrices (1-MAX_MATRIX_COUNT).
+   */
+  size_t getMatrixCount() const { return 1 + extraMatrices.size(); }
+
+  /**
+   * @brief Get the description of a matrix.
+   * @param index Matrix index, 0 is the main matrix described by the top
+   * level settings.
+   * @return The matrix, a default matrix for an out-of-range index.
+   */
+  ScanMatrix getMatrix(size_t index) const;
+
+  /**
+   * @brief Get the first key index of a matrix, the keys a matrix reports are
+   * shifted by it into the shared key index space.
+   * @param index Matrix index.
+   * @return First key index, always a multiple of 8.
+   */
+  uint16_t getKeyOffset(size_t index) const;
+
   /**
    * @brief Get the local to HID mapping.
    * @return Vector of local to HID mapping data.
@@ -152,7 +388,7 @@ public:
    * @brief Get the HID code for a local key index from the map
    * @return HID code
    */
-  uint8_t getHIDCodeForIndex(uint8_t localKeyIndex) const;
+  uint8_t getHIDCodeForIndex(uint16_t localKeyIndex) const;
 
   // Implementation of IConfig interface methods
   static constexpr const char *NAMESPACE = "KeyCfg";
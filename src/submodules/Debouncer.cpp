@@ -0,0 +1,99 @@
+#include <submodules/Debouncer.h>
+
+Debouncer::Debouncer(size_t wordCount) : wordCount(wordCount) {}
+
+void Debouncer::configure(DebounceMode mode, uint8_t windowScans)
+{
+  // A window of one scan or less filters nothing
+  if (windowScans <= 1)
+    mode = DebounceMode::None;
+
+  this->mode = mode;
+  this->windowScans = windowScans;
+
+  // Enough planes to hold the window count
+  planeCount = 0;
+  if (mode != DebounceMode::None)
+  {
+    while ((windowScans >> planeCount) != 0)
+      planeCount++;
+  }
+  counterPlanes.assign(planeCount * wordCount, 0);
+}
+
+void Debouncer::update(uint32_t *samples, const uint32_t *stable)
+{
+  if (mode == DebounceMode::None)
+    return;
+
+  for (size_t word = 0; word < wordCount; word++)
+  {
+    uint32_t changed = samples[word] ^ stable[word];
+
+    // Nothing differs and no key is counting, the word stays as is
+    if (changed == 0 && mode == DebounceMode::Deferred)
+    {
+      for (uint8_t k = 0; k < planeCount; k++)
+        *plane(k, word) = 0;
+      continue;
+    }
+
+    uint32_t flip = (mode == DebounceMode::Deferred) ? updateDeferred(word, changed)
+                                                     : updateEager(word, changed);
+    samples[word] = stable[word] ^ flip;
+  }
+}
+
+uint32_t Debouncer::updateDeferred(size_t word, uint32_t changed)
+{
+  // Count up keys that differ from their stable state, reset all others
+  uint32_t carry = changed;
+  for (uint8_t k = 0; k < planeCount; k++)
+  {
+    uint32_t *bits = plane(k, word);
+    uint32_t next = *bits ^ carry;
+    carry &= *bits;
+    *bits = next & changed;
+  }
+
+  // Keys whose counter reached the window flip and restart from zero
+  uint32_t reached = changed;
+  for (uint8_t k = 0; k < planeCount; k++)
+  {
+    uint32_t bits = *plane(k, word);
+    reached &= ((windowScans >> k) & 1) ? bits : ~bits;
+  }
+  for (uint8_t k = 0; k < planeCount; k++)
+    *plane(k, word) &= ~reached;
+
+  return reached;
+}
+
+uint32_t Debouncer::updateEager(size_t word, uint32_t changed)
+{
+  // Keys with a non-zero counter are locked out after a recent change
+  uint32_t locked = 0;
+  for (uint8_t k = 0; k < planeCount; k++)
+    locked |= *plane(k, word);
+
+  uint32_t flip = changed & ~locked;
+
+  // Count locked keys down by one
+  uint32_t borrow = locked;
+  for (uint8_t k = 0; k < planeCount; k++)
+  {
+    uint32_t *bits = plane(k, word);
+    uint32_t next = *bits ^ borrow;
+    borrow &= ~*bits;
+    *bits = next;
+  }
+
+  // Lock keys that flipped now for the whole window
+  for (uint8_t k = 0; k < planeCount; k++)
+  {
+    uint32_t *bits = plane(k, word);
+    *bits = ((windowScans >> k) & 1) ? (*bits | flip) : (*bits & ~flip);
+  }
+
+  return flip;
+}
@@ -0,0 +1,63 @@
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+#include <cstdint>
+#include <cstring>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <vector>
+
+/**
+ * @brief Per-key debounce filter for packed key bitmaps.
+ *
+ * Every key has a small counter, stored bit-sliced ("vertical counters"):
+ * plane k holds bit k of the counters of 32 keys per word. Counting, comparing
+ * and resetting all keys of a word then takes a few bitwise operations per
+ * plane, independent of how many keys bounce.
+ *
+ * The window is given in scans, the caller converts time to scans from its
+ * scan rate.
+ */
+class Debouncer
+{
+public:
+  using DebounceMode = KeyScannerConfig::DebounceMode;
+
+  /**
+   * @brief Constructor for Debouncer.
+   * @param wordCount Number of 32-bit words of the filtered bitmaps.
+   */
+  Debouncer(size_t wordCount);
+
+  /**
+   * @brief Configure the filter and reset all counters.
+   * @param mode Debounce mode, see DebounceMode.
+   * @param windowScans Debounce window in scans. 0 or 1 disables filtering.
+   */
+  void configure(DebounceMode mode, uint8_t windowScans);
+
+  /**
+   * @brief Filter one scan.
+   * @param samples Raw sampled bitmap, replaced with the debounced bitmap.
+   * @param stable Debounced bitmap of the previous scan.
+   */
+  void update(uint32_t *samples, const uint32_t *stable);
+
+  DebounceMode getMode() const { return mode; }
+  uint8_t getWindowScans() const { return windowScans; }
+
+private:
+  size_t wordCount;
+  DebounceMode mode = DebounceMode::None;
+  uint8_t windowScans = 0;
+
+  // Counter bit planes, planeCount planes of wordCount words each
+  std::vector<uint32_t> counterPlanes;
+  uint8_t planeCount = 0;
+
+  uint32_t *plane(uint8_t k, size_t word) { return &counterPlanes[k * wordCount + word]; }
+
+  uint32_t updateDeferred(size_t word, uint32_t changed);
+  uint32_t updateEager(size_t word, uint32_t changed);
+};
+
+#endif
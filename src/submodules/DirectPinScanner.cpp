@@ -0,0 +1,63 @@
+#include <submodules/DirectPinScanner.h>
+#include <algorithm>
+
+DirectPinScanner::DirectPinScanner(IGpio &gpio, const uint8_t *keyPins,
+                                   uint8_t keyCount)
+    : BitmapScanner(keyCount), gpio(gpio), keyPins(keyPins), keyCount(keyCount)
+{
+  keyPinBits.resize(keyCount);
+  for (size_t i = 0; i < keyCount; i++)
+  {
+    gpio.pinMode(keyPins[i], PinMode::InputPullup);
+    keyPinBits[i] = pinToMask(keyPins[i]);
+    keyPinMask |= keyPinBits[i];
+  }
+}
+
+void DirectPinScanner::sampleKeys()
+{
+  // Pressed keys pull their pin low, one read covers every key
+  uint64_t pressedPins = ~gpio.readPins(keyPinMask) & keyPinMask;
+  if (pressedPins == 0)
+    return;
+
+  for (size_t first = 0; first < keyCount; first += 32)
+  {
+    size_t chunkSize = std::min<size_t>(32, keyCount - first);
+    uint32_t bits = 0;
+    for (size_t i = 0; i < chunkSize; i++)
+    {
+      if (pressedPins & keyPinBits[first + i])
+        bits |= (1u << i);
+    }
+    workingBuffer[first / 32] = bits;
+  }
+}
+
+DirectPinScanner::~DirectPinScanner()
+{
+  if (isIdle())
+    exitIdle();
+}
+
+bool DirectPinScanner::enterIdle(PinInterruptHandler wakeHandler, void *arg)
+{
+  for (size_t i = 0; i < keyCount; i++)
+    gpio.attachPinInterrupt(keyPins[i], PinEdge::Falling, wakeHandler, arg);
+  idle = true;
+
+  // A key that went down before the interrupts were armed produced no edge
+  if (gpio.readPins(keyPinMask) != keyPinMask)
+  {
+    exitIdle();
+    return false;
+  }
+  return true;
+}
+
+void DirectPinScanner::exitIdle()
+{
+  for (size_t i = 0; i < keyCount; i++)
+    gpio.detachPinInterrupt(keyPins[i]);
+  idle = false;
+}
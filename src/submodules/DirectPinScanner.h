@@ -0,0 +1,60 @@
+#ifndef DIRECTPINSCANNER_H
+#define DIRECTPINSCANNER_H
+
+#include <cstdint>
+#include <interfaces/IGpio.h>
+#include <submodules/BitmapScanner.h>
+#include <vector>
+
+/**
+ * @brief Scanner engine for keys wired straight to their own pin.
+ *
+ * Every key connects one pin to ground, so all keys are sampled with a single
+ * bulk read and no line has to be driven. Meant for macro pads and other
+ * boards with fewer keys than free pins. Key index i is the key on keyPins[i].
+ */
+class DirectPinScanner : public BitmapScanner
+{
+public:
+  /**
+   * @brief Constructor for DirectPinScanner.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param keyPins Array of GPIO pin numbers, one per key.
+   * @param keyCount Number of keys.
+   */
+  DirectPinScanner(IGpio &gpio, const uint8_t *keyPins, uint8_t keyCount);
+
+  /**
+   * @brief Destructor for DirectPinScanner, disarms the wake interrupts if
+   * idle.
+   */
+  ~DirectPinScanner() override;
+
+  /**
+   * @brief Arms a falling-edge interrupt on every key pin. If a key is already
+   * down no edge would follow, in that case idle is not entered.
+   * @param wakeHandler Handler invoked from interrupt context on a press.
+   * @param arg Argument passed to the handler.
+   * @return True if idle was entered, false if a key is currently pressed.
+   */
+  bool enterIdle(PinInterruptHandler wakeHandler, void *arg) override;
+
+  /**
+   * @brief Disarms the wake interrupts.
+   * Called automatically by updateKeyState() while idle.
+   */
+  void exitIdle() override;
+
+private:
+  IGpio &gpio;
+  const uint8_t *keyPins;
+  size_t keyCount;
+
+  // Bulk read mask covering all key pins, and the mask bit of each key
+  uint64_t keyPinMask = 0;
+  std::vector<uint64_t> keyPinBits;
+
+  void sampleKeys() override;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include <submodules/DuplexMatrixScanner.h>
+#include <algorithm>
+
+DuplexMatrixScanner::DuplexMatrixScanner(IGpio &gpio, const uint8_t *rowPins,
+                                         const uint8_t *colPins, uint8_t rowCount,
+                                         uint8_t colCount)
+    : BitmapScanner(2 * rowCount * colCount), gpio(gpio), rowPins(rowPins),
+      colPins(colPins), rowCount(rowCount), colCount(colCount)
+{
+  rowPinBits.resize(rowCount);
+  for (size_t r = 0; r < rowCount; r++)
+  {
+    gpio.pinMode(rowPins[r], PinMode::InputPullup);
+    rowPinBits[r] = pinToMask(rowPins[r]);
+    rowPinMask |= rowPinBits[r];
+  }
+  colPinBits.resize(colCount);
+  for (size_t c = 0; c < colCount; c++)
+  {
+    gpio.pinMode(colPins[c], PinMode::InputPullup);
+    colPinBits[c] = pinToMask(colPins[c]);
+    colPinMask |= colPinBits[c];
+  }
+}
+
+void DuplexMatrixScanner::sampleKeys()
+{
+  // Drive rows: keys of the first half pull their column low. Columns are
+  // consecutive keys of a row, merged in chunks of up to 32.
+  for (size_t r = 0; r < rowCount; r++)
+  {
+    gpio.pinMode(rowPins[r], PinMode::Output);
+    gpio.digitalWrite(rowPins[r], PinState::Low);
+    uint64_t pressedPins = ~gpio.readPins(colPinMask) & colPinMask;
+    gpio.pinMode(rowPins[r], PinMode::InputPullup);
+    if (pressedPins == 0)
+      continue;
+
+    for (size_t first = 0; first < colCount; first += 32)
+    {
+      uint8_t chunkSize = static_cast<uint8_t>(std::min<size_t>(32, colCount - first));
+      uint32_t rowBits = 0;
+      for (uint8_t i = 0; i < chunkSize; i++)
+      {
+        if (pressedPins & colPinBits[first + i])
+          rowBits |= (1u << i);
+      }
+      mergeRowBits(r * colCount + first, rowBits, chunkSize);
+    }
+  }
+
+  // Drive columns: keys of the second half pull their row low, spaced a row
+  // apart in the bitmap
+  const size_t secondHalf = rowCount * colCount;
+  for (size_t c = 0; c < colCount; c++)
+  {
+    gpio.pinMode(colPins[c], PinMode::Output);
+    gpio.digitalWrite(colPins[c], PinState::Low);
+    uint64_t pressedPins = ~gpio.readPins(rowPinMask) & rowPinMask;
+    gpio.pinMode(colPins[c], PinMode::InputPullup);
+    if (pressedPins == 0)
+      continue;
+
+    size_t bitIndex = secondHalf + c;
+    for (size_t r = 0; r < rowCount; r++, bitIndex += colCount)
+    {
+      if (pressedPins & rowPinBits[r])
+        workingBuffer[bitIndex / 32] |= (1u << (bitIndex % 32));
+    }
+  }
+}
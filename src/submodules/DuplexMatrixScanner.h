@@ -0,0 +1,52 @@
+#ifndef DUPLEXMATRIXSCANNER_H
+#define DUPLEXMATRIXSCANNER_H
+
+#include <cstdint>
+#include <interfaces/IGpio.h>
+#include <submodules/BitmapScanner.h>
+#include <vector>
+
+/**
+ * @brief Scanner engine for duplex matrices.
+ *
+ * Every row and column crossing carries two keys with diodes in opposite
+ * directions, so rowCount + colCount pins serve 2 * rowCount * colCount keys.
+ * A scan first drives each row and senses the columns, then drives each
+ * column and senses the rows.
+ *
+ * The first rowCount * colCount key indexes are the keys found while driving
+ * rows, row-major like KeyScanner, the second half are the keys found while
+ * driving columns, laid out the same way. Only one direction can be armed at a
+ * time, so a press could go unnoticed and this engine never idles.
+ */
+class DuplexMatrixScanner : public BitmapScanner
+{
+public:
+  /**
+   * @brief Constructor for DuplexMatrixScanner.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param rowPins Array of GPIO pin numbers for the rows.
+   * @param colPins Array of GPIO pin numbers for the columns.
+   * @param rowCount Number of rows in the key matrix.
+   * @param colCount Number of columns in the key matrix.
+   */
+  DuplexMatrixScanner(IGpio &gpio, const uint8_t *rowPins, const uint8_t *colPins,
+                      uint8_t rowCount, uint8_t colCount);
+
+private:
+  IGpio &gpio;
+  const uint8_t *rowPins;
+  const uint8_t *colPins;
+  size_t rowCount;
+  size_t colCount;
+
+  // Bulk read masks of all rows and all columns, and the mask bit of each line
+  uint64_t rowPinMask = 0;
+  uint64_t colPinMask = 0;
+  std::vector<uint64_t> rowPinBits;
+  std::vector<uint64_t> colPinBits;
+
+  void sampleKeys() override;
+};
+
+#endif
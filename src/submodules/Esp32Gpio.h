@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <interfaces/IGpio.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
 
 /**
  * @brief ESP32 GPIO implementation of the IGpio interface.
@@ -11,6 +13,8 @@
  * for ESP32 microcontrollers using the Arduino framework.
  * It maps the generic GPIO operations defined in IGpio
  * to the specific functions provided by the ESP32 Arduino core.
+ * Bulk reads and writes bypass the Arduino core and access the GPIO
+ * input/output registers directly.
  */
 class Esp32Gpio : public IGpio {
 public:
@@ -19,6 +23,15 @@ public:
   PinState digitalRead(uint8_t pin) override;
 
   void digitalWrite(uint8_t pin, PinState value) override;
+
+  uint64_t readPins(uint64_t pinMask) override;
+
+  void writePins(uint64_t pinMask, PinState value) override;
+
+  void attachPinInterrupt(uint8_t pin, PinEdge edge, PinInterruptHandler handler,
+                          void *arg) override;
+
+  void detachPinInterrupt(uint8_t pin) override;
 };
 
 inline void Esp32Gpio::pinMode(uint8_t pin, PinMode mode) {
@@ -43,4 +56,52 @@ inline void Esp32Gpio::digitalWrite(uint8_t pin, PinState value) {
   ::digitalWrite(pin, static_cast<uint8_t>(value));
 }
 
+inline uint64_t Esp32Gpio::readPins(uint64_t pinMask) {
+  // GPIO_IN_REG holds GPIO0-31, GPIO_IN1_REG holds GPIO32 and up
+  uint64_t levels = REG_READ(GPIO_IN_REG);
+  if (pinMask >> 32)
+    levels |= static_cast<uint64_t>(REG_READ(GPIO_IN1_REG)) << 32;
+  return levels & pinMask;
+}
+
+inline void Esp32Gpio::writePins(uint64_t pinMask, PinState value) {
+  // The W1TS/W1TC registers only touch the bits written as 1, so no
+  // read-modify-write of the output register is needed
+  uint32_t lowBank = static_cast<uint32_t>(pinMask);
+  uint32_t highBank = static_cast<uint32_t>(pinMask >> 32);
+  if (value == PinState::High) {
+    if (lowBank)
+      REG_WRITE(GPIO_OUT_W1TS_REG, lowBank);
+    if (highBank)
+      REG_WRITE(GPIO_OUT1_W1TS_REG, highBank);
+  } else {
+    if (lowBank)
+      REG_WRITE(GPIO_OUT_W1TC_REG, lowBank);
+    if (highBank)
+      REG_WRITE(GPIO_OUT1_W1TC_REG, highBank);
+  }
+}
+
+inline void Esp32Gpio::attachPinInterrupt(uint8_t pin, PinEdge edge,
+                                          PinInterruptHandler handler,
+                                          void *arg) {
+  int mode = CHANGE;
+  switch (edge) {
+  case PinEdge::Rising:
+    mode = RISING;
+    break;
+  case PinEdge::Falling:
+    mode = FALLING;
+    break;
+  case PinEdge::Change:
+    mode = CHANGE;
+    break;
+  }
+  ::attachInterruptArg(digitalPinToInterrupt(pin), handler, arg, mode);
+}
+
+inline void Esp32Gpio::detachPinInterrupt(uint8_t pin) {
+  ::detachInterrupt(digitalPinToInterrupt(pin));
+}
+
 #endif // ESP32GPIO_H
\ No newline at end of file
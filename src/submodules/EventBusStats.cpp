@@ -0,0 +1,113 @@
+#include <submodules/EventBusStats.h>
+
+template <typename T>
+static void storeMax(std::atomic<T> &max, T value)
+{
+  T current = max.load(std::memory_order_relaxed);
+  while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+void EventBusStats::recordPush(EventType type, size_t core, uint16_t pending)
+{
+  size_t index = static_cast<size_t>(type);
+  if (index >= EVENT_TYPE_COUNT)
+    return;
+
+  cores[core < MAX_CORES ? core : MAX_CORES - 1].pushed[index].fetch_add(1, std::memory_order_relaxed);
+  storeMax(types[index].highWater, pending);
+}
+
+void EventBusStats::recordDrop(EventType type, size_t core)
+{
+  size_t index = static_cast<size_t>(type);
+  if (index >= EVENT_TYPE_COUNT)
+    return;
+
+  cores[core < MAX_CORES ? core : MAX_CORES - 1].dropped[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventBusStats::recordDispatch(EventType type, uint32_t latencyUs)
+{
+  size_t index = static_cast<size_t>(type);
+  if (index >= EVENT_TYPE_COUNT)
+    return;
+  TypeCounters &counters = types[index];
+
+  counters.dispatched.fetch_add(1, std::memory_order_relaxed);
+  counters.totalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+  storeMax(counters.maxLatencyUs, latencyUs);
+  counters.latencyBuckets[ScanTimingStats::bucketFor(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventBusStats::recordHandler(EventType type, size_t slot, uint32_t elapsedUs)
+{
+  size_t index = static_cast<size_t>(type);
+  if (index >= EVENT_TYPE_COUNT || slot >= EVENT_BUS_HANDLER_SLOTS)
+    return;
+  TypeCounters &counters = types[index];
+  HandlerCounters &handler = counters.handlers[slot];
+
+  counters.handlerBuckets[ScanTimingStats::bucketFor(elapsedUs)].fetch_add(1, std::memory_order_relaxed);
+  handler.calls.fetch_add(1, std::memory_order_relaxed);
+  handler.totalUs.fetch_add(elapsedUs, std::memory_order_relaxed);
+  storeMax(handler.maxUs, elapsedUs);
+}
+
+void EventBusStats::reset()
+{
+  copyCounters(*this, nullptr, [](auto &counter)
+               { return counter.exchange(0, std::memory_order_relaxed); });
+}
+
+void EventBusStats::snapshot(uint32_t windowUs, EventBusSnapshot &out) const
+{
+  out.windowUs = windowUs;
+  copyCounters(*this, &out, [](const auto &counter)
+               { return counter.load(std::memory_order_relaxed); });
+}
+
+void EventBusStats::collect(uint32_t windowUs, EventBusSnapshot &out)
+{
+  // Every counter is taken with an exchange, a record landing meanwhile
+  // counts in the old window or the new one, never in neither
+  out.windowUs = windowUs;
+  copyCounters(*this, &out, [](auto &counter)
+               { return counter.exchange(0, std::memory_order_relaxed); });
+}
+
+template <typename Self, typename Take>
+void EventBusStats::copyCounters(Self &self, EventBusSnapshot *out, Take take)
+{
+  // Without out the counters are only taken, one type at a time
+  EventBusTypeStats discarded;
+
+  for (size_t t = 0; t < EVENT_TYPE_COUNT; t++)
+  {
+    auto &counters = self.types[t];
+    EventBusTypeStats &stats = out != nullptr ? out->types[t] : discarded;
+    stats.pushed = 0;
+    stats.dropped = 0;
+    for (auto &core : self.cores)
+    {
+      stats.pushed += take(core.pushed[t]);
+      stats.dropped += take(core.dropped[t]);
+    }
+    stats.highWater = take(counters.highWater);
+    stats.dispatched = take(counters.dispatched);
+    stats.maxLatencyUs = take(counters.maxLatencyUs);
+    stats.totalLatencyUs = take(counters.totalLatencyUs);
+    for (size_t b = 0; b < SCAN_TIMING_BUCKETS; b++)
+    {
+      stats.latencyBuckets[b] = take(counters.latencyBuckets[b]);
+      stats.handlerBuckets[b] = take(counters.handlerBuckets[b]);
+    }
+    for (size_t h = 0; h < EVENT_BUS_HANDLER_SLOTS; h++)
+    {
+      stats.handlers[h].calls = take(counters.handlers[h].calls);
+      stats.handlers[h].maxUs = take(counters.handlers[h].maxUs);
+      stats.handlers[h].totalUs = take(counters.handlers[h].totalUs);
+    }
+  }
+}
@@ -0,0 +1,150 @@
+#ifndef EVENTBUSSTATS_H
+#define EVENTBUSSTATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared/EventTypes.h>
+#include <submodules/ScanTimingStats.h>
+
+static constexpr size_t EVENT_TYPE_COUNT = static_cast<size_t>(EventType::COUNT);
+// Handler slots per event type, see EventRegistry::HandlerTimer
+static constexpr size_t EVENT_BUS_HANDLER_SLOTS = 24;
+
+// Time spent in one handler
+struct EventBusHandlerStats
+{
+  uint32_t calls;
+  uint32_t maxUs;
+  uint32_t totalUs;
+};
+
+// Counters of one event type
+struct EventBusTypeStats
+{
+  uint32_t pushed;     // Events the bus accepted
+  uint32_t dropped;    // Events refused or evicted because the bus was full or stopped
+  uint16_t highWater;  // Most events of the type pending at the same time
+  uint32_t dispatched; // Events handed to the handlers
+  uint32_t maxLatencyUs;
+  uint32_t totalLatencyUs;
+  uint32_t latencyBuckets[SCAN_TIMING_BUCKETS]; // Push to dispatch
+  uint32_t handlerBuckets[SCAN_TIMING_BUCKETS]; // Time per handler call, all handlers
+  EventBusHandlerStats handlers[EVENT_BUS_HANDLER_SLOTS];
+};
+
+// Plain copy of the event bus counters, safe to memcpy and to pass in events
+struct EventBusSnapshot
+{
+  uint32_t windowUs; // Time covered by this window
+  EventBusTypeStats types[EVENT_TYPE_COUNT];
+};
+
+/**
+ * @brief Counters and histograms of the event bus, per event type.
+ *
+ * Pushes come from tasks on both cores, so push and drop counts are kept
+ * per core and only added up when read: a push is one relaxed increment on
+ * a counter no other core writes. Everything else is a relaxed increment or
+ * a compare-and-swap maximum, no record takes a lock. Reads may mix counts
+ * from just before and after a record, collect() rolls the window without
+ * losing any.
+ *
+ * Times go into the power-of-two buckets of ScanTimingStats. Every counter
+ * is at most 32 bits wide, the widest atomic the ESP32 updates without a
+ * lock. Time totals fit a window of over an hour, the caller keeps the
+ * window short and tracks its start, which keeps the class free of a clock.
+ */
+class EventBusStats
+{
+  static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint16_t>::is_always_lock_free,
+                "Recording must not take a lock, every counter needs a lock-free atomic");
+
+public:
+  static constexpr size_t MAX_CORES = 2;
+
+  /**
+   * @brief Record an event the bus accepted, on the pushing task.
+   * @param type Type of the event.
+   * @param core Core of the pushing task.
+   * @param pending Events of the type pending after the push.
+   */
+  void recordPush(EventType type, size_t core, uint16_t pending);
+
+  /**
+   * @brief Record an event the bus refused, or evicted to make room for a
+   * newer one, on the pushing task.
+   * @param type Type of the event.
+   * @param core Core of the pushing task.
+   */
+  void recordDrop(EventType type, size_t core);
+
+  /**
+   * @brief Record the dispatch of an event.
+   * @param type Type of the event.
+   * @param latencyUs Microseconds between push and dispatch.
+   */
+  void recordDispatch(EventType type, uint32_t latencyUs);
+
+  /**
+   * @brief Record one handler call.
+   * @param type Type of the dispatched events.
+   * @param slot Handler slot, below EVENT_BUS_HANDLER_SLOTS.
+   * @param elapsedUs Microseconds the handler ran.
+   */
+  void recordHandler(EventType type, size_t slot, uint32_t elapsedUs);
+
+  /**
+   * @brief Clear all counters and start a new window.
+   */
+  void reset();
+
+  /**
+   * @brief Copy the counters of the current window.
+   * @param windowUs Time the window covered so far.
+   * @param out Snapshot to fill.
+   */
+  void snapshot(uint32_t windowUs, EventBusSnapshot &out) const;
+
+  /**
+   * @brief Copy the counters of the current window and start a new one.
+   * Unlike snapshot() followed by reset(), no record is lost between the two.
+   * @param windowUs Time the closed window covered.
+   * @param out Snapshot to fill.
+   */
+  void collect(uint32_t windowUs, EventBusSnapshot &out);
+
+private:
+  struct CoreCounters
+  {
+    std::atomic<uint32_t> pushed[EVENT_TYPE_COUNT];
+    std::atomic<uint32_t> dropped[EVENT_TYPE_COUNT];
+  };
+
+  struct HandlerCounters
+  {
+    std::atomic<uint32_t> calls;
+    std::atomic<uint32_t> maxUs;
+    std::atomic<uint32_t> totalUs;
+  };
+
+  struct TypeCounters
+  {
+    std::atomic<uint16_t> highWater;
+    std::atomic<uint32_t> dispatched;
+    std::atomic<uint32_t> maxLatencyUs;
+    std::atomic<uint32_t> totalLatencyUs;
+    std::atomic<uint32_t> latencyBuckets[SCAN_TIMING_BUCKETS];
+    std::atomic<uint32_t> handlerBuckets[SCAN_TIMING_BUCKETS];
+    HandlerCounters handlers[EVENT_BUS_HANDLER_SLOTS];
+  };
+
+  CoreCounters cores[MAX_CORES]{};
+  TypeCounters types[EVENT_TYPE_COUNT]{};
+
+  // Copy every counter through take into out, skipped if out is nullptr
+  template <typename Self, typename Take>
+  static void copyCounters(Self &self, EventBusSnapshot *out, Take take);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include <submodules/EventChannel.h>
+
+EventRef &EventRef::operator=(EventRef &&other)
+{
+  if (this != &other)
+  {
+    reset();
+    event = other.event;
+    owned = other.owned;
+    other.owned = false;
+  }
+  return *this;
+}
+
+EventRef EventRef::adopt(const Event &event)
+{
+  EventRef ref;
+  ref.event = event;
+  ref.owned = true;
+  return ref;
+}
+
+EventRef EventRef::share(const Event &event)
+{
+  retainEvent(event);
+  return adopt(event);
+}
+
+Event EventRef::release()
+{
+  owned = false;
+  return event;
+}
+
+void EventRef::reset()
+{
+  if (!owned)
+    return;
+  owned = false;
+  if (event.cleanup)
+    event.cleanup(&event);
+}
+
+void retainEvent(const Event &event)
+{
+  switch (event.type)
+  {
+  case EventType::RawBitmap:
+    event.rawBitmapEvt.retain(EventType::RawBitmap);
+    break;
+  case EventType::HidBitmap:
+    event.hidBitmapEvt.retain(EventType::HidBitmap);
+    break;
+  case EventType::ScanStats:
+    retainEventPayload(EventType::ScanStats, event.scanStatsEvt.stats);
+    break;
+  case EventType::BusStats:
+    retainEventPayload(EventType::BusStats, event.busStatsEvt.stats);
+    break;
+  default:
+    break;
+  }
+}
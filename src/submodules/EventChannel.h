@@ -0,0 +1,225 @@
+#ifndef EVENTCHANNEL_H
+#define EVENTCHANNEL_H
+
+#include <cstddef>
+#include <shared/EventTypes.h>
+#include <submodules/EventRegistry.h>
+
+/**
+ * @brief Owning handle of one reference to the payload of an event.
+ *
+ * Events stay plain structs so they can be copied through FreeRTOS queues
+ * and the bus lanes, the reference an event holds is what its cleanup
+ * releases. EventRef wraps that reference: it is move-only, releases it
+ * exactly once when destroyed or reset, and hands it on to a queue with
+ * release(). Spilled bitmaps and stats are shared by reference counting, the
+ * payload is freed when the last holder lets go.
+ */
+class EventRef
+{
+public:
+  EventRef() : event{}, owned(false) {}
+  EventRef(EventRef &&other) : event(other.event), owned(other.owned) { other.owned = false; }
+  EventRef &operator=(EventRef &&other);
+  EventRef(const EventRef &) = delete;
+  EventRef &operator=(const EventRef &) = delete;
+  ~EventRef() { reset(); }
+
+  /**
+   * @brief Take over the reference an event holds, e.g. one received from a
+   * queue.
+   * @param event The event, its reference must not be released elsewhere.
+   * @return The handle.
+   */
+  static EventRef adopt(const Event &event);
+
+  /**
+   * @brief Take another reference to the payload of an event, e.g. one a
+   * handler keeps beyond its call.
+   * @param event The event, its own reference is left untouched.
+   * @return The handle.
+   */
+  static EventRef share(const Event &event);
+
+  /**
+   * @brief Gets the event.
+   * @return The event, valid while the handle holds it.
+   */
+  const Event &get() const { return event; }
+  const Event *operator->() const { return &event; }
+  explicit operator bool() const { return owned; }
+
+  /**
+   * @brief Give up ownership without releasing, the returned event carries
+   * the reference on, e.g. into a queue.
+   * @return The event, the handle is empty afterwards.
+   */
+  Event release();
+
+  /**
+   * @brief Release the reference, the payload is freed with the last one.
+   * Empty handles ignore it.
+   */
+  void reset();
+
+private:
+  Event event;
+  bool owned;
+};
+
+/**
+ * @brief Take another reference to the payload of an event.
+ * @param event The event, types without a shared payload need nothing.
+ */
+void retainEvent(const Event &event);
+
+/// @brief Maps an event payload to its event type and union member.
+template <typename T>
+struct ChannelTraits;
+
+template <>
+struct ChannelTraits<RawKeyEvent>
+{
+  static constexpr EventType TYPE = EventType::RawKey;
+  static void cleanup(Event *event) { cleanupRawKeyEvent(event); }
+  static RawKeyEvent &payload(Event &event) { return event.rawKeyEvt; }
+  static const RawKeyEvent &payload(const Event &event) { return event.rawKeyEvt; }
+};
+
+template <>
+struct ChannelTraits<RawBitmapEvent>
+{
+  static constexpr EventType TYPE = EventType::RawBitmap;
+  static void cleanup(Event *event) { cleanupRawBitmapEvent(event); }
+  static RawBitmapEvent &payload(Event &event) { return event.rawBitmapEvt; }
+  static const RawBitmapEvent &payload(const Event &event) { return event.rawBitmapEvt; }
+};
+
+template <>
+struct ChannelTraits<HidBitmapEvent>
+{
+  static constexpr EventType TYPE = EventType::HidBitmap;
+  static void cleanup(Event *event) { cleanupHidBitmapEvent(event); }
+  static HidBitmapEvent &payload(Event &event) { return event.hidBitmapEvt; }
+  static const HidBitmapEvent &payload(const Event &event) { return event.hidBitmapEvt; }
+};
+
+template <>
+struct ChannelTraits<ScanStatsEvent>
+{
+  static constexpr EventType TYPE = EventType::ScanStats;
+  static void cleanup(Event *event) { cleanupScanStatsEvent(event); }
+  static ScanStatsEvent &payload(Event &event) { return event.scanStatsEvt; }
+  static const ScanStatsEvent &payload(const Event &event) { return event.scanStatsEvt; }
+};
+
+template <>
+struct ChannelTraits<BusStatsEvent>
+{
+  static constexpr EventType TYPE = EventType::BusStats;
+  static void cleanup(Event *event) { cleanupBusStatsEvent(event); }
+  static BusStatsEvent &payload(Event &event) { return event.busStatsEvt; }
+  static const BusStatsEvent &payload(const Event &event) { return event.busStatsEvt; }
+};
+
+/**
+ * @brief Compile-time typed view of the event bus for one payload type.
+ *
+ * Publishers hand a payload over and never touch its cleanup, subscribers get
+ * the payload of their type instead of the Event union. The bus owns every
+ * event it dispatches and releases it once the last handler returned, see
+ * EventRegistry::deliverBatch(). A handler that keeps the payload beyond its
+ * call shares it, so all subscribers read one buffer without copies.
+ */
+template <typename T>
+class Channel
+{
+  using Traits = ChannelTraits<T>;
+
+public:
+  static constexpr EventType TYPE = Traits::TYPE;
+
+  /**
+   * @brief Wrap a payload in an event of the channel type.
+   * @param payload The payload, its reference moves into the event.
+   * @return The event.
+   */
+  static Event wrap(const T &payload)
+  {
+    Event event{};
+    event.type = TYPE;
+    event.cleanup = Traits::cleanup;
+    Traits::payload(event) = payload;
+    return event;
+  }
+
+  /**
+   * @brief Publish a payload on the event bus.
+   * @param payload The payload, the bus takes its reference over. A refused
+   * payload is released.
+   * @return False if the bus refused the event.
+   */
+  static bool publish(const T &payload)
+  {
+    EventRef event = EventRef::adopt(wrap(payload));
+    if (!EventRegistry::pushEvent(event.get()))
+      return false;
+    event.release();
+    return true;
+  }
+
+  /**
+   * @brief Subscribe a typed handler, called on the bus task for every event
+   * of the channel type.
+   * @tparam Handler The handler, it may read the payload during the call.
+   * @return False if the type already has EventRegistry::MAX_HANDLERS
+   * handlers.
+   */
+  template <void (*Handler)(const T &)>
+  static bool subscribe()
+  {
+    return EventRegistry::registerHandler(TYPE, [](const Event &event)
+                                          { Handler(Traits::payload(event)); });
+  }
+
+  /**
+   * @brief Subscribe a heavy typed handler, run on a worker task off the bus
+   * task, see EventRegistry::registerOffloadHandler.
+   * @tparam Handler The handler, it may read the payload during the call.
+   * @param coreMask Cores the handler may run on, bit n for core n.
+   * @return False if the type already has EventRegistry::MAX_HANDLERS
+   * offloaded handlers.
+   */
+  template <void (*Handler)(const T &)>
+  static bool subscribeOffloaded(uint32_t coreMask = EventRegistry::ANY_CORE)
+  {
+    return EventRegistry::registerOffloadHandler(TYPE, [](const Event *events, size_t count)
+                                                 {
+                                                   for (size_t i = 0; i < count; i++)
+                                                     Handler(Traits::payload(events[i]));
+                                                 },
+                                                 coreMask);
+  }
+
+  /**
+   * @brief Share a payload a handler received, for use beyond its call.
+   * @param payload The payload as passed to the handler.
+   * @return Handle of a new reference to the payload.
+   */
+  static EventRef share(const T &payload) { return EventRef::share(wrap(payload)); }
+
+  /**
+   * @brief Gets the payload of an event of the channel type.
+   * @param event The event.
+   * @return The payload.
+   */
+  static const T &payload(const Event &event) { return Traits::payload(event); }
+};
+
+using RawKeyChannel = Channel<RawKeyEvent>;
+using RawBitmapChannel = Channel<RawBitmapEvent>;
+using HidBitmapChannel = Channel<HidBitmapEvent>;
+using ScanStatsChannel = Channel<ScanStatsEvent>;
+using BusStatsChannel = Channel<BusStatsEvent>;
+
+#endif
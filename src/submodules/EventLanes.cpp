@@ -0,0 +1,167 @@
+#include <submodules/EventLanes.h>
+#include <algorithm>
+
+EventLanes::EventLanes()
+{
+  for (size_t i = 0; i < LANE_COUNT; i++)
+  {
+    Lane &lane = lanes[i];
+    lane.config = defaultConfig(static_cast<EventType>(i));
+    lane.slots.reset(new Event[lane.config.depth]);
+    lane.head = 0;
+    lane.count = 0;
+    lane.stats = {};
+  }
+  updateOrder();
+}
+
+EventLanes::LaneConfig EventLanes::defaultConfig(EventType type)
+{
+  switch (type)
+  {
+  case EventType::RawKey:
+    return {0, 32, false, DropPolicy::Newest};
+  case EventType::HidBitmap:
+    return {1, 1, true, DropPolicy::Oldest};
+  case EventType::ConfigUpdate:
+    return {2, 4, false, DropPolicy::Newest};
+  case EventType::RawBitmap:
+    return {3, 1, true, DropPolicy::Oldest};
+  case EventType::BusStats:
+    return {4, 1, true, DropPolicy::Oldest};
+  case EventType::ScanStats:
+  default:
+    return {4, 4, false, DropPolicy::Oldest};
+  }
+}
+
+void EventLanes::configure(EventType type, const LaneConfig &config)
+{
+  if (static_cast<size_t>(type) >= LANE_COUNT)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Lane &lane = lanes[static_cast<size_t>(type)];
+  for (uint8_t i = 0; i < lane.count; i++)
+    cleanupEvent(lane.slots[(lane.head + i) % lane.config.depth]);
+
+  lane.config = config;
+  lane.config.depth = config.coalesce ? 1 : std::min(std::max<uint8_t>(config.depth, 1), MAX_LANE_DEPTH);
+  lane.slots.reset(new Event[lane.config.depth]);
+  lane.head = 0;
+  lane.count = 0;
+  updateOrder();
+}
+
+EventLanes::LaneConfig EventLanes::getConfig(EventType type) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return lanes[static_cast<size_t>(type)].config;
+}
+
+bool EventLanes::push(const Event &event, PushResult *result)
+{
+  if (static_cast<size_t>(event.type) >= LANE_COUNT)
+    return false;
+
+  // Replaced or evicted event, cleaned up outside the lock
+  Event displaced;
+  bool hasDisplaced = false;
+  bool evicted = false;
+  uint16_t pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Lane &lane = lanes[static_cast<size_t>(event.type)];
+    const uint8_t depth = lane.config.depth;
+
+    if (lane.config.coalesce && lane.count > 0)
+    {
+      displaced = lane.slots[lane.head];
+      hasDisplaced = true;
+      lane.slots[lane.head] = event;
+      lane.stats.coalesced++;
+    }
+    else if (lane.count == depth)
+    {
+      lane.stats.dropped++;
+      if (lane.config.drop == DropPolicy::Newest)
+      {
+        if (result != nullptr)
+          *result = {lane.count, false};
+        return false;
+      }
+      displaced = lane.slots[lane.head];
+      hasDisplaced = true;
+      evicted = true;
+      lane.slots[lane.head] = event;
+      lane.head = (lane.head + 1) % depth;
+    }
+    else
+    {
+      lane.slots[(lane.head + lane.count) % depth] = event;
+      lane.count++;
+      lane.stats.highWater = std::max<uint16_t>(lane.stats.highWater, lane.count);
+    }
+    lane.stats.pushed++;
+    pending = lane.count;
+  }
+
+  if (result != nullptr)
+    *result = {pending, evicted};
+  if (hasDisplaced)
+    cleanupEvent(displaced);
+  return true;
+}
+
+bool EventLanes::pop(Event &out)
+{
+  return popBatch(&out, 1) == 1;
+}
+
+size_t EventLanes::popBatch(Event *out, size_t max)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (uint8_t index : order)
+  {
+    Lane &lane = lanes[index];
+    if (lane.count == 0)
+      continue;
+    size_t count = std::min<size_t>(lane.count, max);
+    for (size_t i = 0; i < count; i++)
+      out[i] = lane.slots[(lane.head + i) % lane.config.depth];
+    lane.head = (lane.head + count) % lane.config.depth;
+    lane.count -= count;
+    return count;
+  }
+  return 0;
+}
+
+void EventLanes::clear()
+{
+  Event event;
+  while (pop(event))
+    cleanupEvent(event);
+}
+
+EventLanes::LaneStats EventLanes::getStats(EventType type) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const Lane &lane = lanes[static_cast<size_t>(type)];
+  LaneStats stats = lane.stats;
+  stats.depth = lane.count;
+  return stats;
+}
+
+void EventLanes::updateOrder()
+{
+  for (size_t i = 0; i < LANE_COUNT; i++)
+    order[i] = static_cast<uint8_t>(i);
+  std::stable_sort(order, order + LANE_COUNT, [this](uint8_t a, uint8_t b)
+                   { return lanes[a].config.priority < lanes[b].config.priority; });
+}
+
+void EventLanes::cleanupEvent(Event &event)
+{
+  if (event.cleanup)
+    event.cleanup(&event);
+}
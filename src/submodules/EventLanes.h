@@ -0,0 +1,174 @@
+#ifndef EVENTLANES_H
+#define EVENTLANES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared/EventTypes.h>
+
+/**
+ * @brief Pending events of the event bus, one lane per event type.
+ *
+ * Lanes are drained by priority, so key transitions are dispatched ahead of
+ * periodic snapshots and a burst of snapshots cannot take the slots key
+ * events need. A coalescing lane keeps only the newest pending event, the
+ * one it replaces is cleaned up, which suits snapshots carrying the full
+ * state. Coalesced HID bitmaps can fold a tap shorter than one bus round
+ * into nothing, the bus task drains far faster than keys are tapped.
+ *
+ * Every lane has a fixed depth allocated by configure(), and a drop policy
+ * for a full lane: refuse the new event, so the pusher cleans it up as
+ * before, or evict the oldest pending one.
+ */
+class EventLanes
+{
+public:
+  enum class DropPolicy : uint8_t
+  {
+    Newest, // Refuse the pushed event
+    Oldest  // Evict and clean up the oldest pending event
+  };
+
+  struct LaneConfig
+  {
+    uint8_t priority; // Lower values drain first, ties drain in event type order
+    uint8_t depth;    // Pending events, coalescing lanes hold one
+    bool coalesce;    // Latest wins, a new event replaces the pending one
+    DropPolicy drop;
+  };
+
+  struct LaneStats
+  {
+    uint16_t depth;     // Events currently pending
+    uint16_t highWater; // Most events pending at the same time
+    uint32_t pushed;    // Events accepted
+    uint32_t dropped;   // Events refused or evicted because the lane was full
+    uint32_t coalesced; // Pending events replaced by a newer one
+  };
+
+  // What a push did to its lane, for the bus counters
+  struct PushResult
+  {
+    uint16_t pending; // Events pending in the lane after the push
+    bool evicted;     // The oldest pending event made room for this one
+  };
+
+  static constexpr size_t LANE_COUNT = static_cast<size_t>(EventType::COUNT);
+  static constexpr uint8_t MAX_LANE_DEPTH = 64;
+
+  /**
+   * @brief Constructor for EventLanes, configures every lane with its
+   * default.
+   */
+  EventLanes();
+
+  /**
+   * @brief Change the configuration of a lane, pending events of the lane
+   * are cleaned up. Not safe while other tasks push or pop.
+   * @param type The event type of the lane.
+   * @param config The new configuration, depth is clamped to
+   * 1-MAX_LANE_DEPTH.
+   */
+  void configure(EventType type, const LaneConfig &config);
+
+  /**
+   * @brief Gets the configuration of a lane.
+   * @param type The event type of the lane.
+   * @return The configuration.
+   */
+  LaneConfig getConfig(EventType type) const;
+
+  /**
+   * @brief Queue an event in the lane of its type. Replaced and evicted
+   * events are cleaned up, a refused one is left to the caller.
+   * @param event The event, copied.
+   * @param result Filled with the outcome if not nullptr.
+   * @return False if the event was refused.
+   */
+  bool push(const Event &event, PushResult *result = nullptr);
+
+  /**
+   * @brief Take the oldest event of the highest priority non-empty lane.
+   * @param out The event, ownership of its payload passes to the caller.
+   * @return False if all lanes are empty.
+   */
+  bool pop(Event &out);
+
+  /**
+   * @brief Take up to max of the oldest events of the highest priority
+   * non-empty lane, all of the same type.
+   * @param out Array of at least max events, ownership of their payloads
+   * passes to the caller.
+   * @param max Most events to take.
+   * @return Number of events taken, 0 if all lanes are empty.
+   */
+  size_t popBatch(Event *out, size_t max);
+
+  /**
+   * @brief Pop batches and hand them to dispatch until the lanes are empty
+   * or limit events were taken.
+   * @param batch Buffer of at least batchSize events.
+   * @param batchSize Most events per batch.
+   * @param limit Most events to take in total.
+   * @param dispatch Called with each batch as (Event *, size_t), it owns the
+   * payloads of the batch.
+   * @return Number of events taken.
+   */
+  template <typename Dispatch>
+  size_t drain(Event *batch, size_t batchSize, size_t limit, Dispatch dispatch)
+  {
+    size_t drained = 0;
+    while (drained < limit)
+    {
+      size_t count = popBatch(batch, std::min(batchSize, limit - drained));
+      if (count == 0)
+        break;
+      dispatch(batch, count);
+      drained += count;
+    }
+    return drained;
+  }
+
+  /**
+   * @brief Clean up all pending events.
+   */
+  void clear();
+
+  /**
+   * @brief Gets the counters of a lane.
+   * @param type The event type of the lane.
+   * @return Snapshot of the counters.
+   */
+  LaneStats getStats(EventType type) const;
+
+  /**
+   * @brief Gets the default configuration of a lane: key events first and
+   * never coalesced, bitmap snapshots and bus stats coalesced, scan stats
+   * evicting the oldest.
+   * @param type The event type of the lane.
+   * @return The default configuration.
+   */
+  static LaneConfig defaultConfig(EventType type);
+
+private:
+  struct Lane
+  {
+    LaneConfig config;
+    std::unique_ptr<Event[]> slots;
+    uint8_t head;
+    uint8_t count;
+    LaneStats stats;
+  };
+
+  Lane lanes[LANE_COUNT];
+  // Lane indexes in drain order
+  uint8_t order[LANE_COUNT];
+  mutable std::mutex mutex;
+
+  void updateOrder();
+  static void cleanupEvent(Event &event);
+};
+
+#endif
@@ -1,51 +1,242 @@
 #include <submodules/EventRegistry.h>
 #include <mutex>
+#include <thread>
 
 // Initialize static member variables
-std::vector<EventRegistry::EventCallback> EventRegistry::handlers[(size_t)EventType::COUNT]{};
-EventRegistry::PushCallback EventRegistry::pushCallback = nullptr;
+EventRegistry::HandlerTable EventRegistry::tables[(size_t)EventType::COUNT][2]{};
+std::atomic<EventRegistry::HandlerTable *> EventRegistry::published[(size_t)EventType::COUNT]{};
+std::atomic<EventRegistry::PushCallback> EventRegistry::pushCallback{nullptr};
+std::atomic<EventRegistry::ChangeCallback> EventRegistry::changeCallback{nullptr};
+std::atomic<EventRegistry::OffloadCallback> EventRegistry::offloadCallback{nullptr};
+std::atomic<const EventRegistry::HandlerTimer *> EventRegistry::handlerTimer{nullptr};
 std::mutex EventRegistry::mutex{};
 
-void EventRegistry::registerHandler(EventType type, EventCallback callback)
+void EventRegistry::readHandlers(EventType type, HandlerSet &out)
+{
+  std::atomic<HandlerTable *> &current = published[(size_t)type];
+  for (;;)
+  {
+    HandlerTable *table = current.load();
+    if (table == nullptr)
+    {
+      out.count = 0;
+      out.batchCount = 0;
+      out.offloadCount = 0;
+      return;
+    }
+
+    // Announce the read, then make sure the table was not retired meanwhile.
+    // A writer only rebuilds a table after it saw no readers on it.
+    table->readers.fetch_add(1);
+    if (current.load() != table)
+    {
+      table->readers.fetch_sub(1);
+      continue;
+    }
+
+    memcpy(&out, &table->handlers, sizeof(HandlerSet));
+    table->readers.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+}
+
+template <typename Modify>
+bool EventRegistry::updateHandlers(EventType type, Modify modify)
+{
+  HandlerTable *pair = tables[(size_t)type];
+  HandlerTable *current = published[(size_t)type].load();
+  HandlerTable *next = (current == &pair[0]) ? &pair[1] : &pair[0];
+
+  // Dispatches that picked up next before it was retired are still copying
+  while (next->readers.load() != 0)
+    std::this_thread::yield();
+
+  if (current != nullptr)
+    memcpy(&next->handlers, &current->handlers, sizeof(HandlerSet));
+  else
+    next->handlers = {};
+  if (!modify(next->handlers))
+    return false;
+  published[(size_t)type].store(next);
+
+  ChangeCallback changed = changeCallback.load();
+  if (changed)
+    changed(type);
+  return true;
+}
+
+bool EventRegistry::registerHandler(EventType type, EventCallback callback)
 {
   std::lock_guard<std::mutex> lock(mutex);
-  // Add the callback to the vector of handlers for the specified event type
-  handlers[(size_t)type].push_back(callback);
+  // Add the callback to the handlers for the specified event type
+  return updateHandlers(type, [callback](HandlerSet &handlers)
+                        {
+                          if (handlers.count >= MAX_HANDLERS)
+                            return false;
+                          handlers.callbacks[handlers.count++] = callback;
+                          return true;
+                        });
+}
+
+bool EventRegistry::registerBatchHandler(EventType type, BatchCallback callback)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return updateHandlers(type, [callback](HandlerSet &handlers)
+                        {
+                          if (handlers.batchCount >= MAX_HANDLERS)
+                            return false;
+                          handlers.batchCallbacks[handlers.batchCount++] = callback;
+                          return true;
+                        });
+}
+
+bool EventRegistry::registerOffloadHandler(EventType type, BatchCallback callback, uint32_t coreMask)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return updateHandlers(type, [callback, coreMask](HandlerSet &handlers)
+                        {
+                          if (handlers.offloadCount >= MAX_HANDLERS)
+                            return false;
+                          handlers.offloaded[handlers.offloadCount++] = {callback, coreMask};
+                          return true;
+                        });
 }
 
 std::vector<EventRegistry::EventCallback>
 EventRegistry::getHandler(EventType type)
 {
-  std::lock_guard<std::mutex> lock(mutex);
-  // Return the vector of handlers for the specified event type
-  return handlers[(size_t)type];
+  HandlerSet handlers;
+  readHandlers(type, handlers);
+  // Return the handlers for the specified event type
+  return std::vector<EventCallback>(handlers.callbacks, handlers.callbacks + handlers.count);
+}
+
+std::vector<EventRegistry::BatchCallback>
+EventRegistry::getBatchHandler(EventType type)
+{
+  HandlerSet handlers;
+  readHandlers(type, handlers);
+  return std::vector<BatchCallback>(handlers.batchCallbacks, handlers.batchCallbacks + handlers.batchCount);
+}
+
+std::vector<EventRegistry::BatchCallback>
+EventRegistry::getOffloadHandler(EventType type)
+{
+  HandlerSet handlers;
+  readHandlers(type, handlers);
+  std::vector<BatchCallback> callbacks;
+  for (size_t h = 0; h < handlers.offloadCount; h++)
+    callbacks.push_back(handlers.offloaded[h].callback);
+  return callbacks;
+}
+
+size_t EventRegistry::dispatch(const Event &event)
+{
+  return dispatchBatch(&event, 1);
+}
+
+template <typename Call>
+void EventRegistry::runHandlers(const HandlerSet &handlers, const Event *events, size_t count, Call call)
+{
+  for (size_t i = 0; i < count; i++)
+    for (size_t h = 0; h < handlers.count; h++)
+      call(h, [&]
+           { handlers.callbacks[h](events[i]); });
+  for (size_t h = 0; h < handlers.batchCount; h++)
+    call(MAX_HANDLERS + h, [&]
+         { handlers.batchCallbacks[h](events, count); });
+
+  OffloadCallback offload = offloadCallback.load(std::memory_order_acquire);
+  for (size_t h = 0; h < handlers.offloadCount; h++)
+  {
+    const OffloadHandler &handler = handlers.offloaded[h];
+    call(2 * MAX_HANDLERS + h, [&]
+         {
+           if (offload == nullptr || !offload(events[0].type, handler.callback, handler.coreMask, events, count))
+             handler.callback(events, count);
+         });
+  }
+}
+
+size_t EventRegistry::dispatchBatch(const Event *events, size_t count)
+{
+  if (count == 0 || (size_t)events[0].type >= (size_t)EventType::COUNT)
+    return 0;
+  HandlerSet handlers;
+  readHandlers(events[0].type, handlers);
+
+  const HandlerTimer *timer = handlerTimer.load(std::memory_order_acquire);
+  if (timer == nullptr)
+  {
+    runHandlers(handlers, events, count, [](size_t, auto handler)
+                { handler(); });
+  }
+  else
+  {
+    EventType type = events[0].type;
+    runHandlers(handlers, events, count, [timer, type](size_t slot, auto handler)
+                {
+                  uint32_t startUs = timer->nowUs();
+                  handler();
+                  timer->record(type, slot, timer->nowUs() - startUs);
+                });
+  }
+  return handlers.count + handlers.batchCount + handlers.offloadCount;
+}
+
+size_t EventRegistry::deliverBatch(Event *events, size_t count)
+{
+  size_t delivered = dispatchBatch(events, count);
+  for (size_t i = 0; i < count; i++)
+    if (events[i].cleanup)
+      events[i].cleanup(&events[i]);
+  return delivered;
 }
 
 void EventRegistry::clearHandlers(EventType type)
 {
   std::lock_guard<std::mutex> lock(mutex);
   // Clears all registered handlers for a specific event type
-  handlers[(size_t)type].clear();
+  updateHandlers(type, [](HandlerSet &handlers)
+                 {
+                   handlers.count = 0;
+                   handlers.batchCount = 0;
+                   handlers.offloadCount = 0;
+                   return true;
+                 });
 }
 
 void EventRegistry::registerPushCallback(PushCallback cb)
 {
-  std::lock_guard<std::mutex> lock(mutex);
-  pushCallback = cb;
+  pushCallback.store(cb);
 }
 
 void EventRegistry::clearPushCallback()
 {
-  std::lock_guard<std::mutex> lock(mutex);
-  pushCallback = nullptr;
+  pushCallback.store(nullptr);
+}
+
+void EventRegistry::registerChangeCallback(ChangeCallback cb)
+{
+  changeCallback.store(cb);
+}
+
+void EventRegistry::registerOffloadCallback(OffloadCallback cb)
+{
+  offloadCallback.store(cb);
+}
+
+void EventRegistry::registerHandlerTimer(const HandlerTimer *timer)
+{
+  handlerTimer.store(timer);
 }
 
 bool EventRegistry::pushEvent(const Event &event)
 {
-  std::lock_guard<std::mutex> lock(mutex);
-  if (pushCallback)
+  PushCallback callback = pushCallback.load(std::memory_order_acquire);
+  if (callback)
   {
-    return pushCallback(event);
+    return callback(event);
   }
   return false;
-}
\ No newline at end of file
+}
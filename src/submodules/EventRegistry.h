@@ -1,6 +1,7 @@
 #ifndef EVENTREGISTRY_H
 #define EVENTREGISTRY_H
 
+#include <atomic>
 #include <cstring>
 #include <shared/EventTypes.h>
 #include <vector>
@@ -13,30 +14,127 @@
  * handler callbacks for different event types. Handlers can be
  * registered to respond to specific events, and multiple handlers
  * can be associated with each event type.
+ *
+ * Handlers are read far more often than they change. Every event type has
+ * two fixed-capacity handler tables, an atomic pointer publishes the current
+ * one. Dispatch reads the published table without locks or allocations,
+ * registration rebuilds the other table once no reader uses it anymore and
+ * publishes it in place of the current one.
  */
 class EventRegistry
 {
 public:
   /// @brief Type definition for event handler callbacks.
   using EventCallback = void (*)(const Event &);
+  /// @brief Handler taking a batch of events of its type in one call.
+  using BatchCallback = void (*)(const Event *events, size_t count);
   using PushCallback = bool (*)(const Event &);
+  /// @brief Told that the handlers of a type changed, e.g. to wake a task.
+  using ChangeCallback = void (*)(EventType type);
+  /// @brief Hands a batch for an offloaded handler to other tasks, false to
+  /// have the caller run the handler itself.
+  using OffloadCallback = bool (*)(EventType type, BatchCallback handler, uint32_t coreMask,
+                                   const Event *events, size_t count);
+
+  /// @brief Times every handler call of dispatchBatch(). Handlers are told
+  /// apart by slot: the index of a per-event handler, MAX_HANDLERS plus the
+  /// index of a batch handler, or 2 * MAX_HANDLERS plus the index of an
+  /// offloaded one, whose time is that of handing the batch over.
+  struct HandlerTimer
+  {
+    uint32_t (*nowUs)();
+    void (*record)(EventType type, size_t slot, uint32_t elapsedUs);
+  };
+
+  // Handlers per event type
+  static constexpr size_t MAX_HANDLERS = 8;
+  // Per-event, batch and offloaded handlers of a type, see HandlerTimer
+  static constexpr size_t HANDLER_SLOTS = 3 * MAX_HANDLERS;
+  // Core mask of offloaded handlers that may run anywhere
+  static constexpr uint32_t ANY_CORE = 0xFFFFFFFF;
 
   /**
    * @brief Register an event handler for a specific event type.
    * @param type The type of event to register the handler for.
    * @param cb The callback function to be invoked when the event occurs.
+   * @return False if the type already has MAX_HANDLERS handlers.
+   */
+  static bool registerHandler(EventType type, EventCallback cb);
+
+  /**
+   * @brief Register a handler that receives the events of a type in batches.
+   * @param type The type of event to register the handler for.
+   * @param cb The callback function, called once per dispatched batch.
+   * @return False if the type already has MAX_HANDLERS batch handlers.
+   */
+  static bool registerBatchHandler(EventType type, BatchCallback cb);
+
+  /**
+   * @brief Register a batch handler too heavy for the bus task. Its batches
+   * go to the offload callback and run on worker tasks, in order per event
+   * type, or on the bus task if no offload callback takes them.
+   * @param type The type of event to register the handler for.
+   * @param cb The callback function, called once per dispatched batch.
+   * @param coreMask Cores the handler may run on, bit n for core n.
+   * @return False if the type already has MAX_HANDLERS offloaded handlers.
    */
-  static void registerHandler(EventType type, EventCallback cb);
+  static bool registerOffloadHandler(EventType type, BatchCallback cb, uint32_t coreMask = ANY_CORE);
 
   /**
    * @brief Retrieve the list of registered handlers for a specific event type.
+   * Allocates the returned vector, dispatch() is the allocation free path.
    * @param type The type of event to retrieve handlers for.
    * @return A vector of callback functions registered for the event type.
    */
   static std::vector<EventCallback> getHandler(EventType type);
 
   /**
-   * @brief Clear all registered handlers for a specific event type.
+   * @brief Retrieve the list of registered batch handlers for a specific
+   * event type. Allocates the returned vector.
+   * @param type The type of event to retrieve batch handlers for.
+   * @return A vector of batch callbacks registered for the event type.
+   */
+  static std::vector<BatchCallback> getBatchHandler(EventType type);
+
+  /**
+   * @brief Retrieve the list of offloaded handlers for a specific event
+   * type. Allocates the returned vector.
+   * @param type The type of event to retrieve offloaded handlers for.
+   * @return A vector of offloaded batch callbacks registered for the type.
+   */
+  static std::vector<BatchCallback> getOffloadHandler(EventType type);
+
+  /**
+   * @brief Call every handler registered for the type of an event, in the
+   * order they were registered. Lock and allocation free.
+   * @param event The event to pass to the handlers.
+   * @return Number of handlers called.
+   */
+  static size_t dispatch(const Event &event);
+
+  /**
+   * @brief Deliver a batch of events of one type. Every event goes to the
+   * per-event handlers, then the whole batch goes to each batch handler and
+   * is offloaded for each offloaded handler. Lock and allocation free.
+   * @param events The events, all of the type of the first one.
+   * @param count Number of events.
+   * @return Number of handlers the batch went to.
+   */
+  static size_t dispatchBatch(const Event *events, size_t count);
+
+  /**
+   * @brief Dispatch a batch the caller owns, like the bus task does, and
+   * release every event after the last handler returned. Handlers only
+   * borrow the events, one that keeps an event shares it, see EventRef.
+   * @param events The events, all of the type of the first one, cleaned up.
+   * @param count Number of events.
+   * @return Number of handlers the batch went to.
+   */
+  static size_t deliverBatch(Event *events, size_t count);
+
+  /**
+   * @brief Clear all registered handlers, per-event, batch and offloaded,
+   * for a specific event type.
    * @param type The type of event to clear handlers for.
    */
   static void clearHandlers(EventType type);
@@ -59,10 +157,76 @@ public:
    */
   static bool pushEvent(const Event &event);
 
+  /**
+   * @brief Register a callback told about every change of the handlers,
+   * for backends that keep their own view of them. Called with the
+   * registration lock held, it must not register handlers itself.
+   * @param cb The callback, nullptr to clear it.
+   */
+  static void registerChangeCallback(ChangeCallback cb);
+
+  /**
+   * @brief Register the callback running offloaded handlers, see
+   * registerOffloadHandler().
+   * @param cb The callback, nullptr to run them on the dispatching task.
+   */
+  static void registerOffloadCallback(OffloadCallback cb);
+
+  /**
+   * @brief Register the timer of handler calls. Without one dispatch does
+   * not read the clock.
+   * @param timer The timer, must outlive its registration, nullptr to clear
+   * it.
+   */
+  static void registerHandlerTimer(const HandlerTimer *timer);
+
 private:
-  static std::vector<EventCallback> handlers[(size_t)EventType::COUNT];
-  static PushCallback pushCallback;
+  struct OffloadHandler
+  {
+    BatchCallback callback;
+    uint32_t coreMask;
+  };
+
+  struct HandlerSet
+  {
+    EventCallback callbacks[MAX_HANDLERS];
+    size_t count;
+    BatchCallback batchCallbacks[MAX_HANDLERS];
+    size_t batchCount;
+    OffloadHandler offloaded[MAX_HANDLERS];
+    size_t offloadCount;
+  };
+
+  struct HandlerTable
+  {
+    HandlerSet handlers;
+    std::atomic<uint32_t> readers; // Dispatches currently copying the table
+  };
+
+  // Two tables per event type, the published one and the one the next
+  // registration rebuilds
+  static HandlerTable tables[(size_t)EventType::COUNT][2];
+  static std::atomic<HandlerTable *> published[(size_t)EventType::COUNT];
+  static std::atomic<PushCallback> pushCallback;
+  static std::atomic<ChangeCallback> changeCallback;
+  static std::atomic<OffloadCallback> offloadCallback;
+  static std::atomic<const HandlerTimer *> handlerTimer;
+
+  // Serializes registrations, dispatch never takes it
   static std::mutex mutex;
+
+  // Copy the published table of a type, callbacks run on the copy so a
+  // handler may register handlers itself
+  static void readHandlers(EventType type, HandlerSet &out);
+
+  // Call the handlers of a batch, call wraps every handler call with its slot
+  template <typename Call>
+  static void runHandlers(const HandlerSet &handlers, const Event *events, size_t count, Call call);
+
+  // Rebuild the handlers of the unpublished table of a type from the
+  // published one, let modify change them and publish it. Must hold mutex.
+  template <typename Modify>
+  static bool updateHandlers(EventType type, Modify modify);
 };
 
-#endif
\ No newline at end of file
+#endif
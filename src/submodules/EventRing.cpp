@@ -0,0 +1,209 @@
+#include <submodules/EventRing.h>
+#include <cstring>
+#include <submodules/EventChannel.h>
+
+static_assert(sizeof(Event) % 4 == 0, "Events are copied as 32-bit words");
+
+EventRing::EventRing(size_t capacity)
+{
+  size_t rounded = 1;
+  while (rounded < capacity)
+    rounded <<= 1;
+  this->capacity = rounded;
+  slots.reset(new Slot[rounded]);
+  for (size_t i = 0; i < rounded; i++)
+    slots[i].recipients.store(0, std::memory_order_relaxed);
+}
+
+EventRing::~EventRing()
+{
+  for (size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    unsubscribe(static_cast<int>(i));
+}
+
+void EventRing::readSlot(const Slot &slot, Event &out) const
+{
+  uint32_t words[EVENT_WORDS];
+  for (size_t i = 0; i < EVENT_WORDS; i++)
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  memcpy(&out, words, sizeof(Event));
+}
+
+void EventRing::writeSlot(Slot &slot, const Event &event)
+{
+  uint32_t words[EVENT_WORDS];
+  memcpy(words, &event, sizeof(Event));
+  for (size_t i = 0; i < EVENT_WORDS; i++)
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+}
+
+int EventRing::subscribe(uint32_t typeMask, OverflowPolicy policy, WakeCallback wake, void *arg)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+  {
+    Subscriber &subscriber = subscribers[i];
+    if (subscriber.active.load(std::memory_order_relaxed))
+      continue;
+    subscriber.typeMask = typeMask;
+    subscriber.policy = policy;
+    subscriber.wake = wake;
+    subscriber.arg = arg;
+    subscriber.cursor.store(published.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    subscriber.received.store(0, std::memory_order_relaxed);
+    subscriber.dropped.store(0, std::memory_order_relaxed);
+    subscriber.active.store(true, std::memory_order_release);
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void EventRing::unsubscribe(int id)
+{
+  if (id < 0 || static_cast<size_t>(id) >= MAX_SUBSCRIBERS)
+    return;
+  std::lock_guard<std::mutex> lock(mutex);
+  Subscriber &subscriber = subscribers[id];
+  if (!subscriber.active.load(std::memory_order_relaxed))
+    return;
+  subscriber.active.store(false, std::memory_order_release);
+  releaseRange(id, subscriber.cursor.load(std::memory_order_acquire),
+               published.load(std::memory_order_relaxed));
+}
+
+void EventRing::setTypeMask(int id, uint32_t typeMask)
+{
+  if (id < 0 || static_cast<size_t>(id) >= MAX_SUBSCRIBERS)
+    return;
+  std::lock_guard<std::mutex> lock(mutex);
+  subscribers[id].typeMask = typeMask;
+}
+
+void EventRing::releaseRange(size_t id, uint32_t from, uint32_t to)
+{
+  for (uint32_t sequence = from; sequence != to; sequence++)
+  {
+    Slot &slot = slotOf(sequence);
+    if ((slot.recipients.load(std::memory_order_relaxed) & (1u << id)) == 0)
+      continue;
+    Event event;
+    readSlot(slot, event);
+    if (event.cleanup)
+      event.cleanup(&event);
+  }
+}
+
+void EventRing::makeRoom(size_t id, uint32_t sequence)
+{
+  Subscriber &subscriber = subscribers[id];
+  uint32_t cursor = subscriber.cursor.load(std::memory_order_acquire);
+  while (sequence - cursor >= capacity)
+  {
+    // The subscriber may take events meanwhile, the swap tells who got them
+    uint32_t target = subscriber.policy == OverflowPolicy::DropPending
+                          ? sequence
+                          : sequence - static_cast<uint32_t>(capacity) + 1;
+    if (!subscriber.cursor.compare_exchange_weak(cursor, target, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+      continue;
+
+    uint32_t skipped = 0;
+    for (uint32_t s = cursor; s != target; s++)
+      skipped += (slotOf(s).recipients.load(std::memory_order_relaxed) >> id) & 1;
+    subscriber.dropped.fetch_add(skipped, std::memory_order_relaxed);
+    releaseRange(id, cursor, target);
+    return;
+  }
+}
+
+size_t EventRing::publish(const Event &event)
+{
+  uint32_t recipients = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    {
+      const Subscriber &subscriber = subscribers[i];
+      if (subscriber.active.load(std::memory_order_relaxed) &&
+          (subscriber.typeMask & typeBit(event.type)))
+        recipients |= 1u << i;
+    }
+
+    if (recipients != 0)
+    {
+      // Every subscriber has to be past the event the slot still holds
+      uint32_t sequence = published.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+        if (subscribers[i].active.load(std::memory_order_relaxed))
+          makeRoom(i, sequence);
+
+      Slot &slot = slotOf(sequence);
+      writeSlot(slot, event);
+      slot.recipients.store(recipients, std::memory_order_relaxed);
+      for (uint32_t extra = recipients & (recipients - 1); extra != 0; extra &= extra - 1)
+        retainEvent(event);
+      published.store(sequence + 1, std::memory_order_release);
+    }
+  }
+
+  if (recipients == 0)
+  {
+    Event unwanted = event;
+    if (unwanted.cleanup)
+      unwanted.cleanup(&unwanted);
+    return 0;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+  {
+    if ((recipients & (1u << i)) == 0)
+      continue;
+    count++;
+    const Subscriber &subscriber = subscribers[i];
+    if (subscriber.wake != nullptr)
+      subscriber.wake(subscriber.arg);
+  }
+  return count;
+}
+
+size_t EventRing::poll(int id, Event *out, size_t max)
+{
+  if (id < 0 || static_cast<size_t>(id) >= MAX_SUBSCRIBERS)
+    return 0;
+  Subscriber &subscriber = subscribers[id];
+  const uint32_t bit = 1u << id;
+
+  size_t taken = 0;
+  uint32_t cursor = subscriber.cursor.load(std::memory_order_acquire);
+  while (taken < max && cursor != published.load(std::memory_order_acquire))
+  {
+    const Slot &slot = slotOf(cursor);
+    Event event;
+    readSlot(slot, event);
+    uint32_t recipients = slot.recipients.load(std::memory_order_relaxed);
+
+    // A failed swap reloads the cursor a producer moved on, the copy may be
+    // torn and is dropped
+    if (!subscriber.cursor.compare_exchange_strong(cursor, cursor + 1, std::memory_order_acq_rel,
+                                                   std::memory_order_acquire))
+      continue;
+    cursor++;
+    if (recipients & bit)
+      out[taken++] = event;
+  }
+  subscriber.received.fetch_add(static_cast<uint32_t>(taken), std::memory_order_relaxed);
+  return taken;
+}
+
+EventRing::SubscriberStats EventRing::getStats(int id) const
+{
+  SubscriberStats stats{};
+  if (id < 0 || static_cast<size_t>(id) >= MAX_SUBSCRIBERS)
+    return stats;
+  const Subscriber &subscriber = subscribers[id];
+  stats.received = subscriber.received.load(std::memory_order_relaxed);
+  stats.dropped = subscriber.dropped.load(std::memory_order_relaxed);
+  stats.lag = published.load(std::memory_order_acquire) - subscriber.cursor.load(std::memory_order_acquire);
+  return stats;
+}
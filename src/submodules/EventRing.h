@@ -0,0 +1,166 @@
+#ifndef EVENTRING_H
+#define EVENTRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared/EventTypes.h>
+
+/**
+ * @brief Event ring read by several subscribers, each at its own pace.
+ *
+ * Producers write every event once into a preallocated ring. Every subscriber
+ * has its own read cursor, so a slow one never delays the others and
+ * producers never wait for it: when a producer is about to overwrite an event
+ * a subscriber has not read yet, it moves that subscriber's cursor on as its
+ * overflow policy says and releases what the subscriber skipped.
+ *
+ * Subscribers take events without locks. They copy a slot and claim it by
+ * moving their cursor with a compare and swap. A failed swap means a producer
+ * skipped the subscriber past the slot meanwhile, and the copy is discarded.
+ * Slots are stored as 32-bit atomic words, as in SeqLockBitmap, so such a
+ * copy is never a data race. Producers serialize on a short lock that only
+ * covers the write of one slot.
+ *
+ * Payloads are shared: the ring holds one reference per subscriber that
+ * wants the event's type, and poll() hands each reference on to its
+ * subscriber.
+ */
+class EventRing
+{
+public:
+  enum class OverflowPolicy : uint8_t
+  {
+    DropOldest, // Skip the overwritten event, keep the rest of the backlog
+    DropPending // Skip the whole backlog and go on with the newest events
+  };
+
+  struct SubscriberStats
+  {
+    uint32_t received; // Events taken by poll()
+    uint32_t dropped;  // Events skipped by the overflow policy
+    uint32_t lag;      // Events published but not taken yet, any type
+  };
+
+  /// @brief Wakes a subscriber after a publish, e.g. xTaskNotifyGive.
+  using WakeCallback = void (*)(void *arg);
+
+  // Subscribers are bits of a 32-bit mask in every slot
+  static constexpr size_t MAX_SUBSCRIBERS = 16;
+  static constexpr uint32_t ALL_TYPES = (1u << static_cast<size_t>(EventType::COUNT)) - 1;
+
+  /**
+   * @brief Constructor for EventRing, allocates all slots up front.
+   * @param capacity Number of slots, rounded up to a power of two.
+   */
+  EventRing(size_t capacity);
+  ~EventRing();
+
+  EventRing(const EventRing &) = delete;
+  EventRing &operator=(const EventRing &) = delete;
+
+  /**
+   * @brief Mask bit of an event type for subscribe().
+   * @param type The event type.
+   * @return The bit.
+   */
+  static constexpr uint32_t typeBit(EventType type) { return 1u << static_cast<size_t>(type); }
+
+  /**
+   * @brief Add a subscriber, it sees events published from now on.
+   * @param typeMask Event types it takes, see typeBit().
+   * @param policy What to skip when it falls a full ring behind.
+   * @param wake Called by producers after publishing an event it takes,
+   * nullptr for subscribers that poll on their own.
+   * @param arg Passed to wake.
+   * @return Subscriber id, -1 if all MAX_SUBSCRIBERS are taken.
+   */
+  int subscribe(uint32_t typeMask, OverflowPolicy policy, WakeCallback wake, void *arg);
+
+  /**
+   * @brief Remove a subscriber and release the events it did not take. The
+   * subscriber must not poll meanwhile.
+   * @param id Id from subscribe().
+   */
+  void unsubscribe(int id);
+
+  /**
+   * @brief Change the event types a subscriber takes, from the next publish
+   * on. Events already published for it stay readable.
+   * @param id Id from subscribe().
+   * @param typeMask Event types it takes, see typeBit().
+   */
+  void setTypeMask(int id, uint32_t typeMask);
+
+  /**
+   * @brief Publish an event to every subscriber of its type.
+   * @param event The event, the ring takes its reference over. Released at
+   * once if no subscriber takes the type.
+   * @return Number of subscribers it went to.
+   */
+  size_t publish(const Event &event);
+
+  /**
+   * @brief Take the next events of a subscriber, in publish order. Only
+   * the subscriber may call it.
+   * @param id Id from subscribe().
+   * @param out Array of at least max events, the reference of every event
+   * passes to the caller.
+   * @param max Most events to take.
+   * @return Number of events taken.
+   */
+  size_t poll(int id, Event *out, size_t max);
+
+  /**
+   * @brief Read the counters of a subscriber.
+   * @param id Id from subscribe().
+   * @return Snapshot of the counters.
+   */
+  SubscriberStats getStats(int id) const;
+
+  size_t getCapacity() const { return capacity; }
+
+private:
+  static constexpr size_t EVENT_WORDS = (sizeof(Event) + 3) / 4;
+
+  struct Slot
+  {
+    std::atomic<uint32_t> words[EVENT_WORDS];
+    std::atomic<uint32_t> recipients; // Subscribers holding a reference
+  };
+
+  struct Subscriber
+  {
+    std::atomic<bool> active{false};
+    uint32_t typeMask = 0;
+    OverflowPolicy policy = OverflowPolicy::DropOldest;
+    WakeCallback wake = nullptr;
+    void *arg = nullptr;
+    std::atomic<uint32_t> cursor{0}; // Next sequence to read
+    std::atomic<uint32_t> received{0};
+    std::atomic<uint32_t> dropped{0};
+  };
+
+  size_t capacity;
+  std::unique_ptr<Slot[]> slots;
+  Subscriber subscribers[MAX_SUBSCRIBERS];
+
+  // Sequence of the next event, slots below it are readable
+  std::atomic<uint32_t> published{0};
+  // Serializes producers, subscribe and unsubscribe
+  std::mutex mutex;
+
+  Slot &slotOf(uint32_t sequence) { return slots[sequence & (capacity - 1)]; }
+  void readSlot(const Slot &slot, Event &out) const;
+  void writeSlot(Slot &slot, const Event &event);
+  // Move a lapped subscriber past sequence, releasing what it skipped. Must
+  // hold mutex.
+  void makeRoom(size_t id, uint32_t sequence);
+  // Release the reference of subscriber id to the events in [from, to).
+  // Must hold mutex.
+  void releaseRange(size_t id, uint32_t from, uint32_t to);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include <submodules/GhostFilter.h>
+
+GhostFilter::GhostFilter(size_t rowCount, size_t colCount)
+    : rowCount(rowCount), colCount(colCount)
+{
+  rowMasks.resize(rowCount);
+  ambiguousMasks.resize(rowCount);
+  multiKeyRows.reserve(rowCount);
+}
+
+size_t GhostFilter::apply(uint32_t *samples, const uint32_t *stable)
+{
+  if (colCount > MAX_COLUMNS || rowCount < 2)
+    return 0;
+
+  // A rectangle needs two rows with at least two keys each
+  multiKeyRows.clear();
+  for (size_t r = 0; r < rowCount; r++)
+  {
+    rowMasks[r] = readRow(samples, r);
+    if (__builtin_popcountll(rowMasks[r]) >= 2)
+      multiKeyRows.push_back(static_cast<uint16_t>(r));
+  }
+  if (multiKeyRows.size() < 2)
+    return 0;
+
+  // Two or more shared columns between a pair of rows form a rectangle, all
+  // keys on the shared columns of both rows are ambiguous
+  for (uint16_t r : multiKeyRows)
+    ambiguousMasks[r] = 0;
+  bool ghosting = false;
+  for (size_t i = 0; i < multiKeyRows.size(); i++)
+  {
+    for (size_t j = i + 1; j < multiKeyRows.size(); j++)
+    {
+      uint64_t shared = rowMasks[multiKeyRows[i]] & rowMasks[multiKeyRows[j]];
+      if (__builtin_popcountll(shared) >= 2)
+      {
+        ambiguousMasks[multiKeyRows[i]] |= shared;
+        ambiguousMasks[multiKeyRows[j]] |= shared;
+        ghosting = true;
+      }
+    }
+  }
+  if (!ghosting)
+    return 0;
+
+  // Keep ambiguous keys that were already held, clear the new ones
+  size_t suppressed = 0;
+  for (uint16_t r : multiKeyRows)
+  {
+    uint64_t suppress = ambiguousMasks[r] & ~readRow(stable, r);
+    while (suppress != 0)
+    {
+      size_t bitIndex = r * colCount + __builtin_ctzll(suppress);
+      suppress &= suppress - 1;
+      samples[bitIndex / 32] &= ~(1u << (bitIndex % 32));
+      suppressed++;
+    }
+  }
+  return suppressed;
+}
+
+uint64_t GhostFilter::readRow(const uint32_t *bitmap, size_t row) const
+{
+  // Gather the colCount bits of a row, which may span up to three words
+  size_t first = row * colCount;
+  size_t word = first / 32;
+  uint8_t shift = first % 32;
+  uint64_t bits = bitmap[word] >> shift;
+  size_t have = 32 - shift;
+  size_t lastWord = (first + colCount - 1) / 32;
+  while (have < colCount && ++word <= lastWord)
+  {
+    bits |= static_cast<uint64_t>(bitmap[word]) << have;
+    have += 32;
+  }
+  return colCount < 64 ? bits & ((uint64_t{1} << colCount) - 1) : bits;
+}
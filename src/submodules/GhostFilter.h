@@ -0,0 +1,57 @@
+#ifndef GHOSTFILTER_H
+#define GHOSTFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Suppresses ghost keys of diode-less matrices.
+ *
+ * Without diodes, three keys on the corners of a rectangle also connect the
+ * fourth corner, which then reads as pressed. A rectangle shows up as two rows
+ * sharing two or more pressed columns, so the filter ANDs the column masks of
+ * every pair of rows that hold at least two keys and counts the common bits.
+ * Every key on a shared column of such a pair is ambiguous: it may be real or
+ * a ghost. Ambiguous keys that are already held stay held, new ones are
+ * suppressed until the pattern clears.
+ *
+ * The cost is one AND and one popcount per pair of rows with two or more
+ * keys, scans with at most one multi-key row only extract the row masks.
+ * The bitmap is row-major like KeyScanner; rows longer than 64 columns are
+ * not filtered.
+ */
+class GhostFilter
+{
+public:
+  static constexpr size_t MAX_COLUMNS = 64;
+
+  /**
+   * @brief Constructor for GhostFilter.
+   * @param rowCount Number of matrix rows.
+   * @param colCount Number of matrix columns.
+   */
+  GhostFilter(size_t rowCount, size_t colCount);
+
+  /**
+   * @brief Filter one scan.
+   * @param samples Raw sampled bitmap, ambiguous new keys are cleared.
+   * @param stable Key state of the previous scan.
+   * @return Number of keys suppressed in this scan.
+   */
+  size_t apply(uint32_t *samples, const uint32_t *stable);
+
+private:
+  size_t rowCount;
+  size_t colCount;
+
+  // Column masks of the sampled rows and the indexes of rows with 2+ keys,
+  // kept between scans so filtering never allocates
+  std::vector<uint64_t> rowMasks;
+  std::vector<uint64_t> ambiguousMasks;
+  std::vector<uint16_t> multiKeyRows;
+
+  uint64_t readRow(const uint32_t *bitmap, size_t row) const;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <submodules/HidMapper.h>
 #include <submodules/Logger.h>
+#include <algorithm>
 static Logger log(HidMapper::NAMESPACE);
 
 HidMapper::HidMapper() {};
@@ -7,17 +8,43 @@ HidMapper::HidMapper() {};
 void HidMapper::insertMap(const uint8_t *map, size_t mapSize, uint8_t mapId)
 {
     log.debug("Inserted map of size %d with ID %d", mapSize, mapId);
-    std::vector<uint8_t> buffer;
-    buffer.assign(map, map + mapSize);
-    localToHidMaps[mapId] = buffer;
+    DeviceMap &device = localToHidMaps[mapId];
+
+    // Keys held under the old map are released, the device resends its state
+    for (size_t index = 0; index < device.localToHid.size(); index++)
+        updateKey(device, index, false);
+
+    device.localToHid.assign(map, map + mapSize);
+    device.pressedKeys.assign((mapSize + 7) / 8, 0);
 }
 
 void HidMapper::mapBitmapToHidBitmap(const uint8_t *bitmap, size_t bitmapSize, uint8_t mapId)
 {
-    // Implement mapping a bitmap to the hidBitmap via map at localToHidMaps[map]
+    if (!doesMapExist(mapId))
+    {
+        log.warn("Could not map bitmap, no map found");
+        return;
+    }
+
+    // Only keys that differ from the device's last state update their HID
+    // bit, so a released key never clears a code another key still holds.
+    // Keys beyond the map are ignored.
+    DeviceMap &device = localToHidMaps[mapId];
+    size_t keyCount = std::min(bitmapSize * 8, device.localToHid.size());
+    for (size_t byte = 0; byte * 8 < keyCount; byte++)
+    {
+        uint8_t changed = bitmap[byte] ^ device.pressedKeys[byte];
+        while (changed != 0)
+        {
+            size_t index = byte * 8 + __builtin_ctz(changed);
+            changed &= changed - 1; // Clear the lowest set bit
+            if (index < keyCount)
+                updateKey(device, index, (bitmap[byte] >> (index % 8)) & 1);
+        }
+    }
 }
 
-void HidMapper::mapIndexToHidBitmap(uint8_t index, bool bitState, uint8_t mapId)
+void HidMapper::mapIndexToHidBitmap(uint16_t index, bool bitState, uint8_t mapId)
 {
     if (!doesMapExist(mapId))
     {
@@ -25,14 +52,57 @@ void HidMapper::mapIndexToHidBitmap(uint8_t index, bool bitState, uint8_t mapId)
         return;
     }
 
-    if (index > localToHidMaps[mapId].size())
+    DeviceMap &device = localToHidMaps[mapId];
+    if (index >= device.localToHid.size())
     {
         log.warn("Could not map Index, index not inside map");
         return;
     }
 
-    uint8_t mappedBitmapIndex = localToHidMaps[mapId][index];
-    updateHidBit(bitState, mappedBitmapIndex);
+    updateKey(device, index, bitState);
+}
+
+bool HidMapper::mapKeyEventToHidBitmap(const RawKeyEvent &keyEvent, uint8_t mapId)
+{
+    if (!doesMapExist(mapId))
+    {
+        log.warn("Could not map key event, no map found");
+        return false;
+    }
+
+    DeviceMap &device = localToHidMaps[mapId];
+    if (keyEvent.keyIndex >= device.localToHid.size())
+    {
+        log.warn("Could not map key event, index not inside map");
+        return false;
+    }
+
+    return updateKey(device, keyEvent.keyIndex, keyEvent.state);
+}
+
+bool HidMapper::updateKey(DeviceMap &device, size_t index, bool pressed)
+{
+    uint8_t &pressedByte = device.pressedKeys[index / 8];
+    uint8_t keyBit = 1 << (index % 8);
+    if (((pressedByte & keyBit) != 0) == pressed)
+        return false;
+    pressedByte ^= keyBit;
+
+    // Unmapped keys and padding have no HID code
+    uint8_t hidCode = device.localToHid[index];
+    if (hidCode == 0)
+        return false;
+
+    // The HID bit follows the first press and the last release of its code
+    if (pressed)
+    {
+        if (hidCodeHolders[hidCode]++ != 0)
+            return false;
+    }
+    else if (--hidCodeHolders[hidCode] != 0)
+        return false;
+    updateHidBit(pressed, hidCode);
+    return true;
 }
 
 void HidMapper::updateHidBit(bool bitState, uint8_t bitmapBitIndex)
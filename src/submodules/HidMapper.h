@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <shared/EventTypes.h>
 #include <stdio.h>
 #include <vector>
 #include <unordered_map>
@@ -13,11 +14,23 @@ class HidMapper
 private:
   uint8_t hidBitmap[32]{0}; // 32 Bytes = 256 bits for HID report
 
-  std::unordered_map<uint8_t, std::vector<uint8_t>> localToHidMaps;
+  // Map of one sending device and the local keys it holds pressed
+  struct DeviceMap
+  {
+    std::vector<uint8_t> localToHid;  // HID code per local key, 0 for none
+    std::vector<uint8_t> pressedKeys; // One bit per local key
+  };
+  std::unordered_map<uint8_t, DeviceMap> localToHidMaps;
+
+  // Pressed keys of all devices per HID code. Several keys may share a code,
+  // e.g. Shift on both halves, its bit is set while any of them is held.
+  uint16_t hidCodeHolders[256]{0};
 
   void setBit(uint8_t bitmapBitIndex);
   void clearBit(uint8_t bitmapBitIndex);
   void updateHidBit(bool bitState, uint8_t bitmapBitIndex);
+  // Update one local key of a device, true if its HID bit changed
+  bool updateKey(DeviceMap &device, size_t index, bool pressed);
 
 public:
   HidMapper();
@@ -27,7 +40,15 @@ public:
   void insertMap(const uint8_t *map, size_t mapSize, uint8_t mapId);
 
   void mapBitmapToHidBitmap(const uint8_t *bitmap, size_t bitmapSize, uint8_t mapId);
-  void mapIndexToHidBitmap(uint8_t index, bool bitState, uint8_t mapId);
+  void mapIndexToHidBitmap(uint16_t index, bool bitState, uint8_t mapId);
+
+  /**
+   * @brief Maps a key event to its HID bit.
+   * @param keyEvent Key event with the local key index and its timestamps.
+   * @param mapId ID of the map of the sending device.
+   * @return True if the HID bitmap changed.
+   */
+  bool mapKeyEventToHidBitmap(const RawKeyEvent &keyEvent, uint8_t mapId);
 
   size_t getBitmapSize() { return 32; }
   size_t copyBitmap(uint8_t *dest, size_t destSize) const;
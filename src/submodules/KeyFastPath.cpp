@@ -0,0 +1,130 @@
+#include <submodules/KeyFastPath.h>
+#include <thread>
+
+KeyFastPath::Consumer KeyFastPath::consumers[KeyFastPath::MAX_CONSUMERS];
+std::atomic<uint8_t> KeyFastPath::activeCount{0};
+uint8_t KeyFastPath::pendingWake[KeyFastPath::MAX_PRODUCERS] = {};
+std::mutex KeyFastPath::mutex;
+
+int KeyFastPath::attach(WakeCallback wake, void *arg)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < MAX_CONSUMERS; i++)
+  {
+    Consumer &consumer = consumers[i];
+    if (consumer.active.load(std::memory_order_relaxed))
+      continue;
+
+    if (!consumer.rings)
+      consumer.rings.reset(new Ring[MAX_PRODUCERS]);
+    for (size_t p = 0; p < MAX_PRODUCERS; p++)
+      consumer.rings[p].reset();
+    consumer.wake = wake;
+    consumer.arg = arg;
+    consumer.delivered.store(0, std::memory_order_relaxed);
+    consumer.overflowed.store(0, std::memory_order_relaxed);
+
+    // Scan loops see the slot only once it is complete
+    consumer.active.store(true, std::memory_order_release);
+    activeCount.fetch_add(1, std::memory_order_release);
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void KeyFastPath::detach(int consumer)
+{
+  if (consumer < 0 || static_cast<size_t>(consumer) >= MAX_CONSUMERS)
+    return;
+  std::lock_guard<std::mutex> lock(mutex);
+  Consumer &slot = consumers[consumer];
+  if (!slot.active.exchange(false))
+    return;
+  activeCount.fetch_sub(1, std::memory_order_release);
+
+  // Scan loops that entered before the slot went inactive may still push to
+  // its rings or call its wake, the next attach resets both
+  while (slot.producers.load() != 0)
+    std::this_thread::yield();
+}
+
+bool KeyFastPath::enter(Consumer &consumer)
+{
+  // Announce the scan loop, then make sure the slot was not detached
+  // meanwhile. A detach only returns after it saw no scan loop on it.
+  consumer.producers.fetch_add(1);
+  if (consumer.active.load())
+    return true;
+  consumer.producers.fetch_sub(1, std::memory_order_release);
+  return false;
+}
+
+void KeyFastPath::leave(Consumer &consumer)
+{
+  consumer.producers.fetch_sub(1, std::memory_order_release);
+}
+
+size_t KeyFastPath::push(size_t producer, const RawKeyEvent &event)
+{
+  if (producer >= MAX_PRODUCERS || !hasConsumers())
+    return 0;
+
+  size_t reached = 0;
+  for (size_t i = 0; i < MAX_CONSUMERS; i++)
+  {
+    Consumer &consumer = consumers[i];
+    if (!enter(consumer))
+      continue;
+    if (consumer.rings[producer].push(event))
+    {
+      consumer.delivered.fetch_add(1, std::memory_order_relaxed);
+      pendingWake[producer] |= 1u << i;
+      reached++;
+    }
+    else
+      consumer.overflowed.fetch_add(1, std::memory_order_relaxed);
+    leave(consumer);
+  }
+  return reached;
+}
+
+void KeyFastPath::flush(size_t producer)
+{
+  if (producer >= MAX_PRODUCERS)
+    return;
+  uint8_t pending = pendingWake[producer];
+  pendingWake[producer] = 0;
+  for (size_t i = 0; pending != 0; i++, pending >>= 1)
+  {
+    Consumer &consumer = consumers[i];
+    if ((pending & 1) && enter(consumer))
+    {
+      consumer.wake(consumer.arg);
+      leave(consumer);
+    }
+  }
+}
+
+size_t KeyFastPath::poll(int consumer, RawKeyEvent *out, size_t max)
+{
+  if (consumer < 0 || static_cast<size_t>(consumer) >= MAX_CONSUMERS)
+    return 0;
+  Consumer &slot = consumers[consumer];
+  if (!slot.active.load(std::memory_order_acquire))
+    return 0;
+
+  size_t taken = 0;
+  for (size_t p = 0; p < MAX_PRODUCERS && taken < max; p++)
+    taken += slot.rings[p].popBatch(out + taken, max - taken);
+  return taken;
+}
+
+KeyFastPath::Stats KeyFastPath::getStats(int consumer)
+{
+  Stats stats{};
+  if (consumer < 0 || static_cast<size_t>(consumer) >= MAX_CONSUMERS)
+    return stats;
+  stats.delivered = consumers[consumer].delivered.load(std::memory_order_relaxed);
+  stats.overflowed = consumers[consumer].overflowed.load(std::memory_order_relaxed);
+  return stats;
+}
@@ -0,0 +1,131 @@
+#ifndef KEYFASTPATH_H
+#define KEYFASTPATH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared/EventTypes.h>
+#include <submodules/SpscRing.h>
+
+/**
+ * @brief Direct path for key transitions from the scan loops to the tasks
+ * that forward them with the lowest latency.
+ *
+ * On the bus a transition crosses two queues and two task switches before
+ * the transport sees it. A consumer attached here gets every transition
+ * through one lock-free ring straight from the scan loop, which wakes it
+ * once per scan that changed keys. The scan loops still publish every
+ * transition on the bus for all other subscribers, so a consumer attached
+ * here must not take key events from the bus as well.
+ *
+ * Every scan loop is a producer with a ring to every consumer, so each ring
+ * has exactly one producer and one consumer. Rings are allocated by the
+ * first attach of a consumer slot and kept for later ones. A full ring
+ * drops the transition and counts it, the ring holds more than a full
+ * chord.
+ */
+class KeyFastPath
+{
+public:
+  /// @brief Wakes a consumer, called by a scan loop, e.g. xTaskNotifyGive.
+  using WakeCallback = void (*)(void *arg);
+
+  // Scan loops, one per matrix at most, identified by their first matrix
+  static constexpr size_t MAX_PRODUCERS = 4;
+  static constexpr size_t MAX_CONSUMERS = 2;
+  static constexpr size_t RING_SIZE = 32;
+  using Ring = SpscRing<RawKeyEvent, RING_SIZE>;
+
+  struct Stats
+  {
+    uint32_t delivered;  // Transitions put in the rings of the consumer
+    uint32_t overflowed; // Transitions dropped because a ring was full
+  };
+
+  /**
+   * @brief Attach a consumer, its rings start empty.
+   * @param wake Called by a scan loop once it put transitions in the rings
+   * of the consumer.
+   * @param arg Passed to wake.
+   * @return Consumer slot, -1 if all MAX_CONSUMERS slots are taken.
+   */
+  static int attach(WakeCallback wake, void *arg);
+
+  /**
+   * @brief Detach a consumer, scan loops stop feeding it. Returns once no
+   * scan loop is inside push() or flush() on the slot, so the wake callback
+   * is not called anymore. Transitions left in its rings are dropped by the
+   * next attach of the slot.
+   * @param consumer Slot from attach().
+   */
+  static void detach(int consumer);
+
+  /**
+   * @brief Check whether any consumer is attached.
+   * @return True if scan loops feed at least one consumer.
+   */
+  static bool hasConsumers() { return activeCount.load(std::memory_order_acquire) > 0; }
+
+  /**
+   * @brief Put a transition in the rings of every attached consumer. Only
+   * the scan loop of producer may call it.
+   * @param producer Index of the scan loop, below MAX_PRODUCERS.
+   * @param event The transition.
+   * @return Number of consumers it reached.
+   */
+  static size_t push(size_t producer, const RawKeyEvent &event);
+
+  /**
+   * @brief Wake every consumer that got transitions from producer since its
+   * last flush. Only the scan loop of producer may call it.
+   * @param producer Index of the scan loop.
+   */
+  static void flush(size_t producer);
+
+  /**
+   * @brief Take transitions from the rings of a consumer, producer by
+   * producer. Only the consumer may call it.
+   * @param consumer Slot from attach().
+   * @param out Array of at least max transitions.
+   * @param max Most transitions to take.
+   * @return Number of transitions taken.
+   */
+  static size_t poll(int consumer, RawKeyEvent *out, size_t max);
+
+  /**
+   * @brief Read the counters of a consumer.
+   * @param consumer Slot from attach().
+   * @return Snapshot of the counters.
+   */
+  static Stats getStats(int consumer);
+
+private:
+  struct Consumer
+  {
+    std::atomic<bool> active;
+    std::atomic<uint8_t> producers; // Scan loops currently pushing to or waking the slot
+    WakeCallback wake;
+    void *arg;
+    std::unique_ptr<Ring[]> rings; // One per producer
+    std::atomic<uint32_t> delivered;
+    std::atomic<uint32_t> overflowed;
+  };
+
+  static Consumer consumers[MAX_CONSUMERS];
+  static std::atomic<uint8_t> activeCount;
+  // Consumers each producer put transitions in since its last flush, only
+  // touched by that producer
+  static uint8_t pendingWake[MAX_PRODUCERS];
+
+  // Serializes attach and detach, the scan loops never take it
+  static std::mutex mutex;
+
+  // Announce a scan loop on the slot, false if it is not active. A detach
+  // waits for every enter() that returned true to leave().
+  static bool enter(Consumer &consumer);
+  static void leave(Consumer &consumer);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <submodules/KeyLatencyStats.h>
+#include <cstring>
+
+void KeyLatencyStats::record(const RawKeyEvent &keyEvent, uint8_t senderId, uint32_t hidUs)
+{
+  const KeyEventTimestamps &stamps = keyEvent.timestamps;
+  stats.eventCount++;
+  if (keyEvent.scanSequence != 0)
+  {
+    recordStage(LatencyStage::ScanToBus, stamps.busUs - stamps.scanUs);
+    recordStage(LatencyStage::BusToTx, stamps.txUs - stamps.busUs);
+    recordStage(LatencyStage::TxToRx, transportDelayUs(senderId, stamps.txUs, stamps.rxUs));
+  }
+  recordStage(LatencyStage::RxToHid, hidUs - stamps.rxUs);
+}
+
+void KeyLatencyStats::reset()
+{
+  memset(&stats, 0, sizeof(stats));
+  // Clocks drift apart, a fresh baseline per window keeps the error small
+  baselines.clear();
+}
+
+void KeyLatencyStats::snapshot(KeyLatencySnapshot &out) const
+{
+  out = stats;
+}
+
+const char *KeyLatencyStats::getStageName(LatencyStage stage)
+{
+  switch (stage)
+  {
+  case LatencyStage::ScanToBus:
+    return "scan->bus";
+  case LatencyStage::BusToTx:
+    return "bus->tx";
+  case LatencyStage::TxToRx:
+    return "tx->rx";
+  case LatencyStage::RxToHid:
+    return "rx->hid";
+  default:
+    return "unknown";
+  }
+}
+
+void KeyLatencyStats::recordStage(LatencyStage stage, uint32_t latencyUs)
+{
+  size_t index = static_cast<size_t>(stage);
+  stats.totalUs[index] += latencyUs;
+  if (latencyUs > stats.maxUs[index])
+    stats.maxUs[index] = latencyUs;
+  stats.buckets[index][ScanTimingStats::bucketFor(latencyUs)]++;
+}
+
+uint32_t KeyLatencyStats::transportDelayUs(uint8_t senderId, uint32_t txUs, uint32_t rxUs)
+{
+  uint32_t offsetUs = rxUs - txUs;
+  auto it = baselines.find(senderId);
+  if (it == baselines.end())
+  {
+    baselines[senderId] = {offsetUs, 0};
+    return 0;
+  }
+
+  ClockBaseline &baseline = it->second;
+  int32_t deltaUs = static_cast<int32_t>(offsetUs - baseline.referenceOffsetUs);
+  if (deltaUs < baseline.minDeltaUs)
+    baseline.minDeltaUs = deltaUs;
+  return static_cast<uint32_t>(deltaUs - baseline.minDeltaUs);
+}
@@ -0,0 +1,88 @@
+#ifndef KEYLATENCYSTATS_H
+#define KEYLATENCYSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <shared/EventTypes.h>
+#include <submodules/ScanTimingStats.h>
+#include <unordered_map>
+
+// Stages of a key event between the scan and the HID report
+enum class LatencyStage : uint8_t
+{
+  ScanToBus, // Scan start until the event bus delivered the event
+  BusToTx,   // Event bus until the event was handed to the transport
+  TxToRx,    // Transport until the master received it, see KeyLatencyStats
+  RxToHid,   // Reception until the HID bitmap was updated
+  Count
+};
+
+static constexpr size_t LATENCY_STAGE_COUNT = static_cast<size_t>(LatencyStage::Count);
+
+// Plain copy of the latency counters, safe to memcpy and to pass in events
+struct KeyLatencySnapshot
+{
+  uint32_t eventCount; // Key events recorded in this window
+  uint32_t maxUs[LATENCY_STAGE_COUNT];
+  uint64_t totalUs[LATENCY_STAGE_COUNT];
+  uint32_t buckets[LATENCY_STAGE_COUNT][SCAN_TIMING_BUCKETS];
+};
+
+/**
+ * @brief Per-stage latency histograms of received key events.
+ *
+ * Uses the power-of-two buckets of ScanTimingStats. Scan, bus and tx are
+ * stamped on the sender's clock and rx and HID on the master's, so tx to rx
+ * cannot be measured directly. It is recorded as the delay above the fastest
+ * packet of the same sender in the current window, which takes out the clock
+ * offset and leaves the queuing and retransmission delay.
+ */
+class KeyLatencyStats
+{
+public:
+  /**
+   * @brief Record one key event.
+   * @param keyEvent Received key event with all timestamps up to rxUs set.
+   * Events without a scan sequence carry no sender timestamps, only their
+   * rx to HID latency is recorded.
+   * @param senderId ID of the sending device, selects the clock baseline.
+   * @param hidUs Timestamp the HID bitmap was updated, on the rx clock.
+   */
+  void record(const RawKeyEvent &keyEvent, uint8_t senderId, uint32_t hidUs);
+
+  /**
+   * @brief Clear all counters and clock baselines and start a new window.
+   */
+  void reset();
+
+  /**
+   * @brief Copy the counters of the current window.
+   * @param out Snapshot to fill.
+   */
+  void snapshot(KeyLatencySnapshot &out) const;
+
+  /**
+   * @brief Gets a printable name of a stage.
+   * @param stage The stage.
+   * @return Name such as "scan->bus".
+   */
+  static const char *getStageName(LatencyStage stage);
+
+private:
+  KeyLatencySnapshot stats{};
+
+  // Offset between a sender's tx clock and the rx clock. Offsets are kept
+  // relative to the first one seen, so the 32-bit wrap of either clock does
+  // not disturb the minimum.
+  struct ClockBaseline
+  {
+    uint32_t referenceOffsetUs;
+    int32_t minDeltaUs;
+  };
+  std::unordered_map<uint8_t, ClockBaseline> baselines;
+
+  void recordStage(LatencyStage stage, uint32_t latencyUs);
+  uint32_t transportDelayUs(uint8_t senderId, uint32_t txUs, uint32_t rxUs);
+};
+
+#endif
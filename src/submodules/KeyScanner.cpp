@@ -1,23 +1,13 @@
 #include <submodules/KeyScanner.h>
+#include <algorithm>
 
 KeyScanner::KeyScanner(IGpio &gpio, const uint8_t *rowPins,
                        const uint8_t *colPins, const uint8_t rowCount,
-                       const uint8_t colCount)
-    : gpio(gpio), rowPins(rowPins), colPins(colPins), rowCount(rowCount),
-      colCount(colCount)
+                       const uint8_t colCount, ScanOrder order)
+    : BitmapScanner(rowCount * colCount), gpio(gpio), rowPins(rowPins),
+      colPins(colPins), rowCount(rowCount), colCount(colCount),
+      ghostFilter(rowCount, colCount)
 {
-
-  // Calculate bitmap size in bytes
-  bitmapSize = (rowCount * colCount + 7) / 8;
-
-  // Initialize double buffers and size them appropriately
-  keyMapSwapBufferA.resize(bitmapSize);
-  keyMapSwapBufferB.resize(bitmapSize);
-
-  // Set initial buffer pointers
-  workingBuffer = keyMapSwapBufferA.data();
-  publishedBuffer = keyMapSwapBufferB.data();
-
   // Initialize GPIO pins as input pull-ups
   for (size_t r = 0; r < rowCount; r++)
   {
@@ -27,64 +17,185 @@ KeyScanner::KeyScanner(IGpio &gpio, const uint8_t *rowPins,
   {
     gpio.pinMode(colPins[c], PinMode::InputPullup);
   }
+
+  compileScanPlan(order);
 }
 
-void KeyScanner::updateKeyState()
+void KeyScanner::compileScanPlan(ScanOrder order)
 {
-  // Clear the working buffer for fresh scan
-  memset(workingBuffer, 0, bitmapSize);
+  // Resolve Auto to the orientation with fewer drive lines, as every drive
+  // line costs one step while all sense lines are read in one operation
+  if (order == ScanOrder::Auto)
+    order = (colCount < rowCount) ? ScanOrder::ColumnMajor : ScanOrder::RowMajor;
+  planOrder = order;
+
+  bool rowMajor = (order != ScanOrder::ColumnMajor);
+  const uint8_t *drivePins = rowMajor ? rowPins : colPins;
+  const uint8_t *sensePins = rowMajor ? colPins : rowPins;
+  size_t driveCount = rowMajor ? rowCount : colCount;
+  size_t senseCount = rowMajor ? colCount : rowCount;
+
+  this->sensePins = sensePins;
+  sensePinBits.resize(senseCount);
+  for (size_t i = 0; i < senseCount; i++)
+  {
+    sensePinBits[i] = pinToMask(sensePins[i]);
+    sensePinMask |= sensePinBits[i];
+  }
 
-  // Scan each row
-  for (uint8_t row = 0; row < rowCount; row++)
+  // Each step releases the line of the previous step, so only two pin mode
+  // changes happen per step. The first step releases the line the last step
+  // of the previous scan left driven.
+  scanPlan.resize(driveCount);
+  for (size_t i = 0; i < driveCount; i++)
   {
-    // Set all rows to high-Z, then drive only the active row low.
-    for (uint8_t pinIndex = 0; pinIndex < rowCount; pinIndex++)
-    {
-      gpio.pinMode(rowPins[pinIndex], PinMode::InputPullup);
-    }
-    gpio.pinMode(rowPins[row], PinMode::Output);
-    gpio.digitalWrite(rowPins[row], PinState::Low);
+    ScanStep &step = scanPlan[i];
+    step.releasePin = drivePins[(i + driveCount - 1) % driveCount];
+    step.drivePin = drivePins[i];
+    step.firstBit = rowMajor ? i * colCount : i;
+    step.bitStride = rowMajor ? 1 : colCount;
+    drivePinMask |= pinToMask(drivePins[i]);
+  }
+}
 
-    // Scan each column for key presses
-    for (uint8_t col = 0; col < colCount; col++)
-    {
-      bool isKeyPressed = (gpio.digitalRead(colPins[col]) == PinState::Low);
-      bool wasPressed = wasKeyPressed(row, col);
+void KeyScanner::sampleKeys()
+{
+  // A matrix without rows or columns has no keys to sample
+  if (scanPlan.empty())
+    return;
 
-      // Update working buffer and trigger callbacks on state change
-      if (isKeyPressed)
-        setKey(row, col);
-      if (isKeyPressed && !wasPressed && onKeyChange)
-      {
-        onKeyChange(getBitIndex(row, col), true); // Key press event detected
-      }
-      else if (!isKeyPressed && wasPressed && onKeyChange)
-      {
-        onKeyChange(getBitIndex(row, col), false); // Key release event detected
-      }
-    }
+  // Replay the scan plan
+  for (const ScanStep &step : scanPlan)
+  {
+    gpio.pinMode(step.releasePin, PinMode::InputPullup);
+    gpio.pinMode(step.drivePin, PinMode::Output);
+    gpio.digitalWrite(step.drivePin, PinState::Low);
+
+    // Sample all sense lines at once, pressed keys pull their line low
+    uint64_t pressedPins = ~gpio.readPins(sensePinMask) & sensePinMask;
+    sampleStep(step, pressedPins);
   }
-  // Swap the working and published buffers
-  swapBuffers();
+
+  // Hold back keys that could be ghosts before the debouncer sees them
+  if (ghostFilterEnabled)
+    ghostFilter.apply(workingBuffer, publishedBuffer);
 }
 
-void KeyScanner::setKey(uint8_t row, uint8_t col)
+void KeyScanner::sampleHeldKeys()
 {
-  // Set the corresponding bit in the working buffer
-  workingBuffer[getByteIndex(row, col)] |= (getBitMask(row, col));
+  // Lines without held keys have nothing to copy from the published state,
+  // only the lines with held keys are driven and sampled. Like a full scan,
+  // start by releasing the line the last step of the previous scan drove.
+  if (scanPlan.empty())
+    return;
+  uint8_t drivenPin = scanPlan.back().drivePin;
+  for (const ScanStep &step : scanPlan)
+  {
+    if (!stepHasHeldKeys(step))
+      continue;
+
+    gpio.pinMode(drivenPin, PinMode::InputPullup);
+    gpio.pinMode(step.drivePin, PinMode::Output);
+    gpio.digitalWrite(step.drivePin, PinState::Low);
+    drivenPin = step.drivePin;
+
+    uint64_t pressedPins = ~gpio.readPins(sensePinMask) & sensePinMask;
+    sampleStep(step, pressedPins);
+  }
+
+  // Full scans expect only the line of their last step to be left driven
+  if (drivenPin != scanPlan.back().drivePin)
+    gpio.pinMode(drivenPin, PinMode::InputPullup);
+
+  if (ghostFilterEnabled)
+    ghostFilter.apply(workingBuffer, publishedBuffer);
 }
 
-bool KeyScanner::wasKeyPressed(uint8_t row, uint8_t col)
+bool KeyScanner::stepHasHeldKeys(const ScanStep &step) const
 {
-  // Check the corresponding bit in the published buffer
-  return (publishedBuffer[getByteIndex(row, col)] & (getBitMask(row, col))) !=
-         0;
+  uint16_t bitIndex = step.firstBit;
+  for (size_t i = 0; i < sensePinBits.size(); i++, bitIndex += step.bitStride)
+  {
+    if ((publishedBuffer[bitIndex / 32] >> (bitIndex % 32)) & 1)
+      return true;
+  }
+  return false;
 }
 
-void KeyScanner::swapBuffers()
+KeyScanner::~KeyScanner()
 {
-  // Swap the working and published buffer pointers
-  std::swap(workingBuffer, publishedBuffer);
+  // The interrupts would call the handler with an arg that may be gone
+  if (isIdle())
+    exitIdle();
+}
+
+bool KeyScanner::enterIdle(PinInterruptHandler wakeHandler, void *arg)
+{
+  // Drive every line low at once, a press on any key then pulls its sense line
+  for (const ScanStep &step : scanPlan)
+    gpio.pinMode(step.drivePin, PinMode::Output);
+  gpio.writePins(drivePinMask, PinState::Low);
+
+  for (size_t i = 0; i < sensePinBits.size(); i++)
+    gpio.attachPinInterrupt(sensePins[i], PinEdge::Falling, wakeHandler, arg);
+  idle = true;
+
+  // A key that went down before the interrupts were armed produced no edge
+  if (gpio.readPins(sensePinMask) != sensePinMask)
+  {
+    exitIdle();
+    return false;
+  }
+  return true;
+}
+
+void KeyScanner::exitIdle()
+{
+  for (size_t i = 0; i < sensePinBits.size(); i++)
+    gpio.detachPinInterrupt(sensePins[i]);
+  for (const ScanStep &step : scanPlan)
+    gpio.pinMode(step.drivePin, PinMode::InputPullup);
+  idle = false;
+}
+
+void KeyScanner::sampleStep(const ScanStep &step, uint64_t pressedPins)
+{
+  size_t senseCount = sensePinBits.size();
+
+  // Column sense lines are consecutive keys of a row: build the row bitmask in
+  // chunks of up to 32 columns and merge each chunk in one go
+  if (step.bitStride == 1)
+  {
+    for (size_t first = 0; first < senseCount; first += 32)
+    {
+      uint8_t chunkSize = static_cast<uint8_t>(std::min<size_t>(32, senseCount - first));
+      uint32_t rowBits = 0;
+      for (uint8_t i = 0; i < chunkSize; i++)
+      {
+        if (pressedPins & sensePinBits[first + i])
+          rowBits |= (1u << i);
+      }
+      mergeRowBits(step.firstBit + first, rowBits, chunkSize);
+    }
+    return;
+  }
+
+  // Row sense lines are one column of keys, spaced a row apart in the bitmap
+  if (pressedPins == 0)
+    return;
+  uint16_t bitIndex = step.firstBit;
+  for (size_t i = 0; i < senseCount; i++, bitIndex += step.bitStride)
+  {
+    if (pressedPins & sensePinBits[i])
+      workingBuffer[bitIndex / 32] |= (1u << (bitIndex % 32));
+  }
+}
+
+void KeyScanner::setKey(uint8_t row, uint8_t col)
+{
+  // Set the corresponding bit in the working buffer
+  uint16_t bitIndex = getBitIndex(row, col);
+  workingBuffer[bitIndex / 32] |= (1u << (bitIndex % 32));
 }
 
 uint8_t KeyScanner::getBitMask(uint8_t row, uint8_t col)
@@ -99,19 +210,8 @@ uint16_t KeyScanner::getBitIndex(uint8_t row, uint8_t col)
   return (row * colCount + col);
 }
 
-uint8_t KeyScanner::getByteIndex(uint8_t row, uint8_t col)
+uint16_t KeyScanner::getByteIndex(uint8_t row, uint8_t col)
 {
   // Calculate the byte index in the buffer for the key at (row, col)
   return getBitIndex(row, col) / 8;
 }
-
-void KeyScanner::copyPublishedBitmap(uint8_t *dest, size_t destSize) const
-{
-  // Copy the published key state bitmap to the provided destination buffer
-  size_t n = std::min(bitmapSize, destSize);
-  memcpy(dest, publishedBuffer, n);
-  if (destSize > n)
-  {
-    memset(dest + n, 0, destSize - n);
-  }
-}
\ No newline at end of file
@@ -3,8 +3,10 @@
 
 #include <cstdint>
 #include <cstring>
-#include <functional>
 #include <interfaces/IGpio.h>
+#include <submodules/BitmapScanner.h>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <submodules/GhostFilter.h>
 #include <vector>
 
 /**
@@ -17,7 +19,7 @@
  * maintains the current state of the keys, and allows registration
  * of callback functions to handle key state changes.
  */
-class KeyScanner
+class KeyScanner : public BitmapScanner
 {
 private:
   // Reference to the GPIO interface for pin operations. Interface allows for
@@ -30,28 +32,45 @@ private:
   size_t rowCount;
   size_t colCount;
 
-  // Size of the bitmap representing key states in bytes.
-  size_t bitmapSize;
+  using ScanOrder = KeyScannerConfig::ScanOrder;
 
-  // Buffers for storing key states. Used for double buffering to avoid
-  // read/write conflicts.
-  std::vector<uint8_t> keyMapSwapBufferA;
-  std::vector<uint8_t> keyMapSwapBufferB;
-
-  // Pointers to the current working and published buffers.
-  uint8_t *workingBuffer;
-  uint8_t *publishedBuffer;
-
-  // Callback function to be invoked on key state changes.
-  std::function<void(uint16_t keyIndex, bool pressed)> onKeyChange;
+  // One step of the scan plan: drive one line and sample all sense lines.
+  struct ScanStep
+  {
+    uint8_t releasePin; // Line driven by the previous step, released first
+    uint8_t drivePin;   // Line driven low during this step
+    uint16_t firstBit;  // Bit index of the key on the first sense line
+    uint16_t bitStride; // Bit distance between keys on consecutive sense lines
+  };
+
+  // Scan plan compiled once in the constructor, updateKeyState() only replays
+  // it. Either rows or columns are the drive lines, the others are sensed.
+  std::vector<ScanStep> scanPlan;
+  ScanOrder planOrder;
+
+  // Bulk read mask covering all sense pins, and the mask bit of each sense
+  // line. Precomputed so a step can be sampled with a single readPins() call.
+  const uint8_t *sensePins = nullptr;
+  uint64_t sensePinMask = 0;
+  std::vector<uint64_t> sensePinBits;
+
+  // Bulk write mask covering all drive pins, used to drive all at once in idle.
+  uint64_t drivePinMask = 0;
+
+  // Optional anti-ghosting stage between sampling and debouncing.
+  GhostFilter ghostFilter;
+  bool ghostFilterEnabled = false;
 
   // Internal helper methods
   void setKey(uint8_t row, uint8_t col);
-  bool wasKeyPressed(uint8_t row, uint8_t col);
-  void swapBuffers();
+  void compileScanPlan(ScanOrder order);
+  void sampleKeys() override;
+  void sampleHeldKeys() override;
+  void sampleStep(const ScanStep &step, uint64_t pressedPins);
+  bool stepHasHeldKeys(const ScanStep &step) const;
   uint8_t getBitMask(uint8_t row, uint8_t col);
   uint16_t getBitIndex(uint8_t row, uint8_t col);
-  uint8_t getByteIndex(uint8_t row, uint8_t col);
+  uint16_t getByteIndex(uint8_t row, uint8_t col);
 
 #ifdef UNIT_TEST
   friend class TestKeyScanner;
@@ -65,45 +84,48 @@ public:
    * @param colPins Array of GPIO pin numbers for the columns.
    * @param rowCount Number of rows in the key matrix.
    * @param colCount Number of columns in the key matrix.
+   * @param order Which lines to drive. Auto drives whichever of rows and
+   * columns has fewer lines and is only valid for diode-less matrices.
    */
   KeyScanner(IGpio &gpio, const uint8_t *rowPins, const uint8_t *colPins,
-             const uint8_t rowCount, const uint8_t colCount);
+             const uint8_t rowCount, const uint8_t colCount,
+             ScanOrder order = ScanOrder::RowMajor);
 
   /**
-   * @brief Registers a callback function to be invoked on key state changes.
-   * @param callback The callback function taking keyIndex and pressed state.
+   * @brief Destructor for KeyScanner, disarms the wake interrupts if idle.
    */
-  void registerOnKeyChangeCallback(
-      const std::function<void(uint16_t keyIndex, bool pressed)> &callback)
-  {
-    onKeyChange = callback;
-  }
+  ~KeyScanner() override;
 
   /**
-   * @brief Clears the registered key change callback.
+   * @brief Gets the scan order the scan plan was compiled for.
+   * @return RowMajor or ColumnMajor, Auto is resolved at construction.
    */
-  void clearOnKeyChangeCallback() { onKeyChange = nullptr; }
+  ScanOrder getScanOrder() const { return planOrder; }
 
   /**
-   * @brief Copies the published key state bitmap to the provided destination
-   * buffer.
-   * @param dest Pointer to the destination buffer.
-   * @param destSize Size of the destination buffer in bytes.
+   * @brief Enables suppression of ghost keys, only needed for matrices
+   * without diodes.
+   * @param enabled True to filter every scan.
    */
-  void copyPublishedBitmap(uint8_t *dest, size_t destSize) const;
+  void setGhostFilter(bool enabled) { ghostFilterEnabled = enabled; }
 
   /**
-   * @brief Gets the size of the key state bitmap in bytes.
-   * @return Size of the bitmap in bytes.
+   * @brief Prepares the matrix to wake the caller on the next key press.
+   *
+   * Drives all drive lines low at once so any press pulls its sense line low,
+   * and arms a falling-edge interrupt on every sense line. If a key is already
+   * down no edge would follow, in that case idle is not entered.
+   * @param wakeHandler Handler invoked from interrupt context on a press.
+   * @param arg Argument passed to the handler.
+   * @return True if idle was entered, false if a key is currently pressed.
    */
-  const size_t getBitMapSize() const { return bitmapSize; }
+  bool enterIdle(PinInterruptHandler wakeHandler, void *arg) override;
 
   /**
-   * @brief Scans the key matrix and updates key states.
-   *
-   * This method should be called periodically to detect key state changes.
+   * @brief Disarms the wake interrupts and releases all drive lines.
+   * Called automatically by updateKeyState() while idle.
    */
-  void updateKeyState();
+  void exitIdle() override;
 };
 
 #endif
\ No newline at end of file
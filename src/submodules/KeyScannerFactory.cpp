@@ -0,0 +1,95 @@
+#include <submodules/KeyScannerFactory.h>
+#include <submodules/DirectPinScanner.h>
+#include <submodules/DuplexMatrixScanner.h>
+#include <submodules/KeyScanner.h>
+#include <submodules/Logger.h>
+#include <submodules/ShiftRegisterScanner.h>
+
+static Logger log(KeyScannerFactory::NAMESPACE);
+
+using ScanTopology = KeyScannerConfig::ScanTopology;
+
+std::unique_ptr<IKeyScanner> KeyScannerFactory::create(IGpio &gpio, const KeyScannerConfig &config,
+                                                       const uint8_t *rowPins, const uint8_t *colPins)
+{
+  return createEngine(gpio, config.getMatrix(0), rowPins, colPins);
+}
+
+std::unique_ptr<IKeyScanner> KeyScannerFactory::create(IGpio &gpio,
+                                                       const KeyScannerConfig::ScanMatrix &matrix)
+{
+  return createEngine(gpio, matrix, matrix.rowPins.data(), matrix.colPins.data());
+}
+
+std::unique_ptr<IKeyScanner> KeyScannerFactory::createEngine(IGpio &gpio,
+                                                             const KeyScannerConfig::ScanMatrix &matrix,
+                                                             const uint8_t *rowPins,
+                                                             const uint8_t *colPins)
+{
+  uint8_t rowCount = matrix.rowPins.size();
+  uint8_t colCount = matrix.colPins.size();
+
+  switch (matrix.topology)
+  {
+  case ScanTopology::Matrix:
+  {
+    if (rowCount == 0 || colCount == 0)
+    {
+      log.error("Matrix topology needs at least one row and one column pin");
+      return nullptr;
+    }
+    KeyScanner *scanner =
+        new KeyScanner(gpio, rowPins, colPins, rowCount, colCount, matrix.scanOrder);
+    scanner->setGhostFilter(matrix.ghostFilter);
+    return std::unique_ptr<IKeyScanner>(scanner);
+  }
+
+  case ScanTopology::DirectPins:
+    if (colCount == 0)
+    {
+      log.error("Direct pin topology needs at least one key pin");
+      return nullptr;
+    }
+    return std::unique_ptr<IKeyScanner>(new DirectPinScanner(gpio, colPins, colCount));
+
+  case ScanTopology::ShiftRegister:
+    if (rowCount != 2 || colCount != 1 || matrix.shiftRegisterCount == 0)
+    {
+      log.error("Shift register topology needs load and clock as row pins, the data pin "
+                "as column pin and at least one register");
+      return nullptr;
+    }
+    return std::unique_ptr<IKeyScanner>(new ShiftRegisterScanner(
+        gpio, rowPins[0], rowPins[1], colPins[0], matrix.shiftRegisterCount));
+
+  case ScanTopology::DuplexMatrix:
+    if (rowCount == 0 || colCount == 0)
+    {
+      log.error("Duplex matrix topology needs at least one row and one column pin");
+      return nullptr;
+    }
+    return std::unique_ptr<IKeyScanner>(
+        new DuplexMatrixScanner(gpio, rowPins, colPins, rowCount, colCount));
+
+  default:
+    log.error("Unknown scan topology %d", static_cast<uint8_t>(matrix.topology));
+    return nullptr;
+  }
+}
+
+const char *KeyScannerFactory::getTopologyName(ScanTopology topology)
+{
+  switch (topology)
+  {
+  case ScanTopology::Matrix:
+    return "matrix";
+  case ScanTopology::DirectPins:
+    return "direct pins";
+  case ScanTopology::ShiftRegister:
+    return "shift register";
+  case ScanTopology::DuplexMatrix:
+    return "duplex matrix";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef KEYSCANNERFACTORY_H
+#define KEYSCANNERFACTORY_H
+
+#include <cstdint>
+#include <interfaces/IGpio.h>
+#include <interfaces/IKeyScanner.h>
+#include <memory>
+#include <submodules/Config/KeyScannerConfig.h>
+
+/**
+ * @brief Creates the scanner engine for the topology of a KeyScannerConfig.
+ */
+class KeyScannerFactory
+{
+public:
+  static constexpr const char *NAMESPACE = "KeyScannerFactory";
+
+  /**
+   * @brief Create the scanner engine described by the config.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param config Config selecting topology, pins and counts.
+   * @param rowPins Row pins of the config, must outlive the scanner.
+   * @param colPins Column pins of the config, must outlive the scanner.
+   * @return The scanner, or nullptr if the pins do not fit the topology.
+   */
+  static std::unique_ptr<IKeyScanner> create(IGpio &gpio, const KeyScannerConfig &config,
+                                             const uint8_t *rowPins, const uint8_t *colPins);
+
+  /**
+   * @brief Create the scanner engine of one matrix of a config.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param matrix Matrix selecting topology, pins and counts, must outlive
+   * the scanner.
+   * @return The scanner, or nullptr if the pins do not fit the topology.
+   */
+  static std::unique_ptr<IKeyScanner> create(IGpio &gpio,
+                                             const KeyScannerConfig::ScanMatrix &matrix);
+
+  /**
+   * @brief Get a printable name of a topology.
+   * @param topology Scan topology.
+   * @return Name of the topology.
+   */
+  static const char *getTopologyName(KeyScannerConfig::ScanTopology topology);
+
+private:
+  static std::unique_ptr<IKeyScanner> createEngine(IGpio &gpio,
+                                                   const KeyScannerConfig::ScanMatrix &matrix,
+                                                   const uint8_t *rowPins, const uint8_t *colPins);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <submodules/PayloadPool.h>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <submodules/EventBusStats.h>
+#include <submodules/ScanTimingStats.h>
+
+PayloadPool::PayloadPool(size_t blockSize, size_t blockCount, FallbackPolicy fallback)
+    : blockSize((blockSize + 7) & ~size_t{7}),
+      blockCount(blockSize == 0 ? 0 : std::min(blockCount, MAX_BLOCK_COUNT)),
+      fallback(fallback),
+      storage(new uint8_t[this->blockSize * this->blockCount]),
+      nextFree(new std::atomic<uint16_t>[this->blockCount]),
+      refs(new std::atomic<uint16_t>[this->blockCount])
+{
+  for (size_t i = 0; i < this->blockCount; i++)
+  {
+    nextFree[i].store(i + 1 < this->blockCount ? i + 1 : LIST_END, std::memory_order_relaxed);
+    refs[i].store(0, std::memory_order_relaxed);
+  }
+  freeHead.store(this->blockCount > 0 ? 0 : LIST_END, std::memory_order_release);
+}
+
+uint16_t PayloadPool::popFree()
+{
+  uint32_t head = freeHead.load(std::memory_order_acquire);
+  for (;;)
+  {
+    uint16_t index = head & 0xFFFF;
+    if (index == LIST_END)
+      return LIST_END;
+
+    // Stale if another task took the block meanwhile, the tag then fails
+    // the exchange
+    uint16_t next = nextFree[index].load(std::memory_order_relaxed);
+    uint32_t newHead = (((head >> 16) + 1) << 16) | next;
+    if (freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire,
+                                       std::memory_order_acquire))
+      return index;
+  }
+}
+
+void PayloadPool::pushFree(uint16_t index)
+{
+  uint32_t head = freeHead.load(std::memory_order_relaxed);
+  uint32_t newHead;
+  do
+  {
+    nextFree[index].store(head & 0xFFFF, std::memory_order_relaxed);
+    newHead = (((head >> 16) + 1) << 16) | index;
+  } while (!freeHead.compare_exchange_weak(head, newHead, std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+void *PayloadPool::fallbackAllocate(size_t size)
+{
+  if (fallback == FallbackPolicy::Drop && size <= blockSize)
+  {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  uint8_t *header = static_cast<uint8_t *>(malloc(HEAP_HEADER_SIZE + size));
+  if (header == nullptr)
+    return nullptr;
+  fallbacks.fetch_add(1, std::memory_order_relaxed);
+  heapInUse.fetch_add(1, std::memory_order_relaxed);
+  new (header) std::atomic<uint16_t>(1);
+  return header + HEAP_HEADER_SIZE;
+}
+
+void *PayloadPool::allocate(size_t size)
+{
+  if (size > blockSize)
+    return fallbackAllocate(size);
+
+  uint16_t index = popFree();
+  if (index == LIST_END)
+  {
+    exhausted.fetch_add(1, std::memory_order_relaxed);
+    return fallbackAllocate(size);
+  }
+
+  uint16_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+  uint16_t peak = highWater.load(std::memory_order_relaxed);
+  while (used > peak && !highWater.compare_exchange_weak(peak, used, std::memory_order_relaxed))
+  {
+  }
+  refs[index].store(1, std::memory_order_relaxed);
+  return storage.get() + size_t{index} * blockSize;
+}
+
+std::atomic<uint16_t> &PayloadPool::refCount(void *block)
+{
+  if (!owns(block))
+    return *reinterpret_cast<std::atomic<uint16_t> *>(static_cast<uint8_t *>(block) - HEAP_HEADER_SIZE);
+  size_t offset = static_cast<uint8_t *>(block) - storage.get();
+  return refs[offset / blockSize];
+}
+
+void PayloadPool::retain(void *block)
+{
+  if (block != nullptr)
+    refCount(block).fetch_add(1, std::memory_order_relaxed);
+}
+
+void PayloadPool::release(void *block)
+{
+  if (block == nullptr)
+    return;
+  // Acquire on the last reference, the writes of every other holder happen
+  // before the block is reused
+  if (refCount(block).fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  if (!owns(block))
+  {
+    heapInUse.fetch_sub(1, std::memory_order_relaxed);
+    free(static_cast<uint8_t *>(block) - HEAP_HEADER_SIZE);
+    return;
+  }
+  size_t offset = static_cast<uint8_t *>(block) - storage.get();
+  inUse.fetch_sub(1, std::memory_order_relaxed);
+  pushFree(static_cast<uint16_t>(offset / blockSize));
+}
+
+bool PayloadPool::owns(const void *block) const
+{
+  const uint8_t *address = static_cast<const uint8_t *>(block);
+  return address >= storage.get() && address < storage.get() + blockSize * blockCount;
+}
+
+PayloadPool::Stats PayloadPool::getStats() const
+{
+  Stats stats{};
+  stats.blockSize = static_cast<uint16_t>(blockSize);
+  stats.blockCount = static_cast<uint16_t>(blockCount);
+  stats.inUse = inUse.load(std::memory_order_relaxed);
+  stats.highWater = highWater.load(std::memory_order_relaxed);
+  stats.heapInUse = heapInUse.load(std::memory_order_relaxed);
+  stats.exhausted = exhausted.load(std::memory_order_relaxed);
+  stats.fallbacks = fallbacks.load(std::memory_order_relaxed);
+  stats.dropped = dropped.load(std::memory_order_relaxed);
+  return stats;
+}
+
+PayloadPool &PayloadPool::forType(EventType type)
+{
+  // Bitmaps that spill out of the event, up to 512 keys, larger ones come
+  // from the heap. Snapshots are resent periodically, the next one replaces
+  // a dropped one.
+  static constexpr size_t RAW_BITMAP_BLOCK_SIZE = 64;
+
+  // Blocks cover a full event bus queue of one type, stats come once a
+  // window per matrix, bus stats once a window. HID bitmaps fit inline, a spilled one must not drop,
+  // it would lose a key change.
+  static PayloadPool pools[] = {
+      {0, 0, FallbackPolicy::Heap}, // RawKey
+      {RAW_BITMAP_BLOCK_SIZE, 32, FallbackPolicy::Drop},
+      {0, 0, FallbackPolicy::Heap}, // HidBitmap
+      {0, 0, FallbackPolicy::Heap}, // ConfigUpdate
+      {sizeof(ScanTimingSnapshot), 4, FallbackPolicy::Drop},
+      {sizeof(EventBusSnapshot), 2, FallbackPolicy::Drop},
+  };
+  static_assert(sizeof(pools) / sizeof(pools[0]) == static_cast<size_t>(EventType::COUNT),
+                "One pool per event type");
+  return pools[static_cast<size_t>(type)];
+}
+
+void *allocateEventPayload(EventType type, size_t size)
+{
+  return PayloadPool::forType(type).allocate(size);
+}
+
+void retainEventPayload(EventType type, void *payload)
+{
+  PayloadPool::forType(type).retain(payload);
+}
+
+void releaseEventPayload(EventType type, void *payload)
+{
+  PayloadPool::forType(type).release(payload);
+}
@@ -0,0 +1,142 @@
+#ifndef PAYLOADPOOL_H
+#define PAYLOADPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared/EventTypes.h>
+
+/**
+ * @brief Lock-free pool of fixed-size blocks for event payloads.
+ *
+ * Stats events and bitmaps too large to travel inside the event carry their
+ * payload by pointer. Taking those blocks from a pool instead of the heap
+ * keeps the allocator lock out of the scan and bus tasks and the heap from
+ * fragmenting at bitmap rates.
+ *
+ * Free blocks form a singly linked list of 16-bit indexes. The list head packs
+ * the first index with a 16-bit tag that every push and pop increments, so a
+ * compare and swap fails when the head was popped and pushed back meanwhile.
+ * 32-bit atomics are lock-free on every target, 64-bit ones are not on the
+ * ESP32. Allocation and release are safe from any task on either core.
+ *
+ * Every event type has its own size class, see forType(). When a pool is
+ * empty the fallback policy decides between the heap and dropping the
+ * payload. Payloads larger than the blocks always come from the heap.
+ *
+ * Blocks are reference counted so several holders can share one payload
+ * without copying it: allocate() hands out the first reference, retain()
+ * adds one and release() returns the block with the last. Heap blocks keep
+ * their count in a header in front of the payload.
+ */
+class PayloadPool
+{
+public:
+  enum class FallbackPolicy : uint8_t
+  {
+    Heap, // Allocate from the heap, for payloads that must be delivered
+    Drop  // Refuse, for payloads the next event supersedes
+  };
+
+  struct Stats
+  {
+    uint16_t blockSize;
+    uint16_t blockCount;
+    uint16_t inUse;     // Pool blocks currently allocated
+    uint16_t highWater; // Most pool blocks allocated at the same time
+    uint16_t heapInUse; // Heap blocks currently allocated
+    uint32_t exhausted; // Allocations that found the pool empty
+    uint32_t fallbacks; // Allocations served from the heap, oversized ones included
+    uint32_t dropped;   // Allocations refused by the Drop policy
+  };
+
+  // Largest pool, block indexes are 16 bit and one value marks the list end
+  static constexpr size_t MAX_BLOCK_COUNT = 0xFFFE;
+
+  /**
+   * @brief Constructor for PayloadPool, allocates all blocks up front.
+   * @param blockSize Size of a block in bytes, rounded up to 8 for alignment.
+   * @param blockCount Number of blocks, at most MAX_BLOCK_COUNT.
+   * @param fallback What to do when no block is available.
+   */
+  PayloadPool(size_t blockSize, size_t blockCount, FallbackPolicy fallback);
+
+  PayloadPool(const PayloadPool &) = delete;
+  PayloadPool &operator=(const PayloadPool &) = delete;
+
+  /**
+   * @brief Take a block for a payload.
+   * @param size Size of the payload in bytes.
+   * @return Block of at least size bytes, nullptr if the fallback policy
+   * refused or the heap is out of memory.
+   */
+  void *allocate(size_t size);
+
+  /**
+   * @brief Take another reference to a block from allocate().
+   * @param block The block, nullptr is ignored.
+   */
+  void retain(void *block);
+
+  /**
+   * @brief Drop a reference to a block from allocate(), the last one
+   * returns the block to the pool or frees a heap block.
+   * @param block The block, nullptr is ignored.
+   */
+  void release(void *block);
+
+  /**
+   * @brief Check whether a block lies in the pool storage.
+   * @param block The block.
+   * @return True for pool blocks, false for heap blocks.
+   */
+  bool owns(const void *block) const;
+
+  /**
+   * @brief Read the usage counters.
+   * @return Snapshot of the counters, each one read atomically.
+   */
+  Stats getStats() const;
+
+  /**
+   * @brief Gets the pool of the payloads of an event type. The pools are
+   * created on first use and live for the whole program.
+   * @param type The event type.
+   * @return The pool, types without payload have an empty one.
+   */
+  static PayloadPool &forType(EventType type);
+
+private:
+  static constexpr uint16_t LIST_END = 0xFFFF;
+  // Reference count in front of heap blocks, sized to keep payloads aligned
+  static constexpr size_t HEAP_HEADER_SIZE = 8;
+
+  size_t blockSize;
+  size_t blockCount;
+  FallbackPolicy fallback;
+  std::unique_ptr<uint8_t[]> storage;
+
+  // Next free block of every free block, LIST_END terminates the list
+  std::unique_ptr<std::atomic<uint16_t>[]> nextFree;
+  // Tag in the upper, index of the first free block in the lower half
+  std::atomic<uint32_t> freeHead;
+  // Reference count of every block, 0 while it is free
+  std::unique_ptr<std::atomic<uint16_t>[]> refs;
+
+  std::atomic<uint16_t> inUse{0};
+  std::atomic<uint16_t> highWater{0};
+  std::atomic<uint16_t> heapInUse{0};
+  std::atomic<uint32_t> exhausted{0};
+  std::atomic<uint32_t> fallbacks{0};
+  std::atomic<uint32_t> dropped{0};
+
+  // Pop the first free block, LIST_END if there is none
+  uint16_t popFree();
+  void pushFree(uint16_t index);
+  void *fallbackAllocate(size_t size);
+  // Reference count of a pool or heap block
+  std::atomic<uint16_t> &refCount(void *block);
+};
+
+#endif
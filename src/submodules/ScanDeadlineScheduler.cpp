@@ -0,0 +1,80 @@
+#include <submodules/ScanDeadlineScheduler.h>
+#include <algorithm>
+
+ScanDeadlineScheduler::ScanDeadlineScheduler(uint32_t guardUs)
+    : guardUs(guardUs)
+{
+}
+
+size_t ScanDeadlineScheduler::addSource(uint32_t periodUs)
+{
+  sources.push_back({std::max<uint32_t>(periodUs, 1), 0, 0});
+  return sources.size() - 1;
+}
+
+void ScanDeadlineScheduler::reset(uint64_t nowUs)
+{
+  for (Source &source : sources)
+    source.deadlineUs = nowUs;
+}
+
+void ScanDeadlineScheduler::setPeriod(size_t source, uint32_t periodUs, uint64_t nowUs)
+{
+  sources[source].periodUs = std::max<uint32_t>(periodUs, 1);
+  sources[source].deadlineUs = nowUs + sources[source].periodUs;
+}
+
+size_t ScanDeadlineScheduler::nextDue(uint64_t nowUs) const
+{
+  // Earliest deadline and smallest gap between the scans of the higher
+  // priority sources checked so far, none of them is due
+  uint64_t blockingDeadlineUs = UINT64_MAX;
+  uint64_t smallestGapUs = UINT64_MAX;
+
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    const Source &source = sources[i];
+    if (source.deadlineUs <= nowUs)
+    {
+      uint64_t neededUs = uint64_t{source.estimateUs} + guardUs;
+      if (nowUs + neededUs <= blockingDeadlineUs || neededUs > smallestGapUs)
+        return i;
+    }
+    blockingDeadlineUs = std::min(blockingDeadlineUs, source.deadlineUs);
+    uint32_t gapUs = source.periodUs > source.estimateUs ? source.periodUs - source.estimateUs : 0;
+    smallestGapUs = std::min<uint64_t>(smallestGapUs, gapUs);
+  }
+  return NONE;
+}
+
+uint64_t ScanDeadlineScheduler::getNextWakeUs(uint64_t nowUs) const
+{
+  uint64_t wakeUs = UINT64_MAX;
+  for (const Source &source : sources)
+    if (source.deadlineUs > nowUs)
+      wakeUs = std::min(wakeUs, source.deadlineUs);
+  return wakeUs == UINT64_MAX ? nowUs : wakeUs;
+}
+
+ScanDeadlineScheduler::Completion ScanDeadlineScheduler::complete(size_t source, uint64_t startUs,
+                                                                  uint64_t endUs)
+{
+  Source &entry = sources[source];
+  Completion completion{};
+
+  // Scan for the latest deadline that passed, the ones before it are missed
+  if (startUs >= entry.deadlineUs)
+  {
+    uint64_t missed = (startUs - entry.deadlineUs) / entry.periodUs;
+    entry.deadlineUs += missed * entry.periodUs;
+    completion.missedDeadlines = static_cast<uint32_t>(std::min<uint64_t>(missed, UINT32_MAX));
+    completion.jitterUs =
+        static_cast<uint32_t>(std::min<uint64_t>(startUs - entry.deadlineUs, UINT32_MAX));
+  }
+  entry.deadlineUs += entry.periodUs;
+
+  // Follow longer scans at once, let the estimate decay after a short one
+  uint32_t durationUs = static_cast<uint32_t>(std::min<uint64_t>(endUs - startUs, UINT32_MAX));
+  entry.estimateUs = std::max(durationUs, entry.estimateUs - entry.estimateUs / 16);
+  return completion;
+}
@@ -0,0 +1,113 @@
+#ifndef SCANDEADLINESCHEDULER_H
+#define SCANDEADLINESCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Deadlines of several periodic scans sharing one task.
+ *
+ * Every source scans at its own period, sources added first have priority.
+ * Scans cannot be preempted, so a lower priority scan only starts when its
+ * estimated duration fits before the next deadline of every higher priority
+ * source. Otherwise it waits for the gap after the next higher priority scan,
+ * and the higher priority sources keep the jitter they have on their own.
+ * A scan that is longer than any such gap runs as soon as it is due.
+ *
+ * The caller sleeps until getNextWakeUs(), scans the sources nextDue()
+ * returns one after the other and reports each with complete().
+ */
+class ScanDeadlineScheduler
+{
+public:
+  // Returned by nextDue() when no source is to be scanned now
+  static constexpr size_t NONE = SIZE_MAX;
+
+  // Timing of one completed scan relative to its deadline
+  struct Completion
+  {
+    uint32_t jitterUs;        // Time between the deadline and the scan start
+    uint32_t missedDeadlines; // Earlier deadlines that passed without a scan
+  };
+
+  /**
+   * @brief Constructor for ScanDeadlineScheduler.
+   * @param guardUs Margin kept before a higher priority deadline, covers the
+   * wake-up latency of the caller.
+   */
+  explicit ScanDeadlineScheduler(uint32_t guardUs = 0);
+
+  /**
+   * @brief Add a source with lower priority than all added before.
+   * @param periodUs Time between two scans of the source.
+   * @return Index of the source.
+   */
+  size_t addSource(uint32_t periodUs);
+
+  /**
+   * @brief Gets the number of sources.
+   * @return Number of added sources.
+   */
+  size_t getSourceCount() const { return sources.size(); }
+
+  /**
+   * @brief Make every source due now.
+   * @param nowUs Current time.
+   */
+  void reset(uint64_t nowUs);
+
+  /**
+   * @brief Change the period of a source, its next deadline is a new period
+   * from now.
+   * @param source Index of the source.
+   * @param periodUs New time between two scans.
+   * @param nowUs Current time.
+   */
+  void setPeriod(size_t source, uint32_t periodUs, uint64_t nowUs);
+
+  /**
+   * @brief Gets the source to scan now.
+   * @param nowUs Current time.
+   * @return The highest priority source that is due and fits, NONE if there
+   * is none.
+   */
+  size_t nextDue(uint64_t nowUs) const;
+
+  /**
+   * @brief Gets the time the caller has to wake up at.
+   * @param nowUs Current time.
+   * @return Earliest deadline after nowUs, sources that are due but wait for
+   * a gap become runnable after the scan due then.
+   */
+  uint64_t getNextWakeUs(uint64_t nowUs) const;
+
+  /**
+   * @brief Report a scan of a source and move its deadline on.
+   * @param source Index of the source.
+   * @param startUs Time the scan started.
+   * @param endUs Time the scan ended.
+   * @return Jitter and missed deadlines of the scan.
+   */
+  Completion complete(size_t source, uint64_t startUs, uint64_t endUs);
+
+  /**
+   * @brief Gets the duration a scan of a source is assumed to take.
+   * @param source Index of the source.
+   * @return Longest recent scan duration in microseconds.
+   */
+  uint32_t getEstimateUs(size_t source) const { return sources[source].estimateUs; }
+
+private:
+  struct Source
+  {
+    uint32_t periodUs;
+    uint64_t deadlineUs;
+    uint32_t estimateUs; // Decaying maximum of the scan durations
+  };
+
+  std::vector<Source> sources;
+  uint32_t guardUs;
+};
+
+#endif
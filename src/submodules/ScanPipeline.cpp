@@ -0,0 +1,66 @@
+#include <submodules/ScanPipeline.h>
+#include <utility>
+
+ScanPipeline::ScanPipeline(size_t keyCount)
+    : bitmapWords((keyCount + 31) / 32), sharedBitmap((keyCount + 7) / 8),
+      debouncer((keyCount + 31) / 32)
+{
+  // Every key can change in a single scan
+  changeBuffer.resize(keyCount);
+}
+
+size_t ScanPipeline::finish(uint32_t *&working, uint32_t *&published)
+{
+  // Any raw difference, even one the debouncer holds back, counts as activity
+  keyActivity = false;
+  for (size_t word = 0; word < bitmapWords && !keyActivity; word++)
+    keyActivity = (working[word] != published[word]);
+
+  // Turn the raw samples into the debounced key state
+  debouncer.update(working, published);
+
+  // Trigger callbacks for keys that changed since the last scan
+  scanSequence++;
+  size_t changeCount = collectChanges(working, published);
+  if (changeCount > 0)
+    notifyChanges(changeCount);
+
+  // Swap the working and published buffers, readers on other tasks only need
+  // a new copy if something changed
+  std::swap(working, published);
+  if (changeCount > 0)
+    publish(published);
+  return changeCount;
+}
+
+size_t ScanPipeline::collectChanges(const uint32_t *working, const uint32_t *published)
+{
+  // Compare the new and the published state a word at a time and only visit
+  // the bits that differ, an idle scan costs one XOR per word
+  size_t count = 0;
+  for (size_t word = 0; word < bitmapWords; word++)
+  {
+    uint32_t changed = working[word] ^ published[word];
+    while (changed != 0)
+    {
+      uint8_t bit = __builtin_ctz(changed);
+      changed &= changed - 1; // Clear the lowest set bit
+      KeyChange &change = changeBuffer[count++];
+      change.keyIndex = static_cast<uint16_t>(word * 32 + bit);
+      change.pressed = (working[word] >> bit) & 1;
+    }
+  }
+  return count;
+}
+
+void ScanPipeline::notifyChanges(size_t changeCount)
+{
+  if (onKeyChangeBatch)
+    onKeyChangeBatch(changeBuffer.data(), changeCount, scanSequence);
+
+  if (onKeyChange)
+  {
+    for (size_t i = 0; i < changeCount; i++)
+      onKeyChange(changeBuffer[i].keyIndex, changeBuffer[i].pressed);
+  }
+}
@@ -0,0 +1,110 @@
+#ifndef SCANPIPELINE_H
+#define SCANPIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <interfaces/IKeyScanner.h>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <submodules/Debouncer.h>
+#include <submodules/SeqLockBitmap.h>
+#include <vector>
+
+/**
+ * @brief Everything a scan does after sampling the keys, shared by all
+ * scanner engines.
+ *
+ * The engine keeps its own double buffered bitmap and fills the working
+ * buffer with raw samples. finish() debounces them against the published
+ * buffer, reports the keys that changed, swaps the two buffers and publishes
+ * the new state to readers on other tasks.
+ */
+class ScanPipeline
+{
+public:
+  using KeyChange = IKeyScanner::KeyChange;
+
+  /**
+   * @brief Constructor for ScanPipeline.
+   * @param keyCount Number of keys, the bitmaps hold one bit per key.
+   */
+  ScanPipeline(size_t keyCount);
+
+  // The methods below back their IKeyScanner counterparts
+
+  void registerOnKeyChangeCallback(const IKeyScanner::KeyChangeCallback &callback)
+  {
+    onKeyChange = callback;
+  }
+
+  void clearOnKeyChangeCallback() { onKeyChange = nullptr; }
+
+  void registerOnKeyChangeBatchCallback(const IKeyScanner::KeyChangeBatchCallback &callback)
+  {
+    onKeyChangeBatch = callback;
+  }
+
+  void clearOnKeyChangeBatchCallback() { onKeyChangeBatch = nullptr; }
+
+  uint32_t getScanSequence() const { return scanSequence; }
+
+  void setDebounce(KeyScannerConfig::DebounceMode mode, uint8_t windowScans)
+  {
+    debouncer.configure(mode, windowScans);
+  }
+
+  uint32_t copyPublishedBitmap(uint8_t *dest, size_t destSize) const
+  {
+    return sharedBitmap.read(dest, destSize);
+  }
+
+  uint32_t getPublishedVersion() const { return sharedBitmap.getVersion(); }
+
+  bool sawKeyActivity() const { return keyActivity; }
+
+  /**
+   * @brief Hands a bitmap to readers on other tasks, finish() does so on
+   * every scan that changed a key.
+   * @param words Bitmap to publish, one bit per key.
+   */
+  void publish(const uint32_t *words) { sharedBitmap.publish(words); }
+
+  /**
+   * @brief Completes a scan whose raw samples are in working.
+   * @param working Working buffer holding the raw samples, swapped with
+   * published on return.
+   * @param published Published buffer holding the debounced state of the
+   * previous scan, swapped with working on return.
+   * @return Number of keys that changed state in this scan.
+   */
+  size_t finish(uint32_t *&working, uint32_t *&published);
+
+private:
+  size_t bitmapWords;
+
+  // Copy of the published buffer for readers on other tasks, updated on
+  // every scan that changed a key.
+  SeqLockBitmap sharedBitmap;
+
+  // Filters the raw samples of the working buffer against the published state.
+  Debouncer debouncer;
+
+  // Callback functions to be invoked on key state changes, per key and per
+  // scan.
+  IKeyScanner::KeyChangeCallback onKeyChange;
+  IKeyScanner::KeyChangeBatchCallback onKeyChangeBatch;
+
+  // Transitions of the current scan, sized for every key changing at once so
+  // collecting them never allocates.
+  std::vector<KeyChange> changeBuffer;
+
+  // Number of completed scans, passed along with each batch.
+  uint32_t scanSequence = 0;
+
+  // Whether the raw samples of the last scan differed from the stable state.
+  bool keyActivity = false;
+
+  size_t collectChanges(const uint32_t *working, const uint32_t *published);
+  void notifyChanges(size_t changeCount);
+};
+
+#endif
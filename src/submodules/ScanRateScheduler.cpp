@@ -0,0 +1,82 @@
+#include <submodules/ScanRateScheduler.h>
+#include <algorithm>
+
+ScanRateScheduler::ScanRateScheduler(uint16_t activeRateHz, uint16_t idleRateHz,
+                                     uint16_t heldKeyRateHz, uint16_t holdOffMs)
+    : activePeriodUs(1000000 / std::max<uint16_t>(activeRateHz, 1)),
+      holdOffUs(uint64_t{holdOffMs} * 1000)
+{
+  // An idle rate that is not below the active rate turns adaptation off
+  idlePeriodUs = (idleRateHz == 0 || idleRateHz >= activeRateHz) ? activePeriodUs
+                                                                 : 1000000 / idleRateHz;
+  heldKeyPeriodUs = heldKeyRateHz == 0 ? 0 : 1000000 / heldKeyRateHz;
+  tickPeriodUs = activePeriodUs;
+}
+
+void ScanRateScheduler::reset(uint64_t nowUs)
+{
+  boosted = true;
+  lastActivityUs = nowUs;
+  tickPeriodUs = activePeriodUs;
+  ticksPerFullScan = 1;
+  tick = 0;
+  resetAverage(nowUs);
+}
+
+ScanRateScheduler::ScanKind ScanRateScheduler::nextScan()
+{
+  ScanKind kind = (tick == 0) ? ScanKind::Full : ScanKind::HeldKeys;
+  tick = (tick + 1) % ticksPerFullScan;
+  return kind;
+}
+
+bool ScanRateScheduler::update(uint64_t nowUs, bool keyActivity, bool keysHeld)
+{
+  if (keyActivity)
+    lastActivityUs = nowUs;
+  boosted = (nowUs - lastActivityUs) < holdOffUs;
+
+  if (boosted)
+    return setSchedule(nowUs, activePeriodUs, 1);
+
+  // Rescan held keys in between the full scans, a full scan every idle period
+  if (keysHeld && heldKeyPeriodUs != 0 && heldKeyPeriodUs < idlePeriodUs)
+  {
+    uint32_t ticks = (idlePeriodUs + heldKeyPeriodUs / 2) / heldKeyPeriodUs;
+    return setSchedule(nowUs, heldKeyPeriodUs, std::max<uint32_t>(ticks, 1));
+  }
+  return setSchedule(nowUs, idlePeriodUs, 1);
+}
+
+bool ScanRateScheduler::setSchedule(uint64_t nowUs, uint32_t periodUs, uint32_t ticksPerFull)
+{
+  if (periodUs == tickPeriodUs && ticksPerFull == ticksPerFullScan)
+    return false;
+
+  // Close the segment scanned at the old rate
+  scheduledFullScans += static_cast<double>(nowUs - segmentStartUs) / getFullPeriodUs();
+  segmentStartUs = nowUs;
+
+  tickPeriodUs = periodUs;
+  ticksPerFullScan = ticksPerFull;
+  // The scan that triggered the change was a full scan or a rescan in between,
+  // either way the next full scan is due one full period later
+  tick = 1 % ticksPerFullScan;
+  return true;
+}
+
+float ScanRateScheduler::getAverageRateHz(uint64_t nowUs) const
+{
+  if (nowUs <= windowStartUs)
+    return 0;
+  double fullScans = scheduledFullScans +
+                     static_cast<double>(nowUs - segmentStartUs) / getFullPeriodUs();
+  return static_cast<float>(fullScans * 1000000.0 / (nowUs - windowStartUs));
+}
+
+void ScanRateScheduler::resetAverage(uint64_t nowUs)
+{
+  windowStartUs = nowUs;
+  segmentStartUs = nowUs;
+  scheduledFullScans = 0;
+}
@@ -0,0 +1,114 @@
+#ifndef SCANRATESCHEDULER_H
+#define SCANRATESCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Activity driven scan rate.
+ *
+ * Scans run at a low idle rate until a scan sees a key changing, then at the
+ * active rate until the hold-off window after the last change has passed.
+ * While keys are held outside that window, the lines with held keys can be
+ * rescanned at their own rate in between the full scans, so releases are
+ * caught quickly without scanning the whole matrix.
+ *
+ * The scheduler runs on a tick: the caller fires one tick per
+ * getTickPeriodUs(), asks nextScan() what to do on it and reports the result
+ * with update(), which returns true when the tick period changed.
+ */
+class ScanRateScheduler
+{
+public:
+  enum class ScanKind : uint8_t
+  {
+    Full,    // Scan all keys
+    HeldKeys // Rescan only the lines with held keys
+  };
+
+  /**
+   * @brief Constructor for ScanRateScheduler.
+   * @param activeRateHz Full scan rate while keys are changing.
+   * @param idleRateHz Full scan rate outside the hold-off window, 0 or a rate
+   * at or above the active rate keeps scanning at the active rate.
+   * @param heldKeyRateHz Rescan rate of lines with held keys outside the
+   * hold-off window, 0 disables it. Only used while above the idle rate.
+   * @param holdOffMs Time after the last change the active rate is kept.
+   */
+  ScanRateScheduler(uint16_t activeRateHz, uint16_t idleRateHz, uint16_t heldKeyRateHz,
+                    uint16_t holdOffMs);
+
+  /**
+   * @brief Start scanning at the active rate, as after a key press woke the
+   * scanner, and start a new rate statistics window.
+   * @param nowUs Current time.
+   */
+  void reset(uint64_t nowUs);
+
+  /**
+   * @brief Gets the kind of scan to run on this tick and advances the tick.
+   * @return Full on every tick at the idle and active rate, in between the
+   * held key rescans a full scan every idle period.
+   */
+  ScanKind nextScan();
+
+  /**
+   * @brief Report the outcome of a scan.
+   * @param nowUs Time the scan ended.
+   * @param keyActivity True if the scan saw a key changing, including bounces.
+   * @param keysHeld True if any key is pressed.
+   * @return True if the tick period changed, the caller reprograms its timer.
+   */
+  bool update(uint64_t nowUs, bool keyActivity, bool keysHeld);
+
+  /**
+   * @brief Gets the time between two ticks.
+   * @return Tick period in microseconds.
+   */
+  uint32_t getTickPeriodUs() const { return tickPeriodUs; }
+
+  /**
+   * @brief Checks whether the scheduler scans at the active rate.
+   * @return True within the hold-off window after a change.
+   */
+  bool isBoosted() const { return boosted; }
+
+  /**
+   * @brief Time-weighted average of the full scan rate.
+   * @param nowUs End of the averaging window.
+   * @return Average full scan rate in Hz since the window started, 0 for an
+   * empty window.
+   */
+  float getAverageRateHz(uint64_t nowUs) const;
+
+  /**
+   * @brief Start a new averaging window.
+   * @param nowUs Start of the window.
+   */
+  void resetAverage(uint64_t nowUs);
+
+private:
+  uint32_t activePeriodUs;
+  uint32_t idlePeriodUs;
+  uint32_t heldKeyPeriodUs; // 0 if held key rescans are disabled
+  uint64_t holdOffUs;
+
+  bool boosted = true;
+  uint64_t lastActivityUs = 0;
+
+  // Tick period and how many ticks pass per full scan
+  uint32_t tickPeriodUs;
+  uint32_t ticksPerFullScan = 1;
+  uint32_t tick = 0;
+
+  // Time-weighted full scan rate: full scans the schedule called for in the
+  // closed segments of the window, and the start of the open segment
+  uint64_t windowStartUs = 0;
+  uint64_t segmentStartUs = 0;
+  double scheduledFullScans = 0;
+
+  uint32_t getFullPeriodUs() const { return tickPeriodUs * ticksPerFullScan; }
+  bool setSchedule(uint64_t nowUs, uint32_t periodUs, uint32_t ticksPerFull);
+};
+
+#endif
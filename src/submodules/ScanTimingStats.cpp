@@ -0,0 +1,74 @@
+#include <submodules/ScanTimingStats.h>
+#include <cstring>
+
+ScanTimingStats::ScanTimingStats(uint32_t periodUs)
+{
+  stats.periodUs = periodUs;
+}
+
+void ScanTimingStats::recordScan(uint32_t jitterUs, uint32_t durationUs)
+{
+  stats.scanCount++;
+  stats.totalJitterUs += jitterUs;
+  stats.totalDurationUs += durationUs;
+  if (jitterUs > stats.maxJitterUs)
+    stats.maxJitterUs = jitterUs;
+  if (durationUs > stats.maxDurationUs)
+    stats.maxDurationUs = durationUs;
+  stats.jitterBuckets[bucketFor(jitterUs)]++;
+  stats.durationBuckets[bucketFor(durationUs)]++;
+}
+
+void ScanTimingStats::recordMissedDeadlines(uint32_t count)
+{
+  stats.missedDeadlines += count;
+}
+
+void ScanTimingStats::reset(uint64_t windowStartUs)
+{
+  uint32_t periodUs = stats.periodUs;
+  memset(&stats, 0, sizeof(stats));
+  stats.periodUs = periodUs;
+  this->windowStartUs = windowStartUs;
+}
+
+void ScanTimingStats::snapshot(uint64_t nowUs, ScanTimingSnapshot &out) const
+{
+  out = stats;
+  out.windowUs = nowUs - windowStartUs;
+}
+
+size_t ScanTimingStats::bucketFor(uint32_t valueUs)
+{
+  if (valueUs == 0)
+    return 0;
+  size_t bucket = 32 - __builtin_clz(valueUs);
+  return bucket < SCAN_TIMING_BUCKETS ? bucket : SCAN_TIMING_BUCKETS - 1;
+}
+
+uint32_t ScanTimingStats::bucketLimitUs(size_t bucket)
+{
+  if (bucket >= SCAN_TIMING_BUCKETS - 1)
+    return UINT32_MAX;
+  return uint32_t{1} << bucket;
+}
+
+uint32_t ScanTimingStats::percentileUs(const uint32_t *buckets, uint8_t percent)
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < SCAN_TIMING_BUCKETS; i++)
+    total += buckets[i];
+  if (total == 0)
+    return 0;
+
+  // Smallest bucket that covers the requested share of samples
+  uint64_t target = (total * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < SCAN_TIMING_BUCKETS; i++)
+  {
+    seen += buckets[i];
+    if (seen >= target && seen > 0)
+      return bucketLimitUs(i);
+  }
+  return bucketLimitUs(SCAN_TIMING_BUCKETS - 1);
+}
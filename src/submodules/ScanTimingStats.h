@@ -0,0 +1,97 @@
+#ifndef SCANTIMINGSTATS_H
+#define SCANTIMINGSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Number of histogram buckets. Bucket 0 counts 0 us, bucket i counts values in
+// [2^(i-1), 2^i) us, the last bucket also takes everything above.
+static constexpr size_t SCAN_TIMING_BUCKETS = 16;
+
+// Plain copy of the scan timing counters, safe to memcpy and to pass in events
+struct ScanTimingSnapshot
+{
+  uint32_t periodUs;        // Scheduled scan period
+  uint32_t scanCount;       // Scans recorded in this window
+  uint32_t missedDeadlines; // Scheduled scans that were skipped because the previous one overran
+  uint32_t maxJitterUs;
+  uint32_t maxDurationUs;
+  uint64_t totalJitterUs;
+  uint64_t totalDurationUs;
+  uint64_t windowUs; // Time covered by this window
+  float averageRateHz; // Time-weighted full scan rate of the schedule, filled in by the scan task
+  uint8_t matrix;      // Index of the scanned matrix, filled in by the scan task
+  uint32_t jitterBuckets[SCAN_TIMING_BUCKETS];
+  uint32_t durationBuckets[SCAN_TIMING_BUCKETS];
+};
+
+/**
+ * @brief Histograms of scan start jitter and scan duration.
+ *
+ * Jitter is how late a scan started relative to its deadline, duration is
+ * how long the scan itself took. Values go into power-of-two buckets so
+ * recording is a count-leading-zeros and an increment, no allocation.
+ */
+class ScanTimingStats
+{
+public:
+  /**
+   * @brief Constructor for ScanTimingStats.
+   * @param periodUs Scheduled scan period in microseconds.
+   */
+  ScanTimingStats(uint32_t periodUs);
+
+  /**
+   * @brief Record one scan.
+   * @param jitterUs Microseconds between the scan deadline and the scan start.
+   * @param durationUs Microseconds the scan took.
+   */
+  void recordScan(uint32_t jitterUs, uint32_t durationUs);
+
+  /**
+   * @brief Record deadlines that passed without a scan.
+   * @param count Number of skipped deadlines.
+   */
+  void recordMissedDeadlines(uint32_t count);
+
+  /**
+   * @brief Clear all counters and start a new window.
+   * @param windowStartUs Timestamp the new window starts at.
+   */
+  void reset(uint64_t windowStartUs);
+
+  /**
+   * @brief Copy the counters of the current window.
+   * @param nowUs Timestamp used to close the window.
+   * @param out Snapshot to fill.
+   */
+  void snapshot(uint64_t nowUs, ScanTimingSnapshot &out) const;
+
+  /**
+   * @brief Histogram bucket a value falls into.
+   * @param valueUs Value in microseconds.
+   * @return Bucket index, below SCAN_TIMING_BUCKETS.
+   */
+  static size_t bucketFor(uint32_t valueUs);
+
+  /**
+   * @brief Exclusive upper bound of a bucket.
+   * @param bucket Bucket index.
+   * @return Upper bound in microseconds, UINT32_MAX for the last bucket.
+   */
+  static uint32_t bucketLimitUs(size_t bucket);
+
+  /**
+   * @brief Estimate a percentile from a histogram.
+   * @param buckets Histogram with SCAN_TIMING_BUCKETS entries.
+   * @param percent Percentile, 0 to 100.
+   * @return Upper bound of the bucket the percentile falls into, 0 if empty.
+   */
+  static uint32_t percentileUs(const uint32_t *buckets, uint8_t percent);
+
+private:
+  ScanTimingSnapshot stats{};
+  uint64_t windowStartUs = 0;
+};
+
+#endif
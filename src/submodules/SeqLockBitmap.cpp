@@ -0,0 +1,56 @@
+#include <submodules/SeqLockBitmap.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+SeqLockBitmap::SeqLockBitmap(size_t byteSize)
+    : byteSize(byteSize), wordCount((byteSize + 3) / 4),
+      words(new std::atomic<uint32_t>[(byteSize + 3) / 4])
+{
+  for (size_t i = 0; i < wordCount; i++)
+    words[i].store(0, std::memory_order_relaxed);
+}
+
+void SeqLockBitmap::publish(const uint32_t *source)
+{
+  uint32_t seq = sequence.load(std::memory_order_relaxed);
+  sequence.store(seq + 1, std::memory_order_relaxed);
+  // Keep the word stores from moving above the odd counter
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (size_t i = 0; i < wordCount; i++)
+    words[i].store(source[i], std::memory_order_relaxed);
+
+  sequence.store(seq + 2, std::memory_order_release);
+}
+
+uint32_t SeqLockBitmap::read(uint8_t *dest, size_t destSize) const
+{
+  size_t n = std::min(byteSize, destSize);
+
+  for (;;)
+  {
+    uint32_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1)
+    {
+      // Publish in progress, let the writer finish
+      std::this_thread::yield();
+      continue;
+    }
+
+    for (size_t offset = 0; offset < n; offset += 4)
+    {
+      uint32_t word = words[offset / 4].load(std::memory_order_relaxed);
+      memcpy(dest + offset, &word, std::min<size_t>(4, n - offset));
+    }
+
+    // Keep the word loads from moving below the second counter read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) == before)
+    {
+      if (destSize > n)
+        memset(dest + n, 0, destSize - n);
+      return before / 2;
+    }
+  }
+}
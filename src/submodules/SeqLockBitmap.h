@@ -0,0 +1,64 @@
+#ifndef SEQLOCKBITMAP_H
+#define SEQLOCKBITMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Bitmap shared by one writer and any number of lock-free readers.
+ *
+ * The writer bumps a sequence counter to odd, stores the words and bumps it
+ * back to even. Readers copy the words and retry if the counter was odd or
+ * moved meanwhile, so they never see a half written bitmap and never block
+ * the writer. Words are stored as relaxed atomics, which compile to plain
+ * 32-bit loads and stores.
+ *
+ * A reader only spins while a publish is in progress. A reader that outranks
+ * the writer on the same core must not call read() in a tight loop, it could
+ * keep the preempted writer from finishing.
+ */
+class SeqLockBitmap
+{
+public:
+  /**
+   * @brief Constructor for SeqLockBitmap.
+   * @param byteSize Size of the bitmap in bytes.
+   */
+  SeqLockBitmap(size_t byteSize);
+
+  /**
+   * @brief Publish a new bitmap. Only one task may publish.
+   * @param words Bitmap as 32-bit words, little endian byte order.
+   */
+  void publish(const uint32_t *words);
+
+  /**
+   * @brief Take a consistent copy of the last published bitmap.
+   * @param dest Destination buffer.
+   * @param destSize Size of the destination in bytes, any bytes past the
+   * bitmap are zeroed.
+   * @return Version of the copied bitmap, the number of publishes before it.
+   */
+  uint32_t read(uint8_t *dest, size_t destSize) const;
+
+  /**
+   * @brief Version of the last published bitmap, cheap way for readers to
+   * check for a change before copying.
+   * @return Number of completed publishes.
+   */
+  uint32_t getVersion() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+  size_t getByteSize() const { return byteSize; }
+
+private:
+  size_t byteSize;
+  size_t wordCount;
+  std::unique_ptr<std::atomic<uint32_t>[]> words;
+
+  // Odd while a publish is in progress
+  std::atomic<uint32_t> sequence{0};
+};
+
+#endif
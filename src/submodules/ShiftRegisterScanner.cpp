@@ -0,0 +1,42 @@
+#include <submodules/ShiftRegisterScanner.h>
+
+ShiftRegisterScanner::ShiftRegisterScanner(IGpio &gpio, uint8_t loadPin,
+                                           uint8_t clockPin, uint8_t dataPin,
+                                           uint8_t registerCount)
+    : BitmapScanner(registerCount * 8), gpio(gpio), loadPin(loadPin),
+      clockPin(clockPin), dataPin(dataPin), keyCount(registerCount * 8)
+{
+  gpio.pinMode(loadPin, PinMode::Output);
+  gpio.digitalWrite(loadPin, PinState::High);
+  gpio.pinMode(clockPin, PinMode::Output);
+  gpio.digitalWrite(clockPin, PinState::Low);
+  gpio.pinMode(dataPin, PinMode::Input);
+}
+
+void ShiftRegisterScanner::sampleKeys()
+{
+  // Latch all inputs of the chain at once
+  gpio.digitalWrite(loadPin, PinState::Low);
+  gpio.digitalWrite(loadPin, PinState::High);
+
+  // The data pin shows the next bit right after the load and after every
+  // clock, so the chain needs one clock less than it has bits. Bits are
+  // collected a word at a time, pressed keys read low.
+  uint32_t bits = 0;
+  for (size_t index = 0; index < keyCount; index++)
+  {
+    if (index != 0)
+    {
+      gpio.digitalWrite(clockPin, PinState::High);
+      gpio.digitalWrite(clockPin, PinState::Low);
+    }
+    if (gpio.digitalRead(dataPin) == PinState::Low)
+      bits |= (1u << (index % 32));
+
+    if (index % 32 == 31 || index == keyCount - 1)
+    {
+      workingBuffer[index / 32] = bits;
+      bits = 0;
+    }
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef SHIFTREGISTERSCANNER_H
+#define SHIFTREGISTERSCANNER_H
+
+#include <cstdint>
+#include <interfaces/IGpio.h>
+#include <submodules/BitmapScanner.h>
+
+/**
+ * @brief Scanner engine for keys on daisy-chained parallel-in shift registers.
+ *
+ * Each key pulls one parallel input of a 74HC165 style register to ground.
+ * A low pulse on the load pin latches all inputs, then the chain is clocked
+ * out one bit at a time on the data pin. Only three pins are needed for any
+ * number of keys, but a scan costs about three GPIO operations per key.
+ *
+ * Key index i is the i-th bit shifted out: the first register of the chain
+ * (the one wired to the data pin) holds keys 0-7, starting at its last input.
+ * Presses cannot be detected without clocking, so this engine never idles.
+ */
+class ShiftRegisterScanner : public BitmapScanner
+{
+public:
+  /**
+   * @brief Constructor for ShiftRegisterScanner.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param loadPin Parallel load pin, active low.
+   * @param clockPin Shift clock pin, shifts on the rising edge.
+   * @param dataPin Serial output of the first register in the chain.
+   * @param registerCount Number of 8-bit registers in the chain.
+   */
+  ShiftRegisterScanner(IGpio &gpio, uint8_t loadPin, uint8_t clockPin,
+                       uint8_t dataPin, uint8_t registerCount);
+
+private:
+  IGpio &gpio;
+  uint8_t loadPin;
+  uint8_t clockPin;
+  uint8_t dataPin;
+  size_t keyCount;
+
+  void sampleKeys() override;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free ring buffer between exactly one producer and one consumer.
+ *
+ * The producer only writes the tail, the consumer only the head, so neither
+ * side needs a compare and swap: a slot is written before the tail moves past
+ * it with release order and read after the consumer loads the tail with
+ * acquire order. Indexes run freely and wrap at 32 bits, the capacity is a
+ * power of two so the slot is a mask away.
+ *
+ * Items are copied in and out by value and should be small and trivially
+ * copyable, as events are.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  static constexpr size_t CAPACITY = Capacity;
+
+  /**
+   * @brief Append an item, producer side only.
+   * @param item The item, copied.
+   * @return False if the ring is full.
+   */
+  bool push(const T &item)
+  {
+    uint32_t tail = this->tail.load(std::memory_order_relaxed);
+    if (tail - head.load(std::memory_order_acquire) == Capacity)
+      return false;
+    slots[tail & (Capacity - 1)] = item;
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest item, consumer side only.
+   * @param out The item.
+   * @return False if the ring is empty.
+   */
+  bool pop(T &out)
+  {
+    uint32_t head = this->head.load(std::memory_order_relaxed);
+    if (head == tail.load(std::memory_order_acquire))
+      return false;
+    out = slots[head & (Capacity - 1)];
+    this->head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take up to max of the oldest items, consumer side only.
+   * @param out Array of at least max items.
+   * @param max Most items to take.
+   * @return Number of items taken.
+   */
+  size_t popBatch(T *out, size_t max)
+  {
+    uint32_t head = this->head.load(std::memory_order_relaxed);
+    uint32_t available = tail.load(std::memory_order_acquire) - head;
+    size_t count = available < max ? available : max;
+    for (size_t i = 0; i < count; i++)
+      out[i] = slots[(head + i) & (Capacity - 1)];
+    this->head.store(head + static_cast<uint32_t>(count), std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Number of items waiting, exact on either side, an estimate
+   * elsewhere.
+   * @return Number of items.
+   */
+  size_t size() const
+  {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Drop all items. Neither side may use the ring meanwhile.
+   */
+  void reset()
+  {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_release);
+  }
+
+private:
+  T slots[Capacity];
+  // Next slot to read, written by the consumer
+  std::atomic<uint32_t> head{0};
+  // Next slot to write, written by the producer
+  std::atomic<uint32_t> tail{0};
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef STATICKEYSCANNER_H
+#define STATICKEYSCANNER_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <interfaces/IGpio.h>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <interfaces/IKeyScanner.h>
+#include <submodules/ScanPipeline.h>
+#include <utility>
+
+/**
+ * @brief Key matrix scanner specialized for a matrix size known at build time.
+ *
+ * Same behaviour and interface as KeyScanner for row-major scanning, but the
+ * buffers are fixed-size arrays and all bit positions are compile-time
+ * constants, so the column loop of every row unrolls into straight-line code.
+ * Everything after sampling runs through the same ScanPipeline as the other
+ * engines.
+ * Boards with a fixed matrix select it through the board profile, anything
+ * configured at runtime keeps using KeyScanner.
+ *
+ * @tparam Rows Number of rows, the drive lines.
+ * @tparam Cols Number of columns, the sense lines.
+ */
+template <uint8_t Rows, uint8_t Cols>
+class StaticKeyScanner
+{
+  static_assert(Rows > 0 && Cols > 0, "Matrix needs at least one row and column");
+  static_assert(Cols <= 32, "A row must fit into one 32-bit merge");
+
+public:
+  using KeyChange = IKeyScanner::KeyChange;
+  using KeyChangeBatchCallback = IKeyScanner::KeyChangeBatchCallback;
+  using ScanOrder = KeyScannerConfig::ScanOrder;
+
+  static constexpr size_t KEY_COUNT = size_t{Rows} * Cols;
+  static constexpr size_t BITMAP_SIZE = (KEY_COUNT + 7) / 8;
+  static constexpr size_t BITMAP_WORDS = (KEY_COUNT + 31) / 32;
+
+  /**
+   * @brief Bit index of a key in the bitmap.
+   * @param row Row of the key.
+   * @param col Column of the key.
+   * @return Linear bit index, row-major.
+   */
+  static constexpr uint16_t bitIndex(uint8_t row, uint8_t col)
+  {
+    return static_cast<uint16_t>(row * Cols + col);
+  }
+
+  /**
+   * @brief Constructor for StaticKeyScanner.
+   * @param gpio Reference to the IGpio interface for GPIO operations.
+   * @param rowPins Array of Rows GPIO pin numbers for the rows.
+   * @param colPins Array of Cols GPIO pin numbers for the columns.
+   */
+  StaticKeyScanner(IGpio &gpio, const uint8_t *rowPins, const uint8_t *colPins)
+      : gpio(gpio), rowPins(rowPins), colPins(colPins), pipeline(KEY_COUNT)
+  {
+    for (uint8_t r = 0; r < Rows; r++)
+    {
+      gpio.pinMode(rowPins[r], PinMode::InputPullup);
+      drivePinMask |= pinToMask(rowPins[r]);
+    }
+    for (uint8_t c = 0; c < Cols; c++)
+    {
+      gpio.pinMode(colPins[c], PinMode::InputPullup);
+      senseBits[c] = pinToMask(colPins[c]);
+      sensePinMask |= senseBits[c];
+    }
+  }
+
+  ~StaticKeyScanner()
+  {
+    // The interrupts would call the handler with an arg that may be gone
+    if (isIdle())
+      exitIdle();
+  }
+
+  // Buffer pointers refer to the object's own arrays
+  StaticKeyScanner(const StaticKeyScanner &) = delete;
+  StaticKeyScanner &operator=(const StaticKeyScanner &) = delete;
+
+  // The methods below have the same contract as their IKeyScanner counterparts
+
+  void registerOnKeyChangeCallback(
+      const std::function<void(uint16_t keyIndex, bool pressed)> &callback)
+  {
+    pipeline.registerOnKeyChangeCallback(callback);
+  }
+
+  void clearOnKeyChangeCallback() { pipeline.clearOnKeyChangeCallback(); }
+
+  void registerOnKeyChangeBatchCallback(const KeyChangeBatchCallback &callback)
+  {
+    pipeline.registerOnKeyChangeBatchCallback(callback);
+  }
+
+  void clearOnKeyChangeBatchCallback() { pipeline.clearOnKeyChangeBatchCallback(); }
+
+  uint32_t getScanSequence() const { return pipeline.getScanSequence(); }
+
+  void setDebounce(KeyScannerConfig::DebounceMode mode, uint8_t windowScans)
+  {
+    pipeline.setDebounce(mode, windowScans);
+  }
+
+  uint32_t copyPublishedBitmap(uint8_t *dest, size_t destSize) const
+  {
+    return pipeline.copyPublishedBitmap(dest, destSize);
+  }
+
+  uint32_t getPublishedVersion() const { return pipeline.getPublishedVersion(); }
+
+  const size_t getBitMapSize() const { return BITMAP_SIZE; }
+
+  ScanOrder getScanOrder() const { return ScanOrder::RowMajor; }
+
+  bool hasPressedKeys() const
+  {
+    for (size_t word = 0; word < BITMAP_WORDS; word++)
+    {
+      if (publishedBuffer[word] != 0)
+        return true;
+    }
+    return false;
+  }
+
+  bool enterIdle(PinInterruptHandler wakeHandler, void *arg)
+  {
+    for (uint8_t r = 0; r < Rows; r++)
+      gpio.pinMode(rowPins[r], PinMode::Output);
+    gpio.writePins(drivePinMask, PinState::Low);
+
+    for (uint8_t c = 0; c < Cols; c++)
+      gpio.attachPinInterrupt(colPins[c], PinEdge::Falling, wakeHandler, arg);
+    idle = true;
+
+    // A key that went down before the interrupts were armed produced no edge
+    if (gpio.readPins(sensePinMask) != sensePinMask)
+    {
+      exitIdle();
+      return false;
+    }
+    return true;
+  }
+
+  void exitIdle()
+  {
+    for (uint8_t c = 0; c < Cols; c++)
+      gpio.detachPinInterrupt(colPins[c]);
+    for (uint8_t r = 0; r < Rows; r++)
+      gpio.pinMode(rowPins[r], PinMode::InputPullup);
+    idle = false;
+  }
+
+  bool isIdle() const { return idle; }
+
+  size_t updateKeyState() { return scan(false); }
+
+  size_t updateHeldKeyState() { return scan(true); }
+
+  bool sawKeyActivity() const { return pipeline.sawKeyActivity(); }
+
+private:
+  using Bitmap = std::array<uint32_t, BITMAP_WORDS>;
+
+  IGpio &gpio;
+  const uint8_t *rowPins;
+  const uint8_t *colPins;
+
+  // Bulk masks of all row and column pins, and the mask bit of each column
+  uint64_t drivePinMask = 0;
+  uint64_t sensePinMask = 0;
+  std::array<uint64_t, Cols> senseBits{};
+
+  bool idle = false;
+
+  // Double buffered key state, same word layout as KeyScanner
+  Bitmap bufferA{};
+  Bitmap bufferB{};
+  uint32_t *workingBuffer = bufferA.data();
+  uint32_t *publishedBuffer = bufferB.data();
+
+  // Debounces, reports and publishes each scan
+  ScanPipeline pipeline;
+
+  // Scan all rows, or only the rows with held keys. Rows without held keys
+  // are all released, so skipping them leaves their cleared bits correct.
+  size_t scan(bool heldOnly)
+  {
+    if (idle)
+      exitIdle();
+
+    memset(workingBuffer, 0, sizeof(Bitmap));
+
+    uint8_t releasePin = rowPins[Rows - 1];
+    for (uint8_t r = 0; r < Rows; r++)
+    {
+      if (heldOnly && readRow(publishedBuffer, r) == 0)
+        continue;
+
+      gpio.pinMode(releasePin, PinMode::InputPullup);
+      gpio.pinMode(rowPins[r], PinMode::Output);
+      gpio.digitalWrite(rowPins[r], PinState::Low);
+      releasePin = rowPins[r];
+
+      uint64_t pressedPins = ~gpio.readPins(sensePinMask) & sensePinMask;
+      mergeRow(r, packRow(pressedPins, std::make_index_sequence<Cols>{}));
+    }
+
+    // Full scans expect only the last row to be left driven
+    if (releasePin != rowPins[Rows - 1])
+      gpio.pinMode(releasePin, PinMode::InputPullup);
+
+    return pipeline.finish(workingBuffer, publishedBuffer);
+  }
+
+  // Gather the column bits of one row, expanded to one test per column
+  template <size_t... Col>
+  uint32_t packRow(uint64_t pressedPins, std::index_sequence<Col...>) const
+  {
+    return ((pressedPins & senseBits[Col] ? (uint32_t{1} << Col) : 0u) | ...);
+  }
+
+  // OR one row into the working buffer, splitting it when it straddles a word
+  void mergeRow(uint8_t row, uint32_t bits)
+  {
+    const uint16_t first = bitIndex(row, 0);
+    const size_t word = first / 32;
+    const uint8_t shift = first % 32;
+    workingBuffer[word] |= bits << shift;
+    if (shift != 0 && shift + Cols > 32)
+      workingBuffer[word + 1] |= bits >> (32 - shift);
+  }
+
+  // Column bits of one row of a bitmap, the counterpart of mergeRow
+  uint32_t readRow(const uint32_t *bitmap, uint8_t row) const
+  {
+    const uint16_t first = bitIndex(row, 0);
+    const size_t word = first / 32;
+    const uint8_t shift = first % 32;
+    uint32_t bits = bitmap[word] >> shift;
+    if (shift != 0 && shift + Cols > 32)
+      bits |= bitmap[word + 1] << (32 - shift);
+    return Cols == 32 ? bits : bits & ((uint32_t{1} << Cols) - 1);
+  }
+};
+
+#endif
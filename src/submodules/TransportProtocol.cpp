@@ -1,5 +1,6 @@
 #include <submodules/TransportProtocol.h>
 #include <submodules/Logger.h>
+#include <algorithm>
 
 static Logger log(TransportProtocol::NAMESPACE);
 
@@ -32,23 +33,42 @@ TransportProtocol::TransportProtocol(ITransport &espNow)
 void TransportProtocol::sendKeyEvent(const RawKeyEvent &keyEvent)
 {
     log.info("Sending Key Event to Master");
-    size_t len = sizeof(RawKeyEvent);
-    uint8_t *buffer = (uint8_t *)malloc(len);
-    memcpy(buffer, &keyEvent, len);
-    transport.sendData(KEY_EVENT, buffer, len, masterMac.data());
-    free(buffer);
+    // Serialize as: [keyIndex (2 bytes)][state (1 byte)][scanSequence (4 bytes)]
+    // [scanUs (4 bytes)][busUs (4 bytes)][txUs (4 bytes)], the receiver stamps rxUs
+    uint8_t buffer[KEY_EVENT_SIZE];
+    uint8_t state = keyEvent.state ? 1 : 0;
+    memcpy(buffer, &keyEvent.keyIndex, 2);
+    memcpy(buffer + 2, &state, 1);
+    memcpy(buffer + 3, &keyEvent.scanSequence, 4);
+    memcpy(buffer + 7, &keyEvent.timestamps.scanUs, 4);
+    memcpy(buffer + 11, &keyEvent.timestamps.busUs, 4);
+    memcpy(buffer + 15, &keyEvent.timestamps.txUs, 4);
+    transport.sendData(KEY_EVENT, buffer, sizeof(buffer), masterMac.data());
 }
 
 void TransportProtocol::sendBitmapEvent(const RawBitmapEvent &bitmapEvent)
 {
     log.debug("Sending Bitmap Event to Master");
-    // Serialize as: [bitmapSize (1 byte)][bitMapData (N bytes)]
-    size_t len = 1 + bitmapEvent.bitmapSize;
-    uint8_t *buffer = (uint8_t *)malloc(len);
-    buffer[0] = bitmapEvent.bitmapSize;
-    memcpy(buffer + 1, bitmapEvent.bitMapData, bitmapEvent.bitmapSize);
-    transport.sendData(KEY_BITMAP, buffer, len, masterMac.data());
-    free(buffer);
+    sendSlices(KEY_BITMAP, bitmapEvent.data(), bitmapEvent.bitmapSize, MAX_BITMAP_CHUNK, masterMac.data());
+}
+
+void TransportProtocol::sendSlices(uint8_t packetType, const uint8_t *data, uint16_t size, size_t maxSlice,
+                                   const uint8_t *mac)
+{
+    // Serialize as: [size (2 bytes)][offset (2 bytes)][slice] with slices of
+    // at most maxSlice bytes
+    uint8_t buffer[4 + MAX_BITMAP_CHUNK];
+    maxSlice = std::min(maxSlice, MAX_BITMAP_CHUNK);
+    uint16_t offset = 0;
+    do
+    {
+        uint16_t sliceSize = static_cast<uint16_t>(std::min<size_t>(maxSlice, size - offset));
+        memcpy(buffer, &size, sizeof(size));
+        memcpy(buffer + 2, &offset, sizeof(offset));
+        memcpy(buffer + 4, data + offset, sliceSize);
+        transport.sendData(packetType, buffer, 4 + sliceSize, mac);
+        offset += sliceSize;
+    } while (offset < size);
 }
 
 void TransportProtocol::requestConfig(uint8_t id)
@@ -70,6 +90,11 @@ void TransportProtocol::sendConfig(uint8_t id, const ConfigManager *config)
     }
 
     size_t requiredSize = config->getSerializedSize();
+    if (requiredSize > UINT16_MAX)
+    {
+        log.error("Config of %zu bytes is too large to send to ID %d", requiredSize, id);
+        return;
+    }
     uint8_t *buffer = (uint8_t *)malloc(requiredSize);
     size_t len = config->packSerialized(buffer, requiredSize);
     if (len == 0 || len != requiredSize)
@@ -82,7 +107,8 @@ void TransportProtocol::sendConfig(uint8_t id, const ConfigManager *config)
     mac_t mac = {};
     getMacById(id, mac.data());
 
-    transport.sendData(CONFIG, buffer, len, mac.data());
+    // A config with a large HID map does not fit into one packet
+    sendSlices(CONFIG, buffer, static_cast<uint16_t>(len), MAX_CONFIG_CHUNK, mac.data());
     free(buffer);
 }
 
@@ -248,10 +274,20 @@ void TransportProtocol::handleKeyEventData(const uint8_t *data, size_t len, cons
         peerDevices.push_back({});
         memcpy(peerDevices.back().data(), mac, sizeof(mac_t));
     }
-    if (keyEventCallback && len >= sizeof(RawKeyEvent))
+    // Packets from before the timestamps only hold index and state, they are
+    // passed on with scanSequence 0 and no timestamps
+    if (keyEventCallback && len >= 3)
     {
-        RawKeyEvent keyEvent;
-        memcpy(&keyEvent, data, sizeof(RawKeyEvent));
+        RawKeyEvent keyEvent{};
+        memcpy(&keyEvent.keyIndex, data, 2);
+        keyEvent.state = data[2] != 0;
+        if (len >= KEY_EVENT_SIZE)
+        {
+            memcpy(&keyEvent.scanSequence, data + 3, 4);
+            memcpy(&keyEvent.timestamps.scanUs, data + 7, 4);
+            memcpy(&keyEvent.timestamps.busUs, data + 11, 4);
+            memcpy(&keyEvent.timestamps.txUs, data + 15, 4);
+        }
         keyEventCallback(keyEvent, getIdByMac(mac));
     }
     log.info("Received key event from ID %d", getIdByMac(mac));
@@ -264,22 +300,59 @@ void TransportProtocol::handleBitmapEventData(const uint8_t *data, size_t len, c
         peerDevices.push_back({});
         memcpy(peerDevices.back().data(), mac, sizeof(mac_t));
     }
-    // Deserialize: [bitmapSize (1 byte)][bitMapData (N bytes)]
-    if (bitmapEventCallback && len >= 1)
+    if (bitmapEventCallback)
     {
-        RawBitmapEvent bitmapEvent;
-        bitmapEvent.bitmapSize = data[0];
-        if (len >= 1 + bitmapEvent.bitmapSize)
+        SliceAssembly &assembly = bitmapAssemblies[getIdByMac(mac)];
+        if (appendSlice(assembly, data, len, getIdByMac(mac)))
         {
-            bitmapEvent.bitMapData = (uint8_t *)malloc(bitmapEvent.bitmapSize);
-            memcpy(bitmapEvent.bitMapData, data + 1, bitmapEvent.bitmapSize);
+            RawBitmapEvent bitmapEvent;
+            bool assigned = bitmapEvent.assign(EventType::RawBitmap, assembly.data.data(), assembly.totalSize);
+            assembly.data.clear();
+            if (!assigned)
+            {
+                log.warn("Bitmap pool exhausted, dropped bitmap from ID %d", getIdByMac(mac));
+                return;
+            }
             bitmapEventCallback(bitmapEvent, getIdByMac(mac));
         }
     }
     log.debug("Received bitmap event from ID %d", getIdByMac(mac));
 }
 
-void TransportProtocol::handleConfigData(const uint8_t *data, size_t len, const uint8_t *mac)
+bool TransportProtocol::appendSlice(SliceAssembly &assembly, const uint8_t *data, size_t len, uint8_t senderId)
+{
+    // Deserialize: [size (2 bytes)][offset (2 bytes)][slice]
+    if (len < 4)
+        return false;
+    uint16_t totalSize = 0;
+    uint16_t offset = 0;
+    memcpy(&totalSize, data, sizeof(totalSize));
+    memcpy(&offset, data + 2, sizeof(offset));
+    size_t sliceSize = len - 4;
+    if (offset + sliceSize > totalSize)
+    {
+        log.warn("Dropped slice outside of the payload from ID %d", senderId);
+        return false;
+    }
+
+    // Slices arrive in order, a slice that does not continue the current
+    // payload discards it. A slice at offset 0 always starts a new one.
+    if (offset == 0)
+    {
+        assembly.totalSize = totalSize;
+        assembly.data.clear();
+    }
+    else if (offset != assembly.data.size() || totalSize != assembly.totalSize)
+    {
+        log.warn("Dropped out of order slice from ID %d", senderId);
+        assembly.data.clear();
+        return false;
+    }
+    assembly.data.insert(assembly.data.end(), data + 4, data + len);
+    return assembly.data.size() == totalSize;
+}
+
+void TransportProtocol::handleConfigData(const uint8_t *packet, size_t packetLen, const uint8_t *mac)
 {
     if (getIdByMac(mac) == 0xFF)
     {
@@ -288,6 +361,16 @@ void TransportProtocol::handleConfigData(const uint8_t *data, size_t len, const
         log.info("Added new device from config data with ID %d", getIdByMac(mac));
     }
 
+    // Wait for the last slice, the assembly keeps the config until it is
+    // unpacked
+    SliceAssembly &assembly = configAssemblies[getIdByMac(mac)];
+    if (!appendSlice(assembly, packet, packetLen, getIdByMac(mac)))
+        return;
+    std::vector<uint8_t> serialized;
+    serialized.swap(assembly.data);
+    const uint8_t *data = serialized.data();
+    size_t len = serialized.size();
+
     // Basic sanity check - must have at least 2 size_t fields
     if (len < 2 * sizeof(size_t))
     {
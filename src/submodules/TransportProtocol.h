@@ -26,6 +26,16 @@ public:
     static constexpr const char* NAMESPACE = "TransportProtocol";
     static const uint8_t MASTER_ID = 0;
 
+    // Largest bitmap slice per packet, keeps header and slice within the
+    // 250 byte ESP-NOW payload. Larger bitmaps are sent in several packets.
+    static constexpr size_t MAX_BITMAP_CHUNK = 224;
+    // Largest config slice per packet, configs are sliced like bitmaps
+    static constexpr size_t MAX_CONFIG_CHUNK = MAX_BITMAP_CHUNK;
+
+    // Key event packet: index, state, scan sequence and the scan, bus and tx
+    // timestamps of the sender
+    static constexpr size_t KEY_EVENT_SIZE = 19;
+
     TransportProtocol(ITransport &espNow);
 
     void sendKeyEvent(const RawKeyEvent &keyEvent);
@@ -39,6 +49,7 @@ public:
     uint8_t getIdByMac(const uint8_t *mac) const;
 
     void onKeyEvent(std::function<void(RawKeyEvent &keyEvent, uint8_t senderId)> callback);
+    // The callback owns the bitmap and returns a spilled one with release()
     void onBitmapEvent(std::function<void(RawBitmapEvent &bitmapEvent, uint8_t senderId)> callback);
     void onConfigReceived(std::function<void(ConfigManager *config, uint8_t senderId)> callback);
 
@@ -78,6 +89,22 @@ private:
     std::function<void(uint8_t)> pairingConfirmationCallback;
     std::function<void(uint8_t)> configRequestCallback;
 
+    // Bitmap or config being reassembled from slices
+    struct SliceAssembly
+    {
+        uint16_t totalSize = 0;
+        std::vector<uint8_t> data;
+    };
+    // One assembly per sender ID and payload
+    std::unordered_map<uint8_t, SliceAssembly> bitmapAssemblies;
+    std::unordered_map<uint8_t, SliceAssembly> configAssemblies;
+
+    // Send data as [total size (2 bytes)][offset (2 bytes)][slice] packets of
+    // at most maxSlice data bytes
+    void sendSlices(uint8_t packetType, const uint8_t *data, uint16_t size, size_t maxSlice, const uint8_t *mac);
+    // Add a received slice packet to assembly, true once it is complete
+    bool appendSlice(SliceAssembly &assembly, const uint8_t *data, size_t len, uint8_t senderId);
+
     void handlePairingRequest(const uint8_t *data, size_t dataLen, const uint8_t *mac);
     void handlePairingConfirmation(const uint8_t *data, size_t dataLen, const uint8_t *mac);
     void handleConfigData(const uint8_t *data, size_t dataLen, const uint8_t *mac);
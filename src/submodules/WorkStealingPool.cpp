@@ -0,0 +1,235 @@
+#include <submodules/WorkStealingPool.h>
+#include <submodules/EventChannel.h>
+#include <algorithm>
+
+WorkStealingPool::~WorkStealingPool()
+{
+  clear();
+}
+
+int WorkStealingPool::addWorker(uint8_t core, WakeCallback wake, void *arg)
+{
+  if (workerCount == MAX_WORKERS)
+    return -1;
+  Worker &worker = workers[workerCount];
+  worker.core = core;
+  worker.wake = wake;
+  worker.arg = arg;
+  return static_cast<int>(workerCount++);
+}
+
+int WorkStealingPool::strandOf(EventType type, BatchCallback handler, uint32_t coreMask)
+{
+  size_t count = strandCount.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; i++)
+    if (strands[i].type == type && strands[i].handler == handler)
+      return static_cast<int>(i);
+  if (count == MAX_STRANDS)
+    return -1;
+
+  Strand &strand = strands[count];
+  strand.type = type;
+  strand.handler = handler;
+  strand.coreMask = coreMask;
+  bool runnable = false;
+  for (size_t w = 0; w < workerCount && !runnable; w++)
+    runnable = mayRun(strand, workers[w]);
+  if (!runnable)
+    return -1;
+  strandCount.store(count + 1, std::memory_order_release);
+  return static_cast<int>(count);
+}
+
+bool WorkStealingPool::submit(EventType type, BatchCallback handler, uint32_t coreMask, const Event *events,
+                              size_t count)
+{
+  int id = strandOf(type, handler, coreMask);
+  if (id < 0)
+    return false;
+
+  Strand &strand = strands[id];
+  for (size_t i = 0; i < count; i++)
+  {
+    // The reference has to exist before a worker can pop the event
+    retainEvent(events[i]);
+    if (strand.events.push(events[i]))
+      continue;
+    Event refused = events[i];
+    if (refused.cleanup)
+      refused.cleanup(&refused);
+    dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (!strand.scheduled.exchange(true))
+    schedule(static_cast<size_t>(id));
+  return true;
+}
+
+void WorkStealingPool::schedule(size_t id)
+{
+  const Strand &strand = strands[id];
+  Worker *target = nullptr;
+  size_t targetLoad = SIZE_MAX;
+  for (size_t w = 0; w < workerCount; w++)
+  {
+    Worker &worker = workers[w];
+    if (!mayRun(strand, worker))
+      continue;
+    size_t load = worker.queued.load(std::memory_order_relaxed) + (worker.busy.load() ? 1 : 0);
+    if (load < targetLoad)
+    {
+      target = &worker;
+      targetLoad = load;
+    }
+  }
+
+  {
+    // A strand is on one queue at most, the queue never overflows
+    std::lock_guard<std::mutex> lock(target->mutex);
+    size_t queued = target->queued.load(std::memory_order_relaxed);
+    target->queue[(target->head + queued) % MAX_STRANDS] = static_cast<uint8_t>(id);
+    target->queued.store(queued + 1, std::memory_order_relaxed);
+  }
+  if (target->wake != nullptr)
+    target->wake(target->arg);
+
+  // Stuck in a handler, let an idle worker take the strand instead
+  if (!target->busy.load())
+    return;
+  for (size_t w = 0; w < workerCount; w++)
+  {
+    Worker &worker = workers[w];
+    if (&worker == target || !mayRun(strand, worker) || worker.busy.load())
+      continue;
+    if (worker.wake != nullptr)
+      worker.wake(worker.arg);
+    return;
+  }
+}
+
+bool WorkStealingPool::take(Worker &worker, size_t &strand)
+{
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  size_t queued = worker.queued.load(std::memory_order_relaxed);
+  if (queued == 0)
+    return false;
+  strand = worker.queue[worker.head];
+  worker.head = (worker.head + 1) % MAX_STRANDS;
+  worker.queued.store(queued - 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, size_t &strand)
+{
+  for (size_t offset = 1; offset < workerCount; offset++)
+  {
+    Worker &victim = workers[(thief + offset) % workerCount];
+    if (victim.queued.load(std::memory_order_relaxed) == 0)
+      continue;
+
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    size_t queued = victim.queued.load(std::memory_order_relaxed);
+    // Newest first, the owner is about to reach the oldest
+    for (size_t i = queued; i-- > 0;)
+    {
+      size_t slot = (victim.head + i) % MAX_STRANDS;
+      if (!mayRun(strands[victim.queue[slot]], workers[thief]))
+        continue;
+      strand = victim.queue[slot];
+      for (size_t j = i + 1; j < queued; j++)
+        victim.queue[(victim.head + j - 1) % MAX_STRANDS] = victim.queue[(victim.head + j) % MAX_STRANDS];
+      victim.queued.store(queued - 1, std::memory_order_relaxed);
+      stolen.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t WorkStealingPool::runStrand(Worker &worker, size_t id)
+{
+  Strand &strand = strands[id];
+  size_t handled = 0;
+  size_t count;
+  while (handled < MAX_STRAND_EVENTS &&
+         (count = strand.events.popBatch(worker.batch, std::min(MAX_BATCH_SIZE, MAX_STRAND_EVENTS - handled))) > 0)
+  {
+    strand.handler(worker.batch, count);
+    for (size_t i = 0; i < count; i++)
+      if (worker.batch[i].cleanup)
+        worker.batch[i].cleanup(&worker.batch[i]);
+    handled += count;
+  }
+  executed.fetch_add(static_cast<uint32_t>(handled), std::memory_order_relaxed);
+
+  // Had its turn, the rest waits behind the other strands
+  if (strand.events.size() > 0 && handled == MAX_STRAND_EVENTS)
+  {
+    schedule(id);
+    return handled;
+  }
+
+  // The bus may have queued events after the last pop, while the strand
+  // still looked scheduled to it
+  strand.scheduled.store(false);
+  if (strand.events.size() > 0 && !strand.scheduled.exchange(true))
+    schedule(id);
+  return handled;
+}
+
+size_t WorkStealingPool::work(size_t index)
+{
+  if (index >= workerCount)
+    return 0;
+  Worker &worker = workers[index];
+  size_t handled = 0;
+  size_t strand;
+  worker.busy.store(true);
+  for (;;)
+  {
+    if (!take(worker, strand) && !steal(index, strand))
+    {
+      // Strands queued elsewhere meanwhile did not wake this worker, look
+      // once more after going idle
+      worker.busy.store(false);
+      if (!take(worker, strand) && !steal(index, strand))
+        break;
+      worker.busy.store(true);
+    }
+    handled += runStrand(worker, strand);
+  }
+  return handled;
+}
+
+void WorkStealingPool::clear()
+{
+  size_t count = strandCount.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; i++)
+  {
+    Strand &strand = strands[i];
+    Event event;
+    while (strand.events.pop(event))
+      if (event.cleanup)
+        event.cleanup(&event);
+    strand.events.reset();
+    strand.scheduled.store(false);
+  }
+  strandCount.store(0);
+
+  for (size_t w = 0; w < workerCount; w++)
+  {
+    workers[w].head = 0;
+    workers[w].queued.store(0);
+    workers[w].busy.store(false);
+  }
+  workerCount = 0;
+}
+
+WorkStealingPool::Stats WorkStealingPool::getStats() const
+{
+  Stats stats{};
+  stats.executed = executed.load(std::memory_order_relaxed);
+  stats.stolen = stolen.load(std::memory_order_relaxed);
+  stats.dropped = dropped.load(std::memory_order_relaxed);
+  return stats;
+}
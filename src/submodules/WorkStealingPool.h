@@ -0,0 +1,145 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared/EventTypes.h>
+#include <submodules/SpscRing.h>
+
+/**
+ * @brief Runs offloaded event handlers on a small pool of workers.
+ *
+ * Every offloaded handler gets one strand per event type it takes. A strand
+ * queues the events the bus handed to the handler and is run by one worker
+ * at a time, so the handler sees the events of a type in order while
+ * different handlers and types run side by side.
+ *
+ * A strand with events is put on the run queue of the least busy worker it
+ * may run on. Workers take strands from the front of their own queue and,
+ * once it is empty, steal from the back of the others, so a worker stuck in
+ * a long handler does not hold up the strands behind it. A strand's core
+ * mask decides which workers may run it, at home or by stealing.
+ *
+ * submit() is called by the bus task alone, workers call work(). Queued
+ * events hold a reference of their own, see retainEvent.
+ */
+class WorkStealingPool
+{
+public:
+  using BatchCallback = void (*)(const Event *events, size_t count);
+  /// @brief Wakes a worker with work for it, e.g. xTaskNotifyGive.
+  using WakeCallback = void (*)(void *arg);
+
+  static constexpr size_t MAX_WORKERS = 4;
+  // Handler and event type pairs
+  static constexpr size_t MAX_STRANDS = 16;
+  // Events queued per strand, more are dropped
+  static constexpr size_t STRAND_DEPTH = 32;
+  // Events handed to a handler in one call
+  static constexpr size_t MAX_BATCH_SIZE = 8;
+  // Events a worker runs of one strand before giving others a turn
+  static constexpr size_t MAX_STRAND_EVENTS = 16;
+
+  struct Stats
+  {
+    uint32_t executed; // Events handed to offloaded handlers
+    uint32_t stolen;   // Strands run by a worker other than the one queued on
+    uint32_t dropped;  // Events refused by a full strand
+  };
+
+  WorkStealingPool() = default;
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  /**
+   * @brief Add a worker. Only before the first submit().
+   * @param core Core the worker runs on, matched against strand core masks.
+   * @param wake Called when the worker has work, nullptr if it polls.
+   * @param arg Passed to wake.
+   * @return Worker index, -1 if all MAX_WORKERS are taken.
+   */
+  int addWorker(uint8_t core, WakeCallback wake, void *arg);
+
+  /**
+   * @brief Queue a batch for an offloaded handler, on the bus task.
+   * @param type Type of the events.
+   * @param handler The handler.
+   * @param coreMask Cores the handler may run on, bit n for core n.
+   * @param events The events, the caller keeps its references.
+   * @param count Number of events.
+   * @return False if no worker runs on coreMask or all strands are taken,
+   * the caller runs the handler itself then.
+   */
+  bool submit(EventType type, BatchCallback handler, uint32_t coreMask, const Event *events, size_t count);
+
+  /**
+   * @brief Run strands until none is left for a worker.
+   * @param worker Index from addWorker().
+   * @return Number of events handled.
+   */
+  size_t work(size_t worker);
+
+  /**
+   * @brief Release every queued event and forget the strands and workers.
+   * No worker may run meanwhile.
+   */
+  void clear();
+
+  Stats getStats() const;
+  size_t getWorkerCount() const { return workerCount; }
+
+private:
+  struct Strand
+  {
+    EventType type;
+    BatchCallback handler;
+    uint32_t coreMask;
+    SpscRing<Event, STRAND_DEPTH> events;
+    // On a run queue or being run, cleared by the worker once drained
+    std::atomic<bool> scheduled{false};
+  };
+
+  struct Worker
+  {
+    uint8_t core = 0;
+    WakeCallback wake = nullptr;
+    void *arg = nullptr;
+    // Set while the worker runs strands, idle workers are woken to steal
+    std::atomic<bool> busy{false};
+    // Run queue of strand indexes, owner takes the front, thieves the back
+    uint8_t queue[MAX_STRANDS];
+    size_t head = 0;
+    std::atomic<size_t> queued{0};
+    std::mutex mutex;
+    // Batch being handled, kept off the task stack
+    Event batch[MAX_BATCH_SIZE];
+  };
+
+  Strand strands[MAX_STRANDS];
+  std::atomic<size_t> strandCount{0};
+  Worker workers[MAX_WORKERS];
+  size_t workerCount = 0;
+
+  std::atomic<uint32_t> executed{0};
+  std::atomic<uint32_t> stolen{0};
+  std::atomic<uint32_t> dropped{0};
+
+  bool mayRun(const Strand &strand, const Worker &worker) const
+  {
+    return (strand.coreMask >> worker.core) & 1;
+  }
+  // Strand of a handler and type, created on first use. Bus task only.
+  int strandOf(EventType type, BatchCallback handler, uint32_t coreMask);
+  // Put a strand on the run queue of the least busy worker that may run it
+  void schedule(size_t strand);
+  bool take(Worker &worker, size_t &strand);
+  bool steal(size_t thief, size_t &strand);
+  // Handle up to MAX_STRAND_EVENTS of a strand, reschedule it if it has more
+  size_t runStrand(Worker &worker, size_t strand);
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef BOARDPROFILE_H
+#define BOARDPROFILE_H
+
+#include <stdint.h>
+
+// Compile-time description of the board hardware. A PlatformIO env that maps
+// to a board with a fixed key matrix sets BOARD_MATRIX_ROWS and
+// BOARD_MATRIX_COLS in its build_flags, the key scanner task then uses the
+// StaticKeyScanner specialized for that size whenever the stored config
+// matches. Without the flags the runtime configured KeyScanner is used.
+struct BoardProfile
+{
+#if defined(BOARD_MATRIX_ROWS) && defined(BOARD_MATRIX_COLS)
+  static constexpr bool FIXED_MATRIX = true;
+  static constexpr uint8_t MATRIX_ROWS = BOARD_MATRIX_ROWS;
+  static constexpr uint8_t MATRIX_COLS = BOARD_MATRIX_COLS;
+#else
+  static constexpr bool FIXED_MATRIX = false;
+  static constexpr uint8_t MATRIX_ROWS = 0;
+  static constexpr uint8_t MATRIX_COLS = 0;
+#endif
+};
+
+#endif
@@ -9,6 +9,18 @@
 static constexpr uint32_t STACK_EVENTBUS = 4096;
 static constexpr UBaseType_t PRIORITY_EVENTBUS = 5;
 static constexpr BaseType_t CORE_EVENTBUS = 1;
+// Run every handler on a task of its own behind an EventRing instead of all
+// of them on the event bus task, see RingBusTask
+static constexpr bool EVENTBUS_RING_BACKEND = false;
+static constexpr uint32_t STACK_RINGBUS_SUBSCRIBER = 3072;
+
+// Event Bus Workers, run offloaded handlers. Worker n runs on the core at
+// n modulo the list, below the key scanner's priority so a worker on its core
+// only runs while the scanner waits.
+static constexpr size_t EVENTBUS_WORKERS = 2;
+static constexpr BaseType_t CORE_EVENTBUS_WORKERS[] = {0, 1};
+static constexpr uint32_t STACK_EVENTBUS_WORKER = 4096;
+static constexpr UBaseType_t PRIORITY_EVENTBUS_WORKER = 3;
 
 // KeyScanner Task Config
 static constexpr uint32_t STACK_KEYSCAN = 4096;
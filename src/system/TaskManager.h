@@ -7,6 +7,7 @@
 #include <modules/LoggerTask.h>
 #include <modules/KeyScannerTask.h>
 #include <modules/MasterTask.h>
+#include <modules/RingBusTask.h>
 #include <modules/SlaveTask.h>
 
 #include <submodules/Config/ConfigManager.h>
@@ -19,8 +20,11 @@
 #include <interfaces/ILogSink.h>
 #include <interfaces/IStorage.h>
 
+#include <type_traits>
+
 using DeviceModule = GlobalConfig::DeviceModule;
 using DeviceMode = GlobalConfig::DeviceMode;
+using EventBusBackend = std::conditional<EVENTBUS_RING_BACKEND, RingBusTask, EventBusTask>::type;
 
 class TaskManager
 {
@@ -63,7 +67,7 @@ private:
 
   // Task classes are stored here, this is also the order they will be started/stopped
   LoggerTask loggerTask;
-  EventBusTask eventBusTask;
+  EventBusBackend eventBusTask;
   MasterTask masterTask;
   SlaveTask slaveTask;
   KeyScannerTask keyScannerTask;
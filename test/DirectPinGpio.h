@@ -0,0 +1,88 @@
+#ifndef TEST_DIRECTPINGPIO_H_
+#define TEST_DIRECTPINGPIO_H_
+
+#include <interfaces/IGpio.h>
+#include <unordered_map>
+#include <vector>
+
+// Simulated keys wired straight to their own pin. A closed key connects its
+// pin to ground, so an input with pull-up reads Low while the key is closed.
+class DirectPinGpio : public IGpio {
+public:
+  // Number of calls per operation since the last resetCounters()
+  struct CallCounts {
+    uint32_t pinMode;
+    uint32_t digitalWrite;
+    uint32_t digitalRead;
+    uint32_t readPins;
+    uint32_t writePins;
+
+    uint32_t total() const {
+      return pinMode + digitalWrite + digitalRead + readPins + writePins;
+    }
+  };
+
+  CallCounts calls{};
+
+  DirectPinGpio(const uint8_t *keyPins, uint8_t keyCount)
+      : keyPins(keyPins, keyPins + keyCount) {}
+
+  void pinMode(uint8_t pin, PinMode mode) override { calls.pinMode++; }
+
+  PinState digitalRead(uint8_t pin) override {
+    calls.digitalRead++;
+    return (sampleLevels() & pinToMask(pin)) ? PinState::High : PinState::Low;
+  }
+
+  // Nothing is driven in a direct pin board
+  void digitalWrite(uint8_t pin, PinState value) override { calls.digitalWrite++; }
+
+  uint64_t readPins(uint64_t pinMask) override {
+    calls.readPins++;
+    return sampleLevels() & pinMask;
+  }
+
+  void writePins(uint64_t pinMask, PinState value) override { calls.writePins++; }
+
+  void attachPinInterrupt(uint8_t pin, PinEdge edge, PinInterruptHandler handler,
+                          void *arg) override {
+    interrupts[pin] = {edge, handler, arg};
+  }
+
+  void detachPinInterrupt(uint8_t pin) override { interrupts.erase(pin); }
+
+  bool hasInterrupt(uint8_t pin) const { return interrupts.count(pin) != 0; }
+
+  void resetCounters() { calls = {}; }
+
+  // Close or open the key on keyPins[key]
+  void setKey(uint16_t key, bool closed) {
+    uint64_t bit = pinToMask(keyPins[key]);
+    if (closed)
+      closedPins |= bit;
+    else
+      closedPins &= ~bit;
+
+    auto interrupt = interrupts.find(keyPins[key]);
+    if (interrupt == interrupts.end())
+      return;
+    PinEdge edge = closed ? PinEdge::Falling : PinEdge::Rising;
+    if (interrupt->second.edge == edge || interrupt->second.edge == PinEdge::Change)
+      interrupt->second.handler(interrupt->second.arg);
+  }
+
+private:
+  struct PinInterrupt {
+    PinEdge edge;
+    PinInterruptHandler handler;
+    void *arg;
+  };
+
+  std::vector<uint8_t> keyPins;
+  uint64_t closedPins = 0;
+  std::unordered_map<uint8_t, PinInterrupt> interrupts;
+
+  uint64_t sampleLevels() const { return ~closedPins; }
+};
+
+#endif // TEST_DIRECTPINGPIO_H_
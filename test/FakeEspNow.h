@@ -1,17 +1,43 @@
 #ifndef TEST_FAKE_ESPNOW_H
 #define TEST_FAKE_ESPNOW_H
 
+#include <array>
+#include <cstring>
 #include <functional>
 #include <interfaces/ITransport.h>
+#include <vector>
 
 class FakeEspNow : public ITransport
 {
 public:
+  // Copy of a packet passed to sendData
+  struct SentPacket
+  {
+    uint8_t packetType;
+    std::vector<uint8_t> data;
+    std::array<uint8_t, 6> targetMac;
+  };
+
+  std::vector<SentPacket> sentPackets;
+
   bool sendData(uint8_t packetType, const uint8_t *data, size_t length, const uint8_t *targetMac) override
   {
-    // do nothing
+    SentPacket packet{packetType, std::vector<uint8_t>(data, data + length), {}};
+    if (targetMac)
+      memcpy(packet.targetMac.data(), targetMac, packet.targetMac.size());
+    sentPackets.push_back(packet);
     return true;
   }
+
+  // Deliver every recorded packet to this transport's own callbacks as if it
+  // came from senderMac, then forget them
+  void loopbackSentPackets(const uint8_t *senderMac)
+  {
+    std::vector<SentPacket> packets;
+    packets.swap(sentPackets);
+    for (const SentPacket &packet : packets)
+      simulateReceiveData(packet.packetType, packet.data.data(), packet.data.size(), senderMac);
+  }
   bool registerPacketTypeCallback(uint8_t packetType,
                                   receiveCallback callback) override
   {
@@ -3,6 +3,7 @@
 
 #include <interfaces/IGpio.h>
 #include <unordered_map>
+#include <vector>
 
 #define INPUT_PULLUP 0x2
 #define INPUT 0x0
@@ -12,15 +13,135 @@
 
 class FakeGpio : public IGpio {
 public:
+  // Number of calls per operation since the last resetCounters()
+  struct CallCounts {
+    uint32_t pinMode;
+    uint32_t digitalWrite;
+    uint32_t digitalRead;
+    uint32_t readPins;
+    uint32_t writePins;
+
+    uint32_t total() const {
+      return pinMode + digitalWrite + digitalRead + readPins + writePins;
+    }
+  };
+
+  CallCounts calls{};
+
   void pinMode(uint8_t pin, PinMode mode) override {
-    // do nothing
+    calls.pinMode++;
+    pinModes[pin] = mode;
   }
 
-  PinState digitalRead(uint8_t pin) override { return PinState::High; }
+  PinState digitalRead(uint8_t pin) override {
+    calls.digitalRead++;
+    return (sampleLevels(pinToMask(pin)) != 0) ? PinState::High : PinState::Low;
+  }
 
   void digitalWrite(uint8_t pin, PinState value) override {
-    // do nothing
+    calls.digitalWrite++;
+    setOutputLevels(pinToMask(pin), value);
+  }
+
+  uint64_t readPins(uint64_t pinMask) override {
+    calls.readPins++;
+    return sampleLevels(pinMask);
+  }
+
+  void writePins(uint64_t pinMask, PinState value) override {
+    calls.writePins++;
+    setOutputLevels(pinMask, value);
+  }
+
+  void attachPinInterrupt(uint8_t pin, PinEdge edge, PinInterruptHandler handler,
+                          void *arg) override {
+    interrupts[pin] = {edge, handler, arg};
+  }
+
+  void detachPinInterrupt(uint8_t pin) override { interrupts.erase(pin); }
+
+  void resetCounters() { calls = {}; }
+
+  // Test helper: force the level every read of the pin returns. Pins default
+  // to High, i.e. no key pressed.
+  void setPinState(uint8_t pin, PinState state) {
+    if (state == PinState::High)
+      pinLevels |= pinToMask(pin);
+    else
+      pinLevels &= ~pinToMask(pin);
+  }
+
+  // Test helper: replay a waveform on a pin. Every read of the pin consumes
+  // the next level, the last level is held once the script is exhausted.
+  void scriptPin(uint8_t pin, const std::vector<PinState> &levels) {
+    scripts[pin] = {levels, 0};
+  }
+
+  void clearScripts() { scripts.clear(); }
+
+  // Test helper: change the level of a pin and invoke its interrupt handler if
+  // the resulting edge is armed, like the hardware would.
+  void injectEdge(uint8_t pin, PinState level) {
+    bool wasHigh = (pinLevels & pinToMask(pin)) != 0;
+    setPinState(pin, level);
+    bool isHigh = (level == PinState::High);
+    auto it = interrupts.find(pin);
+    if (wasHigh == isHigh || it == interrupts.end())
+      return;
+    PinEdge edge = isHigh ? PinEdge::Rising : PinEdge::Falling;
+    if (it->second.edge == edge || it->second.edge == PinEdge::Change)
+      it->second.handler(it->second.arg);
+  }
+
+  bool isInterruptArmed(uint8_t pin) const {
+    return interrupts.find(pin) != interrupts.end();
+  }
+
+  PinMode getPinMode(uint8_t pin) const {
+    auto it = pinModes.find(pin);
+    return it == pinModes.end() ? PinMode::Input : it->second;
+  }
+
+  PinState getOutputLevel(uint8_t pin) const {
+    return (outputLevels & pinToMask(pin)) ? PinState::High : PinState::Low;
+  }
+
+private:
+  struct PinScript {
+    std::vector<PinState> levels;
+    size_t position;
+  };
+
+  struct PinInterrupt {
+    PinEdge edge;
+    PinInterruptHandler handler;
+    void *arg;
+  };
+
+  uint64_t pinLevels = ~uint64_t{0};
+  uint64_t outputLevels = ~uint64_t{0};
+  std::unordered_map<uint8_t, PinScript> scripts;
+  std::unordered_map<uint8_t, PinMode> pinModes;
+  std::unordered_map<uint8_t, PinInterrupt> interrupts;
+
+  void setOutputLevels(uint64_t pinMask, PinState value) {
+    if (value == PinState::High)
+      outputLevels |= pinMask;
+    else
+      outputLevels &= ~pinMask;
+  }
+
+  uint64_t sampleLevels(uint64_t pinMask) {
+    for (auto &entry : scripts) {
+      PinScript &script = entry.second;
+      if (!(pinMask & pinToMask(entry.first)) || script.levels.empty())
+        continue;
+      setPinState(entry.first, script.levels[script.position]);
+      if (script.position + 1 < script.levels.size())
+        script.position++;
+    }
+    return pinLevels & pinMask;
   }
 };
 
-#endif // TEST_TEST_KEYSCANNER_FAKEGPIO_H_
\ No newline at end of file
+#endif // TEST_TEST_KEYSCANNER_FAKEGPIO_H_
@@ -0,0 +1,303 @@
+#ifndef TEST_MATRIXGPIO_H_
+#define TEST_MATRIXGPIO_H_
+
+#include <algorithm>
+#include <interfaces/IGpio.h>
+#include <unordered_map>
+#include <vector>
+
+// Simulated key matrix behind the IGpio interface. Keys connect a row line
+// with a column line; a line configured as input with pull-up reads Low when a
+// closed key connects it to a line driven Low, exactly like the hardware.
+// Key presses are replayed from a timed script against a virtual clock the
+// test advances, so scans can be driven with realistic typing, bounce and
+// ghosting patterns. Reverse keys, with the diode pointing from row to column,
+// turn the diode matrix into a duplex matrix.
+class MatrixGpio : public IGpio {
+public:
+  // Number of calls per operation since the last resetCounters()
+  struct CallCounts {
+    uint32_t pinMode;
+    uint32_t digitalWrite;
+    uint32_t digitalRead;
+    uint32_t readPins;
+    uint32_t writePins;
+
+    uint32_t total() const {
+      return pinMode + digitalWrite + digitalRead + readPins + writePins;
+    }
+  };
+
+  // One scripted contact change of a key
+  struct KeyEvent {
+    uint64_t timeUs;
+    uint8_t row;
+    uint8_t col;
+    bool closed;
+    bool reverse;
+  };
+
+  CallCounts calls{};
+
+  // diodes: every key has a diode from column to row, current only flows when
+  // a row is driven. Without diodes current flows both ways and through
+  // several keys, which is what makes ghost keys appear.
+  MatrixGpio(const uint8_t *rowPins, uint8_t rowCount, const uint8_t *colPins,
+             uint8_t colCount, bool diodes = true)
+      : rowPins(rowPins, rowPins + rowCount),
+        colPins(colPins, colPins + colCount), diodes(diodes),
+        closedKeys(rowCount, 0), closedReverseKeys(rowCount, 0) {}
+
+  void pinMode(uint8_t pin, PinMode mode) override {
+    calls.pinMode++;
+    if (mode == PinMode::Output)
+      outputPinMask |= pinToMask(pin);
+    else
+      outputPinMask &= ~pinToMask(pin);
+  }
+
+  PinState digitalRead(uint8_t pin) override {
+    calls.digitalRead++;
+    return (sampleLevels() & pinToMask(pin)) ? PinState::High : PinState::Low;
+  }
+
+  void digitalWrite(uint8_t pin, PinState value) override {
+    calls.digitalWrite++;
+    setOutputLevels(pinToMask(pin), value);
+  }
+
+  uint64_t readPins(uint64_t pinMask) override {
+    calls.readPins++;
+    return sampleLevels() & pinMask;
+  }
+
+  void writePins(uint64_t pinMask, PinState value) override {
+    calls.writePins++;
+    setOutputLevels(pinMask, value);
+  }
+
+  void attachPinInterrupt(uint8_t pin, PinEdge edge, PinInterruptHandler handler,
+                          void *arg) override {
+    interrupts[pin] = {edge, handler, arg};
+  }
+
+  void detachPinInterrupt(uint8_t pin) override { interrupts.erase(pin); }
+
+  void resetCounters() { calls = {}; }
+
+  // Close or open a key right away
+  void setKey(uint8_t row, uint8_t col, bool closed) {
+    uint64_t before = sampleLevels();
+    if (closed)
+      closedKeys[row] |= (uint32_t{1} << col);
+    else
+      closedKeys[row] &= ~(uint32_t{1} << col);
+    fireInterrupts(before, sampleLevels());
+  }
+
+  bool isKeyClosed(uint8_t row, uint8_t col) const {
+    return (closedKeys[row] >> col) & 1;
+  }
+
+  // Close or open the reverse key of a crossing right away, only conducts
+  // with diodes, from a row into a driven column
+  void setReverseKey(uint8_t row, uint8_t col, bool closed) {
+    uint64_t before = sampleLevels();
+    if (closed)
+      closedReverseKeys[row] |= (uint32_t{1} << col);
+    else
+      closedReverseKeys[row] &= ~(uint32_t{1} << col);
+    fireInterrupts(before, sampleLevels());
+  }
+
+  // Script helpers, events may be added in any order
+
+  void addEvent(uint64_t timeUs, uint8_t row, uint8_t col, bool closed,
+                bool reverse = false) {
+    script.push_back({timeUs, row, col, closed, reverse});
+    scriptSorted = false;
+  }
+
+  // Press a key for holdUs. With bounce, the contact flips back bounceCount
+  // times per edge before it settles, contact changes bounceIntervalUs apart.
+  void press(uint64_t timeUs, uint8_t row, uint8_t col, uint64_t holdUs,
+             uint8_t bounceCount = 0, uint64_t bounceIntervalUs = 0) {
+    addEdge(timeUs, row, col, true, bounceCount, bounceIntervalUs);
+    addEdge(timeUs + holdUs, row, col, false, bounceCount, bounceIntervalUs);
+    keystrokes++;
+  }
+
+  // Same as press() for the reverse key of a crossing
+  void pressReverse(uint64_t timeUs, uint8_t row, uint8_t col, uint64_t holdUs,
+                    uint8_t bounceCount = 0, uint64_t bounceIntervalUs = 0) {
+    addEdge(timeUs, row, col, true, bounceCount, bounceIntervalUs, true);
+    addEdge(timeUs + holdUs, row, col, false, bounceCount, bounceIntervalUs, true);
+    keystrokes++;
+  }
+
+  // Type the given keys one after another, intervalUs apart
+  void typingBurst(uint64_t startUs, const std::vector<std::pair<uint8_t, uint8_t>> &keys,
+                   uint64_t intervalUs, uint64_t holdUs, uint8_t bounceCount = 0,
+                   uint64_t bounceIntervalUs = 0) {
+    for (size_t i = 0; i < keys.size(); i++)
+      press(startUs + i * intervalUs, keys[i].first, keys[i].second, holdUs,
+            bounceCount, bounceIntervalUs);
+  }
+
+  // Hold three corners of the rectangle spanned by (row0, col0) and
+  // (row1, col1). Without diodes the fourth corner reads as pressed too.
+  void ghostRectangle(uint64_t timeUs, uint8_t row0, uint8_t col0, uint8_t row1,
+                      uint8_t col1, uint64_t holdUs) {
+    press(timeUs, row0, col0, holdUs);
+    press(timeUs, row0, col1, holdUs);
+    press(timeUs, row1, col0, holdUs);
+  }
+
+  // Apply all scripted events up to and including timeUs
+  void advanceTo(uint64_t timeUs) {
+    if (!scriptSorted) {
+      std::stable_sort(script.begin() + nextEvent, script.end(),
+                       [](const KeyEvent &a, const KeyEvent &b) { return a.timeUs < b.timeUs; });
+      scriptSorted = true;
+    }
+    while (nextEvent < script.size() && script[nextEvent].timeUs <= timeUs) {
+      const KeyEvent &event = script[nextEvent++];
+      if (event.reverse)
+        setReverseKey(event.row, event.col, event.closed);
+      else
+        setKey(event.row, event.col, event.closed);
+    }
+    nowUs = timeUs;
+  }
+
+  uint64_t now() const { return nowUs; }
+  bool scriptDone() const { return nextEvent >= script.size(); }
+  uint32_t getKeystrokes() const { return keystrokes; }
+
+  void clearScript() {
+    script.clear();
+    nextEvent = 0;
+    keystrokes = 0;
+  }
+
+private:
+  struct PinInterrupt {
+    PinEdge edge;
+    PinInterruptHandler handler;
+    void *arg;
+  };
+
+  std::vector<uint8_t> rowPins;
+  std::vector<uint8_t> colPins;
+  bool diodes;
+
+  // Bit c of closedKeys[r] is set while the key at (r, c) is closed, same for
+  // the reverse keys of a duplex matrix
+  std::vector<uint32_t> closedKeys;
+  std::vector<uint32_t> closedReverseKeys;
+
+  uint64_t outputLevels = ~uint64_t{0};
+  uint64_t outputPinMask = 0;
+  std::unordered_map<uint8_t, PinInterrupt> interrupts;
+
+  std::vector<KeyEvent> script;
+  size_t nextEvent = 0;
+  bool scriptSorted = true;
+  uint64_t nowUs = 0;
+  uint32_t keystrokes = 0;
+
+  void addEdge(uint64_t timeUs, uint8_t row, uint8_t col, bool closed,
+               uint8_t bounceCount, uint64_t bounceIntervalUs, bool reverse = false) {
+    // closed, open, closed, ... ending on the final level
+    for (uint16_t i = 0; i <= 2 * bounceCount; i++)
+      addEvent(timeUs + i * bounceIntervalUs, row, col, (i % 2 == 0) ? closed : !closed,
+               reverse);
+  }
+
+  bool isDrivenLow(uint8_t pin) const {
+    return (outputPinMask & ~outputLevels & pinToMask(pin)) != 0;
+  }
+
+  void setOutputLevels(uint64_t pinMask, PinState value) {
+    uint64_t before = sampleLevels();
+    if (value == PinState::High)
+      outputLevels |= pinMask;
+    else
+      outputLevels &= ~pinMask;
+    fireInterrupts(before, sampleLevels());
+  }
+
+  // Levels of all pins: outputs read their own level, everything else is
+  // pulled up unless a closed key connects it to a line driven Low
+  uint64_t sampleLevels() const {
+    uint32_t lowRows = 0;
+    uint32_t lowCols = 0;
+    for (size_t r = 0; r < rowPins.size(); r++)
+      if (isDrivenLow(rowPins[r]))
+        lowRows |= (uint32_t{1} << r);
+    for (size_t c = 0; c < colPins.size(); c++)
+      if (isDrivenLow(colPins[c]))
+        lowCols |= (uint32_t{1} << c);
+
+    if (diodes) {
+      // Current only flows from a column into a low row, or through a reverse
+      // key from a row into a low column. Spread until nothing changes.
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (size_t r = 0; r < rowPins.size(); r++) {
+          uint32_t rowBit = uint32_t{1} << r;
+          if ((lowRows & rowBit) && (closedKeys[r] & ~lowCols)) {
+            lowCols |= closedKeys[r];
+            changed = true;
+          }
+          if (!(lowRows & rowBit) && (closedReverseKeys[r] & lowCols)) {
+            lowRows |= rowBit;
+            changed = true;
+          }
+        }
+      }
+    } else {
+      // Spread the Low level through closed keys until nothing changes
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (size_t r = 0; r < rowPins.size(); r++) {
+          bool rowLow = lowRows & (uint32_t{1} << r);
+          if (rowLow && (closedKeys[r] & ~lowCols)) {
+            lowCols |= closedKeys[r];
+            changed = true;
+          } else if (!rowLow && (closedKeys[r] & lowCols)) {
+            lowRows |= (uint32_t{1} << r);
+            changed = true;
+          }
+        }
+      }
+    }
+
+    uint64_t levels = ~uint64_t{0};
+    for (size_t r = 0; r < rowPins.size(); r++)
+      if (lowRows & (uint32_t{1} << r))
+        levels &= ~pinToMask(rowPins[r]);
+    for (size_t c = 0; c < colPins.size(); c++)
+      if (lowCols & (uint32_t{1} << c))
+        levels &= ~pinToMask(colPins[c]);
+    // Outputs driven High read High even if a key shorts them
+    return levels | (outputLevels & outputPinMask);
+  }
+
+  void fireInterrupts(uint64_t before, uint64_t after) {
+    if (interrupts.empty() || before == after)
+      return;
+    for (const auto &entry : interrupts) {
+      uint64_t bit = pinToMask(entry.first);
+      if ((before & bit) == (after & bit))
+        continue;
+      PinEdge edge = (after & bit) ? PinEdge::Rising : PinEdge::Falling;
+      if (entry.second.edge == edge || entry.second.edge == PinEdge::Change)
+        entry.second.handler(entry.second.arg);
+    }
+  }
+};
+
+#endif // TEST_MATRIXGPIO_H_
@@ -0,0 +1,110 @@
+#ifndef TEST_SHIFTREGISTERGPIO_H_
+#define TEST_SHIFTREGISTERGPIO_H_
+
+#include <interfaces/IGpio.h>
+#include <vector>
+
+// Simulated chain of 74HC165 parallel-in shift registers with a key on every
+// input. While the load pin is Low the inputs are latched continuously, every
+// rising clock edge with load High moves the chain one bit towards the data
+// pin. Key k is the k-th bit to appear on the data pin; closed keys read Low
+// and the serial input of the last register is pulled up.
+class ShiftRegisterGpio : public IGpio {
+public:
+  // Number of calls per operation since the last resetCounters()
+  struct CallCounts {
+    uint32_t pinMode;
+    uint32_t digitalWrite;
+    uint32_t digitalRead;
+    uint32_t readPins;
+    uint32_t writePins;
+
+    uint32_t total() const {
+      return pinMode + digitalWrite + digitalRead + readPins + writePins;
+    }
+  };
+
+  CallCounts calls{};
+
+  ShiftRegisterGpio(uint8_t loadPin, uint8_t clockPin, uint8_t dataPin,
+                    uint8_t registerCount)
+      : loadPin(loadPin), clockPin(clockPin), dataPin(dataPin),
+        closedKeys(registerCount * 8, false), latched(registerCount * 8, false) {}
+
+  void pinMode(uint8_t pin, PinMode mode) override { calls.pinMode++; }
+
+  PinState digitalRead(uint8_t pin) override {
+    calls.digitalRead++;
+    return (sampleLevels() & pinToMask(pin)) ? PinState::High : PinState::Low;
+  }
+
+  void digitalWrite(uint8_t pin, PinState value) override {
+    calls.digitalWrite++;
+    setLevel(pin, value);
+  }
+
+  uint64_t readPins(uint64_t pinMask) override {
+    calls.readPins++;
+    return sampleLevels() & pinMask;
+  }
+
+  void writePins(uint64_t pinMask, PinState value) override {
+    calls.writePins++;
+    for (uint8_t pin = 0; pin < 64; pin++)
+      if (pinMask & pinToMask(pin))
+        setLevel(pin, value);
+  }
+
+  // No interrupt capable line in a shift register chain
+  void attachPinInterrupt(uint8_t pin, PinEdge edge, PinInterruptHandler handler,
+                          void *arg) override {}
+  void detachPinInterrupt(uint8_t pin) override {}
+
+  void resetCounters() { calls = {}; }
+
+  void setKey(uint16_t key, bool closed) {
+    closedKeys[key] = closed;
+    if (!loadHigh)
+      latch();
+  }
+
+  // Number of rising clock edges since the last load
+  uint32_t getClockedBits() const { return position; }
+
+private:
+  uint8_t loadPin;
+  uint8_t clockPin;
+  uint8_t dataPin;
+  std::vector<bool> closedKeys;
+  std::vector<bool> latched;
+  bool loadHigh = true;
+  bool clockHigh = false;
+  uint32_t position = 0;
+
+  void latch() {
+    latched = closedKeys;
+    position = 0;
+  }
+
+  void setLevel(uint8_t pin, PinState value) {
+    bool high = value == PinState::High;
+    if (pin == loadPin) {
+      loadHigh = high;
+      if (!loadHigh)
+        latch();
+    } else if (pin == clockPin) {
+      if (high && !clockHigh && loadHigh)
+        position++;
+      clockHigh = high;
+    }
+  }
+
+  uint64_t sampleLevels() const {
+    uint64_t levels = ~uint64_t{0};
+    if (position < latched.size() && latched[position])
+      levels &= ~pinToMask(dataPin);
+    return levels;
+  }
+};
+
+#endif // TEST_SHIFTREGISTERGPIO_H_
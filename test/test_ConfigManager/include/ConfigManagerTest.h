@@ -193,6 +193,215 @@ void test_ConfigManager_overwrite_config()
   TEST_ASSERT_EQUAL_UINT8_ARRAY(mac2, retrievedMac, 6);
 }
 
+void test_ConfigManager_save_and_load_KeyScannerConfig_scanSettings()
+{
+  ConfigManager manager1(testStorage);
+  manager1.createConfig<KeyScannerConfig>();
+
+  KeyScannerConfig scannerCfg;
+  scannerCfg.setScanOrder(KeyScannerConfig::ScanOrder::Auto);
+  scannerCfg.setDebounce(KeyScannerConfig::DebounceMode::Eager, 12);
+  manager1.setConfig(scannerCfg);
+  manager1.saveConfigs();
+
+  ConfigManager manager2(testStorage);
+  manager2.createConfig<KeyScannerConfig>();
+  manager2.loadConfigs();
+
+  KeyScannerConfig *retrieved = manager2.getConfig<KeyScannerConfig>();
+  TEST_ASSERT_NOT_NULL(retrieved);
+  TEST_ASSERT_EQUAL(KeyScannerConfig::ScanOrder::Auto, retrieved->getScanOrder());
+  TEST_ASSERT_EQUAL(KeyScannerConfig::DebounceMode::Eager, retrieved->getDebounceMode());
+  TEST_ASSERT_EQUAL(12, retrieved->getDebounceTime());
+}
+
+void test_ConfigManager_load_KeyScannerConfig_rejectsDebounceTime()
+{
+  KeyScannerConfig scannerCfg;
+  scannerCfg.setDebounce(KeyScannerConfig::DebounceMode::Eager, 77);
+  std::vector<uint8_t> packed(scannerCfg.getSerializedSize());
+  TEST_ASSERT_EQUAL(packed.size(), scannerCfg.packSerialized(packed.data(), packed.size()));
+
+  // A stored time setDebounce() would refuse falls back to the default
+  size_t timeOffset = 0;
+  for (size_t i = 1; i < packed.size() && timeOffset == 0; i++)
+    if (packed[i - 1] == static_cast<uint8_t>(KeyScannerConfig::DebounceMode::Eager) && packed[i] == 77)
+      timeOffset = i;
+  TEST_ASSERT_NOT_EQUAL(0, timeOffset);
+  packed[timeOffset] = 101;
+
+  KeyScannerConfig loaded;
+  loaded.unpackSerialized(packed.data(), packed.size());
+  TEST_ASSERT_EQUAL(KeyScannerConfig::DebounceMode::Eager, loaded.getDebounceMode());
+  TEST_ASSERT_EQUAL(5, loaded.getDebounceTime());
+}
+
+void test_ConfigManager_save_and_load_KeyScannerConfig_largeMatrix()
+{
+  ConfigManager manager1(testStorage);
+  manager1.createConfig<KeyScannerConfig>();
+
+  // 16 x 32 = 512 keys, more than an 8 bit key index can address
+  uint8_t rowPins[16];
+  uint8_t colPins[32];
+  for (uint8_t i = 0; i < sizeof(rowPins); i++)
+    rowPins[i] = i;
+  for (uint8_t i = 0; i < sizeof(colPins); i++)
+    colPins[i] = 16 + i;
+  uint8_t hidMap[512];
+  for (size_t i = 0; i < sizeof(hidMap); i++)
+    hidMap[i] = static_cast<uint8_t>(i % 251);
+
+  KeyScannerConfig scannerCfg;
+  scannerCfg.setPins(rowPins, sizeof(rowPins), colPins, sizeof(colPins));
+  scannerCfg.setLocalToHidMap(hidMap, sizeof(hidMap));
+  manager1.setConfig(scannerCfg);
+  TEST_ASSERT_TRUE(manager1.saveConfigs());
+
+  ConfigManager manager2(testStorage);
+  manager2.createConfig<KeyScannerConfig>();
+  TEST_ASSERT_TRUE(manager2.loadConfigs());
+
+  KeyScannerConfig *retrieved = manager2.getConfig<KeyScannerConfig>();
+  TEST_ASSERT_NOT_NULL(retrieved);
+  TEST_ASSERT_EQUAL(16, retrieved->getRowsCount());
+  TEST_ASSERT_EQUAL(32, retrieved->getColCount());
+  TEST_ASSERT_EQUAL(64, retrieved->getBitmapSize());
+  TEST_ASSERT_EQUAL(512, retrieved->getLocalToHidMap().size());
+  TEST_ASSERT_EQUAL(hidMap[300], retrieved->getHIDCodeForIndex(300));
+  TEST_ASSERT_EQUAL(hidMap[511], retrieved->getHIDCodeForIndex(511));
+}
+
+void test_ConfigManager_save_and_load_KeyScannerConfig_topology()
+{
+  ConfigManager manager1(testStorage);
+  manager1.createConfig<KeyScannerConfig>();
+
+  // Direct pins have no rows, the whole HID map follows the topology fields
+  uint8_t keyPins[20];
+  uint8_t hidMap[20];
+  for (uint8_t i = 0; i < sizeof(keyPins); i++)
+  {
+    keyPins[i] = i;
+    hidMap[i] = 0x04 + i;
+  }
+
+  KeyScannerConfig scannerCfg;
+  scannerCfg.setPins(nullptr, 0, keyPins, sizeof(keyPins));
+  scannerCfg.setTopology(KeyScannerConfig::ScanTopology::DirectPins);
+  scannerCfg.setGhostFilter(true);
+  scannerCfg.setLocalToHidMap(hidMap, sizeof(hidMap));
+  TEST_ASSERT_EQUAL(20, scannerCfg.getKeyCount());
+  TEST_ASSERT_EQUAL(3, scannerCfg.getBitmapSize());
+  manager1.setConfig(scannerCfg);
+  TEST_ASSERT_TRUE(manager1.saveConfigs());
+
+  ConfigManager manager2(testStorage);
+  manager2.createConfig<KeyScannerConfig>();
+  TEST_ASSERT_TRUE(manager2.loadConfigs());
+
+  KeyScannerConfig *retrieved = manager2.getConfig<KeyScannerConfig>();
+  TEST_ASSERT_NOT_NULL(retrieved);
+  TEST_ASSERT_EQUAL(KeyScannerConfig::ScanTopology::DirectPins, retrieved->getTopology());
+  TEST_ASSERT_TRUE(retrieved->isGhostFilterEnabled());
+  TEST_ASSERT_EQUAL(20, retrieved->getKeyCount());
+  TEST_ASSERT_EQUAL(3, retrieved->getBitmapSize());
+  TEST_ASSERT_EQUAL(20, retrieved->getLocalToHidMap().size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(hidMap, retrieved->getLocalToHidMap().data(), sizeof(hidMap));
+}
+
+void test_ConfigManager_save_and_load_KeyScannerConfig_adaptiveScan()
+{
+  ConfigManager manager1(testStorage);
+  manager1.createConfig<KeyScannerConfig>();
+
+  KeyScannerConfig scannerCfg;
+  TEST_ASSERT_EQUAL(0, scannerCfg.getIdleRefreshRate());
+  TEST_ASSERT_EQUAL(0, scannerCfg.getHeldKeyRefreshRate());
+
+  // Out of range settings are refused as a whole
+  scannerCfg.setAdaptiveScan(100, 10001, 500);
+  TEST_ASSERT_EQUAL(0, scannerCfg.getIdleRefreshRate());
+  scannerCfg.setAdaptiveScan(100, 300, 500);
+  manager1.setConfig(scannerCfg);
+  TEST_ASSERT_TRUE(manager1.saveConfigs());
+
+  ConfigManager manager2(testStorage);
+  manager2.createConfig<KeyScannerConfig>();
+  TEST_ASSERT_TRUE(manager2.loadConfigs());
+
+  KeyScannerConfig *retrieved = manager2.getConfig<KeyScannerConfig>();
+  TEST_ASSERT_NOT_NULL(retrieved);
+  TEST_ASSERT_EQUAL(100, retrieved->getIdleRefreshRate());
+  TEST_ASSERT_EQUAL(300, retrieved->getBoostHoldOffTime());
+  TEST_ASSERT_EQUAL(500, retrieved->getHeldKeyRefreshRate());
+}
+
+void test_ConfigManager_save_and_load_KeyScannerConfig_extraMatrices()
+{
+  ConfigManager manager1(testStorage);
+  manager1.createConfig<KeyScannerConfig>();
+
+  uint8_t rowPins[3] = {1, 2, 3};
+  uint8_t colPins[3] = {4, 5, 6};
+  KeyScannerConfig scannerCfg;
+  scannerCfg.setPins(rowPins, 3, colPins, 3);
+
+  KeyScannerConfig::ScanMatrix macro;
+  macro.rowPins = {10, 11};
+  macro.colPins = {12, 13, 14};
+  macro.refreshRate = 250;
+  macro.ownTask = true;
+  macro.coreAffinity = 1;
+  scannerCfg.addMatrix(macro);
+
+  // Invalid matrices are refused
+  KeyScannerConfig::ScanMatrix empty;
+  scannerCfg.addMatrix(empty);
+  KeyScannerConfig::ScanMatrix tooFast = macro;
+  tooFast.refreshRate = 2000;
+  scannerCfg.addMatrix(tooFast);
+  TEST_ASSERT_EQUAL(2, scannerCfg.getMatrixCount());
+
+  // The macro keys start at the byte after the 9 main keys
+  TEST_ASSERT_EQUAL(16, scannerCfg.getKeyOffset(1));
+  TEST_ASSERT_EQUAL(22, scannerCfg.getKeyCount());
+  TEST_ASSERT_EQUAL(3, scannerCfg.getBitmapSize());
+  uint8_t hidMap[22];
+  for (uint8_t i = 0; i < sizeof(hidMap); i++)
+    hidMap[i] = 0x04 + i;
+  scannerCfg.setLocalToHidMap(hidMap, sizeof(hidMap));
+  manager1.setConfig(scannerCfg);
+  TEST_ASSERT_TRUE(manager1.saveConfigs());
+
+  ConfigManager manager2(testStorage);
+  manager2.createConfig<KeyScannerConfig>();
+  TEST_ASSERT_TRUE(manager2.loadConfigs());
+
+  KeyScannerConfig *retrieved = manager2.getConfig<KeyScannerConfig>();
+  TEST_ASSERT_NOT_NULL(retrieved);
+  TEST_ASSERT_EQUAL(2, retrieved->getMatrixCount());
+  KeyScannerConfig::ScanMatrix loaded = retrieved->getMatrix(1);
+  TEST_ASSERT_EQUAL(KeyScannerConfig::ScanTopology::Matrix, loaded.topology);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(macro.rowPins.data(), loaded.rowPins.data(), 2);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(macro.colPins.data(), loaded.colPins.data(), 3);
+  TEST_ASSERT_EQUAL(250, loaded.refreshRate);
+  TEST_ASSERT_TRUE(loaded.ownTask);
+  TEST_ASSERT_EQUAL(1, loaded.coreAffinity);
+  TEST_ASSERT_EQUAL(9, retrieved->getMatrix(0).getKeyCount());
+  TEST_ASSERT_EQUAL(22, retrieved->getKeyCount());
+  TEST_ASSERT_EQUAL(22, retrieved->getLocalToHidMap().size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(hidMap, retrieved->getLocalToHidMap().data(), sizeof(hidMap));
+
+  // A config without extra matrices drops the loaded ones
+  scannerCfg.clearExtraMatrices();
+  TEST_ASSERT_EQUAL(9, scannerCfg.getKeyCount());
+  manager1.setConfig(scannerCfg);
+  TEST_ASSERT_TRUE(manager1.saveConfigs());
+  TEST_ASSERT_TRUE(manager2.loadConfigs());
+  TEST_ASSERT_EQUAL(1, manager2.getConfig<KeyScannerConfig>()->getMatrixCount());
+}
+
 void run_ConfigManager_tests()
 {
   RUN_TEST(test_ConfigManager_initialization);
@@ -204,6 +413,12 @@ void run_ConfigManager_tests()
   RUN_TEST(test_ConfigManager_loadConfig);
   RUN_TEST(test_ConfigManager_save_and_load_multiple_configs);
   RUN_TEST(test_ConfigManager_overwrite_config);
+  RUN_TEST(test_ConfigManager_save_and_load_KeyScannerConfig_scanSettings);
+  RUN_TEST(test_ConfigManager_load_KeyScannerConfig_rejectsDebounceTime);
+  RUN_TEST(test_ConfigManager_save_and_load_KeyScannerConfig_largeMatrix);
+  RUN_TEST(test_ConfigManager_save_and_load_KeyScannerConfig_topology);
+  RUN_TEST(test_ConfigManager_save_and_load_KeyScannerConfig_adaptiveScan);
+  RUN_TEST(test_ConfigManager_save_and_load_KeyScannerConfig_extraMatrices);
 }
 
 #endif
\ No newline at end of file
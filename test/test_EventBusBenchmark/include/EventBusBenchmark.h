@@ -0,0 +1,125 @@
+#ifndef EVENTBUSBENCHMARK_H
+#define EVENTBUSBENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <submodules/EventLanes.h>
+#include <submodules/EventRegistry.h>
+#include <unity.h>
+
+// Bursts of key events as a chord or a fast roll leaves the scan task,
+// drained by the bus the way EventBusTask does
+static constexpr uint32_t BUS_BURSTS = 20000;
+static constexpr uint16_t BURST_KEYS = 32;
+static constexpr size_t BUS_DRAIN_LIMIT = 64;
+
+// Stand-in for the SlaveTask queue: every forwarded event is copied once
+static Event forwarded[BURST_KEYS];
+static size_t forwardedCount;
+static size_t handlerCalls;
+static uint16_t expectedKey;
+static uint32_t outOfOrder;
+
+static void forwardEvent(const Event &event)
+{
+    handlerCalls++;
+    if (event.rawKeyEvt.keyIndex != expectedKey++)
+        outOfOrder++;
+    forwarded[forwardedCount++ % BURST_KEYS] = event;
+}
+
+static void forwardBatch(const Event *events, size_t count)
+{
+    handlerCalls++;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (events[i].rawKeyEvt.keyIndex != expectedKey++)
+            outOfOrder++;
+        forwarded[forwardedCount++ % BURST_KEYS] = events[i];
+    }
+}
+
+struct BusRun
+{
+    double eventsPerSecond;
+    double handlerCallsPerEvent;
+    double popsPerEvent;
+};
+
+static BusRun runBus(size_t batchSize, bool batchHandler)
+{
+    EventRegistry::clearHandlers(EventType::RawKey);
+    if (batchHandler)
+        EventRegistry::registerBatchHandler(EventType::RawKey, forwardBatch);
+    else
+        EventRegistry::registerHandler(EventType::RawKey, forwardEvent);
+
+    EventLanes lanes;
+    Event batch[BURST_KEYS];
+    forwardedCount = 0;
+    handlerCalls = 0;
+    expectedKey = 0;
+    outOfOrder = 0;
+    size_t pops = 0;
+
+    Event key{};
+    key.type = EventType::RawKey;
+    key.cleanup = cleanupRawKeyEvent;
+    uint16_t nextKey = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t burst = 0; burst < BUS_BURSTS; burst++)
+    {
+        for (uint16_t k = 0; k < BURST_KEYS; k++)
+        {
+            key.rawKeyEvt.keyIndex = nextKey++;
+            TEST_ASSERT_TRUE(lanes.push(key));
+        }
+
+        // One wakeup of the bus task
+        lanes.drain(batch, batchSize, BUS_DRAIN_LIMIT, [&pops](const Event *events, size_t count)
+                    {
+                        pops++;
+                        EventRegistry::dispatchBatch(events, count);
+                    });
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double events = static_cast<double>(BUS_BURSTS) * BURST_KEYS;
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    TEST_ASSERT_EQUAL(BUS_BURSTS * BURST_KEYS, forwardedCount);
+    EventRegistry::clearHandlers(EventType::RawKey);
+    return {events / std::chrono::duration<double>(end - start).count(), handlerCalls / events,
+            pops / events};
+}
+
+void test_eventBus_batchSizes()
+{
+    BusRun perEvent = runBus(1, false);
+    char message[160];
+    snprintf(message, sizeof(message),
+             "per-event handler, batch  1: %6.2f M events/s, %5.3f handler calls/event, %5.3f pops/event",
+             perEvent.eventsPerSecond / 1e6, perEvent.handlerCallsPerEvent, perEvent.popsPerEvent);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, perEvent.handlerCallsPerEvent);
+
+    for (size_t batchSize = 1; batchSize <= BURST_KEYS; batchSize *= 2)
+    {
+        BusRun run = runBus(batchSize, true);
+        snprintf(message, sizeof(message),
+                 "batch handler,     batch %2zu: %6.2f M events/s, %5.3f handler calls/event, %5.3f pops/event",
+                 batchSize, run.eventsPerSecond / 1e6, run.handlerCallsPerEvent, run.popsPerEvent);
+        TEST_MESSAGE(message);
+
+        // Each burst goes out in BURST_KEYS / batch size pops and handler calls
+        TEST_ASSERT_EQUAL_FLOAT(1.0f / batchSize, run.handlerCallsPerEvent);
+        TEST_ASSERT_EQUAL_FLOAT(1.0f / batchSize, run.popsPerEvent);
+    }
+}
+
+void run_EventBusBenchmark_tests()
+{
+    RUN_TEST(test_eventBus_batchSizes);
+}
+
+#endif
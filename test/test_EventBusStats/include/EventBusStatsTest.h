@@ -0,0 +1,152 @@
+#ifndef EVENTBUSSTATSTEST_H
+#define EVENTBUSSTATSTEST_H
+
+#include <submodules/EventBusStats.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <thread>
+#endif
+
+// Snapshots are a few kilobytes, kept off the test task stack
+static EventBusSnapshot busSnapshot;
+
+void test_EventBusStats_sumsPushesOfBothCores()
+{
+    static EventBusStats stats;
+    stats.reset();
+
+    stats.recordPush(EventType::RawKey, 0, 1);
+    stats.recordPush(EventType::RawKey, 1, 3);
+    stats.recordPush(EventType::RawKey, 0, 2);
+    stats.recordDrop(EventType::RawKey, 1);
+    stats.recordPush(EventType::HidBitmap, 1, 1);
+    // Cores past MAX_CORES count on the last one instead of out of bounds
+    stats.recordDrop(EventType::HidBitmap, 7);
+    stats.recordPush(EventType::COUNT, 0, 9);
+
+    stats.snapshot(250, busSnapshot);
+    TEST_ASSERT_EQUAL_UINT32(250, busSnapshot.windowUs);
+    const EventBusTypeStats &keys = busSnapshot.types[(size_t)EventType::RawKey];
+    TEST_ASSERT_EQUAL_UINT32(3, keys.pushed);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.dropped);
+    TEST_ASSERT_EQUAL_UINT16(3, keys.highWater);
+    const EventBusTypeStats &bitmaps = busSnapshot.types[(size_t)EventType::HidBitmap];
+    TEST_ASSERT_EQUAL_UINT32(1, bitmaps.pushed);
+    TEST_ASSERT_EQUAL_UINT32(1, bitmaps.dropped);
+    TEST_ASSERT_EQUAL_UINT16(1, bitmaps.highWater);
+    TEST_ASSERT_EQUAL_UINT32(0, busSnapshot.types[(size_t)EventType::ScanStats].pushed);
+}
+
+void test_EventBusStats_recordsLatencyAndHandlerTimes()
+{
+    static EventBusStats stats;
+    stats.reset();
+
+    stats.recordDispatch(EventType::RawKey, 0);
+    stats.recordDispatch(EventType::RawKey, 40);
+    stats.recordDispatch(EventType::RawKey, 900);
+    stats.recordHandler(EventType::RawKey, 0, 12);
+    stats.recordHandler(EventType::RawKey, 0, 30);
+    stats.recordHandler(EventType::RawKey, 9, 5);
+    // Slots past the table are ignored
+    stats.recordHandler(EventType::RawKey, EVENT_BUS_HANDLER_SLOTS, 5);
+
+    stats.snapshot(1000, busSnapshot);
+    const EventBusTypeStats &keys = busSnapshot.types[(size_t)EventType::RawKey];
+    TEST_ASSERT_EQUAL_UINT32(3, keys.dispatched);
+    TEST_ASSERT_EQUAL_UINT32(900, keys.maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(940, keys.totalLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.latencyBuckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.latencyBuckets[ScanTimingStats::bucketFor(40)]);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.latencyBuckets[ScanTimingStats::bucketFor(900)]);
+    TEST_ASSERT_EQUAL_UINT32(1024, ScanTimingStats::percentileUs(keys.latencyBuckets, 99));
+
+    TEST_ASSERT_EQUAL_UINT32(2, keys.handlers[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(30, keys.handlers[0].maxUs);
+    TEST_ASSERT_EQUAL_UINT32(42, keys.handlers[0].totalUs);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.handlers[9].calls);
+    TEST_ASSERT_EQUAL_UINT32(0, keys.handlers[1].calls);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.handlerBuckets[ScanTimingStats::bucketFor(12)]);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.handlerBuckets[ScanTimingStats::bucketFor(30)]);
+    TEST_ASSERT_EQUAL_UINT32(1, keys.handlerBuckets[ScanTimingStats::bucketFor(5)]);
+}
+
+void test_EventBusStats_collectStartsNewWindow()
+{
+    static EventBusStats stats;
+    stats.reset();
+    stats.recordPush(EventType::RawBitmap, 0, 1);
+    stats.recordDispatch(EventType::RawBitmap, 20);
+    stats.recordHandler(EventType::RawBitmap, 8, 3);
+
+    stats.collect(500, busSnapshot);
+    TEST_ASSERT_EQUAL_UINT32(500, busSnapshot.windowUs);
+    TEST_ASSERT_EQUAL_UINT32(1, busSnapshot.types[(size_t)EventType::RawBitmap].pushed);
+    TEST_ASSERT_EQUAL_UINT32(1, busSnapshot.types[(size_t)EventType::RawBitmap].dispatched);
+    TEST_ASSERT_EQUAL_UINT32(1, busSnapshot.types[(size_t)EventType::RawBitmap].handlers[8].calls);
+
+    stats.snapshot(100, busSnapshot);
+    const EventBusTypeStats &bitmaps = busSnapshot.types[(size_t)EventType::RawBitmap];
+    TEST_ASSERT_EQUAL_UINT32(100, busSnapshot.windowUs);
+    TEST_ASSERT_EQUAL_UINT32(0, bitmaps.pushed);
+    TEST_ASSERT_EQUAL_UINT16(0, bitmaps.highWater);
+    TEST_ASSERT_EQUAL_UINT32(0, bitmaps.dispatched);
+    TEST_ASSERT_EQUAL_UINT32(0, bitmaps.maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(0, bitmaps.handlers[8].calls);
+}
+
+void test_EventBusStats_collectLosesNoConcurrentPush()
+{
+#ifdef UNITY_NATIVE
+    // Two pushing cores while the bus task rolls windows, every push lands in
+    // exactly one of them
+    static EventBusStats stats;
+    static constexpr uint32_t PUSHES = 200000;
+    stats.reset();
+    std::atomic<bool> go{false};
+
+    auto pusher = [&](size_t core)
+    {
+        while (!go.load())
+            std::this_thread::yield();
+        for (uint32_t i = 0; i < PUSHES; i++)
+        {
+            stats.recordPush(EventType::RawKey, core, 1);
+            if (i % 4 == 0)
+                stats.recordDrop(EventType::RawKey, core);
+        }
+    };
+    std::thread first(pusher, 0);
+    std::thread second(pusher, 1);
+
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;
+    go.store(true);
+    for (int window = 1; window < 200; window++)
+    {
+        stats.collect(1, busSnapshot);
+        pushed += busSnapshot.types[(size_t)EventType::RawKey].pushed;
+        dropped += busSnapshot.types[(size_t)EventType::RawKey].dropped;
+    }
+    first.join();
+    second.join();
+    stats.collect(1, busSnapshot);
+    pushed += busSnapshot.types[(size_t)EventType::RawKey].pushed;
+    dropped += busSnapshot.types[(size_t)EventType::RawKey].dropped;
+
+    TEST_ASSERT_EQUAL_UINT64(2 * PUSHES, pushed);
+    TEST_ASSERT_EQUAL_UINT64(2 * PUSHES / 4, dropped);
+#endif
+}
+
+void run_EventBusStats_tests()
+{
+    RUN_TEST(test_EventBusStats_sumsPushesOfBothCores);
+    RUN_TEST(test_EventBusStats_recordsLatencyAndHandlerTimes);
+    RUN_TEST(test_EventBusStats_collectStartsNewWindow);
+    RUN_TEST(test_EventBusStats_collectLosesNoConcurrentPush);
+}
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef EVENTCHANNELTEST_H
+#define EVENTCHANNELTEST_H
+
+#include <submodules/EventChannel.h>
+#include <submodules/EventLanes.h>
+#include <submodules/PayloadPool.h>
+#include <submodules/ScanTimingStats.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+// Stands in for EventBusTask: lanes filled by the push callback, drained
+// and delivered like the bus task does
+static EventLanes *busLanes = nullptr;
+
+static bool pushToBus(const Event &event)
+{
+    return busLanes != nullptr && busLanes->push(event);
+}
+
+static size_t drainBus()
+{
+    Event batch[8];
+    return busLanes->drain(batch, 8, 64, [](Event *events, size_t count)
+                           { EventRegistry::deliverBatch(events, count); });
+}
+
+static void clearChannels()
+{
+    for (size_t type = 0; type < static_cast<size_t>(EventType::COUNT); type++)
+        EventRegistry::clearHandlers(static_cast<EventType>(type));
+}
+
+// Bitmap of size bytes, too large for the event from 33 bytes on
+static RawBitmapEvent makeBitmap(uint16_t size, uint8_t fill)
+{
+    uint8_t bitmap[128];
+    memset(bitmap, fill, sizeof(bitmap));
+    RawBitmapEvent event{};
+    event.assign(EventType::RawBitmap, bitmap, size);
+    return event;
+}
+
+static const uint8_t *seenByFirst = nullptr;
+static const uint8_t *seenBySecond = nullptr;
+static EventRef kept;
+
+static void firstReader(const RawBitmapEvent &bitmap) { seenByFirst = bitmap.data(); }
+static void secondReader(const RawBitmapEvent &bitmap) { seenBySecond = bitmap.data(); }
+static void keeper(const RawBitmapEvent &bitmap) { kept = RawBitmapChannel::share(bitmap); }
+
+void test_EventChannel_subscribersShareOneBuffer()
+{
+    PayloadPool::Stats before = PayloadPool::forType(EventType::RawBitmap).getStats();
+    EventLanes lanes;
+    busLanes = &lanes;
+    EventRegistry::registerPushCallback(pushToBus);
+    clearChannels();
+    TEST_ASSERT_TRUE(RawBitmapChannel::subscribe<firstReader>());
+    TEST_ASSERT_TRUE(RawBitmapChannel::subscribe<keeper>());
+    TEST_ASSERT_TRUE(RawBitmapChannel::subscribe<secondReader>());
+
+    // A pool block and a heap block, oversized for the pool
+    const uint16_t sizes[] = {50, 100};
+    for (uint16_t size : sizes)
+    {
+        RawBitmapEvent published = makeBitmap(size, 0xA5);
+        const uint8_t *buffer = published.data();
+        TEST_ASSERT_TRUE(RawBitmapChannel::publish(published));
+        TEST_ASSERT_EQUAL(1, drainBus());
+
+        // Every subscriber read the published buffer, the kept one outlives
+        // the dispatch
+        TEST_ASSERT_EQUAL_PTR(buffer, seenByFirst);
+        TEST_ASSERT_EQUAL_PTR(buffer, seenBySecond);
+        TEST_ASSERT_TRUE(static_cast<bool>(kept));
+        TEST_ASSERT_EQUAL_PTR(buffer, kept->rawBitmapEvt.data());
+        TEST_ASSERT_EQUAL_UINT8(0xA5, kept->rawBitmapEvt.data()[size - 1]);
+        PayloadPool::Stats during = PayloadPool::forType(EventType::RawBitmap).getStats();
+        TEST_ASSERT_EQUAL_UINT16(before.inUse + before.heapInUse + 1, during.inUse + during.heapInUse);
+
+        kept.reset();
+        PayloadPool::Stats after = PayloadPool::forType(EventType::RawBitmap).getStats();
+        TEST_ASSERT_EQUAL_UINT16(before.inUse, after.inUse);
+        TEST_ASSERT_EQUAL_UINT16(before.heapInUse, after.heapInUse);
+    }
+
+    clearChannels();
+    EventRegistry::clearPushCallback();
+    busLanes = nullptr;
+}
+
+void test_EventChannel_refusedPublishReleases()
+{
+    PayloadPool &statsPool = PayloadPool::forType(EventType::ScanStats);
+    PayloadPool::Stats before = statsPool.getStats();
+    EventRegistry::clearPushCallback();
+
+    ScanStatsEvent event{static_cast<ScanTimingSnapshot *>(statsPool.allocate(sizeof(ScanTimingSnapshot)))};
+    TEST_ASSERT_NOT_NULL(event.stats);
+    TEST_ASSERT_FALSE(ScanStatsChannel::publish(event));
+    TEST_ASSERT_FALSE(RawBitmapChannel::publish(makeBitmap(100, 1)));
+
+    PayloadPool::Stats after = statsPool.getStats();
+    TEST_ASSERT_EQUAL_UINT16(before.inUse, after.inUse);
+    TEST_ASSERT_EQUAL_UINT16(0, PayloadPool::forType(EventType::RawBitmap).getStats().heapInUse);
+}
+
+void test_EventChannel_eventRefReleasesExactlyOnce()
+{
+    PayloadPool &statsPool = PayloadPool::forType(EventType::ScanStats);
+    uint16_t inUse = statsPool.getStats().inUse;
+
+    ScanStatsEvent event{static_cast<ScanTimingSnapshot *>(statsPool.allocate(sizeof(ScanTimingSnapshot)))};
+    EventRef owner = EventRef::adopt(ScanStatsChannel::wrap(event));
+    EventRef shared = EventRef::share(owner.get());
+
+    // Moving hands the reference on, the source releases nothing
+    EventRef moved(std::move(owner));
+    TEST_ASSERT_FALSE(static_cast<bool>(owner));
+    owner.reset();
+    moved.reset();
+    moved.reset();
+    TEST_ASSERT_EQUAL_UINT16(inUse + 1, statsPool.getStats().inUse);
+
+    // A released event carries the last reference, e.g. through a queue
+    Event queued = shared.release();
+    shared.reset();
+    TEST_ASSERT_EQUAL_UINT16(inUse + 1, statsPool.getStats().inUse);
+    EventRef received = EventRef::adopt(queued);
+    received = EventRef();
+    TEST_ASSERT_EQUAL_UINT16(inUse, statsPool.getStats().inUse);
+}
+
+#ifdef UNITY_NATIVE
+// Shared events handed from the bus task to a transport task
+static std::mutex handoffMutex;
+static std::vector<EventRef> handoff;
+
+static void handOff(const RawBitmapEvent &bitmap)
+{
+    std::lock_guard<std::mutex> lock(handoffMutex);
+    handoff.push_back(RawBitmapChannel::share(bitmap));
+}
+
+static std::atomic<uint32_t> readBytes{0};
+
+static void readBitmap(const RawBitmapEvent &bitmap)
+{
+    readBytes += bitmap.data()[bitmap.bitmapSize - 1];
+}
+#endif
+
+void test_EventChannel_concurrentHoldersBalanceAllocations()
+{
+#ifdef UNITY_NATIVE
+    static constexpr uint32_t EVENTS = 20000;
+    PayloadPool &bitmaps = PayloadPool::forType(EventType::RawBitmap);
+    PayloadPool::Stats before = bitmaps.getStats();
+
+    EventLanes lanes;
+    // Deep lane, no coalescing, so most events are dispatched
+    lanes.configure(EventType::RawBitmap, {0, 16, false, EventLanes::DropPolicy::Oldest});
+    busLanes = &lanes;
+    EventRegistry::registerPushCallback(pushToBus);
+    clearChannels();
+    RawBitmapChannel::subscribe<handOff>();
+    RawBitmapChannel::subscribe<readBitmap>();
+
+    std::atomic<bool> published{false};
+    std::atomic<bool> drained{false};
+    uint32_t refused = 0;
+    std::thread scanner([&]
+                        {
+                            // Pool blocks, inline bitmaps and heap blocks
+                            const uint16_t sizes[] = {50, 16, 100};
+                            for (uint32_t i = 0; i < EVENTS; i++)
+                            {
+                                RawBitmapEvent event = makeBitmap(sizes[i % 3], 1);
+                                if (event.bitmapSize == 0 || !RawBitmapChannel::publish(event))
+                                    refused++;
+                            }
+                            published = true;
+                        });
+    std::thread bus([&]
+                    {
+                        while (!published.load())
+                            drainBus();
+                        drainBus();
+                        drained = true;
+                    });
+    std::thread transport([&]
+                          {
+                              for (;;)
+                              {
+                                  bool done = drained.load();
+                                  std::vector<EventRef> sent;
+                                  {
+                                      std::lock_guard<std::mutex> lock(handoffMutex);
+                                      sent.swap(handoff);
+                                  }
+                                  if (sent.empty() && done)
+                                      break;
+                              }
+                          });
+    scanner.join();
+    bus.join();
+    transport.join();
+
+    PayloadPool::Stats after = bitmaps.getStats();
+    TEST_ASSERT_TRUE(readBytes.load() > 0);
+    TEST_ASSERT_TRUE(refused < EVENTS);
+    TEST_ASSERT_EQUAL_UINT16(before.inUse, after.inUse);
+    TEST_ASSERT_EQUAL_UINT16(before.heapInUse, after.heapInUse);
+    TEST_ASSERT_TRUE(after.fallbacks > before.fallbacks);
+
+    clearChannels();
+    EventRegistry::clearPushCallback();
+    busLanes = nullptr;
+#endif
+}
+
+void run_EventChannel_tests()
+{
+    RUN_TEST(test_EventChannel_subscribersShareOneBuffer);
+    RUN_TEST(test_EventChannel_refusedPublishReleases);
+    RUN_TEST(test_EventChannel_eventRefReleasesExactlyOnce);
+    RUN_TEST(test_EventChannel_concurrentHoldersBalanceAllocations);
+}
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef EVENTLANESTEST_H
+#define EVENTLANESTEST_H
+
+#include <atomic>
+#include <submodules/EventLanes.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <thread>
+#include <vector>
+#endif
+
+using LaneConfig = EventLanes::LaneConfig;
+using DropPolicy = EventLanes::DropPolicy;
+
+// Events cleaned up by the lanes or by the test
+static std::atomic<uint32_t> cleanedUp{0};
+
+static void countCleanup(Event *event)
+{
+    cleanedUp++;
+}
+
+static Event keyEvent(uint16_t keyIndex)
+{
+    Event event{};
+    event.type = EventType::RawKey;
+    event.rawKeyEvt.keyIndex = keyIndex;
+    event.rawKeyEvt.state = true;
+    event.cleanup = cleanupRawKeyEvent;
+    return event;
+}
+
+static Event bitmapEvent(uint8_t firstByte)
+{
+    Event event{};
+    event.type = EventType::RawBitmap;
+    uint8_t bitmap[8] = {firstByte};
+    event.rawBitmapEvt.assign(EventType::RawBitmap, bitmap, sizeof(bitmap));
+    event.cleanup = countCleanup;
+    return event;
+}
+
+static Event statsEvent()
+{
+    Event event{};
+    event.type = EventType::ScanStats;
+    event.cleanup = countCleanup;
+    return event;
+}
+
+void test_EventLanes_keyEventsDrainFirst()
+{
+    EventLanes lanes;
+    TEST_ASSERT_TRUE(lanes.push(statsEvent()));
+    TEST_ASSERT_TRUE(lanes.push(bitmapEvent(1)));
+    TEST_ASSERT_TRUE(lanes.push(keyEvent(5)));
+    TEST_ASSERT_TRUE(lanes.push(keyEvent(6)));
+
+    Event event;
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL(EventType::RawKey, event.type);
+    TEST_ASSERT_EQUAL_UINT16(5, event.rawKeyEvt.keyIndex);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_UINT16(6, event.rawKeyEvt.keyIndex);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL(EventType::RawBitmap, event.type);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL(EventType::ScanStats, event.type);
+    TEST_ASSERT_FALSE(lanes.pop(event));
+
+    // A lane moved behind the others drains last
+    LaneConfig config = lanes.getConfig(EventType::RawKey);
+    config.priority = 10;
+    lanes.configure(EventType::RawKey, config);
+    lanes.push(keyEvent(7));
+    lanes.push(statsEvent());
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL(EventType::ScanStats, event.type);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL(EventType::RawKey, event.type);
+}
+
+void test_EventLanes_snapshotsCoalesce()
+{
+    EventLanes lanes;
+    cleanedUp = 0;
+    for (uint8_t i = 1; i <= 5; i++)
+        TEST_ASSERT_TRUE(lanes.push(bitmapEvent(i)));
+
+    // The four replaced snapshots were cleaned up, the newest is pending
+    TEST_ASSERT_EQUAL_UINT32(4, cleanedUp.load());
+    EventLanes::LaneStats stats = lanes.getStats(EventType::RawBitmap);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.depth);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.pushed);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+
+    Event event;
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_UINT8(5, event.rawBitmapEvt.data()[0]);
+    TEST_ASSERT_FALSE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_UINT16(0, lanes.getStats(EventType::RawBitmap).depth);
+}
+
+void test_EventLanes_dropPolicies()
+{
+    EventLanes lanes;
+    cleanedUp = 0;
+
+    // Refusing: the pusher keeps the event and cleans it up
+    lanes.configure(EventType::RawKey, {0, 2, false, DropPolicy::Newest});
+    TEST_ASSERT_TRUE(lanes.push(keyEvent(1)));
+    TEST_ASSERT_TRUE(lanes.push(keyEvent(2)));
+    EventLanes::PushResult refused{};
+    TEST_ASSERT_FALSE(lanes.push(keyEvent(3), &refused));
+    TEST_ASSERT_EQUAL_UINT16(2, refused.pending);
+    TEST_ASSERT_FALSE(refused.evicted);
+
+    // Evicting: the oldest pending event goes
+    lanes.configure(EventType::ScanStats, {4, 2, false, DropPolicy::Oldest});
+    Event stats[3] = {statsEvent(), statsEvent(), statsEvent()};
+    EventLanes::PushResult result{};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        stats[i].scanStatsEvt.stats = reinterpret_cast<ScanTimingSnapshot *>(uintptr_t{i + 1});
+        TEST_ASSERT_TRUE(lanes.push(stats[i], &result));
+        TEST_ASSERT_EQUAL_UINT16(i < 2 ? i + 1 : 2, result.pending);
+        TEST_ASSERT_EQUAL(i == 2, result.evicted);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, cleanedUp.load());
+
+    TEST_ASSERT_EQUAL_UINT32(1, lanes.getStats(EventType::RawKey).dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, lanes.getStats(EventType::ScanStats).dropped);
+    TEST_ASSERT_EQUAL_UINT16(2, lanes.getStats(EventType::ScanStats).highWater);
+
+    Event event;
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_UINT16(1, event.rawKeyEvt.keyIndex);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_UINT16(2, event.rawKeyEvt.keyIndex);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_PTR(stats[1].scanStatsEvt.stats, event.scanStatsEvt.stats);
+    TEST_ASSERT_TRUE(lanes.pop(event));
+    TEST_ASSERT_EQUAL_PTR(stats[2].scanStatsEvt.stats, event.scanStatsEvt.stats);
+}
+
+void test_EventLanes_snapshotBurstKeepsKeyEvents()
+{
+    // A single 32 deep FIFO fills up with snapshots between two bus rounds
+    // and refuses key events, the lanes keep every key transition
+    EventLanes lanes;
+    cleanedUp = 0;
+    uint32_t keysPushed = 0;
+    uint32_t keysDelivered = 0;
+    for (uint16_t round = 0; round < 50; round++)
+    {
+        for (uint8_t i = 0; i < 40; i++)
+        {
+            lanes.push(bitmapEvent(i));
+            if (i % 8 == 0)
+                keysPushed += lanes.push(keyEvent(keysPushed)) ? 1 : 0;
+        }
+
+        Event event;
+        while (lanes.pop(event))
+        {
+            if (event.type == EventType::RawKey)
+                TEST_ASSERT_EQUAL_UINT16(keysDelivered++, event.rawKeyEvt.keyIndex);
+            event.cleanup(&event);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(250, keysPushed);
+    TEST_ASSERT_EQUAL_UINT32(250, keysDelivered);
+    TEST_ASSERT_EQUAL_UINT32(0, lanes.getStats(EventType::RawKey).dropped);
+    TEST_ASSERT_EQUAL_UINT32(50 * 39, lanes.getStats(EventType::RawBitmap).coalesced);
+    // Every snapshot was cleaned up once, coalesced or delivered
+    TEST_ASSERT_EQUAL_UINT32(50 * 40, cleanedUp.load());
+}
+
+void test_EventLanes_configureClampsAndClears()
+{
+    EventLanes lanes;
+    cleanedUp = 0;
+    lanes.configure(EventType::ScanStats, {4, 200, false, DropPolicy::Oldest});
+    TEST_ASSERT_EQUAL_UINT8(EventLanes::MAX_LANE_DEPTH, lanes.getConfig(EventType::ScanStats).depth);
+    lanes.configure(EventType::ConfigUpdate, {2, 0, false, DropPolicy::Newest});
+    TEST_ASSERT_EQUAL_UINT8(1, lanes.getConfig(EventType::ConfigUpdate).depth);
+    // Coalescing lanes hold one event
+    lanes.configure(EventType::RawBitmap, {3, 16, true, DropPolicy::Newest});
+    TEST_ASSERT_EQUAL_UINT8(1, lanes.getConfig(EventType::RawBitmap).depth);
+
+    lanes.push(statsEvent());
+    lanes.push(statsEvent());
+    lanes.push(bitmapEvent(1));
+    lanes.clear();
+    TEST_ASSERT_EQUAL_UINT32(3, cleanedUp.load());
+    Event event;
+    TEST_ASSERT_FALSE(lanes.pop(event));
+}
+
+void test_EventLanes_batchesHoldOneType()
+{
+    EventLanes lanes;
+    for (uint16_t k = 0; k < 10; k++)
+        lanes.push(keyEvent(k));
+    lanes.push(bitmapEvent(1));
+
+    Event batch[4];
+    TEST_ASSERT_EQUAL(4, lanes.popBatch(batch, 4));
+    TEST_ASSERT_EQUAL_UINT16(3, batch[3].rawKeyEvt.keyIndex);
+
+    // Drain stops at the limit, a batch never mixes types
+    static uint16_t nextKey;
+    static size_t batches;
+    nextKey = 4;
+    batches = 0;
+    size_t drained = lanes.drain(batch, 4, 5, [](const Event *events, size_t count)
+                                 {
+                                     batches++;
+                                     for (size_t i = 0; i < count; i++)
+                                         TEST_ASSERT_EQUAL_UINT16(nextKey++, events[i].rawKeyEvt.keyIndex);
+                                 });
+    TEST_ASSERT_EQUAL(5, drained);
+    TEST_ASSERT_EQUAL(2, batches);
+
+    drained = lanes.drain(batch, 4, 64, [](const Event *events, size_t count)
+                          {
+                              batches++;
+                              if (events[0].type == EventType::RawKey)
+                                  TEST_ASSERT_EQUAL(1, count);
+                              else
+                                  TEST_ASSERT_EQUAL(EventType::RawBitmap, events[count - 1].type);
+                          });
+    TEST_ASSERT_EQUAL(2, drained);
+    TEST_ASSERT_EQUAL(4, batches);
+    TEST_ASSERT_EQUAL(0, lanes.popBatch(batch, 4));
+}
+
+void test_EventLanes_concurrentProducers()
+{
+#ifdef UNITY_NATIVE
+    // Producers push key events and snapshots while the bus drains, key
+    // events of every producer arrive complete and in order
+    static constexpr int PRODUCERS = 3;
+    static constexpr uint16_t KEYS = 20000;
+
+    EventLanes lanes;
+    lanes.configure(EventType::RawKey, {0, EventLanes::MAX_LANE_DEPTH, false, DropPolicy::Newest});
+    cleanedUp = 0;
+    std::atomic<int> running{PRODUCERS};
+    std::atomic<uint32_t> bitmapsPushed{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&, p]()
+                               {
+                                   for (uint16_t k = 0; k < KEYS; k++)
+                                   {
+                                       Event key = keyEvent(k);
+                                       key.rawKeyEvt.scanSequence = p;
+                                       while (!lanes.push(key))
+                                           std::this_thread::yield();
+                                       if (k % 4 == 0 && lanes.push(bitmapEvent(p)))
+                                           bitmapsPushed++;
+                                   }
+                                   running--;
+                               });
+    }
+
+    uint16_t nextKey[PRODUCERS] = {};
+    uint32_t outOfOrder = 0;
+    Event event;
+    for (;;)
+    {
+        bool producersDone = running.load() == 0;
+        if (!lanes.pop(event))
+        {
+            if (producersDone)
+                break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (event.type == EventType::RawKey)
+        {
+            uint32_t producer = event.rawKeyEvt.scanSequence;
+            if (event.rawKeyEvt.keyIndex != nextKey[producer]++)
+                outOfOrder++;
+        }
+        event.cleanup(&event);
+    }
+    for (std::thread &producer : producers)
+        producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    for (int p = 0; p < PRODUCERS; p++)
+        TEST_ASSERT_EQUAL_UINT16(KEYS, nextKey[p]);
+    TEST_ASSERT_EQUAL_UINT32(bitmapsPushed.load(), cleanedUp.load());
+#endif
+}
+
+void run_EventLanes_tests()
+{
+    RUN_TEST(test_EventLanes_keyEventsDrainFirst);
+    RUN_TEST(test_EventLanes_snapshotsCoalesce);
+    RUN_TEST(test_EventLanes_dropPolicies);
+    RUN_TEST(test_EventLanes_snapshotBurstKeepsKeyEvents);
+    RUN_TEST(test_EventLanes_configureClampsAndClears);
+    RUN_TEST(test_EventLanes_batchesHoldOneType);
+    RUN_TEST(test_EventLanes_concurrentProducers);
+}
+
+#endif
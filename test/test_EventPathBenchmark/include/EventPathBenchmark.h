@@ -0,0 +1,245 @@
+#ifndef EVENTPATHBENCHMARK_H
+#define EVENTPATHBENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <shared/EventTypes.h>
+#include <submodules/PayloadPool.h>
+#include <submodules/SeqLockBitmap.h>
+#include <unity.h>
+#include <vector>
+
+// Heap calls of the test binary: operator new and delete go through here,
+// the reference path below counts its malloc and free itself
+static std::atomic<size_t> heapCalls{0};
+
+void *operator new(size_t size)
+{
+    heapCalls++;
+    void *memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    heapCalls++;
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    heapCalls++;
+    free(memory);
+}
+
+static constexpr uint32_t PATH_EVENTS = 200000;
+static constexpr size_t QUEUE_DEPTH = 32;
+
+// Copies items in and out by value like a FreeRTOS queue, which is what
+// makes the size of an event matter
+template <typename Item>
+class CopyQueue
+{
+public:
+    bool send(const Item &item)
+    {
+        if (count == QUEUE_DEPTH)
+            return false;
+        memcpy(slots[(head + count) % QUEUE_DEPTH], &item, sizeof(Item));
+        count++;
+        return true;
+    }
+
+    bool receive(Item &item)
+    {
+        if (count == 0)
+            return false;
+        memcpy(&item, slots[head], sizeof(Item));
+        head = (head + 1) % QUEUE_DEPTH;
+        count--;
+        return true;
+    }
+
+private:
+    alignas(8) uint8_t slots[QUEUE_DEPTH][sizeof(Item)];
+    size_t head = 0;
+    size_t count = 0;
+};
+
+// Bitmap event as it was before bitmaps travelled inline, the payload always
+// lives on the heap
+struct PointerBitmapEvent
+{
+    EventType type;
+    void (*cleanup)(PointerBitmapEvent *);
+    uint16_t bitmapSize;
+    uint8_t *bitMapData;
+};
+
+static void cleanupPointerBitmapEvent(PointerBitmapEvent *event)
+{
+    heapCalls++;
+    free(event->bitMapData);
+}
+
+struct PathRun
+{
+    double nsPerEvent;
+    size_t heapCalls;
+    uint32_t delivered;
+    uint32_t checksum;
+};
+
+// Slave side: slice the bitmap into the transport buffer like
+// TransportProtocol::sendBitmapEvent and fold it into a checksum
+static uint32_t transmit(const uint8_t *bitmap, uint16_t size, uint32_t checksum)
+{
+    uint8_t buffer[4 + 250];
+    for (uint16_t offset = 0; offset < size; offset += 250)
+    {
+        uint16_t slice = std::min<uint16_t>(250, size - offset);
+        memcpy(buffer, &size, 2);
+        memcpy(buffer + 2, &offset, 2);
+        memcpy(buffer + 4, bitmap + offset, slice);
+        for (uint16_t i = 0; i < slice; i++)
+            checksum = checksum * 31 + buffer[4 + i];
+    }
+    return checksum;
+}
+
+// Scan task publishes a new bitmap and snapshots it, the bus task forwards
+// the event to the slave queue, the slave transmits and cleans up
+template <typename EventT, typename Make, typename Data>
+static PathRun runPath(uint16_t bitmapSize, Make make, Data data)
+{
+    SeqLockBitmap published(bitmapSize);
+    std::vector<uint32_t> words((bitmapSize + 3) / 4);
+    std::vector<uint8_t> snapshot(bitmapSize);
+    CopyQueue<EventT> busQueue;
+    CopyQueue<EventT> slaveQueue;
+    PathRun run{};
+
+    size_t heapBefore = heapCalls.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < PATH_EVENTS; i++)
+    {
+        // Scan
+        words[i % words.size()] ^= 1u << (i % 32);
+        published.publish(words.data());
+        published.read(snapshot.data(), snapshot.size());
+        EventT event{};
+        if (!make(event, snapshot.data(), bitmapSize) || !busQueue.send(event))
+            continue;
+
+        // Bus
+        EventT busEvent;
+        busQueue.receive(busEvent);
+        slaveQueue.send(busEvent);
+
+        // Slave
+        EventT slaveEvent;
+        slaveQueue.receive(slaveEvent);
+        run.checksum = transmit(data(slaveEvent), bitmapSize, run.checksum);
+        run.delivered++;
+        slaveEvent.cleanup(&slaveEvent);
+    }
+    auto end = std::chrono::steady_clock::now();
+    run.heapCalls = heapCalls.load() - heapBefore;
+    run.nsPerEvent = std::chrono::duration<double, std::nano>(end - start).count() / PATH_EVENTS;
+    return run;
+}
+
+static PathRun runPointerPath(uint16_t bitmapSize)
+{
+    return runPath<PointerBitmapEvent>(
+        bitmapSize,
+        [](PointerBitmapEvent &event, const uint8_t *bitmap, uint16_t size)
+        {
+            heapCalls++;
+            event.type = EventType::RawBitmap;
+            event.cleanup = cleanupPointerBitmapEvent;
+            event.bitmapSize = size;
+            event.bitMapData = static_cast<uint8_t *>(malloc(size));
+            memcpy(event.bitMapData, bitmap, size);
+            return true;
+        },
+        [](const PointerBitmapEvent &event) { return event.bitMapData; });
+}
+
+static PathRun runInlinePath(uint16_t bitmapSize)
+{
+    return runPath<Event>(
+        bitmapSize,
+        [](Event &event, const uint8_t *bitmap, uint16_t size)
+        {
+            event.type = EventType::RawBitmap;
+            event.cleanup = cleanupRawBitmapEvent;
+            return event.rawBitmapEvt.assign(EventType::RawBitmap, bitmap, size);
+        },
+        [](const Event &event) { return event.rawBitmapEvt.data(); });
+}
+
+static void reportPath(const char *name, uint16_t bitmapSize, size_t itemSize, const PathRun &run)
+{
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%2u byte bitmap, %-7s %3zu byte queue items, %7.1f ns/event, %4.2f heap calls/event",
+             bitmapSize, name, itemSize, run.nsPerEvent,
+             static_cast<double>(run.heapCalls) / PATH_EVENTS);
+    TEST_MESSAGE(message);
+}
+
+void test_eventPath_inlineBitmapsSkipHeap()
+{
+    const uint16_t sizes[] = {8, 16, INLINE_BITMAP_SIZE};
+    for (uint16_t size : sizes)
+    {
+        PathRun pointer = runPointerPath(size);
+        PathRun inlined = runInlinePath(size);
+        reportPath("pointer", size, sizeof(PointerBitmapEvent), pointer);
+        reportPath("inline", size, sizeof(Event), inlined);
+
+        // Same bitmaps delivered, one malloc and one free per event before
+        TEST_ASSERT_EQUAL_UINT32(PATH_EVENTS, pointer.delivered);
+        TEST_ASSERT_EQUAL_UINT32(PATH_EVENTS, inlined.delivered);
+        TEST_ASSERT_EQUAL_UINT32(pointer.checksum, inlined.checksum);
+        TEST_ASSERT_EQUAL(2 * PATH_EVENTS, pointer.heapCalls);
+        TEST_ASSERT_EQUAL(0, inlined.heapCalls);
+    }
+}
+
+void test_eventPath_oversizedBitmapsSpillToPool()
+{
+    // 400 keys, too large to travel inline
+    static constexpr uint16_t SIZE = 50;
+    PayloadPool &pool = PayloadPool::forType(EventType::RawBitmap);
+    PayloadPool::Stats before = pool.getStats();
+
+    PathRun pointer = runPointerPath(SIZE);
+    PathRun spilled = runInlinePath(SIZE);
+    reportPath("pointer", SIZE, sizeof(PointerBitmapEvent), pointer);
+    reportPath("spilled", SIZE, sizeof(Event), spilled);
+
+    PayloadPool::Stats after = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT32(PATH_EVENTS, spilled.delivered);
+    TEST_ASSERT_EQUAL_UINT32(pointer.checksum, spilled.checksum);
+    TEST_ASSERT_EQUAL(0, spilled.heapCalls);
+    TEST_ASSERT_EQUAL_UINT32(before.fallbacks, after.fallbacks);
+    TEST_ASSERT_EQUAL_UINT16(before.inUse, after.inUse);
+    TEST_ASSERT_TRUE(after.highWater >= 1);
+}
+
+void run_EventPathBenchmark_tests()
+{
+    RUN_TEST(test_eventPath_inlineBitmapsSkipHeap);
+    RUN_TEST(test_eventPath_oversizedBitmapsSpillToPool);
+}
+
+#endif
@@ -4,6 +4,35 @@
 #include <unity.h>
 #include <submodules/EventRegistry.h>
 #include <shared/EventTypes.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#ifdef UNITY_NATIVE
+// Allocation counting hook: every operator new of the test binary goes
+// through here
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    void *memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+#endif
 
 // Test callbacks
 static int callback1_count = 0;
@@ -98,6 +127,241 @@ void test_multiple_handlers_execution(void) {
   TEST_ASSERT_EQUAL(1, callback2_count);
 }
 
+void test_dispatch_calls_handlers_in_order(void) {
+  static int order[2];
+  static int calls;
+  calls = 0;
+  EventRegistry::registerHandler(EventType::RawKey, [](const Event &) { order[calls++] = 1; });
+  EventRegistry::registerHandler(EventType::RawKey, [](const Event &) { order[calls++] = 2; });
+  EventRegistry::registerHandler(EventType::RawBitmap, test_callback_2);
+
+  Event test_event{};
+  test_event.type = EventType::RawKey;
+  TEST_ASSERT_EQUAL(2, EventRegistry::dispatch(test_event));
+  TEST_ASSERT_EQUAL(1, order[0]);
+  TEST_ASSERT_EQUAL(2, order[1]);
+  TEST_ASSERT_EQUAL(0, callback2_count);
+
+  test_event.type = EventType::HidBitmap;
+  TEST_ASSERT_EQUAL(0, EventRegistry::dispatch(test_event));
+}
+
+void test_register_refused_when_full(void) {
+  for (size_t i = 0; i < EventRegistry::MAX_HANDLERS; i++)
+    TEST_ASSERT_TRUE(EventRegistry::registerHandler(EventType::RawKey, test_callback_1));
+  TEST_ASSERT_FALSE(EventRegistry::registerHandler(EventType::RawKey, test_callback_2));
+
+  Event test_event{};
+  test_event.type = EventType::RawKey;
+  TEST_ASSERT_EQUAL(EventRegistry::MAX_HANDLERS, EventRegistry::dispatch(test_event));
+  TEST_ASSERT_EQUAL(EventRegistry::MAX_HANDLERS, callback1_count);
+  TEST_ASSERT_EQUAL(0, callback2_count);
+}
+
+void test_dispatch_batch_reaches_both_handler_kinds(void) {
+  static size_t batchCalls;
+  static size_t batchEvents;
+  batchCalls = 0;
+  batchEvents = 0;
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_1);
+  TEST_ASSERT_TRUE(EventRegistry::registerBatchHandler(EventType::RawKey, [](const Event *events, size_t count)
+                                                       {
+                                                         batchCalls++;
+                                                         batchEvents += count;
+                                                         TEST_ASSERT_EQUAL(EventType::RawKey, events[count - 1].type);
+                                                       }));
+
+  Event events[5]{};
+  for (Event &event : events)
+    event.type = EventType::RawKey;
+  TEST_ASSERT_EQUAL(2, EventRegistry::dispatchBatch(events, 5));
+  TEST_ASSERT_EQUAL(5, callback1_count);
+  TEST_ASSERT_EQUAL(1, batchCalls);
+  TEST_ASSERT_EQUAL(5, batchEvents);
+
+  // A single event is a batch of one
+  EventRegistry::dispatch(events[0]);
+  TEST_ASSERT_EQUAL(2, batchCalls);
+  TEST_ASSERT_EQUAL(0, EventRegistry::dispatchBatch(events, 0));
+
+  // getHandler only lists the per-event handlers, clearing drops both kinds
+  TEST_ASSERT_EQUAL(1, EventRegistry::getHandler(EventType::RawKey).size());
+  EventRegistry::clearHandlers(EventType::RawKey);
+  TEST_ASSERT_EQUAL(0, EventRegistry::dispatchBatch(events, 5));
+  TEST_ASSERT_EQUAL(2, batchCalls);
+}
+
+void test_change_callback_follows_registrations(void) {
+  static size_t changes;
+  static EventType changedType;
+  changes = 0;
+  EventRegistry::registerChangeCallback([](EventType type)
+                                        {
+                                          changes++;
+                                          changedType = type;
+                                        });
+
+  EventRegistry::BatchCallback batch = [](const Event *, size_t) {};
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_1);
+  EventRegistry::registerBatchHandler(EventType::RawBitmap, batch);
+  TEST_ASSERT_EQUAL(2, changes);
+  TEST_ASSERT_EQUAL(EventType::RawBitmap, changedType);
+  TEST_ASSERT_EQUAL(1, EventRegistry::getBatchHandler(EventType::RawBitmap).size());
+  TEST_ASSERT_TRUE(EventRegistry::getBatchHandler(EventType::RawBitmap)[0] == batch);
+  TEST_ASSERT_EQUAL(0, EventRegistry::getBatchHandler(EventType::RawKey).size());
+
+  EventRegistry::clearHandlers(EventType::RawBitmap);
+  TEST_ASSERT_EQUAL(3, changes);
+
+  // Cleared, later registrations go unnoticed
+  EventRegistry::registerChangeCallback(nullptr);
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_2);
+  TEST_ASSERT_EQUAL(3, changes);
+}
+
+void test_offloaded_handler_goes_to_offload_callback(void) {
+  static size_t inline_calls;
+  static size_t offloaded_events;
+  static uint32_t offloaded_mask;
+  static bool accept;
+  inline_calls = 0;
+  offloaded_events = 0;
+  EventRegistry::BatchCallback heavy = [](const Event *, size_t) { inline_calls++; };
+  TEST_ASSERT_TRUE(EventRegistry::registerOffloadHandler(EventType::RawKey, heavy, 1u << 0));
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_1);
+
+  // Without an offload callback it runs like any batch handler
+  Event events[3]{};
+  for (Event &event : events)
+    event.type = EventType::RawKey;
+  TEST_ASSERT_EQUAL(2, EventRegistry::dispatchBatch(events, 3));
+  TEST_ASSERT_EQUAL(1, inline_calls);
+  TEST_ASSERT_EQUAL(3, callback1_count);
+
+  EventRegistry::registerOffloadCallback([](EventType type, EventRegistry::BatchCallback handler, uint32_t coreMask,
+                                            const Event *events, size_t count)
+                                         {
+                                           offloaded_events += count;
+                                           offloaded_mask = coreMask;
+                                           return accept;
+                                         });
+  accept = true;
+  EventRegistry::dispatchBatch(events, 3);
+  TEST_ASSERT_EQUAL(1, inline_calls);
+  TEST_ASSERT_EQUAL(3, offloaded_events);
+  TEST_ASSERT_EQUAL_UINT32(1u << 0, offloaded_mask);
+  TEST_ASSERT_EQUAL(6, callback1_count);
+
+  // Refused, the dispatching task runs it after all
+  accept = false;
+  EventRegistry::dispatchBatch(events, 3);
+  TEST_ASSERT_EQUAL(2, inline_calls);
+  TEST_ASSERT_EQUAL(1, EventRegistry::getOffloadHandler(EventType::RawKey).size());
+  TEST_ASSERT_EQUAL(0, EventRegistry::getBatchHandler(EventType::RawKey).size());
+  EventRegistry::registerOffloadCallback(nullptr);
+}
+
+void test_handler_timer_sees_every_handler_slot(void) {
+  static uint32_t clock_us;
+  static size_t slot_calls[EventRegistry::HANDLER_SLOTS];
+  static uint32_t slot_us[EventRegistry::HANDLER_SLOTS];
+  clock_us = 0;
+  memset(slot_calls, 0, sizeof(slot_calls));
+  memset(slot_us, 0, sizeof(slot_us));
+  // Every clock read advances 10 us, so each handler call takes 10 us
+  static const EventRegistry::HandlerTimer timer{
+      []() { return clock_us += 10; },
+      [](EventType type, size_t slot, uint32_t elapsed_us)
+      {
+        TEST_ASSERT_EQUAL(EventType::RawKey, type);
+        slot_calls[slot]++;
+        slot_us[slot] += elapsed_us;
+      }};
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_1);
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_2);
+  EventRegistry::registerBatchHandler(EventType::RawKey, [](const Event *, size_t) {});
+  EventRegistry::registerOffloadHandler(EventType::RawKey, [](const Event *, size_t) {});
+
+  Event events[2]{};
+  for (Event &event : events)
+    event.type = EventType::RawKey;
+  EventRegistry::dispatchBatch(events, 2);
+  TEST_ASSERT_EQUAL(0, clock_us);
+
+  EventRegistry::registerHandlerTimer(&timer);
+  TEST_ASSERT_EQUAL(4, EventRegistry::dispatchBatch(events, 2));
+  EventRegistry::registerHandlerTimer(nullptr);
+
+  // Per-event handlers once per event, the others once per batch
+  TEST_ASSERT_EQUAL(2, slot_calls[0]);
+  TEST_ASSERT_EQUAL(2, slot_calls[1]);
+  TEST_ASSERT_EQUAL(1, slot_calls[EventRegistry::MAX_HANDLERS]);
+  TEST_ASSERT_EQUAL(1, slot_calls[2 * EventRegistry::MAX_HANDLERS]);
+  TEST_ASSERT_EQUAL_UINT32(20, slot_us[0]);
+  TEST_ASSERT_EQUAL_UINT32(10, slot_us[2 * EventRegistry::MAX_HANDLERS]);
+  TEST_ASSERT_EQUAL(0, slot_calls[2]);
+  TEST_ASSERT_EQUAL(8, callback1_count + callback2_count);
+}
+
+void test_dispatch_does_not_allocate(void) {
+#ifdef UNITY_NATIVE
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_1);
+  EventRegistry::registerHandler(EventType::RawKey, test_callback_2);
+  EventRegistry::registerPushCallback([](const Event &) { return true; });
+
+  Event test_event{};
+  test_event.type = EventType::RawKey;
+  size_t allocationsBefore = allocationCount.load();
+  for (int i = 0; i < 1000; i++)
+  {
+    EventRegistry::pushEvent(test_event);
+    EventRegistry::dispatch(test_event);
+  }
+  TEST_ASSERT_EQUAL(0, allocationCount.load() - allocationsBefore);
+  TEST_ASSERT_EQUAL(1000, callback1_count);
+
+  // The copying accessor still allocates, which shows the hook works
+  EventRegistry::getHandler(EventType::RawKey);
+  TEST_ASSERT_EQUAL(1, allocationCount.load() - allocationsBefore);
+  EventRegistry::clearPushCallback();
+#endif
+}
+
+void test_dispatch_while_registering(void) {
+#ifdef UNITY_NATIVE
+  static std::atomic<int> calls{0};
+  calls = 0;
+  EventRegistry::EventCallback countCall = [](const Event &) { calls++; };
+  EventRegistry::registerHandler(EventType::RawKey, countCall);
+
+  // A writer keeps adding and clearing a second handler, dispatch always
+  // sees the first one and at most one more
+  std::atomic<bool> done{false};
+  std::thread writer([&]
+                     {
+                       while (!done)
+                       {
+                         EventRegistry::registerHandler(EventType::RawKey, test_callback_2);
+                         EventRegistry::clearHandlers(EventType::RawKey);
+                         EventRegistry::registerHandler(EventType::RawKey, countCall);
+                       }
+                     });
+
+  Event test_event{};
+  test_event.type = EventType::RawKey;
+  size_t maxHandlers = 0;
+  for (int i = 0; i < 20000; i++)
+  {
+    size_t count = EventRegistry::dispatch(test_event);
+    maxHandlers = std::max(maxHandlers, count);
+  }
+  done = true;
+  writer.join();
+  TEST_ASSERT_TRUE(maxHandlers <= 2);
+  TEST_ASSERT_TRUE(calls.load() > 0);
+#endif
+}
+
 void run_EventRegistry_tests()
 {
     RUN_TEST(test_register_single_handler);
@@ -106,6 +370,14 @@ void run_EventRegistry_tests()
     RUN_TEST(test_get_handler_empty);
     RUN_TEST(test_handlers_are_callable);
     RUN_TEST(test_multiple_handlers_execution);
+    RUN_TEST(test_dispatch_calls_handlers_in_order);
+    RUN_TEST(test_register_refused_when_full);
+    RUN_TEST(test_dispatch_batch_reaches_both_handler_kinds);
+    RUN_TEST(test_change_callback_follows_registrations);
+    RUN_TEST(test_offloaded_handler_goes_to_offload_callback);
+    RUN_TEST(test_handler_timer_sees_every_handler_slot);
+    RUN_TEST(test_dispatch_does_not_allocate);
+    RUN_TEST(test_dispatch_while_registering);
 }
 
 
@@ -0,0 +1,258 @@
+#ifndef EVENTRINGTEST_H
+#define EVENTRINGTEST_H
+
+#include <submodules/EventChannel.h>
+#include <submodules/EventRing.h>
+#include <submodules/PayloadPool.h>
+#include <submodules/ScanTimingStats.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#endif
+
+using OverflowPolicy = EventRing::OverflowPolicy;
+
+static Event ringKey(uint16_t keyIndex)
+{
+    RawKeyEvent key{};
+    key.keyIndex = keyIndex;
+    key.state = true;
+    return RawKeyChannel::wrap(key);
+}
+
+// Bitmap spilled to the RawBitmap pool, the first byte tells them apart
+static Event ringBitmap(uint8_t firstByte)
+{
+    uint8_t bitmap[48] = {firstByte};
+    RawBitmapEvent event{};
+    event.assign(EventType::RawBitmap, bitmap, sizeof(bitmap));
+    return RawBitmapChannel::wrap(event);
+}
+
+static uint16_t bitmapsInUse()
+{
+    PayloadPool::Stats stats = PayloadPool::forType(EventType::RawBitmap).getStats();
+    return stats.inUse + stats.heapInUse;
+}
+
+static void releaseAll(Event *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        events[i].cleanup(&events[i]);
+}
+
+static uint32_t ringWakes;
+
+static void countRingWake(void *arg)
+{
+    ringWakes++;
+}
+
+void test_EventRing_subscribersReadAtOwnPace()
+{
+    EventRing ring(16);
+    int fast = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropOldest, countRingWake, nullptr);
+    int slow = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropOldest, nullptr, nullptr);
+    TEST_ASSERT_TRUE(fast >= 0 && slow >= 0 && fast != slow);
+
+    ringWakes = 0;
+    for (uint16_t key = 0; key < 10; key++)
+        TEST_ASSERT_EQUAL(2, ring.publish(ringKey(key)));
+    TEST_ASSERT_EQUAL_UINT32(10, ringWakes);
+
+    Event out[16];
+    TEST_ASSERT_EQUAL(10, ring.poll(fast, out, 16));
+    for (uint16_t key = 0; key < 10; key++)
+        TEST_ASSERT_EQUAL_UINT16(key, out[key].rawKeyEvt.keyIndex);
+    TEST_ASSERT_EQUAL(4, ring.poll(slow, out, 4));
+    TEST_ASSERT_EQUAL_UINT16(3, out[3].rawKeyEvt.keyIndex);
+
+    EventRing::SubscriberStats stats = ring.getStats(slow);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.received);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.lag);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getStats(fast).lag);
+
+    // A new mask applies to later events, the backlog stays
+    ring.setTypeMask(slow, EventRing::typeBit(EventType::RawBitmap));
+    TEST_ASSERT_EQUAL(1, ring.publish(ringKey(10)));
+    TEST_ASSERT_EQUAL(6, ring.poll(slow, out, 16));
+    TEST_ASSERT_EQUAL_UINT16(9, out[5].rawKeyEvt.keyIndex);
+}
+
+void test_EventRing_typeMaskFiltersAndSharesPayload()
+{
+    uint16_t inUse = bitmapsInUse();
+    {
+        EventRing ring(8);
+        int keys = ring.subscribe(EventRing::typeBit(EventType::RawKey), OverflowPolicy::DropOldest,
+                                  nullptr, nullptr);
+        int bitmaps = ring.subscribe(EventRing::typeBit(EventType::RawBitmap),
+                                     OverflowPolicy::DropOldest, nullptr, nullptr);
+        int both = ring.subscribe(EventRing::typeBit(EventType::RawKey) | EventRing::typeBit(EventType::RawBitmap),
+                                  OverflowPolicy::DropOldest, nullptr, nullptr);
+
+        TEST_ASSERT_EQUAL(2, ring.publish(ringKey(1)));
+        TEST_ASSERT_EQUAL(2, ring.publish(ringBitmap(7)));
+        TEST_ASSERT_EQUAL(2, ring.publish(ringKey(2)));
+
+        // Nobody takes stats, the payload goes straight back
+        PayloadPool &statsPool = PayloadPool::forType(EventType::ScanStats);
+        uint16_t statsInUse = statsPool.getStats().inUse;
+        ScanStatsEvent stats{static_cast<ScanTimingSnapshot *>(statsPool.allocate(sizeof(ScanTimingSnapshot)))};
+        TEST_ASSERT_EQUAL(0, ring.publish(ScanStatsChannel::wrap(stats)));
+        TEST_ASSERT_EQUAL_UINT16(statsInUse, statsPool.getStats().inUse);
+
+        Event out[8];
+        TEST_ASSERT_EQUAL(2, ring.poll(keys, out, 8));
+        TEST_ASSERT_EQUAL_UINT16(2, out[1].rawKeyEvt.keyIndex);
+        TEST_ASSERT_EQUAL(1, ring.poll(bitmaps, out, 8));
+        const uint8_t *shared = out[0].rawBitmapEvt.data();
+        TEST_ASSERT_EQUAL_UINT8(7, shared[0]);
+        releaseAll(out, 1);
+
+        // One buffer for both subscribers, still held by the second one
+        TEST_ASSERT_EQUAL_UINT16(inUse + 1, bitmapsInUse());
+        TEST_ASSERT_EQUAL(3, ring.poll(both, out, 8));
+        TEST_ASSERT_EQUAL_PTR(shared, out[1].rawBitmapEvt.data());
+        releaseAll(out, 3);
+    }
+    TEST_ASSERT_EQUAL_UINT16(inUse, bitmapsInUse());
+}
+
+void test_EventRing_overflowPolicyOnlyHitsSlowSubscriber()
+{
+    uint16_t inUse = bitmapsInUse();
+    {
+        EventRing ring(8);
+        int fast = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropOldest, nullptr, nullptr);
+        int oldest = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropOldest, nullptr, nullptr);
+        int pending = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropPending, nullptr, nullptr);
+
+        Event out[16];
+        uint32_t fastReceived = 0;
+        for (uint8_t i = 0; i < 12; i++)
+        {
+            ring.publish(ringBitmap(i));
+            size_t count = ring.poll(fast, out, 16);
+            TEST_ASSERT_EQUAL(1, count);
+            TEST_ASSERT_EQUAL_UINT8(i, out[0].rawBitmapEvt.data()[0]);
+            releaseAll(out, count);
+            fastReceived++;
+        }
+        TEST_ASSERT_EQUAL_UINT32(12, fastReceived);
+        TEST_ASSERT_EQUAL_UINT32(0, ring.getStats(fast).dropped);
+
+        // Lapped once per publish past the ring, keeps the newest 8
+        size_t count = ring.poll(oldest, out, 16);
+        TEST_ASSERT_EQUAL(8, count);
+        TEST_ASSERT_EQUAL_UINT8(4, out[0].rawBitmapEvt.data()[0]);
+        TEST_ASSERT_EQUAL_UINT8(11, out[7].rawBitmapEvt.data()[0]);
+        TEST_ASSERT_EQUAL_UINT32(4, ring.getStats(oldest).dropped);
+        releaseAll(out, count);
+
+        // Skipped the full backlog when lapped, then went on
+        count = ring.poll(pending, out, 16);
+        TEST_ASSERT_EQUAL(4, count);
+        TEST_ASSERT_EQUAL_UINT8(8, out[0].rawBitmapEvt.data()[0]);
+        TEST_ASSERT_EQUAL_UINT32(8, ring.getStats(pending).dropped);
+        releaseAll(out, count);
+        TEST_ASSERT_EQUAL_UINT16(inUse, bitmapsInUse());
+
+        // Events left unread are released by unsubscribe
+        ring.publish(ringBitmap(12));
+        ring.unsubscribe(oldest);
+        ring.unsubscribe(pending);
+        TEST_ASSERT_EQUAL_UINT16(inUse + 1, bitmapsInUse());
+    }
+    TEST_ASSERT_EQUAL_UINT16(inUse, bitmapsInUse());
+}
+
+void test_EventRing_concurrentProducersAndSubscribers()
+{
+#ifdef UNITY_NATIVE
+    static constexpr uint32_t EVENTS_PER_PRODUCER = 20000;
+    static constexpr size_t PRODUCERS = 2;
+    static constexpr size_t SUBSCRIBERS = 3;
+    uint16_t inUse = bitmapsInUse();
+    {
+        EventRing ring(64);
+        int ids[SUBSCRIBERS];
+        for (size_t s = 0; s < SUBSCRIBERS; s++)
+            ids[s] = ring.subscribe(EventRing::ALL_TYPES, OverflowPolicy::DropOldest, nullptr, nullptr);
+
+        std::atomic<uint32_t> producing{PRODUCERS};
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < PRODUCERS; p++)
+            threads.emplace_back([&ring, &producing, p]
+                                 {
+                                     // Keys carry the producer in the top bit, every
+                                     // fourth event is a shared bitmap
+                                     for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++)
+                                         ring.publish(i % 4 == 3 ? ringBitmap(static_cast<uint8_t>(p))
+                                                                 : ringKey(static_cast<uint16_t>(p << 15 | (i & 0x7FFF))));
+                                     producing--;
+                                 });
+
+        std::atomic<uint32_t> outOfOrder{0};
+        std::atomic<uint32_t> torn{0};
+        for (size_t s = 0; s < SUBSCRIBERS; s++)
+            threads.emplace_back([&, s]
+                                 {
+                                     Event out[16];
+                                     int32_t lastKey[PRODUCERS] = {-1, -1};
+                                     for (;;)
+                                     {
+                                         bool done = producing.load() == 0;
+                                         size_t count = ring.poll(ids[s], out, 16);
+                                         for (size_t i = 0; i < count; i++)
+                                         {
+                                             if (out[i].type == EventType::RawKey)
+                                             {
+                                                 size_t p = out[i].rawKeyEvt.keyIndex >> 15;
+                                                 int32_t key = out[i].rawKeyEvt.keyIndex & 0x7FFF;
+                                                 if (key <= lastKey[p])
+                                                     outOfOrder++;
+                                                 lastKey[p] = key;
+                                             }
+                                             else if (out[i].rawBitmapEvt.bitmapSize != 48 ||
+                                                      out[i].rawBitmapEvt.data()[0] >= PRODUCERS)
+                                                 torn++;
+                                             out[i].cleanup(&out[i]);
+                                         }
+                                         // The last subscriber falls behind on purpose
+                                         if (s == SUBSCRIBERS - 1)
+                                             std::this_thread::sleep_for(std::chrono::microseconds(50));
+                                         if (done && count == 0)
+                                             break;
+                                     }
+                                 });
+        for (std::thread &thread : threads)
+            thread.join();
+
+        TEST_ASSERT_EQUAL_UINT32(0, outOfOrder.load());
+        TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+        for (size_t s = 0; s < SUBSCRIBERS; s++)
+        {
+            EventRing::SubscriberStats stats = ring.getStats(ids[s]);
+            TEST_ASSERT_EQUAL_UINT32(PRODUCERS * EVENTS_PER_PRODUCER, stats.received + stats.dropped);
+            TEST_ASSERT_EQUAL_UINT32(0, stats.lag);
+        }
+        TEST_ASSERT_TRUE(ring.getStats(ids[SUBSCRIBERS - 1]).dropped > 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(inUse, bitmapsInUse());
+#endif
+}
+
+void run_EventRing_tests()
+{
+    RUN_TEST(test_EventRing_subscribersReadAtOwnPace);
+    RUN_TEST(test_EventRing_typeMaskFiltersAndSharesPayload);
+    RUN_TEST(test_EventRing_overflowPolicyOnlyHitsSlowSubscriber);
+    RUN_TEST(test_EventRing_concurrentProducersAndSubscribers);
+}
+
+#endif
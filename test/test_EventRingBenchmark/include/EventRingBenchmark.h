@@ -0,0 +1,290 @@
+#ifndef EVENTRINGBENCHMARK_H
+#define EVENTRINGBENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <submodules/EventChannel.h>
+#include <submodules/EventLanes.h>
+#include <submodules/EventRing.h>
+#include <thread>
+#include <unity.h>
+#include <vector>
+
+// Two scan tasks publishing keys, two subscribers keeping up and one that
+// takes far longer per event than the producers leave it
+static constexpr size_t PRODUCERS = 2;
+static constexpr uint32_t EVENTS_PER_PRODUCER = 1500;
+static constexpr uint32_t PUBLISHED = PRODUCERS * EVENTS_PER_PRODUCER;
+static constexpr auto PUBLISH_PERIOD = std::chrono::microseconds(200);
+static constexpr auto SLOW_HANDLER_TIME = std::chrono::milliseconds(1);
+
+using Clock = std::chrono::steady_clock;
+
+// Task notification, like xTaskNotifyGive and ulTaskNotifyTake(pdTRUE, ...)
+class Notifier
+{
+public:
+    void give()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+        }
+        condition.notify_one();
+    }
+
+    void take()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return count > 0; });
+        count = 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t count = 0;
+};
+
+static Clock::time_point publishedAt[PRODUCERS][EVENTS_PER_PRODUCER];
+
+// What one subscriber saw, only touched by the task running it
+struct Recorder
+{
+    std::vector<double> latencyUs;
+    int32_t lastKey[PRODUCERS];
+    uint32_t outOfOrder;
+
+    void reset()
+    {
+        latencyUs.clear();
+        latencyUs.reserve(PUBLISHED);
+        std::fill(lastKey, lastKey + PRODUCERS, -1);
+        outOfOrder = 0;
+    }
+
+    void record(const RawKeyEvent &key)
+    {
+        size_t producer = key.keyIndex >> 15;
+        int32_t sequence = static_cast<int32_t>(key.scanSequence);
+        latencyUs.push_back(std::chrono::duration<double, std::micro>(
+                                Clock::now() - publishedAt[producer][sequence])
+                                .count());
+        if (sequence <= lastKey[producer])
+            outOfOrder++;
+        lastKey[producer] = sequence;
+    }
+};
+
+static Recorder fastA;
+static Recorder fastB;
+static std::atomic<uint32_t> slowHandled{0};
+
+static void recordFastA(const RawKeyEvent &key) { fastA.record(key); }
+static void recordFastB(const RawKeyEvent &key) { fastB.record(key); }
+
+static void slowHandler(const RawKeyEvent &)
+{
+    std::this_thread::sleep_for(SLOW_HANDLER_TIME);
+    slowHandled++;
+}
+
+// Both producers at the scan rate, returns the events the backend took
+template <typename Publish>
+static uint32_t runProducers(Publish publish)
+{
+    std::atomic<uint32_t> accepted{0};
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < PRODUCERS; p++)
+        producers.emplace_back([&, p]
+                               {
+                                   for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++)
+                                   {
+                                       RawKeyEvent key{};
+                                       key.keyIndex = static_cast<uint16_t>(p << 15 | (i & 0x7FFF));
+                                       key.state = i % 2 == 0;
+                                       key.scanSequence = i;
+                                       publishedAt[p][i] = Clock::now();
+                                       if (publish(RawKeyChannel::wrap(key)))
+                                           accepted++;
+                                       std::this_thread::sleep_for(PUBLISH_PERIOD);
+                                   }
+                               });
+    for (std::thread &producer : producers)
+        producer.join();
+    return accepted.load();
+}
+
+struct SubscriberResult
+{
+    double medianUs;
+    double p99Us;
+    uint32_t received;
+    uint32_t outOfOrder;
+};
+
+static SubscriberResult summarize(Recorder &recorder)
+{
+    std::vector<double> &latency = recorder.latencyUs;
+    std::sort(latency.begin(), latency.end());
+    uint32_t received = static_cast<uint32_t>(latency.size());
+    if (received == 0)
+        return {0, 0, 0, recorder.outOfOrder};
+    return {latency[received / 2], latency[received * 99 / 100], received, recorder.outOfOrder};
+}
+
+// The single bus task: every handler runs in turn on each event
+static EventLanes *lanes;
+static Notifier *busNotifier;
+
+static bool pushToBus(const Event &event)
+{
+    if (!lanes->push(event))
+        return false;
+    busNotifier->give();
+    return true;
+}
+
+static SubscriberResult runSingleBus(uint32_t &accepted)
+{
+    EventLanes busLanes;
+    Notifier bus;
+    lanes = &busLanes;
+    busNotifier = &bus;
+    fastA.reset();
+    fastB.reset();
+    slowHandled = 0;
+
+    EventRegistry::clearHandlers(EventType::RawKey);
+    EventRegistry::registerPushCallback(pushToBus);
+    RawKeyChannel::subscribe<recordFastA>();
+    RawKeyChannel::subscribe<recordFastB>();
+    RawKeyChannel::subscribe<slowHandler>();
+
+    std::atomic<bool> stop{false};
+    std::thread busTask([&]
+                        {
+                            Event batch[32];
+                            while (!stop.load())
+                            {
+                                bus.take();
+                                busLanes.drain(batch, 32, 64, [](Event *events, size_t count)
+                                               { EventRegistry::deliverBatch(events, count); });
+                            }
+                        });
+
+    accepted = runProducers([](const Event &event) { return EventRegistry::pushEvent(event); });
+    // Let the bus work off what it took, slow handler included
+    while (slowHandled.load() < accepted)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    stop = true;
+    bus.give();
+    busTask.join();
+
+    EventRegistry::clearHandlers(EventType::RawKey);
+    EventRegistry::clearPushCallback();
+
+    TEST_ASSERT_EQUAL_UINT32(accepted, fastB.latencyUs.size());
+    return summarize(fastA);
+}
+
+// One task per subscriber, as RingBusTask runs them
+static void wakeSubscriber(void *arg) { static_cast<Notifier *>(arg)->give(); }
+
+static SubscriberResult runRing(EventRing::SubscriberStats stats[3])
+{
+    EventRing ring(64);
+    Notifier notifiers[3];
+    void (*handlers[3])(const RawKeyEvent &) = {recordFastA, recordFastB, slowHandler};
+    int ids[3];
+    for (size_t s = 0; s < 3; s++)
+        ids[s] = ring.subscribe(EventRing::typeBit(EventType::RawKey), EventRing::OverflowPolicy::DropOldest,
+                                wakeSubscriber, &notifiers[s]);
+    fastA.reset();
+    fastB.reset();
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> subscribers;
+    for (size_t s = 0; s < 3; s++)
+        subscribers.emplace_back([&, s]
+                                 {
+                                     Event events[16];
+                                     for (;;)
+                                     {
+                                         notifiers[s].take();
+                                         // Read before draining, everything was published then
+                                         bool done = stop.load();
+                                         size_t count;
+                                         while ((count = ring.poll(ids[s], events, 16)) > 0)
+                                             for (size_t i = 0; i < count; i++)
+                                             {
+                                                 handlers[s](RawKeyChannel::payload(events[i]));
+                                                 if (events[i].cleanup)
+                                                     events[i].cleanup(&events[i]);
+                                             }
+                                         if (done)
+                                             break;
+                                     }
+                                 });
+
+    uint32_t accepted = runProducers([&ring](const Event &event) { return ring.publish(event) > 0; });
+    TEST_ASSERT_EQUAL_UINT32(PUBLISHED, accepted);
+    stop = true;
+    for (Notifier &notifier : notifiers)
+        notifier.give();
+    for (std::thread &subscriber : subscribers)
+        subscriber.join();
+
+    for (size_t s = 0; s < 3; s++)
+        stats[s] = ring.getStats(ids[s]);
+    TEST_ASSERT_EQUAL_UINT32(stats[1].received, fastB.latencyUs.size());
+    return summarize(fastA);
+}
+
+void test_eventRing_slowSubscriberOnlyDelaysItself()
+{
+    uint32_t busAccepted;
+    SubscriberResult bus = runSingleBus(busAccepted);
+    EventRing::SubscriberStats stats[3];
+    SubscriberResult ring = runRing(stats);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "single bus: fast subscriber median %8.1f us, p99 %8.1f us, %4u/%u events",
+             bus.medianUs, bus.p99Us, bus.received, PUBLISHED);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message),
+             "event ring: fast subscriber median %8.1f us, p99 %8.1f us, %4u/%u events",
+             ring.medianUs, ring.p99Us, ring.received, PUBLISHED);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "event ring: slow subscriber %u received, %u dropped",
+             stats[2].received, stats[2].dropped);
+    TEST_MESSAGE(message);
+
+    // The single bus runs the slow handler in line and refuses events once
+    // its lane is full, for every subscriber alike
+    TEST_ASSERT_EQUAL_UINT32(busAccepted, bus.received);
+    TEST_ASSERT_TRUE(busAccepted < PUBLISHED);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.outOfOrder);
+
+    // On the ring only the slow subscriber skips events, all in order
+    TEST_ASSERT_EQUAL_UINT32(0, ring.outOfOrder);
+    for (size_t s = 0; s < 3; s++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(PUBLISHED, stats[s].received + stats[s].dropped);
+        TEST_ASSERT_EQUAL_UINT32(0, stats[s].lag);
+    }
+    TEST_ASSERT_EQUAL_UINT32(stats[0].received, ring.received);
+    TEST_ASSERT_TRUE(stats[2].dropped > 0);
+}
+
+void run_EventRingBenchmark_tests()
+{
+    RUN_TEST(test_eventRing_slowSubscriberOnlyDelaysItself);
+}
+
+#endif
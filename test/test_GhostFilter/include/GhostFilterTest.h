@@ -0,0 +1,115 @@
+#ifndef GHOSTFILTERTEST_H
+#define GHOSTFILTERTEST_H
+
+#include <submodules/GhostFilter.h>
+#include <unity.h>
+#include <vector>
+
+// Row-major bitmap of a rowCount x colCount matrix
+struct TestBitmap
+{
+    size_t colCount;
+    std::vector<uint32_t> words;
+
+    TestBitmap(size_t rowCount, size_t colCount)
+        : colCount(colCount), words((rowCount * colCount + 31) / 32, 0) {}
+
+    void set(size_t row, size_t col)
+    {
+        size_t bit = row * colCount + col;
+        words[bit / 32] |= (1u << (bit % 32));
+    }
+
+    bool get(size_t row, size_t col) const
+    {
+        size_t bit = row * colCount + col;
+        return (words[bit / 32] >> (bit % 32)) & 1;
+    }
+};
+
+void test_GhostFilter_passesKeysWithoutRectangle()
+{
+    GhostFilter filter(4, 4);
+    TestBitmap samples(4, 4);
+    TestBitmap stable(4, 4);
+
+    // Two keys per row in two rows, but only one shared column
+    samples.set(0, 0);
+    samples.set(0, 1);
+    samples.set(2, 1);
+    samples.set(2, 3);
+    std::vector<uint32_t> before = samples.words;
+
+    TEST_ASSERT_EQUAL(0, filter.apply(samples.words.data(), stable.words.data()));
+    TEST_ASSERT_TRUE(before == samples.words);
+}
+
+void test_GhostFilter_suppressesNewCornerOfRectangle()
+{
+    GhostFilter filter(4, 4);
+    TestBitmap stable(4, 4);
+    stable.set(0, 0);
+    stable.set(0, 3);
+
+    // A third corner is pressed, the fourth one appears as ghost
+    TestBitmap samples(4, 4);
+    samples.set(0, 0);
+    samples.set(0, 3);
+    samples.set(2, 0);
+    samples.set(2, 3);
+
+    TEST_ASSERT_EQUAL(2, filter.apply(samples.words.data(), stable.words.data()));
+    TEST_ASSERT_TRUE(samples.get(0, 0));
+    TEST_ASSERT_TRUE(samples.get(0, 3));
+    TEST_ASSERT_FALSE(samples.get(2, 0));
+    TEST_ASSERT_FALSE(samples.get(2, 3));
+}
+
+void test_GhostFilter_keysOutsideRectangleStillPass()
+{
+    GhostFilter filter(4, 5);
+    TestBitmap stable(4, 5);
+    TestBitmap samples(4, 5);
+    samples.set(1, 1);
+    samples.set(1, 2);
+    samples.set(3, 1);
+    samples.set(3, 2);
+    samples.set(3, 4);
+    samples.set(0, 4);
+
+    TEST_ASSERT_EQUAL(4, filter.apply(samples.words.data(), stable.words.data()));
+    TEST_ASSERT_TRUE(samples.get(3, 4));
+    TEST_ASSERT_TRUE(samples.get(0, 4));
+    TEST_ASSERT_FALSE(samples.get(1, 1));
+    TEST_ASSERT_FALSE(samples.get(3, 2));
+}
+
+void test_GhostFilter_rowsAcrossWordBoundaries()
+{
+    // 40 columns, rows straddle words and the rectangle spans all of them
+    GhostFilter filter(3, 40);
+    TestBitmap stable(3, 40);
+    TestBitmap samples(3, 40);
+    stable.set(1, 0);
+    stable.set(1, 39);
+    samples.set(1, 0);
+    samples.set(1, 39);
+    samples.set(2, 0);
+    samples.set(2, 39);
+
+    TEST_ASSERT_EQUAL(2, filter.apply(samples.words.data(), stable.words.data()));
+    TEST_ASSERT_TRUE(samples.get(1, 0));
+    TEST_ASSERT_TRUE(samples.get(1, 39));
+    TEST_ASSERT_FALSE(samples.get(2, 0));
+    TEST_ASSERT_FALSE(samples.get(2, 39));
+}
+
+void run_GhostFilter_tests()
+{
+    RUN_TEST(test_GhostFilter_passesKeysWithoutRectangle);
+    RUN_TEST(test_GhostFilter_suppressesNewCornerOfRectangle);
+    RUN_TEST(test_GhostFilter_keysOutsideRectangleStillPass);
+    RUN_TEST(test_GhostFilter_rowsAcrossWordBoundaries);
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef HIDMAPPERTEST_H
+#define HIDMAPPERTEST_H
+
+#include <submodules/HidMapper.h>
+#include <unity.h>
+#include <vector>
+
+static bool isHidBitSet(const HidMapper &mapper, uint8_t hidCode)
+{
+    uint8_t hidBitmap[32] = {};
+    mapper.copyBitmap(hidBitmap, sizeof(hidBitmap));
+    return (hidBitmap[hidCode / 8] >> (hidCode % 8)) & 1;
+}
+
+static std::vector<uint8_t> makeMap(size_t keyCount)
+{
+    std::vector<uint8_t> map(keyCount);
+    for (size_t i = 0; i < keyCount; i++)
+        map[i] = static_cast<uint8_t>(i % 256);
+    return map;
+}
+
+void test_HidMapper_indexAbove255()
+{
+    HidMapper mapper;
+    std::vector<uint8_t> map = makeMap(1024);
+    map[300] = 0x04;
+    map[1023] = 0xE1;
+    mapper.insertMap(map.data(), map.size(), 1);
+
+    mapper.mapIndexToHidBitmap(300, true, 1);
+    mapper.mapIndexToHidBitmap(1023, true, 1);
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x04));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0xE1));
+
+    mapper.mapIndexToHidBitmap(300, false, 1);
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0x04));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0xE1));
+}
+
+void test_HidMapper_indexOutsideMapIgnored()
+{
+    HidMapper mapper;
+    std::vector<uint8_t> map = makeMap(16);
+    mapper.insertMap(map.data(), map.size(), 1);
+
+    // The first index past the end must not read beyond the map
+    mapper.mapIndexToHidBitmap(16, true, 1);
+    mapper.mapIndexToHidBitmap(4000, true, 1);
+    uint8_t hidBitmap[32] = {};
+    uint8_t empty[32] = {};
+    mapper.copyBitmap(hidBitmap, sizeof(hidBitmap));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(empty, hidBitmap, sizeof(hidBitmap));
+}
+
+void test_HidMapper_mapsLargeBitmap()
+{
+    HidMapper mapper;
+    std::vector<uint8_t> map(1024, 0);
+    map[5] = 0x04;
+    map[700] = 0x05;
+    map[1023] = 0x06;
+    mapper.insertMap(map.data(), map.size(), 2);
+
+    uint8_t bitmap[128] = {};
+    bitmap[700 / 8] |= 1 << (700 % 8);
+    bitmap[1023 / 8] |= 1 << (1023 % 8);
+    mapper.mapBitmapToHidBitmap(bitmap, sizeof(bitmap), 2);
+
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0x04));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x05));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x06));
+
+    // A later bitmap releases keys it no longer contains
+    bitmap[700 / 8] = 0;
+    mapper.mapBitmapToHidBitmap(bitmap, sizeof(bitmap), 2);
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0x05));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x06));
+}
+
+void test_HidMapper_bitmapLongerThanMap()
+{
+    HidMapper mapper;
+    std::vector<uint8_t> map(10, 0x10);
+    mapper.insertMap(map.data(), map.size(), 3);
+
+    // Padding bits past the last mapped key are ignored
+    uint8_t bitmap[4] = {0x00, 0xFC, 0xFF, 0xFF};
+    mapper.mapBitmapToHidBitmap(bitmap, sizeof(bitmap), 3);
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0x10));
+}
+
+void test_HidMapper_sendersShareHidCode()
+{
+    // Shift on both halves, and padding entries of 0 on the right one
+    HidMapper mapper;
+    std::vector<uint8_t> left(8, 0);
+    std::vector<uint8_t> right(8, 0);
+    left[1] = 0xE1;
+    left[2] = 0x04;
+    right[6] = 0xE1;
+    mapper.insertMap(left.data(), left.size(), 1);
+    mapper.insertMap(right.data(), right.size(), 2);
+
+    uint8_t leftBitmap[1] = {1 << 1 | 1 << 2};
+    uint8_t rightBitmap[1] = {0};
+    mapper.mapBitmapToHidBitmap(leftBitmap, sizeof(leftBitmap), 1);
+    mapper.mapBitmapToHidBitmap(rightBitmap, sizeof(rightBitmap), 2);
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0xE1));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x04));
+
+    // Both halves hold Shift, releasing one keeps it
+    rightBitmap[0] = 1 << 6;
+    mapper.mapBitmapToHidBitmap(rightBitmap, sizeof(rightBitmap), 2);
+    leftBitmap[0] = 1 << 2;
+    mapper.mapBitmapToHidBitmap(leftBitmap, sizeof(leftBitmap), 1);
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0xE1));
+
+    // A resync of the other half repeats its state and changes nothing
+    mapper.mapBitmapToHidBitmap(leftBitmap, sizeof(leftBitmap), 1);
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0xE1));
+    TEST_ASSERT_TRUE(isHidBitSet(mapper, 0x04));
+
+    // The last release clears it, key events count the same way
+    RawKeyEvent release{};
+    release.keyIndex = 6;
+    release.state = false;
+    TEST_ASSERT_TRUE(mapper.mapKeyEventToHidBitmap(release, 2));
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0xE1));
+
+    // Keys mapped to 0 never touch bit 0
+    rightBitmap[0] = 0xBF;
+    mapper.mapBitmapToHidBitmap(rightBitmap, sizeof(rightBitmap), 2);
+    TEST_ASSERT_FALSE(isHidBitSet(mapper, 0));
+}
+
+void run_HidMapper_tests()
+{
+    RUN_TEST(test_HidMapper_indexAbove255);
+    RUN_TEST(test_HidMapper_indexOutsideMapIgnored);
+    RUN_TEST(test_HidMapper_mapsLargeBitmap);
+    RUN_TEST(test_HidMapper_bitmapLongerThanMap);
+    RUN_TEST(test_HidMapper_sendersShareHidCode);
+}
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef KEYFASTPATHTEST_H
+#define KEYFASTPATHTEST_H
+
+#include <submodules/KeyFastPath.h>
+#include <submodules/SpscRing.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <thread>
+#endif
+
+static uint32_t wakes[KeyFastPath::MAX_CONSUMERS];
+
+static void countWake(void *arg)
+{
+    wakes[reinterpret_cast<uintptr_t>(arg)]++;
+}
+
+static RawKeyEvent keyTransition(uint16_t keyIndex, bool state)
+{
+    RawKeyEvent event{};
+    event.keyIndex = keyIndex;
+    event.state = state;
+    return event;
+}
+
+void test_SpscRing_keepsOrderAcrossWrap()
+{
+    SpscRing<uint32_t, 4> ring;
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    uint32_t out[4];
+
+    for (int round = 0; round < 10; round++)
+    {
+        while (ring.push(next))
+            next++;
+        TEST_ASSERT_EQUAL(4, ring.size());
+
+        TEST_ASSERT_TRUE(ring.pop(out[0]));
+        TEST_ASSERT_EQUAL_UINT32(expected++, out[0]);
+        size_t count = ring.popBatch(out, 2);
+        TEST_ASSERT_EQUAL(2, count);
+        for (size_t i = 0; i < count; i++)
+            TEST_ASSERT_EQUAL_UINT32(expected++, out[i]);
+        TEST_ASSERT_EQUAL(1, ring.size());
+    }
+    ring.reset();
+    TEST_ASSERT_FALSE(ring.pop(out[0]));
+}
+
+void test_KeyFastPath_reachesAttachedConsumers()
+{
+    TEST_ASSERT_FALSE(KeyFastPath::hasConsumers());
+    TEST_ASSERT_EQUAL(0, KeyFastPath::push(0, keyTransition(1, true)));
+
+    wakes[0] = wakes[1] = 0;
+    int first = KeyFastPath::attach(countWake, reinterpret_cast<void *>(0));
+    int second = KeyFastPath::attach(countWake, reinterpret_cast<void *>(1));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT_EQUAL(1, second);
+    TEST_ASSERT_EQUAL(-1, KeyFastPath::attach(countWake, nullptr));
+
+    // A chord on one scan loop and a key on another
+    for (uint16_t key = 0; key < 3; key++)
+        TEST_ASSERT_EQUAL(2, KeyFastPath::push(0, keyTransition(key, true)));
+    TEST_ASSERT_EQUAL(2, KeyFastPath::push(1, keyTransition(100, false)));
+
+    // One wake per consumer and flush, only for producers that pushed
+    KeyFastPath::flush(0);
+    KeyFastPath::flush(0);
+    TEST_ASSERT_EQUAL_UINT32(1, wakes[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, wakes[1]);
+    KeyFastPath::flush(1);
+    TEST_ASSERT_EQUAL_UINT32(2, wakes[0]);
+
+    for (int consumer : {first, second})
+    {
+        RawKeyEvent out[8];
+        TEST_ASSERT_EQUAL(4, KeyFastPath::poll(consumer, out, 8));
+        for (uint16_t key = 0; key < 3; key++)
+            TEST_ASSERT_EQUAL_UINT16(key, out[key].keyIndex);
+        TEST_ASSERT_EQUAL_UINT16(100, out[3].keyIndex);
+        TEST_ASSERT_FALSE(out[3].state);
+        TEST_ASSERT_EQUAL(0, KeyFastPath::poll(consumer, out, 8));
+        TEST_ASSERT_EQUAL_UINT32(4, KeyFastPath::getStats(consumer).delivered);
+    }
+
+    KeyFastPath::detach(first);
+    KeyFastPath::detach(second);
+    TEST_ASSERT_FALSE(KeyFastPath::hasConsumers());
+}
+
+void test_KeyFastPath_fullRingDropsAndReattachStartsEmpty()
+{
+    int consumer = KeyFastPath::attach(countWake, reinterpret_cast<void *>(0));
+    TEST_ASSERT_TRUE(consumer >= 0);
+    for (uint16_t key = 0; key < KeyFastPath::RING_SIZE + 2; key++)
+        KeyFastPath::push(2, keyTransition(key, true));
+
+    KeyFastPath::Stats stats = KeyFastPath::getStats(consumer);
+    TEST_ASSERT_EQUAL_UINT32(KeyFastPath::RING_SIZE, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overflowed);
+
+    // Detached consumers are not fed, the next attach drops what was left
+    KeyFastPath::detach(consumer);
+    TEST_ASSERT_EQUAL(0, KeyFastPath::push(2, keyTransition(0, false)));
+    KeyFastPath::flush(2);
+    consumer = KeyFastPath::attach(countWake, reinterpret_cast<void *>(0));
+    RawKeyEvent out[1];
+    TEST_ASSERT_EQUAL(0, KeyFastPath::poll(consumer, out, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, KeyFastPath::getStats(consumer).overflowed);
+    KeyFastPath::detach(consumer);
+}
+
+void test_KeyFastPath_concurrentProducerKeepsOrder()
+{
+#ifdef UNITY_NATIVE
+    static constexpr uint32_t TRANSITIONS = 200000;
+    std::atomic<uint32_t> pending{0};
+    int consumer = KeyFastPath::attach([](void *arg)
+                                       { static_cast<std::atomic<uint32_t> *>(arg)->fetch_add(1); },
+                                       &pending);
+    TEST_ASSERT_TRUE(consumer >= 0);
+
+    uint32_t retries = 0;
+    std::thread scanner([&retries]
+                        {
+                            for (uint32_t i = 0; i < TRANSITIONS; i++)
+                            {
+                                RawKeyEvent event = keyTransition(i & 0xFFFF, i & 1);
+                                event.scanSequence = i;
+                                // Scans come far slower than this, wait for room
+                                while (KeyFastPath::push(3, event) == 0)
+                                {
+                                    retries++;
+                                    std::this_thread::yield();
+                                }
+                                if (i % 4 == 3)
+                                    KeyFastPath::flush(3);
+                            }
+                            KeyFastPath::flush(3);
+                        });
+
+    uint32_t received = 0;
+    uint32_t outOfOrder = 0;
+    RawKeyEvent out[8];
+    while (received < TRANSITIONS)
+    {
+        size_t count = KeyFastPath::poll(consumer, out, 8);
+        for (size_t i = 0; i < count; i++, received++)
+            if (out[i].scanSequence != received || out[i].keyIndex != (received & 0xFFFF))
+                outOfOrder++;
+    }
+    scanner.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(retries, KeyFastPath::getStats(consumer).overflowed);
+    TEST_ASSERT_TRUE(pending.load() > 0);
+    KeyFastPath::detach(consumer);
+#endif
+}
+
+void test_KeyFastPath_detachWaitsForProducers()
+{
+#ifdef UNITY_NATIVE
+    // A wake after detach returned would reach a consumer that may be gone
+    struct Target
+    {
+        std::atomic<bool> attached{false};
+        std::atomic<uint32_t> lateWakes{0};
+    };
+    static Target target;
+    std::atomic<bool> done{false};
+
+    std::thread scanner([&done]
+                        {
+                            for (uint32_t i = 0; !done.load(); i++)
+                            {
+                                KeyFastPath::push(0, keyTransition(i & 0xFFFF, i & 1));
+                                KeyFastPath::flush(0);
+                            }
+                        });
+
+    for (int round = 0; round < 2000; round++)
+    {
+        target.attached.store(true);
+        int consumer = KeyFastPath::attach([](void *arg)
+                                           {
+                                               // Stretch the wake so detach overlaps it
+                                               Target *target = static_cast<Target *>(arg);
+                                               std::this_thread::yield();
+                                               if (!target->attached.load())
+                                                   target->lateWakes.fetch_add(1);
+                                           },
+                                           &target);
+        TEST_ASSERT_TRUE(consumer >= 0);
+        std::this_thread::yield();
+        KeyFastPath::detach(consumer);
+        target.attached.store(false);
+    }
+    done.store(true);
+    scanner.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, target.lateWakes.load());
+#endif
+}
+
+void run_KeyFastPath_tests()
+{
+    RUN_TEST(test_SpscRing_keepsOrderAcrossWrap);
+    RUN_TEST(test_KeyFastPath_reachesAttachedConsumers);
+    RUN_TEST(test_KeyFastPath_fullRingDropsAndReattachStartsEmpty);
+    RUN_TEST(test_KeyFastPath_concurrentProducerKeepsOrder);
+    RUN_TEST(test_KeyFastPath_detachWaitsForProducers);
+}
+
+#endif
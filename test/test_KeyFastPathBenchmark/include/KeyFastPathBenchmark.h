@@ -0,0 +1,227 @@
+#ifndef KEYFASTPATHBENCHMARK_H
+#define KEYFASTPATHBENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <submodules/EventChannel.h>
+#include <submodules/EventLanes.h>
+#include <submodules/KeyFastPath.h>
+#include <thread>
+#include <unity.h>
+#include <vector>
+
+// Transitions sent one scan apart, so every one wakes the tasks on its way
+// instead of queueing behind the previous one
+static constexpr uint32_t TRANSITIONS = 2000;
+static constexpr auto SCAN_PERIOD = std::chrono::microseconds(100);
+
+using Clock = std::chrono::steady_clock;
+
+// Task notification: give counts, take blocks until the count is non-zero
+// and clears it, like xTaskNotifyGive and ulTaskNotifyTake(pdTRUE, ...)
+class Notifier
+{
+public:
+    void give()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+            gives++;
+        }
+        condition.notify_one();
+    }
+
+    void take()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return count > 0; });
+        count = 0;
+    }
+
+    uint32_t getGives()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return gives;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t count = 0;
+    uint32_t gives = 0;
+};
+
+// One run of the scan task, the bus task and the slave task
+static EventLanes *lanes;
+static Notifier *busNotifier;
+static Notifier *slaveNotifier;
+static std::mutex slaveQueueMutex;
+static std::deque<RawKeyEvent> slaveQueue;
+static std::atomic<uint32_t> busSubscriberEvents{0};
+
+static bool pushToBus(const Event &event)
+{
+    if (!lanes->push(event))
+        return false;
+    busNotifier->give();
+    return true;
+}
+
+// SlaveTask::keyBatchCallback, every event goes into the slave queue
+static void forwardToSlave(const Event *events, size_t count)
+{
+    {
+        std::lock_guard<std::mutex> lock(slaveQueueMutex);
+        for (size_t i = 0; i < count; i++)
+            slaveQueue.push_back(RawKeyChannel::payload(events[i]));
+    }
+    for (size_t i = 0; i < count; i++)
+        slaveNotifier->give();
+}
+
+// Any other key subscriber, e.g. a logger
+static void countBusEvent(const RawKeyEvent &) { busSubscriberEvents++; }
+
+static void wakeSlave(void *arg) { static_cast<Notifier *>(arg)->give(); }
+
+struct PathLatency
+{
+    double medianUs;
+    double p99Us;
+    double wakesPerTransition;
+    uint32_t outOfOrder;
+};
+
+static PathLatency runKeyPath(bool fastPath)
+{
+    EventLanes busLanes;
+    Notifier bus;
+    Notifier slave;
+    lanes = &busLanes;
+    busNotifier = &bus;
+    slaveNotifier = &slave;
+    slaveQueue.clear();
+    busSubscriberEvents = 0;
+
+    EventRegistry::clearHandlers(EventType::RawKey);
+    EventRegistry::registerPushCallback(pushToBus);
+    RawKeyChannel::subscribe<countBusEvent>();
+    int consumer = -1;
+    if (fastPath)
+        consumer = KeyFastPath::attach(wakeSlave, &slave);
+    else
+        EventRegistry::registerBatchHandler(EventType::RawKey, forwardToSlave);
+
+    std::vector<Clock::time_point> scannedAt(TRANSITIONS);
+    std::vector<double> latencyUs(TRANSITIONS);
+    std::atomic<bool> stop{false};
+
+    std::thread busTask([&]
+                        {
+                            Event batch[32];
+                            while (!stop.load())
+                            {
+                                bus.take();
+                                busLanes.drain(batch, 32, 64, [](Event *events, size_t count)
+                                               { EventRegistry::deliverBatch(events, count); });
+                            }
+                        });
+
+    uint32_t outOfOrder = 0;
+    std::thread slaveTask([&]
+                          {
+                              uint32_t received = 0;
+                              while (received < TRANSITIONS)
+                              {
+                                  slave.take();
+                                  RawKeyEvent keys[8];
+                                  size_t count;
+                                  auto record = [&](const RawKeyEvent &key)
+                                  {
+                                      latencyUs[received] = std::chrono::duration<double, std::micro>(
+                                                                Clock::now() - scannedAt[key.scanSequence])
+                                                                .count();
+                                      if (key.scanSequence != received)
+                                          outOfOrder++;
+                                      received++;
+                                  };
+                                  while ((count = KeyFastPath::poll(consumer, keys, 8)) > 0)
+                                      for (size_t i = 0; i < count; i++)
+                                          record(keys[i]);
+
+                                  std::lock_guard<std::mutex> lock(slaveQueueMutex);
+                                  for (; !slaveQueue.empty(); slaveQueue.pop_front())
+                                      record(slaveQueue.front());
+                              }
+                          });
+
+    // Scan task: one transition per scan, fast path first like
+    // KeyScannerTask::keyEventCallback
+    for (uint32_t i = 0; i < TRANSITIONS; i++)
+    {
+        RawKeyEvent key{};
+        key.keyIndex = static_cast<uint16_t>(i % 64);
+        key.state = (i / 64) % 2 == 0;
+        key.scanSequence = i;
+        scannedAt[i] = Clock::now();
+        KeyFastPath::push(0, key);
+        TEST_ASSERT_TRUE(RawKeyChannel::publish(key));
+        KeyFastPath::flush(0);
+        std::this_thread::sleep_for(SCAN_PERIOD);
+    }
+
+    slaveTask.join();
+    // Let the bus finish with the last transitions, then release it
+    while (busSubscriberEvents.load() < TRANSITIONS)
+        std::this_thread::yield();
+    stop = true;
+    bus.give();
+    busTask.join();
+
+    KeyFastPath::detach(consumer);
+    EventRegistry::clearHandlers(EventType::RawKey);
+    EventRegistry::clearPushCallback();
+
+    // Wake-ups of the tasks between scan and slave, per transition
+    uint32_t wakes = slave.getGives() + (fastPath ? 0 : TRANSITIONS);
+    std::sort(latencyUs.begin(), latencyUs.end());
+    return {latencyUs[TRANSITIONS / 2], latencyUs[TRANSITIONS * 99 / 100],
+            static_cast<double>(wakes) / TRANSITIONS, outOfOrder};
+}
+
+void test_keyFastPath_latencyOfBothPaths()
+{
+    PathLatency bus = runKeyPath(false);
+    PathLatency fast = runKeyPath(true);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "event bus: median %7.1f us, p99 %7.1f us, %4.2f task hand-offs/transition",
+             bus.medianUs, bus.p99Us, bus.wakesPerTransition);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message),
+             "fast path: median %7.1f us, p99 %7.1f us, %4.2f task hand-offs/transition",
+             fast.medianUs, fast.p99Us, fast.wakesPerTransition);
+    TEST_MESSAGE(message);
+
+    // Both deliver every transition in order, the bus subscriber saw all of
+    // them on either path
+    TEST_ASSERT_EQUAL_UINT32(0, bus.outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(0, fast.outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(TRANSITIONS, busSubscriberEvents.load());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, bus.wakesPerTransition);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, fast.wakesPerTransition);
+}
+
+void run_KeyFastPathBenchmark_tests()
+{
+    RUN_TEST(test_keyFastPath_latencyOfBothPaths);
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef KEYLATENCYSTATSTEST_H
+#define KEYLATENCYSTATSTEST_H
+
+#include <submodules/KeyLatencyStats.h>
+#include <unity.h>
+
+static RawKeyEvent makeKeyEvent(uint32_t scanSequence, uint32_t scanUs, uint32_t busUs,
+                                uint32_t txUs, uint32_t rxUs)
+{
+    RawKeyEvent keyEvent{};
+    keyEvent.keyIndex = 5;
+    keyEvent.state = true;
+    keyEvent.scanSequence = scanSequence;
+    keyEvent.timestamps = {scanUs, busUs, txUs, rxUs};
+    return keyEvent;
+}
+
+static uint32_t stageMax(const KeyLatencySnapshot &stats, LatencyStage stage)
+{
+    return stats.maxUs[static_cast<size_t>(stage)];
+}
+
+static uint64_t stageTotal(const KeyLatencySnapshot &stats, LatencyStage stage)
+{
+    return stats.totalUs[static_cast<size_t>(stage)];
+}
+
+void test_KeyLatencyStats_recordsLocalStages()
+{
+    KeyLatencyStats latency;
+    latency.record(makeKeyEvent(1, 1000, 1150, 1400, 90000), 1, 90030);
+
+    KeyLatencySnapshot stats;
+    latency.snapshot(stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.eventCount);
+    TEST_ASSERT_EQUAL_UINT32(150, stageMax(stats, LatencyStage::ScanToBus));
+    TEST_ASSERT_EQUAL_UINT32(250, stageMax(stats, LatencyStage::BusToTx));
+    TEST_ASSERT_EQUAL_UINT32(30, stageMax(stats, LatencyStage::RxToHid));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.buckets[static_cast<size_t>(LatencyStage::ScanToBus)]
+                                             [ScanTimingStats::bucketFor(150)]);
+}
+
+void test_KeyLatencyStats_transportDelayAboveFastestPacket()
+{
+    KeyLatencyStats latency;
+    // The master clock runs 5 s ahead of the sender, packets take 900, 700
+    // and 1500 us
+    const uint32_t offset = 5000000;
+    latency.record(makeKeyEvent(1, 0, 10, 20, 20 + offset + 900), 1, 20 + offset + 900);
+    latency.record(makeKeyEvent(2, 1000, 1010, 1020, 1020 + offset + 700), 1, 1020 + offset + 700);
+    latency.record(makeKeyEvent(3, 2000, 2010, 2020, 2020 + offset + 1500), 1, 2020 + offset + 1500);
+
+    KeyLatencySnapshot stats;
+    latency.snapshot(stats);
+    // The first packet sets the baseline, the second lowers it by 200 us
+    TEST_ASSERT_EQUAL_UINT32(800, stageMax(stats, LatencyStage::TxToRx));
+    TEST_ASSERT_EQUAL_UINT64(800, stageTotal(stats, LatencyStage::TxToRx));
+}
+
+void test_KeyLatencyStats_survivesClockWrap()
+{
+    KeyLatencyStats latency;
+    // Sender clock wraps between scan and bus, master clock wraps between the
+    // two packets
+    latency.record(makeKeyEvent(1, UINT32_MAX - 99, 100, 300, UINT32_MAX - 499), 2, UINT32_MAX - 479);
+    latency.record(makeKeyEvent(2, 1000, 1100, 1300, 750), 2, 1000);
+
+    KeyLatencySnapshot stats;
+    latency.snapshot(stats);
+    TEST_ASSERT_EQUAL_UINT32(200, stageMax(stats, LatencyStage::ScanToBus));
+    TEST_ASSERT_EQUAL_UINT32(200, stageMax(stats, LatencyStage::BusToTx));
+    TEST_ASSERT_EQUAL_UINT32(250, stageMax(stats, LatencyStage::TxToRx));
+    TEST_ASSERT_EQUAL_UINT32(250, stageMax(stats, LatencyStage::RxToHid));
+}
+
+void test_KeyLatencyStats_unstampedEventsOnlyRecordRxToHid()
+{
+    KeyLatencyStats latency;
+    latency.record(makeKeyEvent(0, 0, 0, 0, 5000), 1, 5040);
+
+    KeyLatencySnapshot stats;
+    latency.snapshot(stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.eventCount);
+    TEST_ASSERT_EQUAL_UINT64(0, stageTotal(stats, LatencyStage::ScanToBus));
+    TEST_ASSERT_EQUAL_UINT64(0, stageTotal(stats, LatencyStage::TxToRx));
+    TEST_ASSERT_EQUAL_UINT32(40, stageMax(stats, LatencyStage::RxToHid));
+
+    latency.reset();
+    latency.snapshot(stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.eventCount);
+    TEST_ASSERT_EQUAL_UINT32(0, stageMax(stats, LatencyStage::RxToHid));
+}
+
+void run_KeyLatencyStats_tests()
+{
+    RUN_TEST(test_KeyLatencyStats_recordsLocalStages);
+    RUN_TEST(test_KeyLatencyStats_transportDelayAboveFastestPacket);
+    RUN_TEST(test_KeyLatencyStats_survivesClockWrap);
+    RUN_TEST(test_KeyLatencyStats_unstampedEventsOnlyRecordRxToHid);
+}
+
+#endif
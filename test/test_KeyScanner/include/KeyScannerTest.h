@@ -10,6 +10,11 @@
 static Esp32Gpio gpio;
 #else
 #include "../../FakeGpio.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
 static FakeGpio gpio;
 #endif
 
@@ -25,6 +30,18 @@ private:
     static void test_updateKeyState_noKeysPressed();
     static void test_updateKeyState_singleKeyPressed();
     static void test_updateKeyState_multipleKeysPressed();
+    static void test_updateKeyState_bulkReadColumn();
+    static void test_updateKeyState_rowStraddlesWordBoundary();
+    static void test_scanPlan_columnMajor();
+    static void test_scanPlan_autoPicksFewerDriveLines();
+    static void test_debounce_deferredFiltersBouncingPress();
+    static void test_debounce_eagerReportsFirstEdge();
+    static void test_debounce_keysAcrossWordsAreIndependent();
+    static void test_changeBatch_oneCallbackPerChangedScan();
+    static void test_idle_drivesAllLinesAndArmsSenseLines();
+    static void test_idle_notEnteredWhileKeyHeld();
+    static void test_idle_wakeLatency();
+    static void test_idle_destructorDisarmsInterrupts();
 
 public:
     static void runAllTests();
@@ -70,7 +87,7 @@ void TestKeyScanner::test_setKey()
 
     scanner.setKey(0, 0);
 
-    uint8_t *state = scanner.workingBuffer;
+    uint8_t *state = reinterpret_cast<uint8_t *>(scanner.workingBuffer);
     uint8_t keyStateKey0_0 = state[byteIndex0_0] & bitMask0_0;
     uint8_t keyStateKey0_6 = state[byteIndex0_6] & bitMask0_6;
     TEST_ASSERT_EQUAL_UINT8(bitMask0_0, keyStateKey0_0);
@@ -81,7 +98,7 @@ void TestKeyScanner::test_setKey()
     TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedArray, scanner.workingBuffer, mapSize);
 
     scanner.setKey(0, 6);
-    state = scanner.workingBuffer;
+    state = reinterpret_cast<uint8_t *>(scanner.workingBuffer);
     keyStateKey0_0 = state[byteIndex0_0] & bitMask0_0;
     TEST_ASSERT_EQUAL_UINT8(0, keyStateKey0_0);
 
@@ -121,7 +138,8 @@ void TestKeyScanner::test_updateKeyState_singleKeyPressed()
     size_t bitMapSize = scanner.getBitMapSize();
 
     scanner.setKey(0, 0);
-    std::swap(scanner.workingBuffer, scanner.publishedBuffer);
+    scanner.swapBuffers();
+    scanner.publishBuffer();
 
     uint8_t state[bitMapSize];
     scanner.copyPublishedBitmap(state, bitMapSize);
@@ -144,6 +162,7 @@ void TestKeyScanner::test_updateKeyState_multipleKeysPressed()
     scanner.setKey(1, 1);
 
     scanner.swapBuffers();
+    scanner.publishBuffer();
     uint8_t state[bitMapSize];
     scanner.copyPublishedBitmap(state, bitMapSize);
 
@@ -159,6 +178,392 @@ void TestKeyScanner::test_updateKeyState_multipleKeysPressed()
     TEST_ASSERT_EQUAL(expected1_1, stateBit1_1);
 }
 
+void TestKeyScanner::test_updateKeyState_bulkReadColumn()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 2);
+
+    // FakeGpio does not model rows, a low column reads as pressed in every row
+    gpio.setPinState(18, PinState::Low);
+    scanner.updateKeyState();
+    gpio.setPinState(18, PinState::High);
+
+    uint8_t state[1];
+    scanner.copyPublishedBitmap(state, sizeof(state));
+    TEST_ASSERT_EQUAL_UINT8(0b00001010, state[0]);
+#endif
+}
+
+void TestKeyScanner::test_updateKeyState_rowStraddlesWordBoundary()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[3] = {1, 2, 3};
+    uint8_t colPins[20] = {4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                           14, 15, 16, 17, 18, 19, 20, 21, 38, 39};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 3, 20);
+
+    gpio.setPinState(4, PinState::Low);
+    gpio.setPinState(39, PinState::Low);
+    scanner.updateKeyState();
+    gpio.setPinState(4, PinState::High);
+    gpio.setPinState(39, PinState::High);
+
+    // Row 1 occupies bits 20-39 and crosses from the first into the second word
+    uint8_t expected[8] = {0};
+    for (uint16_t row = 0; row < 3; row++)
+    {
+        uint16_t first = row * 20;
+        uint16_t last = row * 20 + 19;
+        expected[first / 8] |= (1 << (first % 8));
+        expected[last / 8] |= (1 << (last % 8));
+    }
+
+    uint8_t state[8];
+    TEST_ASSERT_EQUAL(8, scanner.getBitMapSize());
+    scanner.copyPublishedBitmap(state, sizeof(state));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, state, sizeof(state));
+#endif
+}
+
+void TestKeyScanner::test_scanPlan_columnMajor()
+{
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[3] = {17, 18, 19};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 3,
+                                    KeyScannerConfig::ScanOrder::ColumnMajor);
+    TEST_ASSERT_EQUAL(3, scanner.scanPlan.size());
+    TEST_ASSERT_EQUAL(19, scanner.scanPlan[0].releasePin);
+    TEST_ASSERT_EQUAL(17, scanner.scanPlan[0].drivePin);
+    TEST_ASSERT_EQUAL(17, scanner.scanPlan[1].releasePin);
+    TEST_ASSERT_EQUAL(2, scanner.scanPlan[2].firstBit);
+    TEST_ASSERT_EQUAL(3, scanner.scanPlan[2].bitStride);
+
+#ifdef UNITY_NATIVE
+    // Rows are sensed now, a low row reads as pressed for every driven column
+    gpio.setPinState(10, PinState::Low);
+    scanner.updateKeyState();
+    gpio.setPinState(10, PinState::High);
+
+    uint8_t state[1];
+    scanner.copyPublishedBitmap(state, sizeof(state));
+    TEST_ASSERT_EQUAL_UINT8(0b00111000, state[0]);
+#endif
+}
+
+void TestKeyScanner::test_scanPlan_autoPicksFewerDriveLines()
+{
+    uint8_t rowPins[4] = {1, 2, 3, 4};
+    uint8_t colPins[2] = {17, 18};
+
+    KeyScanner tall = KeyScanner(gpio, rowPins, colPins, 4, 2,
+                                 KeyScannerConfig::ScanOrder::Auto);
+    TEST_ASSERT_EQUAL(KeyScannerConfig::ScanOrder::ColumnMajor, tall.getScanOrder());
+    TEST_ASSERT_EQUAL(2, tall.scanPlan.size());
+
+    KeyScanner wide = KeyScanner(gpio, colPins, rowPins, 2, 4,
+                                 KeyScannerConfig::ScanOrder::Auto);
+    TEST_ASSERT_EQUAL(KeyScannerConfig::ScanOrder::RowMajor, wide.getScanOrder());
+    TEST_ASSERT_EQUAL(2, wide.scanPlan.size());
+}
+
+#ifdef UNITY_NATIVE
+// Waveform helper: 'H' and 'L' characters, one level per scan
+static std::vector<PinState> waveform(const char *levels)
+{
+    std::vector<PinState> result;
+    for (const char *c = levels; *c; c++)
+        result.push_back(*c == 'L' ? PinState::Low : PinState::High);
+    return result;
+}
+
+struct RecordedChange
+{
+    uint32_t scan;
+    uint16_t keyIndex;
+    bool pressed;
+};
+#endif
+
+void TestKeyScanner::test_debounce_deferredFiltersBouncingPress()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[1] = {9};
+    uint8_t colPins[1] = {17};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 1, 1);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::Deferred, 4);
+
+    uint32_t scan = 0;
+    std::vector<RecordedChange> changes;
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool pressed)
+                                        { changes.push_back({scan, keyIndex, pressed}); });
+
+    // Bouncing press, then a single-scan glitch while held
+    gpio.scriptPin(17, waveform("HLHLLLLLLHLLLL"));
+    for (scan = 0; scan < 14; scan++)
+        scanner.updateKeyState();
+    gpio.clearScripts();
+    gpio.setPinState(17, PinState::High);
+
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_EQUAL(6, changes[0].scan);
+    TEST_ASSERT_TRUE(changes[0].pressed);
+#endif
+}
+
+void TestKeyScanner::test_debounce_eagerReportsFirstEdge()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[1] = {9};
+    uint8_t colPins[1] = {17};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 1, 1);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::Eager, 4);
+
+    uint32_t scan = 0;
+    std::vector<RecordedChange> changes;
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool pressed)
+                                        { changes.push_back({scan, keyIndex, pressed}); });
+
+    // Press and release both bounce for less than the window
+    gpio.scriptPin(17, waveform("HLHLHLLLHLHHHHHH"));
+    for (scan = 0; scan < 16; scan++)
+        scanner.updateKeyState();
+    gpio.clearScripts();
+    gpio.setPinState(17, PinState::High);
+
+    TEST_ASSERT_EQUAL(2, changes.size());
+    TEST_ASSERT_EQUAL(1, changes[0].scan);
+    TEST_ASSERT_TRUE(changes[0].pressed);
+    TEST_ASSERT_EQUAL(8, changes[1].scan);
+    TEST_ASSERT_FALSE(changes[1].pressed);
+#endif
+}
+
+void TestKeyScanner::test_debounce_keysAcrossWordsAreIndependent()
+{
+#ifdef UNITY_NATIVE
+    static constexpr uint8_t COLS = 40;
+    uint8_t rowPins[1] = {0};
+    uint8_t colPins[COLS];
+    for (uint8_t i = 0; i < COLS; i++)
+        colPins[i] = i + 1;
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 1, COLS);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::Deferred, 3);
+
+    uint32_t scan = 0;
+    uint32_t pressCount[COLS] = {0};
+    uint32_t pressScan[COLS] = {0};
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool pressed)
+                                        {
+                                            pressCount[keyIndex]++;
+                                            pressScan[keyIndex] = scan; });
+
+    // Every key bounces a different number of times before settling low
+    const char *patterns[4] = {"LLLLLLLLLL", "LHLLLLLLLL", "LHLHLLLLLL", "HHLHLHLLLL"};
+    for (uint8_t i = 0; i < COLS; i++)
+        gpio.scriptPin(colPins[i], waveform(patterns[i % 4]));
+    for (scan = 0; scan < 10; scan++)
+        scanner.updateKeyState();
+    gpio.clearScripts();
+    for (uint8_t i = 0; i < COLS; i++)
+        gpio.setPinState(colPins[i], PinState::High);
+
+    const uint32_t expectedScan[4] = {2, 4, 6, 8};
+    for (uint8_t i = 0; i < COLS; i++)
+    {
+        TEST_ASSERT_EQUAL(1, pressCount[i]);
+        TEST_ASSERT_EQUAL(expectedScan[i % 4], pressScan[i]);
+    }
+#endif
+}
+
+void TestKeyScanner::test_changeBatch_oneCallbackPerChangedScan()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 2);
+
+    uint32_t batchCount = 0;
+    uint32_t lastSequence = 0;
+    std::vector<KeyScanner::KeyChange> lastBatch;
+    scanner.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *changes, size_t count, uint32_t scanSequence)
+        {
+            batchCount++;
+            lastSequence = scanSequence;
+            lastBatch.assign(changes, changes + count);
+        });
+
+    gpio.setPinState(18, PinState::Low);
+    scanner.updateKeyState();
+
+    TEST_ASSERT_EQUAL(1, batchCount);
+    TEST_ASSERT_EQUAL(1, lastSequence);
+    TEST_ASSERT_EQUAL(2, lastBatch.size());
+    TEST_ASSERT_EQUAL(1, lastBatch[0].keyIndex);
+    TEST_ASSERT_TRUE(lastBatch[0].pressed);
+    TEST_ASSERT_EQUAL(3, lastBatch[1].keyIndex);
+    TEST_ASSERT_TRUE(lastBatch[1].pressed);
+
+    // Unchanged scans do not invoke the callback but still count
+    scanner.updateKeyState();
+    TEST_ASSERT_EQUAL(1, batchCount);
+    TEST_ASSERT_EQUAL(2, scanner.getScanSequence());
+
+    gpio.setPinState(18, PinState::High);
+    scanner.updateKeyState();
+
+    TEST_ASSERT_EQUAL(2, batchCount);
+    TEST_ASSERT_EQUAL(3, lastSequence);
+    TEST_ASSERT_EQUAL(2, lastBatch.size());
+    TEST_ASSERT_FALSE(lastBatch[0].pressed);
+    TEST_ASSERT_FALSE(lastBatch[1].pressed);
+#endif
+}
+
+#ifdef UNITY_NATIVE
+// Stand-in for the task notification the firmware blocks on while idle
+struct WakeSignal
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t count = 0;
+    std::chrono::steady_clock::time_point firstWake;
+
+    static void handler(void *arg)
+    {
+        WakeSignal *signal = static_cast<WakeSignal *>(arg);
+        std::lock_guard<std::mutex> lock(signal->mutex);
+        if (signal->count++ == 0)
+            signal->firstWake = std::chrono::steady_clock::now();
+        signal->condition.notify_one();
+    }
+};
+#endif
+
+void TestKeyScanner::test_idle_drivesAllLinesAndArmsSenseLines()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 2);
+    scanner.updateKeyState();
+
+    WakeSignal signal;
+    TEST_ASSERT_TRUE(scanner.enterIdle(WakeSignal::handler, &signal));
+    TEST_ASSERT_TRUE(scanner.isIdle());
+    TEST_ASSERT_EQUAL(PinMode::Output, gpio.getPinMode(9));
+    TEST_ASSERT_EQUAL(PinMode::Output, gpio.getPinMode(10));
+    TEST_ASSERT_EQUAL(PinState::Low, gpio.getOutputLevel(9));
+    TEST_ASSERT_EQUAL(PinState::Low, gpio.getOutputLevel(10));
+    TEST_ASSERT_TRUE(gpio.isInterruptArmed(17));
+    TEST_ASSERT_TRUE(gpio.isInterruptArmed(18));
+
+    // A press pulls its column low and fires the wake handler
+    gpio.injectEdge(18, PinState::Low);
+    TEST_ASSERT_EQUAL(1, signal.count);
+
+    // The next scan leaves idle and reports the key
+    TEST_ASSERT_EQUAL(2, scanner.updateKeyState());
+    TEST_ASSERT_FALSE(scanner.isIdle());
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(17));
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(18));
+    gpio.setPinState(18, PinState::High);
+#endif
+}
+
+void TestKeyScanner::test_idle_notEnteredWhileKeyHeld()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 2);
+
+    // The key went down before the interrupts were armed, no edge will follow
+    gpio.setPinState(17, PinState::Low);
+    WakeSignal signal;
+    TEST_ASSERT_FALSE(scanner.enterIdle(WakeSignal::handler, &signal));
+    TEST_ASSERT_FALSE(scanner.isIdle());
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(17));
+    TEST_ASSERT_EQUAL(PinMode::InputPullup, gpio.getPinMode(9));
+    gpio.setPinState(17, PinState::High);
+#endif
+}
+
+void TestKeyScanner::test_idle_destructorDisarmsInterrupts()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    {
+        KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 2, 2);
+        WakeSignal signal;
+        TEST_ASSERT_TRUE(scanner.enterIdle(WakeSignal::handler, &signal));
+        TEST_ASSERT_TRUE(gpio.isInterruptArmed(17));
+    }
+
+    // A press after the scanner is gone must not reach the freed arg
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(17));
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(18));
+    TEST_ASSERT_EQUAL(PinMode::InputPullup, gpio.getPinMode(9));
+    TEST_ASSERT_EQUAL(PinMode::InputPullup, gpio.getPinMode(10));
+#endif
+}
+
+void TestKeyScanner::test_idle_wakeLatency()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[4] = {1, 2, 3, 4};
+    uint8_t colPins[4] = {17, 18, 19, 20};
+
+    KeyScanner scanner = KeyScanner(gpio, rowPins, colPins, 4, 4);
+    scanner.updateKeyState();
+
+    WakeSignal signal;
+    std::chrono::steady_clock::time_point reported;
+    scanner.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *changes, size_t count, uint32_t scanSequence)
+        { reported = std::chrono::steady_clock::now(); });
+
+    TEST_ASSERT_TRUE(scanner.enterIdle(WakeSignal::handler, &signal));
+
+    // The scanning side blocks like the task does, then scans once on wake-up
+    std::thread scanThread([&]()
+                           {
+                               std::unique_lock<std::mutex> lock(signal.mutex);
+                               signal.condition.wait(lock, [&]() { return signal.count > 0; });
+                               lock.unlock();
+                               scanner.updateKeyState(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto pressed = std::chrono::steady_clock::now();
+    gpio.injectEdge(19, PinState::Low);
+    scanThread.join();
+    gpio.setPinState(19, PinState::High);
+
+    double wakeUs = std::chrono::duration<double, std::micro>(signal.firstWake - pressed).count();
+    double reportUs = std::chrono::duration<double, std::micro>(reported - pressed).count();
+    char message[96];
+    snprintf(message, sizeof(message), "Idle wake-up: interrupt after %.1f us, key reported after %.1f us",
+             wakeUs, reportUs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(reportUs >= 0);
+    TEST_ASSERT_TRUE(reportUs < 50000);
+#endif
+}
+
 void TestKeyScanner::runAllTests()
 {
     RUN_TEST(test_getBitMask);
@@ -166,6 +571,18 @@ void TestKeyScanner::runAllTests()
     RUN_TEST(test_updateKeyState_noKeysPressed);
     RUN_TEST(test_updateKeyState_singleKeyPressed);
     RUN_TEST(test_updateKeyState_multipleKeysPressed);
+    RUN_TEST(test_updateKeyState_bulkReadColumn);
+    RUN_TEST(test_updateKeyState_rowStraddlesWordBoundary);
+    RUN_TEST(test_scanPlan_columnMajor);
+    RUN_TEST(test_scanPlan_autoPicksFewerDriveLines);
+    RUN_TEST(test_debounce_deferredFiltersBouncingPress);
+    RUN_TEST(test_debounce_eagerReportsFirstEdge);
+    RUN_TEST(test_debounce_keysAcrossWordsAreIndependent);
+    RUN_TEST(test_changeBatch_oneCallbackPerChangedScan);
+    RUN_TEST(test_idle_drivesAllLinesAndArmsSenseLines);
+    RUN_TEST(test_idle_notEnteredWhileKeyHeld);
+    RUN_TEST(test_idle_wakeLatency);
+    RUN_TEST(test_idle_destructorDisarmsInterrupts);
 }
 
 #endif
\ No newline at end of file
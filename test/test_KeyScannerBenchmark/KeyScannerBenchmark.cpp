@@ -0,0 +1,23 @@
+#include <unity.h>
+#include "include/KeyScannerBenchmark.h"
+
+void setUp(void)
+{
+    gpio.resetCounters();
+}
+
+void tearDown(void) {}
+
+#ifndef UNITY_NATIVE
+void setup()
+{
+#else
+int main(int argc, char **argv)
+{
+#endif
+    UNITY_BEGIN();
+    run_KeyScannerBenchmark_tests();
+    UNITY_END();
+}
+
+void loop() {}
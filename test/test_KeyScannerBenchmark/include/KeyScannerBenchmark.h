@@ -0,0 +1,127 @@
+#ifndef KEYSCANNERBENCHMARK_H
+#define KEYSCANNERBENCHMARK_H
+
+#include <unity.h>
+#include <submodules/KeyScanner.h>
+#include <submodules/StaticKeyScanner.h>
+#include "../../FakeGpio.h"
+#include <chrono>
+#include <cstdio>
+
+static FakeGpio gpio;
+
+using ScanOrder = KeyScannerConfig::ScanOrder;
+
+static constexpr uint32_t BENCHMARK_SCANS = 2000;
+
+// Reference implementation of the scan loop before the scan plan existed:
+// every row resets all rows, then each column is read separately.
+static void legacyScan(IGpio &io, const uint8_t *rowPins, const uint8_t *colPins,
+                       uint8_t rowCount, uint8_t colCount)
+{
+    for (uint8_t row = 0; row < rowCount; row++)
+    {
+        for (uint8_t pinIndex = 0; pinIndex < rowCount; pinIndex++)
+            io.pinMode(rowPins[pinIndex], PinMode::InputPullup);
+        io.pinMode(rowPins[row], PinMode::Output);
+        io.digitalWrite(rowPins[row], PinState::Low);
+        for (uint8_t col = 0; col < colCount; col++)
+            io.digitalRead(colPins[col]);
+    }
+}
+
+struct ScanCost
+{
+    uint32_t opsPerScan;
+    double usPerScan;
+};
+
+static ScanCost measureLegacy(const uint8_t *rowPins, const uint8_t *colPins,
+                              uint8_t rowCount, uint8_t colCount)
+{
+    // Go through a volatile pointer so the virtual calls are not optimized
+    // away, matching the scanner which only sees the IGpio interface
+    IGpio *volatile io = &gpio;
+    gpio.resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_SCANS; i++)
+        legacyScan(*io, rowPins, colPins, rowCount, colCount);
+    auto end = std::chrono::steady_clock::now();
+    return {gpio.calls.total() / BENCHMARK_SCANS,
+            std::chrono::duration<double, std::micro>(end - start).count() / BENCHMARK_SCANS};
+}
+
+static ScanCost measurePlan(const uint8_t *rowPins, const uint8_t *colPins,
+                            uint8_t rowCount, uint8_t colCount, ScanOrder order)
+{
+    KeyScanner scanner(gpio, rowPins, colPins, rowCount, colCount, order);
+    gpio.resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_SCANS; i++)
+        scanner.updateKeyState();
+    auto end = std::chrono::steady_clock::now();
+    return {gpio.calls.total() / BENCHMARK_SCANS,
+            std::chrono::duration<double, std::micro>(end - start).count() / BENCHMARK_SCANS};
+}
+
+template <uint8_t Rows, uint8_t Cols>
+static ScanCost measureStatic(const uint8_t *rowPins, const uint8_t *colPins)
+{
+    StaticKeyScanner<Rows, Cols> scanner(gpio, rowPins, colPins);
+    gpio.resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_SCANS; i++)
+        scanner.updateKeyState();
+    auto end = std::chrono::steady_clock::now();
+    return {gpio.calls.total() / BENCHMARK_SCANS,
+            std::chrono::duration<double, std::micro>(end - start).count() / BENCHMARK_SCANS};
+}
+
+template <uint8_t rowCount, uint8_t colCount>
+static void benchmarkMatrix()
+{
+    uint8_t rowPins[32];
+    uint8_t colPins[32];
+    for (uint8_t i = 0; i < rowCount; i++)
+        rowPins[i] = i;
+    for (uint8_t i = 0; i < colCount; i++)
+        colPins[i] = 32 + i;
+
+    ScanCost legacy = measureLegacy(rowPins, colPins, rowCount, colCount);
+    ScanCost rowMajor = measurePlan(rowPins, colPins, rowCount, colCount, ScanOrder::RowMajor);
+    ScanCost autoOrder = measurePlan(rowPins, colPins, rowCount, colCount, ScanOrder::Auto);
+    ScanCost fixed = measureStatic<rowCount, colCount>(rowPins, colPins);
+
+    char message[192];
+    snprintf(message, sizeof(message),
+             "%2ux%-2u GPIO ops/scan: legacy %4u, plan %3u, auto plan %3u, static %3u | "
+             "us/scan: %.3f, %.3f, %.3f, %.3f",
+             rowCount, colCount, legacy.opsPerScan, rowMajor.opsPerScan, autoOrder.opsPerScan,
+             fixed.opsPerScan, legacy.usPerScan, rowMajor.usPerScan, autoOrder.usPerScan,
+             fixed.usPerScan);
+    TEST_MESSAGE(message);
+
+    // Two pin mode changes, one write and one bulk read per drive line
+    uint8_t driveLines = (colCount < rowCount) ? colCount : rowCount;
+    TEST_ASSERT_EQUAL(4 * rowCount, rowMajor.opsPerScan);
+    TEST_ASSERT_EQUAL(4 * driveLines, autoOrder.opsPerScan);
+    TEST_ASSERT_EQUAL(rowMajor.opsPerScan, fixed.opsPerScan);
+    TEST_ASSERT_TRUE(rowMajor.opsPerScan < legacy.opsPerScan);
+}
+
+void test_benchmark_2x2() { benchmarkMatrix<2, 2>(); }
+void test_benchmark_4x4() { benchmarkMatrix<4, 4>(); }
+void test_benchmark_6x18() { benchmarkMatrix<6, 18>(); }
+void test_benchmark_18x6() { benchmarkMatrix<18, 6>(); }
+void test_benchmark_8x20() { benchmarkMatrix<8, 20>(); }
+
+void run_KeyScannerBenchmark_tests()
+{
+    RUN_TEST(test_benchmark_2x2);
+    RUN_TEST(test_benchmark_4x4);
+    RUN_TEST(test_benchmark_6x18);
+    RUN_TEST(test_benchmark_18x6);
+    RUN_TEST(test_benchmark_8x20);
+}
+
+#endif
@@ -0,0 +1,403 @@
+#ifndef MATRIXSCANBENCHMARK_H
+#define MATRIXSCANBENCHMARK_H
+
+#include <unity.h>
+#include <submodules/KeyScanner.h>
+#include <submodules/ScanRateScheduler.h>
+#include "../../MatrixGpio.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <vector>
+
+using DebounceMode = KeyScannerConfig::DebounceMode;
+
+// Virtual time between two scans, 1 kHz scan rate
+static constexpr uint64_t SCAN_PERIOD_US = 1000;
+
+// Typing pattern: a key every 30 ms held for 60 ms, so two keys overlap, and
+// every edge bounces twice within 0.6 ms
+static constexpr uint32_t KEYSTROKES = 400;
+static constexpr uint64_t KEY_INTERVAL_US = 30000;
+static constexpr uint64_t KEY_HOLD_US = 60000;
+static constexpr uint8_t KEY_BOUNCES = 2;
+static constexpr uint64_t BOUNCE_INTERVAL_US = 150;
+
+struct MatrixRun
+{
+    uint32_t scans;
+    uint32_t events;
+    uint32_t gpioOps;
+    double wallUs;
+};
+
+static MatrixRun runMatrix(MatrixGpio &gpio, KeyScanner &scanner)
+{
+    uint32_t events = 0;
+    scanner.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *, size_t count, uint32_t) { events += count; });
+
+    MatrixRun run{};
+    gpio.resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t time = 0;
+    // Keep scanning a little past the script so the last release settles
+    uint32_t settleScans = 20;
+    while (!gpio.scriptDone() || settleScans-- > 0)
+    {
+        time += SCAN_PERIOD_US;
+        gpio.advanceTo(time);
+        scanner.updateKeyState();
+        run.scans++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    run.events = events;
+    run.gpioOps = gpio.calls.total();
+    run.wallUs = std::chrono::duration<double, std::micro>(end - start).count();
+    return run;
+}
+
+static MatrixRun benchmarkTyping(uint8_t rowCount, uint8_t colCount, bool ghostFilter = false)
+{
+    uint8_t rowPins[32];
+    uint8_t colPins[32];
+    for (uint8_t i = 0; i < rowCount; i++)
+        rowPins[i] = i;
+    for (uint8_t i = 0; i < colCount; i++)
+        colPins[i] = 32 + i;
+
+    MatrixGpio gpio(rowPins, rowCount, colPins, colCount);
+    uint16_t keyCount = rowCount * colCount;
+    for (uint32_t i = 0; i < KEYSTROKES; i++)
+    {
+        // Walk the matrix with a stride coprime to the key count
+        uint16_t key = (i * 7 + 3) % keyCount;
+        gpio.press(SCAN_PERIOD_US / 2 + i * KEY_INTERVAL_US, key / colCount, key % colCount,
+                   KEY_HOLD_US, KEY_BOUNCES, BOUNCE_INTERVAL_US);
+    }
+
+    KeyScanner scanner(gpio, rowPins, colPins, rowCount, colCount);
+    scanner.setDebounce(DebounceMode::Deferred, 5);
+    scanner.setGhostFilter(ghostFilter);
+    MatrixRun run = runMatrix(gpio, scanner);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%2ux%-2u%s %7.0f scans/s, %.4f events/scan, %u GPIO ops/scan, %.3f us/scan",
+             rowCount, colCount, ghostFilter ? " ghost filter" : "",
+             run.scans * 1e6 / run.wallUs,
+             static_cast<double>(run.events) / run.scans, run.gpioOps / run.scans,
+             run.wallUs / run.scans);
+    TEST_MESSAGE(message);
+
+    // Debouncing turns every bouncing keystroke into exactly one press and
+    // one release, and every drive line costs four GPIO operations
+    TEST_ASSERT_EQUAL_UINT32(2 * gpio.getKeystrokes(), run.events);
+    TEST_ASSERT_EQUAL_UINT32(4 * rowCount, run.gpioOps / run.scans);
+    TEST_ASSERT_FALSE(scanner.hasPressedKeys());
+    return run;
+}
+
+void test_matrix_4x4() { benchmarkTyping(4, 4); }
+void test_matrix_8x8() { benchmarkTyping(8, 8); }
+void test_matrix_12x12() { benchmarkTyping(12, 12); }
+void test_matrix_16x16() { benchmarkTyping(16, 16); }
+void test_matrix_32x32() { benchmarkTyping(32, 32); }
+
+void test_matrix_ghostFilterOverhead()
+{
+    // Typing never holds a rectangle, the filter must not change the result
+    // and only costs the row extraction and pair checks
+    const uint8_t sizes[] = {8, 16};
+    for (uint8_t size : sizes)
+    {
+        MatrixRun plain = benchmarkTyping(size, size);
+        MatrixRun filtered = benchmarkTyping(size, size, true);
+        char message[96];
+        snprintf(message, sizeof(message), "%2ux%-2u ghost filter overhead %+.3f us/scan",
+                 size, size, filtered.wallUs / filtered.scans - plain.wallUs / plain.scans);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL_UINT32(plain.events, filtered.events);
+    }
+}
+
+void test_matrix_ghostFilterMasksGhostUntilCleared()
+{
+    uint8_t rowPins[4] = {0, 1, 2, 3};
+    uint8_t colPins[4] = {20, 21, 22, 23};
+    MatrixGpio gpio(rowPins, 4, colPins, 4, false);
+    KeyScanner scanner(gpio, rowPins, colPins, 4, 4);
+    scanner.setDebounce(DebounceMode::None, 0);
+    scanner.setGhostFilter(true);
+
+    auto readKeys = [&]()
+    {
+        uint8_t state[2];
+        scanner.copyPublishedBitmap(state, sizeof(state));
+        return static_cast<uint16_t>(state[0] | (state[1] << 8));
+    };
+    const uint16_t corner00 = 1 << 0, corner03 = 1 << 3, corner20 = 1 << 8;
+
+    gpio.setKey(0, 0, true);
+    gpio.setKey(0, 3, true);
+    scanner.updateKeyState();
+    TEST_ASSERT_EQUAL_HEX16(corner00 | corner03, readKeys());
+
+    // The third corner makes (2, 3) read as pressed, both new keys are held back
+    gpio.setKey(2, 0, true);
+    scanner.updateKeyState();
+    TEST_ASSERT_EQUAL_HEX16(corner00 | corner03, readKeys());
+
+    // Releasing a corner clears the rectangle, the real key comes through
+    gpio.setKey(0, 3, false);
+    scanner.updateKeyState();
+    TEST_ASSERT_EQUAL_HEX16(corner00 | corner20, readKeys());
+}
+
+void test_matrix_1024KeysReportsHighIndexes()
+{
+    uint8_t rowPins[32];
+    uint8_t colPins[32];
+    for (uint8_t i = 0; i < 32; i++)
+    {
+        rowPins[i] = i;
+        colPins[i] = 32 + i;
+    }
+    MatrixGpio gpio(rowPins, 32, colPins, 32);
+    KeyScanner scanner(gpio, rowPins, colPins, 32, 32);
+    scanner.setDebounce(DebounceMode::None, 0);
+    TEST_ASSERT_EQUAL(128, scanner.getBitMapSize());
+
+    std::vector<uint16_t> pressed;
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool isPressed)
+                                        { if (isPressed) pressed.push_back(keyIndex); });
+    gpio.setKey(8, 0, true);
+    gpio.setKey(31, 31, true);
+    scanner.updateKeyState();
+
+    TEST_ASSERT_EQUAL(2, pressed.size());
+    TEST_ASSERT_EQUAL(256, pressed[0]);
+    TEST_ASSERT_EQUAL(1023, pressed[1]);
+
+    uint8_t state[128] = {};
+    scanner.copyPublishedBitmap(state, sizeof(state));
+    TEST_ASSERT_EQUAL_HEX8(0x01, state[256 / 8]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, state[1023 / 8]);
+}
+
+void test_matrix_bounceWithoutDebounceReportsEveryEdge()
+{
+    uint8_t rowPins[4] = {0, 1, 2, 3};
+    uint8_t colPins[4] = {20, 21, 22, 23};
+    MatrixGpio gpio(rowPins, 4, colPins, 4);
+
+    // Bounce flips slower than the scan rate are all sampled
+    gpio.press(500, 1, 2, 20000, 2, SCAN_PERIOD_US);
+
+    KeyScanner scanner(gpio, rowPins, colPins, 4, 4);
+    scanner.setDebounce(DebounceMode::None, 0);
+    MatrixRun run = runMatrix(gpio, scanner);
+    TEST_ASSERT_EQUAL_UINT32(2 * 5, run.events);
+}
+
+void test_matrix_ghostRectangleWithoutDiodes()
+{
+    uint8_t rowPins[4] = {0, 1, 2, 3};
+    uint8_t colPins[4] = {20, 21, 22, 23};
+
+    // Three corners held: the fourth reads as pressed only without diodes
+    const bool diodeOptions[] = {true, false};
+    for (bool diodes : diodeOptions)
+    {
+        MatrixGpio gpio(rowPins, 4, colPins, 4, diodes);
+        KeyScanner scanner(gpio, rowPins, colPins, 4, 4);
+        scanner.setDebounce(DebounceMode::None, 0);
+        gpio.ghostRectangle(0, 0, 0, 2, 3, 50000);
+        gpio.advanceTo(1);
+        scanner.updateKeyState();
+
+        uint8_t state[2];
+        scanner.copyPublishedBitmap(state, sizeof(state));
+        uint16_t keys = state[0] | (state[1] << 8);
+        uint16_t corners = (1 << 0) | (1 << 3) | (1 << 8);
+        uint16_t ghost = 1 << 11;
+        TEST_ASSERT_EQUAL_HEX16(diodes ? corners : (corners | ghost), keys);
+    }
+}
+
+void test_matrix_heldKeyRescanDrivesHeldRowsOnly()
+{
+    uint8_t rowPins[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t colPins[8] = {20, 21, 22, 23, 24, 25, 26, 27};
+    MatrixGpio gpio(rowPins, 8, colPins, 8);
+    KeyScanner scanner(gpio, rowPins, colPins, 8, 8);
+    scanner.setDebounce(DebounceMode::None, 0);
+
+    std::vector<KeyScanner::KeyChange> changes;
+    scanner.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *batch, size_t count, uint32_t)
+        { changes.assign(batch, batch + count); });
+
+    gpio.setKey(2, 3, true);
+    gpio.setKey(5, 1, true);
+    TEST_ASSERT_EQUAL(2, scanner.updateKeyState());
+
+    // Two rows driven and read, the last one released again for the next full scan
+    gpio.resetCounters();
+    TEST_ASSERT_EQUAL(0, scanner.updateHeldKeyState());
+    TEST_ASSERT_EQUAL(2, gpio.calls.readPins);
+    TEST_ASSERT_EQUAL(2 * 4 + 1, gpio.calls.total());
+
+    // A press on a row without held keys waits for the next full scan, a
+    // release on a held row does not
+    gpio.setKey(6, 6, true);
+    gpio.setKey(2, 3, false);
+    TEST_ASSERT_EQUAL(1, scanner.updateHeldKeyState());
+    TEST_ASSERT_EQUAL(2 * 8 + 3, changes[0].keyIndex);
+    TEST_ASSERT_FALSE(changes[0].pressed);
+    TEST_ASSERT_TRUE(scanner.sawKeyActivity());
+
+    TEST_ASSERT_EQUAL(1, scanner.updateKeyState());
+    TEST_ASSERT_EQUAL(6 * 8 + 6, changes[0].keyIndex);
+    TEST_ASSERT_TRUE(changes[0].pressed);
+    TEST_ASSERT_EQUAL(0, scanner.updateKeyState());
+    TEST_ASSERT_FALSE(scanner.sawKeyActivity());
+}
+
+struct AdaptiveRun
+{
+    uint32_t scans;
+    uint32_t events;
+    uint32_t gpioOps;
+    uint64_t maxLatencyUs;
+    uint64_t durationUs;
+    float averageRateHz;
+};
+
+// Scan on the ticks of the scheduler in virtual time and measure how long
+// after its scripted edge every change is reported
+static AdaptiveRun runScheduled(MatrixGpio &gpio, KeyScanner &scanner,
+                                ScanRateScheduler &scheduler,
+                                std::vector<std::deque<uint64_t>> &edgeTimes)
+{
+    AdaptiveRun run{};
+    uint64_t time = 0;
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool pressed)
+                                        {
+                                            run.events++;
+                                            std::deque<uint64_t> &edges = edgeTimes[keyIndex];
+                                            TEST_ASSERT_FALSE(edges.empty());
+                                            run.maxLatencyUs = std::max(run.maxLatencyUs, time - edges.front());
+                                            edges.pop_front();
+                                        });
+
+    gpio.resetCounters();
+    scheduler.reset(0);
+    uint32_t settleScans = 20;
+    while (!gpio.scriptDone() || settleScans-- > 0)
+    {
+        time += scheduler.getTickPeriodUs();
+        gpio.advanceTo(time);
+        if (scheduler.nextScan() == ScanRateScheduler::ScanKind::Full)
+            scanner.updateKeyState();
+        else
+            scanner.updateHeldKeyState();
+        scheduler.update(time, scanner.sawKeyActivity(), scanner.hasPressedKeys());
+        run.scans++;
+    }
+    run.gpioOps = gpio.calls.total();
+    run.durationUs = time;
+    run.averageRateHz = scheduler.getAverageRateHz(time);
+    return run;
+}
+
+static AdaptiveRun benchmarkBursts(uint16_t idleRateHz, uint16_t heldKeyRateHz)
+{
+    uint8_t rowPins[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t colPins[8] = {20, 21, 22, 23, 24, 25, 26, 27};
+    MatrixGpio gpio(rowPins, 8, colPins, 8);
+
+    // Five bursts of 20 keystrokes 3 s apart, a modifier on the last row is
+    // held for 600 ms in every other pause
+    const uint64_t burstUs = 20 * KEY_INTERVAL_US;
+    const uint64_t pauseUs = 3000000;
+    std::vector<std::deque<uint64_t>> edgeTimes(64);
+    for (uint32_t burst = 0; burst < 5; burst++)
+    {
+        uint64_t burstStart = SCAN_PERIOD_US / 2 + burst * (burstUs + pauseUs);
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            uint16_t key = (i * 7 + 3) % 56;
+            uint64_t pressUs = burstStart + i * KEY_INTERVAL_US;
+            gpio.press(pressUs, key / 8, key % 8, KEY_HOLD_US, KEY_BOUNCES, BOUNCE_INTERVAL_US);
+            edgeTimes[key].push_back(pressUs);
+            edgeTimes[key].push_back(pressUs + KEY_HOLD_US);
+        }
+        if (burst % 2 == 1)
+        {
+            uint64_t pressUs = burstStart + burstUs + 200000;
+            gpio.press(pressUs, 7, 0, 600000, KEY_BOUNCES, BOUNCE_INTERVAL_US);
+            edgeTimes[56].push_back(pressUs);
+            edgeTimes[56].push_back(pressUs + 600000);
+        }
+    }
+    // Edges of one key were scripted out of order where presses overlap
+    for (std::deque<uint64_t> &edges : edgeTimes)
+        std::sort(edges.begin(), edges.end());
+
+    KeyScanner scanner(gpio, rowPins, colPins, 8, 8);
+    scanner.setDebounce(DebounceMode::Deferred, 5);
+    ScanRateScheduler scheduler(1000, idleRateHz, heldKeyRateHz, 100);
+    AdaptiveRun run = runScheduled(gpio, scanner, scheduler, edgeTimes);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "idle %4u Hz held %3u Hz: %5u scans, avg %6.1f Hz, %5u GPIO ops/s, max latency %5.2f ms",
+             idleRateHz, heldKeyRateHz, run.scans, run.averageRateHz,
+             static_cast<uint32_t>(run.gpioOps * 1e6 / run.durationUs),
+             run.maxLatencyUs / 1000.0);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * gpio.getKeystrokes(), run.events);
+    TEST_ASSERT_FALSE(scanner.hasPressedKeys());
+    return run;
+}
+
+void test_matrix_adaptiveRateBursts()
+{
+    AdaptiveRun fixed = benchmarkBursts(0, 0);
+    AdaptiveRun adaptive = benchmarkBursts(100, 0);
+    AdaptiveRun held = benchmarkBursts(100, 500);
+
+    // Pauses scan at a tenth of the rate, typing keeps the full rate
+    TEST_ASSERT_LESS_THAN_UINT32(fixed.scans / 2, adaptive.scans);
+    TEST_ASSERT_LESS_THAN_UINT32(fixed.gpioOps / 2, held.gpioOps);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 1000.0f, fixed.averageRateHz);
+    TEST_ASSERT_TRUE(adaptive.averageRateHz < fixed.averageRateHz / 2);
+
+    // Debouncing takes 5 scans at the full rate, a change seen from idle
+    // waits up to one idle period before that
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(6 * SCAN_PERIOD_US, fixed.maxLatencyUs);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(10000 + 6 * SCAN_PERIOD_US, adaptive.maxLatencyUs);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(10000 + 6 * SCAN_PERIOD_US, held.maxLatencyUs);
+}
+
+void run_MatrixScanBenchmark_tests()
+{
+    RUN_TEST(test_matrix_bounceWithoutDebounceReportsEveryEdge);
+    RUN_TEST(test_matrix_ghostRectangleWithoutDiodes);
+    RUN_TEST(test_matrix_4x4);
+    RUN_TEST(test_matrix_8x8);
+    RUN_TEST(test_matrix_12x12);
+    RUN_TEST(test_matrix_16x16);
+    RUN_TEST(test_matrix_32x32);
+    RUN_TEST(test_matrix_ghostFilterOverhead);
+    RUN_TEST(test_matrix_ghostFilterMasksGhostUntilCleared);
+    RUN_TEST(test_matrix_1024KeysReportsHighIndexes);
+    RUN_TEST(test_matrix_heldKeyRescanDrivesHeldRowsOnly);
+    RUN_TEST(test_matrix_adaptiveRateBursts);
+}
+
+#endif
@@ -0,0 +1,271 @@
+#ifndef MULTIMATRIXBENCHMARK_H
+#define MULTIMATRIXBENCHMARK_H
+
+#include "../../DirectPinGpio.h"
+#include "../../MatrixGpio.h"
+#include "../../ShiftRegisterGpio.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <submodules/KeyScannerFactory.h>
+#include <submodules/ScanDeadlineScheduler.h>
+#include <unity.h>
+#include <vector>
+
+using DebounceMode = KeyScannerConfig::DebounceMode;
+using ScanMatrix = KeyScannerConfig::ScanMatrix;
+using ScanTopology = KeyScannerConfig::ScanTopology;
+
+// Scans run in virtual time, every GPIO operation takes this long
+static constexpr uint64_t GPIO_OP_US = 1;
+static constexpr uint32_t GUARD_US = 20;
+
+// Typing on the main matrix, a key every 30 ms held for 60 ms, and on the
+// macro cluster, a key every 100 ms held for 80 ms, edges bounce twice
+static constexpr uint32_t MAIN_KEYSTROKES = 100;
+static constexpr uint32_t MACRO_KEYSTROKES = 30;
+static constexpr uint8_t KEY_BOUNCES = 2;
+static constexpr uint64_t BOUNCE_INTERVAL_US = 150;
+static constexpr uint64_t SETTLE_US = 50000;
+
+// How the benchmark picks the next matrix: through the deadline scheduler,
+// or the first due one in list order without looking at the time left
+enum class SchedulePolicy
+{
+    Deadline,
+    FirstDue
+};
+
+struct JitterRun
+{
+    uint32_t mainScans;
+    uint32_t mainMaxJitterUs;
+    uint64_t mainTotalJitterUs;
+    uint32_t extraMaxJitterUs;
+    uint32_t missedDeadlines;
+    uint32_t events[KeyScannerConfig::MAX_MATRIX_COUNT];
+};
+
+// Main 8x8 matrix at 1 kHz with up to three more matrices of the config,
+// each on its own simulated GPIO
+class MultiMatrixRig
+{
+public:
+    explicit MultiMatrixRig(size_t matrixCount)
+        : mainGpio(mainRows, 8, mainCols, 8), macroGpio(macroRows, 4, macroCols, 4),
+          shiftGpio(10, 11, 12, 4), directGpio(directPins, 8)
+    {
+        config.setPins(mainRows, 8, mainCols, 8);
+        config.setRefreshRate(1000);
+
+        // Rates that do not divide the main rate put their deadlines
+        // anywhere between two main scans
+        ScanMatrix macro;
+        macro.rowPins.assign(macroRows, macroRows + 4);
+        macro.colPins.assign(macroCols, macroCols + 4);
+        macro.refreshRate = 750;
+        ScanMatrix shift;
+        shift.topology = ScanTopology::ShiftRegister;
+        shift.rowPins = {10, 11};
+        shift.colPins = {12};
+        shift.shiftRegisterCount = 4;
+        shift.refreshRate = 333;
+        ScanMatrix direct;
+        direct.topology = ScanTopology::DirectPins;
+        direct.colPins.assign(directPins, directPins + 8);
+        direct.refreshRate = 400;
+
+        const ScanMatrix extras[] = {macro, shift, direct};
+        for (size_t i = 0; i + 1 < matrixCount; i++)
+            config.addMatrix(extras[i]);
+
+        IGpio *gpios[] = {&mainGpio, &macroGpio, &shiftGpio, &directGpio};
+        for (size_t m = 0; m < config.getMatrixCount(); m++)
+        {
+            matrices.push_back(config.getMatrix(m));
+            scanners.push_back(KeyScannerFactory::create(*gpios[m], matrices.back()));
+        }
+        gpioOps = {[this] { return mainGpio.calls.total(); },
+                   [this] { return macroGpio.calls.total(); },
+                   [this] { return shiftGpio.calls.total(); },
+                   [this] { return directGpio.calls.total(); }};
+
+        for (uint32_t i = 0; i < MAIN_KEYSTROKES; i++)
+        {
+            uint16_t key = (i * 7 + 3) % 64;
+            mainGpio.press(500 + i * 30000, key / 8, key % 8, 60000, KEY_BOUNCES, BOUNCE_INTERVAL_US);
+        }
+        for (uint32_t i = 0; i < MACRO_KEYSTROKES; i++)
+        {
+            uint16_t key = (i * 5 + 1) % 16;
+            macroGpio.press(700 + i * 100000, key / 4, key % 4, 80000, KEY_BOUNCES, BOUNCE_INTERVAL_US);
+        }
+    }
+
+    JitterRun run(SchedulePolicy policy)
+    {
+        JitterRun result{};
+        const size_t count = scanners.size();
+        ScanDeadlineScheduler deadlines(GUARD_US);
+        std::vector<uint32_t> periods;
+        for (size_t m = 0; m < count; m++)
+        {
+            periods.push_back(1000000 / matrices[m].refreshRate);
+            deadlines.addSource(periods.back());
+
+            // Debounce over 5 ms at the rate of the matrix, like the scan task
+            scanners[m]->setDebounce(DebounceMode::Deferred, (5 * matrices[m].refreshRate + 999) / 1000);
+            uint16_t keyOffset = config.getKeyOffset(m);
+            uint16_t keyEnd = keyOffset + matrices[m].getKeyCount();
+            uint32_t &events = result.events[m];
+            scanners[m]->registerOnKeyChangeBatchCallback(
+                [&events, keyOffset, keyEnd](const IKeyScanner::KeyChange *changes, size_t n, uint32_t)
+                {
+                    for (size_t i = 0; i < n; i++)
+                        TEST_ASSERT_TRUE(keyOffset + changes[i].keyIndex < keyEnd);
+                    events += n;
+                });
+        }
+
+        // FirstDue keeps its own copy of the deadlines, the scheduler still
+        // does the bookkeeping of both
+        std::vector<uint64_t> firstDueDeadlines(count, 0);
+        uint64_t now = 0;
+        deadlines.reset(now);
+        while (!mainGpio.scriptDone() || !macroGpio.scriptDone() || now < lastEventUs() + SETTLE_US)
+        {
+            size_t source = ScanDeadlineScheduler::NONE;
+            if (policy == SchedulePolicy::Deadline)
+                source = deadlines.nextDue(now);
+            else
+                for (size_t m = 0; m < count && source == ScanDeadlineScheduler::NONE; m++)
+                    if (firstDueDeadlines[m] <= now)
+                        source = m;
+
+            if (source == ScanDeadlineScheduler::NONE)
+            {
+                // Sleep until the next deadline
+                now = policy == SchedulePolicy::Deadline
+                          ? deadlines.getNextWakeUs(now)
+                          : *std::min_element(firstDueDeadlines.begin(), firstDueDeadlines.end());
+                continue;
+            }
+
+            mainGpio.advanceTo(now);
+            macroGpio.advanceTo(now);
+            uint64_t start = now;
+            uint32_t opsBefore = gpioOps[source]();
+            scanners[source]->updateKeyState();
+            now += (gpioOps[source]() - opsBefore) * GPIO_OP_US;
+
+            ScanDeadlineScheduler::Completion completion = deadlines.complete(source, start, now);
+            uint64_t &deadline = firstDueDeadlines[source];
+            deadline += (start - deadline) / periods[source] * periods[source] + periods[source];
+            result.missedDeadlines += completion.missedDeadlines;
+            if (source == 0)
+            {
+                result.mainScans++;
+                result.mainMaxJitterUs = std::max(result.mainMaxJitterUs, completion.jitterUs);
+                result.mainTotalJitterUs += completion.jitterUs;
+            }
+            else
+            {
+                result.extraMaxJitterUs = std::max(result.extraMaxJitterUs, completion.jitterUs);
+            }
+        }
+
+        // Every matrix reported each keystroke once, pressed and released
+        TEST_ASSERT_EQUAL_UINT32(2 * MAIN_KEYSTROKES, result.events[0]);
+        if (count > 1)
+            TEST_ASSERT_EQUAL_UINT32(2 * MACRO_KEYSTROKES, result.events[1]);
+        for (size_t m = 0; m < count; m++)
+            TEST_ASSERT_FALSE(scanners[m]->hasPressedKeys());
+        return result;
+    }
+
+    const KeyScannerConfig &getConfig() const { return config; }
+
+private:
+    uint8_t mainRows[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t mainCols[8] = {20, 21, 22, 23, 24, 25, 26, 27};
+    uint8_t macroRows[4] = {30, 31, 32, 33};
+    uint8_t macroCols[4] = {34, 35, 36, 37};
+    uint8_t directPins[8] = {40, 41, 42, 43, 44, 45, 46, 47};
+
+    MatrixGpio mainGpio;
+    MatrixGpio macroGpio;
+    ShiftRegisterGpio shiftGpio;
+    DirectPinGpio directGpio;
+
+    KeyScannerConfig config;
+    std::vector<ScanMatrix> matrices;
+    std::vector<std::unique_ptr<IKeyScanner>> scanners;
+    std::vector<std::function<uint32_t()>> gpioOps;
+
+    uint64_t lastEventUs() const
+    {
+        return std::max<uint64_t>(500 + MAIN_KEYSTROKES * 30000 + 60000,
+                                  700 + MACRO_KEYSTROKES * 100000 + 80000);
+    }
+};
+
+static JitterRun benchmarkMatrices(size_t matrixCount, SchedulePolicy policy)
+{
+    MultiMatrixRig rig(matrixCount);
+    TEST_ASSERT_EQUAL(matrixCount, rig.getConfig().getMatrixCount());
+    JitterRun run = rig.run(policy);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%zu matrices, %-9s main jitter max %3u us avg %6.2f us, others max %4u us, missed %u",
+             matrixCount, policy == SchedulePolicy::Deadline ? "deadline" : "first due",
+             run.mainMaxJitterUs, static_cast<double>(run.mainTotalJitterUs) / run.mainScans,
+             run.extraMaxJitterUs, run.missedDeadlines);
+    TEST_MESSAGE(message);
+    return run;
+}
+
+void test_multiMatrix_extraMatricesKeepMainJitter()
+{
+    JitterRun alone = benchmarkMatrices(1, SchedulePolicy::Deadline);
+    for (size_t matrixCount = 2; matrixCount <= 4; matrixCount++)
+    {
+        JitterRun shared = benchmarkMatrices(matrixCount, SchedulePolicy::Deadline);
+        TEST_ASSERT_EQUAL_UINT32(alone.mainScans, shared.mainScans);
+        TEST_ASSERT_EQUAL_UINT32(alone.mainMaxJitterUs, shared.mainMaxJitterUs);
+        TEST_ASSERT_EQUAL_UINT64(alone.mainTotalJitterUs, shared.mainTotalJitterUs);
+        TEST_ASSERT_EQUAL_UINT32(0, shared.missedDeadlines);
+    }
+}
+
+void test_multiMatrix_firstDueDelaysMainMatrix()
+{
+    // Without the fit check a long shift register scan started just before a
+    // main deadline pushes the main scan back
+    JitterRun firstDue = benchmarkMatrices(4, SchedulePolicy::FirstDue);
+    JitterRun deadline = benchmarkMatrices(4, SchedulePolicy::Deadline);
+    TEST_ASSERT_TRUE(firstDue.mainMaxJitterUs > deadline.mainMaxJitterUs);
+}
+
+void test_multiMatrix_keyRangesFollowMainMatrix()
+{
+    MultiMatrixRig rig(4);
+    const KeyScannerConfig &config = rig.getConfig();
+    TEST_ASSERT_EQUAL(0, config.getKeyOffset(0));
+    TEST_ASSERT_EQUAL(64, config.getKeyOffset(1));
+    // 16 macro keys, then the 32 keys of the shift registers
+    TEST_ASSERT_EQUAL(80, config.getKeyOffset(2));
+    TEST_ASSERT_EQUAL(112, config.getKeyOffset(3));
+    TEST_ASSERT_EQUAL(120, config.getKeyCount());
+    TEST_ASSERT_EQUAL(15, config.getBitmapSize());
+}
+
+void run_MultiMatrixBenchmark_tests()
+{
+    RUN_TEST(test_multiMatrix_extraMatricesKeepMainJitter);
+    RUN_TEST(test_multiMatrix_firstDueDelaysMainMatrix);
+    RUN_TEST(test_multiMatrix_keyRangesFollowMainMatrix);
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef PAYLOADPOOLTEST_H
+#define PAYLOADPOOLTEST_H
+
+#include <cstring>
+#include <submodules/PayloadPool.h>
+#include <submodules/ScanTimingStats.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+using FallbackPolicy = PayloadPool::FallbackPolicy;
+
+void test_PayloadPool_releasedBlocksAreReused()
+{
+    PayloadPool pool(12, 3, FallbackPolicy::Drop);
+    void *first = pool.allocate(12);
+    void *second = pool.allocate(5);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_TRUE(first != second);
+    TEST_ASSERT_TRUE(pool.owns(first));
+    TEST_ASSERT_TRUE(pool.owns(second));
+
+    // Blocks are rounded up to 8 bytes and aligned for 64-bit payloads
+    PayloadPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT16(16, stats.blockSize);
+    TEST_ASSERT_EQUAL_UINT16(3, stats.blockCount);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.inUse);
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(second) % 8);
+
+    pool.release(first);
+    TEST_ASSERT_TRUE(pool.allocate(12) == first);
+    pool.release(first);
+    pool.release(second);
+    pool.release(nullptr);
+
+    stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT16(0, stats.inUse);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.highWater);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.exhausted);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.fallbacks);
+}
+
+void test_PayloadPool_emptyPoolFollowsFallbackPolicy()
+{
+    PayloadPool dropping(8, 2, FallbackPolicy::Drop);
+    void *a = dropping.allocate(8);
+    void *b = dropping.allocate(8);
+    TEST_ASSERT_NULL(dropping.allocate(8));
+    PayloadPool::Stats stats = dropping.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.exhausted);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.fallbacks);
+    dropping.release(a);
+    dropping.release(b);
+
+    PayloadPool heap(8, 1, FallbackPolicy::Heap);
+    void *pooled = heap.allocate(8);
+    void *fallback = heap.allocate(8);
+    TEST_ASSERT_NOT_NULL(fallback);
+    TEST_ASSERT_FALSE(heap.owns(fallback));
+    memset(fallback, 0x5A, 8);
+    heap.release(fallback);
+    heap.release(pooled);
+    stats = heap.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.exhausted);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fallbacks);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.inUse);
+}
+
+void test_PayloadPool_oversizedPayloadComesFromHeap()
+{
+    // Even a dropping pool serves payloads its blocks cannot hold
+    PayloadPool pool(8, 4, FallbackPolicy::Drop);
+    void *large = pool.allocate(100);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_FALSE(pool.owns(large));
+    memset(large, 0, 100);
+    pool.release(large);
+
+    PayloadPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fallbacks);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.exhausted);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.highWater);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.heapInUse);
+}
+
+void test_PayloadPool_sharedBlockReturnsWithLastReference()
+{
+    PayloadPool pool(8, 1, FallbackPolicy::Heap);
+    void *pooled = pool.allocate(8);
+    void *heap = pool.allocate(8);
+    pool.retain(pooled);
+    pool.retain(heap);
+    pool.retain(heap);
+
+    pool.release(pooled);
+    pool.release(heap);
+    pool.release(heap);
+    PayloadPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT16(1, stats.inUse);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.heapInUse);
+
+    pool.release(pooled);
+    pool.release(heap);
+    stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT16(0, stats.inUse);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.heapInUse);
+    TEST_ASSERT_TRUE(pool.allocate(8) == pooled);
+    pool.release(pooled);
+}
+
+void test_PayloadPool_eventCleanupReturnsBlock()
+{
+    PayloadPool &bitmaps = PayloadPool::forType(EventType::RawBitmap);
+    PayloadPool &stats = PayloadPool::forType(EventType::ScanStats);
+    uint16_t bitmapsInUse = bitmaps.getStats().inUse;
+    uint16_t statsInUse = stats.getStats().inUse;
+
+    // A bitmap too large to travel inline spills to the pool
+    uint8_t bitmap[INLINE_BITMAP_SIZE + 8] = {};
+    Event event{};
+    event.type = EventType::RawBitmap;
+    TEST_ASSERT_TRUE(event.rawBitmapEvt.assign(EventType::RawBitmap, bitmap, sizeof(bitmap)));
+    event.cleanup = cleanupRawBitmapEvent;
+    TEST_ASSERT_TRUE(bitmaps.owns(event.rawBitmapEvt.data()));
+    TEST_ASSERT_EQUAL_UINT16(bitmapsInUse + 1, bitmaps.getStats().inUse);
+    event.cleanup(&event);
+    TEST_ASSERT_EQUAL_UINT16(bitmapsInUse, bitmaps.getStats().inUse);
+
+    event.type = EventType::ScanStats;
+    event.scanStatsEvt.stats =
+        static_cast<ScanTimingSnapshot *>(stats.allocate(sizeof(ScanTimingSnapshot)));
+    event.cleanup = cleanupScanStatsEvent;
+    TEST_ASSERT_TRUE(stats.owns(event.scanStatsEvt.stats));
+    event.cleanup(&event);
+    TEST_ASSERT_EQUAL_UINT16(statsInUse, stats.getStats().inUse);
+}
+
+void test_PayloadPool_inlineBitmapTravelsWithEvent()
+{
+    PayloadPool &bitmaps = PayloadPool::forType(EventType::RawBitmap);
+    uint16_t inUse = bitmaps.getStats().inUse;
+
+    uint8_t bitmap[INLINE_BITMAP_SIZE];
+    for (size_t i = 0; i < sizeof(bitmap); i++)
+        bitmap[i] = static_cast<uint8_t>(i * 7 + 3);
+    Event event{};
+    event.type = EventType::RawBitmap;
+    event.cleanup = cleanupRawBitmapEvent;
+    TEST_ASSERT_TRUE(event.rawBitmapEvt.assign(EventType::RawBitmap, bitmap, sizeof(bitmap)));
+    TEST_ASSERT_TRUE(event.rawBitmapEvt.isInline());
+    TEST_ASSERT_EQUAL_UINT16(inUse, bitmaps.getStats().inUse);
+
+    // A queue copies the bytes of the event, the bitmap goes along
+    Event received;
+    memcpy(&received, &event, sizeof(Event));
+    memset(&event, 0, sizeof(Event));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(bitmap), received.rawBitmapEvt.bitmapSize);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bitmap, received.rawBitmapEvt.data(), sizeof(bitmap));
+    received.cleanup(&received);
+    TEST_ASSERT_EQUAL_UINT16(inUse, bitmaps.getStats().inUse);
+}
+
+void test_PayloadPool_concurrentTasksNeverShareBlock()
+{
+#ifdef UNITY_NATIVE
+    // Every thread stamps the blocks it holds and checks the stamp before
+    // releasing, a block handed out twice gets overwritten
+    static constexpr int THREADS = 4;
+    static constexpr int ROUNDS = 100000;
+    static constexpr size_t HELD = 3;
+
+    PayloadPool pool(16, 8, FallbackPolicy::Drop);
+    std::atomic<uint32_t> corrupted{0};
+    std::atomic<uint32_t> refused{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 for (int round = 0; round < ROUNDS; round++)
+                                 {
+                                     uint32_t *held[HELD] = {};
+                                     for (size_t i = 0; i < HELD; i++)
+                                     {
+                                         held[i] = static_cast<uint32_t *>(pool.allocate(16));
+                                         if (held[i] == nullptr)
+                                         {
+                                             refused++;
+                                             continue;
+                                         }
+                                         for (size_t w = 0; w < 4; w++)
+                                             held[i][w] = (t << 24) | round;
+                                     }
+                                     for (size_t i = 0; i < HELD; i++)
+                                     {
+                                         if (held[i] == nullptr)
+                                             continue;
+                                         for (size_t w = 0; w < 4; w++)
+                                             if (held[i][w] != static_cast<uint32_t>((t << 24) | round))
+                                                 corrupted++;
+                                         pool.release(held[i]);
+                                     }
+                                 }
+                             });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    PayloadPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL_UINT32(0, corrupted.load());
+    TEST_ASSERT_EQUAL_UINT16(0, stats.inUse);
+    TEST_ASSERT_TRUE(stats.highWater <= 8);
+    TEST_ASSERT_EQUAL_UINT32(refused.load(), stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(stats.exhausted, stats.dropped);
+
+    // Every block is still on the free list
+    void *blocks[8];
+    for (void *&block : blocks)
+        TEST_ASSERT_NOT_NULL(block = pool.allocate(16));
+    TEST_ASSERT_NULL(pool.allocate(16));
+#endif
+}
+
+void run_PayloadPool_tests()
+{
+    RUN_TEST(test_PayloadPool_releasedBlocksAreReused);
+    RUN_TEST(test_PayloadPool_emptyPoolFollowsFallbackPolicy);
+    RUN_TEST(test_PayloadPool_oversizedPayloadComesFromHeap);
+    RUN_TEST(test_PayloadPool_sharedBlockReturnsWithLastReference);
+    RUN_TEST(test_PayloadPool_eventCleanupReturnsBlock);
+    RUN_TEST(test_PayloadPool_inlineBitmapTravelsWithEvent);
+    RUN_TEST(test_PayloadPool_concurrentTasksNeverShareBlock);
+}
+
+#endif
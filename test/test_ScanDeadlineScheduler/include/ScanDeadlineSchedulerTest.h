@@ -0,0 +1,102 @@
+#ifndef SCANDEADLINESCHEDULERTEST_H
+#define SCANDEADLINESCHEDULERTEST_H
+
+#include <submodules/ScanDeadlineScheduler.h>
+#include <unity.h>
+
+static constexpr size_t NONE = ScanDeadlineScheduler::NONE;
+
+void test_ScanDeadlineScheduler_dueSourcesInPriorityOrder()
+{
+    ScanDeadlineScheduler deadlines;
+    TEST_ASSERT_EQUAL(0, deadlines.addSource(1000));
+    TEST_ASSERT_EQUAL(1, deadlines.addSource(4000));
+    deadlines.reset(0);
+
+    TEST_ASSERT_EQUAL(0, deadlines.nextDue(0));
+    ScanDeadlineScheduler::Completion completion = deadlines.complete(0, 0, 30);
+    TEST_ASSERT_EQUAL_UINT32(0, completion.jitterUs);
+    TEST_ASSERT_EQUAL_UINT32(0, completion.missedDeadlines);
+
+    TEST_ASSERT_EQUAL(1, deadlines.nextDue(30));
+    completion = deadlines.complete(1, 30, 130);
+    TEST_ASSERT_EQUAL_UINT32(30, completion.jitterUs);
+    TEST_ASSERT_EQUAL_UINT32(100, deadlines.getEstimateUs(1));
+
+    TEST_ASSERT_EQUAL(NONE, deadlines.nextDue(130));
+    TEST_ASSERT_EQUAL_UINT64(1000, deadlines.getNextWakeUs(130));
+}
+
+void test_ScanDeadlineScheduler_lowerPriorityWaitsForGap()
+{
+    ScanDeadlineScheduler deadlines(20);
+    deadlines.addSource(1000);
+    deadlines.addSource(3900);
+    deadlines.reset(0);
+    for (uint64_t t = 0; t < 4000; t += 1000)
+    {
+        TEST_ASSERT_EQUAL(0, deadlines.nextDue(t));
+        deadlines.complete(0, t, t + 30);
+        if (t == 0)
+            deadlines.complete(1, 30, 130);
+    }
+
+    // 100 us of scan and 20 us of guard do not fit in before the main scan
+    TEST_ASSERT_EQUAL(NONE, deadlines.nextDue(3900));
+    TEST_ASSERT_EQUAL_UINT64(4000, deadlines.getNextWakeUs(3900));
+
+    TEST_ASSERT_EQUAL(0, deadlines.nextDue(4000));
+    TEST_ASSERT_EQUAL_UINT32(0, deadlines.complete(0, 4000, 4030).jitterUs);
+    TEST_ASSERT_EQUAL(1, deadlines.nextDue(4030));
+    TEST_ASSERT_EQUAL_UINT32(130, deadlines.complete(1, 4030, 4130).jitterUs);
+}
+
+void test_ScanDeadlineScheduler_scanLongerThanAnyGapRunsWhenDue()
+{
+    ScanDeadlineScheduler deadlines;
+    deadlines.addSource(1000);
+    deadlines.addSource(5000);
+    deadlines.reset(0);
+    deadlines.complete(0, 0, 30);
+    deadlines.complete(1, 30, 1230);
+
+    // The long scan made the main scan late once
+    TEST_ASSERT_EQUAL(0, deadlines.nextDue(1230));
+    TEST_ASSERT_EQUAL_UINT32(230, deadlines.complete(0, 1230, 1260).jitterUs);
+    for (uint64_t t = 2000; t <= 5000; t += 1000)
+        deadlines.complete(0, t, t + 30);
+
+    // Waiting would never help, 1200 us never fit in the 970 us gap
+    TEST_ASSERT_EQUAL(1, deadlines.nextDue(5030));
+    deadlines.complete(1, 5030, 5030);
+    TEST_ASSERT_EQUAL_UINT32(1200 - 1200 / 16, deadlines.getEstimateUs(1));
+}
+
+void test_ScanDeadlineScheduler_missedDeadlinesAndNewPeriod()
+{
+    ScanDeadlineScheduler deadlines;
+    deadlines.addSource(1000);
+    deadlines.reset(0);
+    deadlines.complete(0, 0, 10);
+
+    // Scans for the 3000 us deadline, the two before it were missed
+    TEST_ASSERT_EQUAL(0, deadlines.nextDue(3500));
+    ScanDeadlineScheduler::Completion completion = deadlines.complete(0, 3500, 3510);
+    TEST_ASSERT_EQUAL_UINT32(2, completion.missedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32(500, completion.jitterUs);
+    TEST_ASSERT_EQUAL_UINT64(4000, deadlines.getNextWakeUs(3510));
+
+    deadlines.setPeriod(0, 10000, 3600);
+    TEST_ASSERT_EQUAL(NONE, deadlines.nextDue(4000));
+    TEST_ASSERT_EQUAL_UINT64(13600, deadlines.getNextWakeUs(4000));
+}
+
+void run_ScanDeadlineScheduler_tests()
+{
+    RUN_TEST(test_ScanDeadlineScheduler_dueSourcesInPriorityOrder);
+    RUN_TEST(test_ScanDeadlineScheduler_lowerPriorityWaitsForGap);
+    RUN_TEST(test_ScanDeadlineScheduler_scanLongerThanAnyGapRunsWhenDue);
+    RUN_TEST(test_ScanDeadlineScheduler_missedDeadlinesAndNewPeriod);
+}
+
+#endif
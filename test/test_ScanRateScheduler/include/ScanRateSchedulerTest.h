@@ -0,0 +1,102 @@
+#ifndef SCANRATESCHEDULERTEST_H
+#define SCANRATESCHEDULERTEST_H
+
+#include <submodules/ScanRateScheduler.h>
+#include <unity.h>
+
+using ScanKind = ScanRateScheduler::ScanKind;
+
+void test_ScanRateScheduler_boostsUntilHoldOffPassed()
+{
+    // 1 kHz active, 100 Hz idle, 50 ms hold-off
+    ScanRateScheduler scheduler(1000, 100, 0, 50);
+    scheduler.reset(0);
+    TEST_ASSERT_TRUE(scheduler.isBoosted());
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getTickPeriodUs());
+
+    TEST_ASSERT_FALSE(scheduler.update(10000, true, true));
+    TEST_ASSERT_FALSE(scheduler.update(59000, false, false));
+    TEST_ASSERT_TRUE(scheduler.isBoosted());
+
+    // Hold-off counts from the last activity
+    TEST_ASSERT_TRUE(scheduler.update(60000, false, false));
+    TEST_ASSERT_FALSE(scheduler.isBoosted());
+    TEST_ASSERT_EQUAL_UINT32(10000, scheduler.getTickPeriodUs());
+    TEST_ASSERT_EQUAL(ScanKind::Full, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::Full, scheduler.nextScan());
+
+    // Any activity, even a bounce, switches back right away
+    TEST_ASSERT_TRUE(scheduler.update(70000, true, false));
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getTickPeriodUs());
+}
+
+void test_ScanRateScheduler_rescansHeldKeysBetweenFullScans()
+{
+    // Held keys at 500 Hz between 100 Hz full scans
+    ScanRateScheduler scheduler(1000, 100, 500, 20);
+    scheduler.reset(0);
+    TEST_ASSERT_TRUE(scheduler.update(30000, false, true));
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.getTickPeriodUs());
+
+    // The scan before the switch was a full one, the next is due an idle
+    // period later
+    TEST_ASSERT_EQUAL(ScanKind::HeldKeys, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::HeldKeys, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::HeldKeys, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::HeldKeys, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::Full, scheduler.nextScan());
+    TEST_ASSERT_EQUAL(ScanKind::HeldKeys, scheduler.nextScan());
+
+    // Releasing all keys falls back to plain idle scans
+    TEST_ASSERT_TRUE(scheduler.update(45000, false, false));
+    TEST_ASSERT_EQUAL_UINT32(10000, scheduler.getTickPeriodUs());
+    TEST_ASSERT_EQUAL(ScanKind::Full, scheduler.nextScan());
+}
+
+void test_ScanRateScheduler_fixedRateWithoutIdleRate()
+{
+    ScanRateScheduler scheduler(500, 0, 0, 100);
+    scheduler.reset(0);
+    TEST_ASSERT_FALSE(scheduler.update(1000000, false, false));
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.getTickPeriodUs());
+    TEST_ASSERT_EQUAL(ScanKind::Full, scheduler.nextScan());
+
+    // An idle rate above the active rate does not slow down either, a held
+    // key rate below the idle rate is never used
+    ScanRateScheduler faster(500, 800, 0, 100);
+    faster.reset(0);
+    TEST_ASSERT_FALSE(faster.update(1000000, false, true));
+    TEST_ASSERT_EQUAL_UINT32(2000, faster.getTickPeriodUs());
+
+    ScanRateScheduler slowHeld(1000, 100, 50, 10);
+    slowHeld.reset(0);
+    slowHeld.update(20000, false, true);
+    TEST_ASSERT_EQUAL_UINT32(10000, slowHeld.getTickPeriodUs());
+    TEST_ASSERT_EQUAL(ScanKind::Full, slowHeld.nextScan());
+}
+
+void test_ScanRateScheduler_timeWeightedAverageRate()
+{
+    ScanRateScheduler scheduler(1000, 100, 0, 100);
+    scheduler.reset(0);
+    TEST_ASSERT_EQUAL_FLOAT(1000.0f, scheduler.getAverageRateHz(50000));
+
+    // 100 ms at 1 kHz, then 300 ms at 100 Hz: 130 scans in 0.4 s
+    scheduler.update(100000, false, false);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 325.0f, scheduler.getAverageRateHz(400000));
+
+    // A new window only sees the current rate
+    scheduler.resetAverage(400000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, scheduler.getAverageRateHz(500000));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, scheduler.getAverageRateHz(400000));
+}
+
+void run_ScanRateScheduler_tests()
+{
+    RUN_TEST(test_ScanRateScheduler_boostsUntilHoldOffPassed);
+    RUN_TEST(test_ScanRateScheduler_rescansHeldKeysBetweenFullScans);
+    RUN_TEST(test_ScanRateScheduler_fixedRateWithoutIdleRate);
+    RUN_TEST(test_ScanRateScheduler_timeWeightedAverageRate);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef SCANTIMINGSTATSTEST_H
+#define SCANTIMINGSTATSTEST_H
+
+#include <submodules/ScanTimingStats.h>
+#include <unity.h>
+
+void test_ScanTimingStats_bucketBoundaries()
+{
+    TEST_ASSERT_EQUAL(0, ScanTimingStats::bucketFor(0));
+    TEST_ASSERT_EQUAL(1, ScanTimingStats::bucketFor(1));
+    TEST_ASSERT_EQUAL(2, ScanTimingStats::bucketFor(2));
+    TEST_ASSERT_EQUAL(2, ScanTimingStats::bucketFor(3));
+    TEST_ASSERT_EQUAL(3, ScanTimingStats::bucketFor(4));
+    TEST_ASSERT_EQUAL(11, ScanTimingStats::bucketFor(1024));
+    TEST_ASSERT_EQUAL(SCAN_TIMING_BUCKETS - 1, ScanTimingStats::bucketFor(UINT32_MAX));
+
+    // Every value lies below the limit of its bucket
+    const uint32_t values[] = {0, 1, 7, 500, 999, 1000, 20000};
+    for (uint32_t value : values)
+        TEST_ASSERT_TRUE(value < ScanTimingStats::bucketLimitUs(ScanTimingStats::bucketFor(value)));
+}
+
+void test_ScanTimingStats_recordsJitterAndDuration()
+{
+    ScanTimingStats stats(1000);
+    stats.reset(100);
+
+    stats.recordScan(3, 40);
+    stats.recordScan(0, 45);
+    stats.recordScan(150, 70);
+    stats.recordMissedDeadlines(2);
+
+    ScanTimingSnapshot snapshot{};
+    stats.snapshot(3100, snapshot);
+    TEST_ASSERT_EQUAL_UINT32(1000, snapshot.periodUs);
+    TEST_ASSERT_EQUAL_UINT32(3, snapshot.scanCount);
+    TEST_ASSERT_EQUAL_UINT32(2, snapshot.missedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32(150, snapshot.maxJitterUs);
+    TEST_ASSERT_EQUAL_UINT32(70, snapshot.maxDurationUs);
+    TEST_ASSERT_EQUAL_UINT32(153, (uint32_t)snapshot.totalJitterUs);
+    TEST_ASSERT_EQUAL_UINT32(155, (uint32_t)snapshot.totalDurationUs);
+    TEST_ASSERT_EQUAL_UINT32(3000, (uint32_t)snapshot.windowUs);
+
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.jitterBuckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.jitterBuckets[ScanTimingStats::bucketFor(3)]);
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.jitterBuckets[ScanTimingStats::bucketFor(150)]);
+    TEST_ASSERT_EQUAL_UINT32(2, snapshot.durationBuckets[ScanTimingStats::bucketFor(40)]);
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.durationBuckets[ScanTimingStats::bucketFor(70)]);
+}
+
+void test_ScanTimingStats_resetKeepsPeriod()
+{
+    ScanTimingStats stats(2000);
+    stats.recordScan(10, 10);
+    stats.recordMissedDeadlines(1);
+    stats.reset(500);
+
+    ScanTimingSnapshot snapshot{};
+    stats.snapshot(700, snapshot);
+    TEST_ASSERT_EQUAL_UINT32(2000, snapshot.periodUs);
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.scanCount);
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.missedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.jitterBuckets[ScanTimingStats::bucketFor(10)]);
+    TEST_ASSERT_EQUAL_UINT32(200, (uint32_t)snapshot.windowUs);
+}
+
+void test_ScanTimingStats_percentile()
+{
+    uint32_t empty[SCAN_TIMING_BUCKETS] = {};
+    TEST_ASSERT_EQUAL_UINT32(0, ScanTimingStats::percentileUs(empty, 99));
+
+    ScanTimingStats stats(1000);
+    for (int i = 0; i < 98; i++)
+        stats.recordScan(5, 0);
+    stats.recordScan(300, 0);
+    stats.recordScan(300, 0);
+
+    ScanTimingSnapshot snapshot{};
+    stats.snapshot(0, snapshot);
+    TEST_ASSERT_EQUAL_UINT32(8, ScanTimingStats::percentileUs(snapshot.jitterBuckets, 50));
+    TEST_ASSERT_EQUAL_UINT32(8, ScanTimingStats::percentileUs(snapshot.jitterBuckets, 98));
+    TEST_ASSERT_EQUAL_UINT32(512, ScanTimingStats::percentileUs(snapshot.jitterBuckets, 99));
+}
+
+void run_ScanTimingStats_tests()
+{
+    RUN_TEST(test_ScanTimingStats_bucketBoundaries);
+    RUN_TEST(test_ScanTimingStats_recordsJitterAndDuration);
+    RUN_TEST(test_ScanTimingStats_resetKeepsPeriod);
+    RUN_TEST(test_ScanTimingStats_percentile);
+}
+
+#endif
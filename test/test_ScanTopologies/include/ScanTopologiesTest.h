@@ -0,0 +1,203 @@
+#ifndef SCANTOPOLOGIESTEST_H
+#define SCANTOPOLOGIESTEST_H
+
+#include "../../DirectPinGpio.h"
+#include "../../MatrixGpio.h"
+#include "../../ShiftRegisterGpio.h"
+#include <submodules/DirectPinScanner.h>
+#include <submodules/DuplexMatrixScanner.h>
+#include <submodules/KeyScannerFactory.h>
+#include <submodules/ShiftRegisterScanner.h>
+#include <unity.h>
+#include <vector>
+
+using ScanTopology = KeyScannerConfig::ScanTopology;
+
+// Key indexes of all changes reported by the next scan
+static std::vector<uint16_t> scanChanges(IKeyScanner &scanner)
+{
+    std::vector<uint16_t> changes;
+    scanner.registerOnKeyChangeCallback([&](uint16_t keyIndex, bool pressed)
+                                        { changes.push_back(keyIndex); });
+    scanner.updateKeyState();
+    scanner.clearOnKeyChangeCallback();
+    return changes;
+}
+
+static bool isBitSet(const IKeyScanner &scanner, uint16_t keyIndex)
+{
+    uint8_t bitmap[64] = {};
+    scanner.copyPublishedBitmap(bitmap, sizeof(bitmap));
+    return (bitmap[keyIndex / 8] >> (keyIndex % 8)) & 1;
+}
+
+static void dummyWakeHandler(void *arg)
+{
+    (*static_cast<int *>(arg))++;
+}
+
+void test_directPins_reportsKeyPerPin()
+{
+    uint8_t keyPins[10] = {1, 2, 4, 5, 6, 7, 15, 16, 17, 40};
+    DirectPinGpio gpio(keyPins, 10);
+    DirectPinScanner scanner(gpio, keyPins, 10);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+    TEST_ASSERT_EQUAL(2, scanner.getBitMapSize());
+
+    gpio.setKey(0, true);
+    gpio.setKey(9, true);
+    gpio.resetCounters();
+    std::vector<uint16_t> changes = scanChanges(scanner);
+
+    // All keys in one bulk read
+    TEST_ASSERT_EQUAL(1, gpio.calls.total());
+    TEST_ASSERT_EQUAL(2, changes.size());
+    TEST_ASSERT_EQUAL(0, changes[0]);
+    TEST_ASSERT_EQUAL(9, changes[1]);
+    TEST_ASSERT_TRUE(isBitSet(scanner, 9));
+    TEST_ASSERT_FALSE(isBitSet(scanner, 8));
+}
+
+void test_directPins_idleWakesOnPress()
+{
+    uint8_t keyPins[4] = {3, 4, 5, 6};
+    DirectPinGpio gpio(keyPins, 4);
+    DirectPinScanner scanner(gpio, keyPins, 4);
+    int wakeups = 0;
+
+    TEST_ASSERT_TRUE(scanner.enterIdle(dummyWakeHandler, &wakeups));
+    TEST_ASSERT_TRUE(gpio.hasInterrupt(6));
+    gpio.setKey(3, true);
+    TEST_ASSERT_EQUAL(1, wakeups);
+
+    // Scanning leaves idle, and a held key keeps it from being entered again
+    scanner.updateKeyState();
+    TEST_ASSERT_FALSE(scanner.isIdle());
+    TEST_ASSERT_FALSE(gpio.hasInterrupt(6));
+    TEST_ASSERT_FALSE(scanner.enterIdle(dummyWakeHandler, &wakeups));
+    TEST_ASSERT_FALSE(gpio.hasInterrupt(6));
+}
+
+void test_shiftRegister_readsWholeChain()
+{
+    ShiftRegisterGpio gpio(10, 11, 12, 3);
+    ShiftRegisterScanner scanner(gpio, 10, 11, 12, 3);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+    TEST_ASSERT_EQUAL(3, scanner.getBitMapSize());
+
+    const uint16_t keys[] = {0, 7, 8, 23};
+    for (uint16_t key : keys)
+        gpio.setKey(key, true);
+    gpio.resetCounters();
+    std::vector<uint16_t> changes = scanChanges(scanner);
+
+    TEST_ASSERT_EQUAL(4, changes.size());
+    for (size_t i = 0; i < changes.size(); i++)
+        TEST_ASSERT_EQUAL(keys[i], changes[i]);
+
+    // Load pulse, then one read per bit and one clock pulse between bits
+    TEST_ASSERT_EQUAL(23, gpio.getClockedBits());
+    TEST_ASSERT_EQUAL(2 + 24 + 2 * 23, gpio.calls.total());
+
+    gpio.setKey(7, false);
+    changes = scanChanges(scanner);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_EQUAL(7, changes[0]);
+    TEST_ASSERT_FALSE(isBitSet(scanner, 7));
+    TEST_ASSERT_TRUE(isBitSet(scanner, 23));
+}
+
+void test_shiftRegister_neverIdles()
+{
+    ShiftRegisterGpio gpio(10, 11, 12, 1);
+    ShiftRegisterScanner scanner(gpio, 10, 11, 12, 1);
+    int wakeups = 0;
+    TEST_ASSERT_FALSE(scanner.enterIdle(dummyWakeHandler, &wakeups));
+    TEST_ASSERT_FALSE(scanner.isIdle());
+}
+
+void test_duplex_separatesBothKeysOfACrossing()
+{
+    uint8_t rowPins[3] = {0, 1, 2};
+    uint8_t colPins[5] = {20, 21, 22, 23, 24};
+    MatrixGpio gpio(rowPins, 3, colPins, 5);
+    DuplexMatrixScanner scanner(gpio, rowPins, colPins, 3, 5);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+    TEST_ASSERT_EQUAL((2 * 3 * 5 + 7) / 8, scanner.getBitMapSize());
+
+    gpio.setKey(1, 2, true);
+    std::vector<uint16_t> changes = scanChanges(scanner);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_EQUAL(1 * 5 + 2, changes[0]);
+
+    // The reverse key of the same crossing lands in the second half
+    gpio.setReverseKey(1, 2, true);
+    changes = scanChanges(scanner);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_EQUAL(15 + 1 * 5 + 2, changes[0]);
+
+    gpio.setKey(1, 2, false);
+    gpio.setReverseKey(2, 4, true);
+    changes = scanChanges(scanner);
+    TEST_ASSERT_EQUAL(2, changes.size());
+    TEST_ASSERT_EQUAL(1 * 5 + 2, changes[0]);
+    TEST_ASSERT_EQUAL(15 + 2 * 5 + 4, changes[1]);
+    TEST_ASSERT_TRUE(isBitSet(scanner, 15 + 7));
+    TEST_ASSERT_TRUE(isBitSet(scanner, 29));
+}
+
+void test_factory_createsEngineOfTopology()
+{
+    uint8_t rowPins[4] = {0, 1, 2, 3};
+    uint8_t colPins[6] = {20, 21, 22, 23, 24, 25};
+    MatrixGpio gpio(rowPins, 4, colPins, 6);
+
+    KeyScannerConfig config;
+    config.setPins(rowPins, 4, colPins, 6);
+    std::unique_ptr<IKeyScanner> scanner = KeyScannerFactory::create(gpio, config, rowPins, colPins);
+    TEST_ASSERT_NOT_NULL(scanner.get());
+    TEST_ASSERT_EQUAL(3, scanner->getBitMapSize());
+
+    config.setTopology(ScanTopology::DuplexMatrix);
+    scanner = KeyScannerFactory::create(gpio, config, rowPins, colPins);
+    TEST_ASSERT_NOT_NULL(scanner.get());
+    TEST_ASSERT_EQUAL(6, scanner->getBitMapSize());
+    TEST_ASSERT_EQUAL(config.getBitmapSize(), scanner->getBitMapSize());
+
+    config.setTopology(ScanTopology::DirectPins);
+    scanner = KeyScannerFactory::create(gpio, config, rowPins, colPins);
+    TEST_ASSERT_NOT_NULL(scanner.get());
+    TEST_ASSERT_EQUAL(1, scanner->getBitMapSize());
+
+    // Shift registers need exactly load and clock, and the data pin
+    config.setTopology(ScanTopology::ShiftRegister);
+    config.setShiftRegisterCount(4);
+    TEST_ASSERT_NULL(KeyScannerFactory::create(gpio, config, rowPins, colPins).get());
+    config.setPins(rowPins, 2, colPins, 1);
+    scanner = KeyScannerFactory::create(gpio, config, rowPins, colPins);
+    TEST_ASSERT_NOT_NULL(scanner.get());
+    TEST_ASSERT_EQUAL(4, scanner->getBitMapSize());
+    TEST_ASSERT_EQUAL(32, config.getKeyCount());
+
+    // Matrices without rows or columns have nothing to scan
+    config.setPins(rowPins, 0, colPins, 6);
+    config.setTopology(ScanTopology::Matrix);
+    TEST_ASSERT_NULL(KeyScannerFactory::create(gpio, config, rowPins, colPins).get());
+    config.setTopology(ScanTopology::DuplexMatrix);
+    TEST_ASSERT_NULL(KeyScannerFactory::create(gpio, config, rowPins, colPins).get());
+    config.setPins(rowPins, 4, colPins, 0);
+    config.setTopology(ScanTopology::Matrix);
+    TEST_ASSERT_NULL(KeyScannerFactory::create(gpio, config, rowPins, colPins).get());
+}
+
+void run_ScanTopologies_tests()
+{
+    RUN_TEST(test_directPins_reportsKeyPerPin);
+    RUN_TEST(test_directPins_idleWakesOnPress);
+    RUN_TEST(test_shiftRegister_readsWholeChain);
+    RUN_TEST(test_shiftRegister_neverIdles);
+    RUN_TEST(test_duplex_separatesBothKeysOfACrossing);
+    RUN_TEST(test_factory_createsEngineOfTopology);
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef SCANTOPOLOGYBENCHMARK_H
+#define SCANTOPOLOGYBENCHMARK_H
+
+#include "../../DirectPinGpio.h"
+#include "../../MatrixGpio.h"
+#include "../../ShiftRegisterGpio.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <submodules/DirectPinScanner.h>
+#include <submodules/DuplexMatrixScanner.h>
+#include <submodules/KeyScanner.h>
+#include <submodules/ShiftRegisterScanner.h>
+#include <unity.h>
+#include <vector>
+
+using DebounceMode = KeyScannerConfig::DebounceMode;
+
+// Same typing pattern as the matrix benchmark: 1 kHz scans, a key every 30 ms
+// held for 60 ms, every edge bouncing twice within 0.6 ms
+static constexpr uint64_t SCAN_PERIOD_US = 1000;
+static constexpr uint32_t KEYSTROKES = 400;
+static constexpr uint64_t KEY_INTERVAL_US = 30000;
+static constexpr uint64_t KEY_HOLD_US = 60000;
+static constexpr uint8_t KEY_BOUNCES = 2;
+static constexpr uint64_t BOUNCE_INTERVAL_US = 150;
+
+struct KeyEdge
+{
+    uint64_t timeUs;
+    uint16_t key;
+    bool closed;
+};
+
+struct TopologyRun
+{
+    uint32_t scans;
+    uint32_t events;
+    uint32_t gpioOps;
+    double wallUs;
+};
+
+// Contact changes of the typing pattern over keyCount keys, in time order
+static std::vector<KeyEdge> typingScript(uint16_t keyCount)
+{
+    std::vector<KeyEdge> edges;
+    for (uint32_t i = 0; i < KEYSTROKES; i++)
+    {
+        // Walk the keys with a stride coprime to the key count
+        uint16_t key = (i * 7 + 3) % keyCount;
+        uint64_t pressUs = SCAN_PERIOD_US / 2 + i * KEY_INTERVAL_US;
+        const uint64_t edgeTimes[] = {pressUs, pressUs + KEY_HOLD_US};
+        for (size_t e = 0; e < 2; e++)
+        {
+            bool closed = (e == 0);
+            for (uint16_t b = 0; b <= 2 * KEY_BOUNCES; b++)
+                edges.push_back({edgeTimes[e] + b * BOUNCE_INTERVAL_US, key,
+                                 (b % 2 == 0) ? closed : !closed});
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end(),
+                     [](const KeyEdge &a, const KeyEdge &b) { return a.timeUs < b.timeUs; });
+    return edges;
+}
+
+template <typename Gpio>
+static TopologyRun runTyping(Gpio &gpio, IKeyScanner &scanner, uint16_t keyCount,
+                             const std::function<void(uint16_t key, bool closed)> &setKey)
+{
+    std::vector<KeyEdge> edges = typingScript(keyCount);
+    scanner.setDebounce(DebounceMode::Deferred, 5);
+    uint32_t events = 0;
+    scanner.registerOnKeyChangeBatchCallback(
+        [&](const IKeyScanner::KeyChange *, size_t count, uint32_t) { events += count; });
+
+    TopologyRun run{};
+    gpio.resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t time = 0;
+    size_t nextEdge = 0;
+    // Keep scanning a little past the script so the last release settles
+    uint32_t settleScans = 20;
+    while (nextEdge < edges.size() || settleScans-- > 0)
+    {
+        time += SCAN_PERIOD_US;
+        for (; nextEdge < edges.size() && edges[nextEdge].timeUs <= time; nextEdge++)
+            setKey(edges[nextEdge].key, edges[nextEdge].closed);
+        scanner.updateKeyState();
+        run.scans++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    run.events = events;
+    run.gpioOps = gpio.calls.total();
+    run.wallUs = std::chrono::duration<double, std::micro>(end - start).count();
+
+    // Debouncing turns every bouncing keystroke into one press and one release
+    TEST_ASSERT_EQUAL_UINT32(2 * KEYSTROKES, run.events);
+    TEST_ASSERT_FALSE(scanner.hasPressedKeys());
+    return run;
+}
+
+static void reportRun(const char *name, uint16_t keyCount, uint8_t pinCount,
+                      const TopologyRun &run)
+{
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%-15s %3u keys %2u pins %7.0f scans/s, %4u GPIO ops/scan, %.3f us/scan",
+             name, keyCount, pinCount, run.scans * 1e6 / run.wallUs,
+             run.gpioOps / run.scans, run.wallUs / run.scans);
+    TEST_MESSAGE(message);
+}
+
+void test_topology_matrix8x8()
+{
+    uint8_t rowPins[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t colPins[8] = {20, 21, 22, 23, 24, 25, 26, 27};
+    MatrixGpio gpio(rowPins, 8, colPins, 8);
+    KeyScanner scanner(gpio, rowPins, colPins, 8, 8);
+    TopologyRun run = runTyping(gpio, scanner, 64, [&](uint16_t key, bool closed)
+                                { gpio.setKey(key / 8, key % 8, closed); });
+    reportRun("matrix 8x8", 64, 16, run);
+    TEST_ASSERT_EQUAL_UINT32(4 * 8, run.gpioOps / run.scans);
+}
+
+void test_topology_duplex4x8()
+{
+    uint8_t rowPins[4] = {0, 1, 2, 3};
+    uint8_t colPins[8] = {20, 21, 22, 23, 24, 25, 26, 27};
+    MatrixGpio gpio(rowPins, 4, colPins, 8);
+    DuplexMatrixScanner scanner(gpio, rowPins, colPins, 4, 8);
+    TopologyRun run = runTyping(gpio, scanner, 64, [&](uint16_t key, bool closed)
+                                {
+                                    uint16_t position = key % 32;
+                                    if (key < 32)
+                                        gpio.setKey(position / 8, position % 8, closed);
+                                    else
+                                        gpio.setReverseKey(position / 8, position % 8, closed);
+                                });
+    reportRun("duplex 4x8", 64, 12, run);
+    TEST_ASSERT_EQUAL_UINT32(4 * (4 + 8), run.gpioOps / run.scans);
+}
+
+static void benchmarkShiftRegister(uint8_t registerCount)
+{
+    ShiftRegisterGpio gpio(10, 11, 12, registerCount);
+    ShiftRegisterScanner scanner(gpio, 10, 11, 12, registerCount);
+    uint16_t keyCount = registerCount * 8;
+    TopologyRun run = runTyping(gpio, scanner, keyCount, [&](uint16_t key, bool closed)
+                                { gpio.setKey(key, closed); });
+
+    char name[24];
+    snprintf(name, sizeof(name), "shift reg. x%u", registerCount);
+    reportRun(name, keyCount, 3, run);
+    TEST_ASSERT_EQUAL_UINT32(2 + keyCount + 2 * (keyCount - 1), run.gpioOps / run.scans);
+}
+
+void test_topology_shiftRegister1() { benchmarkShiftRegister(1); }
+void test_topology_shiftRegister8() { benchmarkShiftRegister(8); }
+void test_topology_shiftRegister16() { benchmarkShiftRegister(16); }
+
+void test_topology_directPins16()
+{
+    uint8_t keyPins[16];
+    for (uint8_t i = 0; i < 16; i++)
+        keyPins[i] = i;
+    DirectPinGpio gpio(keyPins, 16);
+    DirectPinScanner scanner(gpio, keyPins, 16);
+    TopologyRun run = runTyping(gpio, scanner, 16, [&](uint16_t key, bool closed)
+                                { gpio.setKey(key, closed); });
+    reportRun("direct pins", 16, 16, run);
+    TEST_ASSERT_EQUAL_UINT32(1, run.gpioOps / run.scans);
+}
+
+void run_ScanTopologyBenchmark_tests()
+{
+    RUN_TEST(test_topology_matrix8x8);
+    RUN_TEST(test_topology_duplex4x8);
+    RUN_TEST(test_topology_shiftRegister1);
+    RUN_TEST(test_topology_shiftRegister8);
+    RUN_TEST(test_topology_shiftRegister16);
+    RUN_TEST(test_topology_directPins16);
+}
+
+#endif
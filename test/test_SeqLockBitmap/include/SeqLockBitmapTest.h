@@ -0,0 +1,154 @@
+#ifndef SEQLOCKBITMAPTEST_H
+#define SEQLOCKBITMAPTEST_H
+
+#include <cstring>
+#include <submodules/SeqLockBitmap.h>
+#include <unity.h>
+
+#ifdef UNITY_NATIVE
+#include "../../FakeGpio.h"
+#include <atomic>
+#include <cstdio>
+#include <submodules/KeyScanner.h>
+#include <thread>
+#include <vector>
+#endif
+
+void test_SeqLockBitmap_readReturnsLastPublish()
+{
+    SeqLockBitmap bitmap(6);
+    uint8_t out[8];
+    memset(out, 0xAA, sizeof(out));
+    TEST_ASSERT_EQUAL_UINT32(0, bitmap.read(out, sizeof(out)));
+    for (size_t i = 0; i < sizeof(out); i++)
+        TEST_ASSERT_EQUAL_UINT8(0, out[i]);
+
+    uint32_t words[2] = {0x04030201, 0x08070605};
+    bitmap.publish(words);
+    TEST_ASSERT_EQUAL_UINT32(1, bitmap.getVersion());
+    TEST_ASSERT_EQUAL_UINT32(1, bitmap.read(out, sizeof(out)));
+
+    // Little endian byte view, bytes past the bitmap size are zeroed
+    const uint8_t expected[8] = {1, 2, 3, 4, 5, 6, 0, 0};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, sizeof(out));
+
+    // A short destination only gets the leading bytes
+    uint8_t shortOut[3] = {};
+    bitmap.read(shortOut, sizeof(shortOut));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, shortOut, sizeof(shortOut));
+}
+
+void test_SeqLockBitmap_stressReadersNeverSeeTornBitmap()
+{
+#ifdef UNITY_NATIVE
+    // Every publish writes the same value into all words, a reader that sees
+    // two different words caught a publish half way
+    static constexpr size_t WORDS = 16;
+    static constexpr uint32_t PUBLISHES = 200000;
+    static constexpr int READERS = 3;
+
+    SeqLockBitmap bitmap(WORDS * 4);
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> tornReads{0};
+    std::atomic<uint32_t> staleVersions{0};
+    std::atomic<uint64_t> totalReads{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++)
+    {
+        readers.emplace_back([&]()
+                             {
+            uint32_t snapshot[WORDS];
+            uint32_t lastVersion = 0;
+            uint64_t reads = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                uint32_t version = bitmap.read(reinterpret_cast<uint8_t *>(snapshot), sizeof(snapshot));
+                for (size_t i = 1; i < WORDS; i++)
+                {
+                    if (snapshot[i] != snapshot[0])
+                    {
+                        tornReads++;
+                        break;
+                    }
+                }
+                // The value written by publish n is n, versions never go back
+                if (snapshot[0] != version || version < lastVersion)
+                    staleVersions++;
+                lastVersion = version;
+                reads++;
+            }
+            totalReads += reads; });
+    }
+
+    uint32_t words[WORDS];
+    for (uint32_t n = 1; n <= PUBLISHES; n++)
+    {
+        for (size_t i = 0; i < WORDS; i++)
+            words[i] = n;
+        bitmap.publish(words);
+    }
+    done = true;
+    for (std::thread &reader : readers)
+        reader.join();
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u publishes, %llu consistent reads by %d readers",
+             PUBLISHES, static_cast<unsigned long long>(totalReads.load()), READERS);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, tornReads.load());
+    TEST_ASSERT_EQUAL_UINT32(0, staleVersions.load());
+    TEST_ASSERT_EQUAL_UINT32(PUBLISHES, bitmap.getVersion());
+#endif
+}
+
+void test_SeqLockBitmap_scannerSnapshotsFromOtherThreads()
+{
+#ifdef UNITY_NATIVE
+    // Column 0 of a 4x4 matrix toggles every scan: a consistent snapshot has
+    // either all four keys of the column pressed or none
+    static constexpr uint32_t SCANS = 20000;
+    FakeGpio gpio;
+    uint8_t rowPins[4] = {1, 2, 3, 4};
+    uint8_t colPins[4] = {17, 18, 19, 20};
+
+    std::vector<PinState> waveform;
+    for (uint32_t scan = 0; scan < SCANS; scan++)
+        waveform.insert(waveform.end(), 4, scan % 2 ? PinState::High : PinState::Low);
+    gpio.scriptPin(17, waveform);
+
+    KeyScanner scanner(gpio, rowPins, colPins, 4, 4);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> tornReads{0};
+    std::thread reader([&]()
+                       {
+        uint8_t state[2];
+        while (!done.load(std::memory_order_relaxed))
+        {
+            scanner.copyPublishedBitmap(state, sizeof(state));
+            bool allPressed = state[0] == 0x11 && state[1] == 0x11;
+            bool nonePressed = state[0] == 0 && state[1] == 0;
+            if (!allPressed && !nonePressed)
+                tornReads++;
+        } });
+
+    for (uint32_t scan = 0; scan < SCANS; scan++)
+        scanner.updateKeyState();
+    done = true;
+    reader.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, tornReads.load());
+    TEST_ASSERT_EQUAL_UINT32(SCANS, scanner.getPublishedVersion());
+#endif
+}
+
+void run_SeqLockBitmap_tests()
+{
+    RUN_TEST(test_SeqLockBitmap_readReturnsLastPublish);
+    RUN_TEST(test_SeqLockBitmap_stressReadersNeverSeeTornBitmap);
+    RUN_TEST(test_SeqLockBitmap_scannerSnapshotsFromOtherThreads);
+}
+
+#endif
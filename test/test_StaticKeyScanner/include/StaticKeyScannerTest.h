@@ -0,0 +1,181 @@
+#ifndef STATICKEYSCANNERTEST_H
+#define STATICKEYSCANNERTEST_H
+
+#include <submodules/KeyScanner.h>
+#include <submodules/StaticKeyScanner.h>
+#include <unity.h>
+#include <vector>
+
+#ifndef UNITY_NATIVE
+#include <submodules/Esp32Gpio.h>
+static Esp32Gpio gpio;
+#else
+#include "../../FakeGpio.h"
+static FakeGpio gpio;
+#endif
+
+void test_StaticKeyScanner_constants()
+{
+    using Scanner = StaticKeyScanner<6, 18>;
+    TEST_ASSERT_EQUAL(108, Scanner::KEY_COUNT);
+    TEST_ASSERT_EQUAL(14, Scanner::BITMAP_SIZE);
+    TEST_ASSERT_EQUAL(4, Scanner::BITMAP_WORDS);
+    static_assert(Scanner::bitIndex(1, 14) == 32, "bit index must be known at compile time");
+    TEST_ASSERT_EQUAL(107, Scanner::bitIndex(5, 17));
+}
+
+void test_StaticKeyScanner_noKeysPressed()
+{
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    StaticKeyScanner<2, 2> scanner(gpio, rowPins, colPins);
+    TEST_ASSERT_EQUAL(0, scanner.updateKeyState());
+
+    uint8_t bitmap[1] = {0xFF};
+    scanner.copyPublishedBitmap(bitmap, sizeof(bitmap));
+    TEST_ASSERT_EQUAL_UINT8(0, bitmap[0]);
+    TEST_ASSERT_FALSE(scanner.hasPressedKeys());
+    TEST_ASSERT_EQUAL(1, scanner.getBitMapSize());
+}
+
+void test_StaticKeyScanner_matchesRuntimeScanner()
+{
+#ifdef UNITY_NATIVE
+    // Rows of 18 keys straddle word boundaries
+    uint8_t rowPins[6] = {1, 2, 3, 4, 5, 6};
+    uint8_t colPins[18];
+    for (uint8_t i = 0; i < 18; i++)
+        colPins[i] = 20 + i;
+
+    KeyScanner runtime(gpio, rowPins, colPins, 6, 18);
+    StaticKeyScanner<6, 18> fixed(gpio, rowPins, colPins);
+    runtime.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+    fixed.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+
+    std::vector<KeyScanner::KeyChange> runtimeChanges;
+    std::vector<KeyScanner::KeyChange> fixedChanges;
+    runtime.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *changes, size_t count, uint32_t)
+        { runtimeChanges.assign(changes, changes + count); });
+    fixed.registerOnKeyChangeBatchCallback(
+        [&](const KeyScanner::KeyChange *changes, size_t count, uint32_t)
+        { fixedChanges.assign(changes, changes + count); });
+
+    gpio.setPinState(20, PinState::Low);
+    gpio.setPinState(33, PinState::Low);
+    gpio.setPinState(37, PinState::Low);
+    size_t runtimeCount = runtime.updateKeyState();
+    size_t fixedCount = fixed.updateKeyState();
+    gpio.setPinState(20, PinState::High);
+    gpio.setPinState(33, PinState::High);
+    gpio.setPinState(37, PinState::High);
+
+    TEST_ASSERT_EQUAL(18, runtimeCount);
+    TEST_ASSERT_EQUAL(runtimeCount, fixedCount);
+    for (size_t i = 0; i < runtimeCount; i++)
+    {
+        TEST_ASSERT_EQUAL(runtimeChanges[i].keyIndex, fixedChanges[i].keyIndex);
+        TEST_ASSERT_EQUAL(runtimeChanges[i].pressed, fixedChanges[i].pressed);
+    }
+
+    uint8_t runtimeBitmap[14];
+    uint8_t fixedBitmap[14];
+    runtime.copyPublishedBitmap(runtimeBitmap, sizeof(runtimeBitmap));
+    fixed.copyPublishedBitmap(fixedBitmap, sizeof(fixedBitmap));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(runtimeBitmap, fixedBitmap, sizeof(runtimeBitmap));
+    TEST_ASSERT_TRUE(fixed.hasPressedKeys());
+#endif
+}
+
+void test_StaticKeyScanner_oneBulkReadPerRow()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[4] = {1, 2, 3, 4};
+    uint8_t colPins[4] = {17, 18, 19, 20};
+
+    StaticKeyScanner<4, 4> scanner(gpio, rowPins, colPins);
+    gpio.resetCounters();
+    scanner.updateKeyState();
+    TEST_ASSERT_EQUAL(4, gpio.calls.readPins);
+    TEST_ASSERT_EQUAL(0, gpio.calls.digitalRead);
+    TEST_ASSERT_EQUAL(16, gpio.calls.total());
+#endif
+}
+
+void test_StaticKeyScanner_idleRefusedWhileKeyHeld()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    StaticKeyScanner<2, 2> scanner(gpio, rowPins, colPins);
+    gpio.setPinState(17, PinState::Low);
+    TEST_ASSERT_FALSE(scanner.enterIdle([](void *) {}, nullptr));
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(17));
+    gpio.setPinState(17, PinState::High);
+
+    TEST_ASSERT_TRUE(scanner.enterIdle([](void *) {}, nullptr));
+    TEST_ASSERT_TRUE(gpio.isInterruptArmed(18));
+    scanner.updateKeyState();
+    TEST_ASSERT_FALSE(scanner.isIdle());
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(18));
+#endif
+}
+
+void test_StaticKeyScanner_destructorLeavesIdle()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[2] = {9, 10};
+    uint8_t colPins[2] = {17, 18};
+
+    {
+        StaticKeyScanner<2, 2> scanner(gpio, rowPins, colPins);
+        TEST_ASSERT_TRUE(scanner.enterIdle([](void *) {}, nullptr));
+        TEST_ASSERT_EQUAL(PinMode::Output, gpio.getPinMode(9));
+    }
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(17));
+    TEST_ASSERT_FALSE(gpio.isInterruptArmed(18));
+    TEST_ASSERT_EQUAL(PinMode::InputPullup, gpio.getPinMode(9));
+#endif
+}
+
+void test_StaticKeyScanner_heldScanSkipsRowsWithoutHeldKeys()
+{
+#ifdef UNITY_NATIVE
+    uint8_t rowPins[4] = {1, 2, 3, 4};
+    uint8_t colPins[4] = {17, 18, 19, 20};
+
+    StaticKeyScanner<4, 4> scanner(gpio, rowPins, colPins);
+    scanner.setDebounce(KeyScannerConfig::DebounceMode::None, 0);
+    gpio.resetCounters();
+    TEST_ASSERT_EQUAL(0, scanner.updateHeldKeyState());
+    TEST_ASSERT_EQUAL(0, gpio.calls.total());
+
+    // New presses are left to the next full scan
+    gpio.setPinState(18, PinState::Low);
+    TEST_ASSERT_EQUAL(0, scanner.updateHeldKeyState());
+    TEST_ASSERT_EQUAL(4, scanner.updateKeyState());
+
+    // The column reads low on every row, so every row is rescanned
+    gpio.setPinState(18, PinState::High);
+    gpio.resetCounters();
+    TEST_ASSERT_EQUAL(4, scanner.updateHeldKeyState());
+    TEST_ASSERT_EQUAL(4, gpio.calls.readPins);
+    TEST_ASSERT_TRUE(scanner.sawKeyActivity());
+    TEST_ASSERT_FALSE(scanner.hasPressedKeys());
+#endif
+}
+
+void run_StaticKeyScanner_tests()
+{
+    RUN_TEST(test_StaticKeyScanner_constants);
+    RUN_TEST(test_StaticKeyScanner_noKeysPressed);
+    RUN_TEST(test_StaticKeyScanner_matchesRuntimeScanner);
+    RUN_TEST(test_StaticKeyScanner_oneBulkReadPerRow);
+    RUN_TEST(test_StaticKeyScanner_idleRefusedWhileKeyHeld);
+    RUN_TEST(test_StaticKeyScanner_destructorLeavesIdle);
+    RUN_TEST(test_StaticKeyScanner_heldScanSkipsRowsWithoutHeldKeys);
+}
+
+#endif
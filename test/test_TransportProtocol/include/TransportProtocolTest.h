@@ -0,0 +1,215 @@
+#ifndef TRANSPORTPROTOCOLTEST_H
+#define TRANSPORTPROTOCOLTEST_H
+
+#include "../../FakeEspNow.h"
+#include <cstdlib>
+#include <submodules/Config/KeyScannerConfig.h>
+#include <submodules/TransportProtocol.h>
+#include <unity.h>
+#include <vector>
+
+static const uint8_t SENDER_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+// Bitmaps delivered to the onBitmapEvent callback
+static std::vector<std::vector<uint8_t>> receivedBitmaps;
+
+static void registerBitmapReceiver(TransportProtocol &protocol)
+{
+    receivedBitmaps.clear();
+    protocol.onBitmapEvent([](RawBitmapEvent &event, uint8_t senderId)
+                           {
+                               receivedBitmaps.emplace_back(event.data(), event.data() + event.bitmapSize);
+                               event.release(EventType::RawBitmap);
+                           });
+}
+
+static std::vector<uint8_t> makeBitmap(size_t size)
+{
+    std::vector<uint8_t> bitmap(size);
+    for (size_t i = 0; i < size; i++)
+        bitmap[i] = static_cast<uint8_t>(i * 7 + 3);
+    return bitmap;
+}
+
+static void sendBitmap(TransportProtocol &protocol, std::vector<uint8_t> &bitmap)
+{
+    RawBitmapEvent event;
+    TEST_ASSERT_TRUE(event.assign(EventType::RawBitmap, bitmap.data(), static_cast<uint16_t>(bitmap.size())));
+    protocol.sendBitmapEvent(event);
+    event.release(EventType::RawBitmap);
+}
+
+void test_TransportProtocol_smallBitmapSinglePacket()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    registerBitmapReceiver(protocol);
+
+    std::vector<uint8_t> bitmap = makeBitmap(16);
+    sendBitmap(protocol, bitmap);
+    TEST_ASSERT_EQUAL(1, espNow.sentPackets.size());
+
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_EQUAL(1, receivedBitmaps.size());
+    TEST_ASSERT_EQUAL(bitmap.size(), receivedBitmaps[0].size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bitmap.data(), receivedBitmaps[0].data(), bitmap.size());
+}
+
+void test_TransportProtocol_largeBitmapIsChunked()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    registerBitmapReceiver(protocol);
+
+    // 4096 keys
+    std::vector<uint8_t> bitmap = makeBitmap(512);
+    sendBitmap(protocol, bitmap);
+
+    size_t expectedPackets = (bitmap.size() + TransportProtocol::MAX_BITMAP_CHUNK - 1) / TransportProtocol::MAX_BITMAP_CHUNK;
+    TEST_ASSERT_EQUAL(expectedPackets, espNow.sentPackets.size());
+    for (const FakeEspNow::SentPacket &packet : espNow.sentPackets)
+        TEST_ASSERT_LESS_OR_EQUAL(250 - 8, packet.data.size());
+
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_EQUAL(1, receivedBitmaps.size());
+    TEST_ASSERT_EQUAL(bitmap.size(), receivedBitmaps[0].size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bitmap.data(), receivedBitmaps[0].data(), bitmap.size());
+}
+
+void test_TransportProtocol_lostChunkDropsBitmap()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    registerBitmapReceiver(protocol);
+
+    std::vector<uint8_t> bitmap = makeBitmap(512);
+    sendBitmap(protocol, bitmap);
+    espNow.sentPackets.erase(espNow.sentPackets.begin() + 1);
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_EQUAL(0, receivedBitmaps.size());
+
+    // The next complete bitmap gets through
+    sendBitmap(protocol, bitmap);
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_EQUAL(1, receivedBitmaps.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bitmap.data(), receivedBitmaps[0].data(), bitmap.size());
+}
+
+void test_TransportProtocol_truncatedPacketIgnored()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    registerBitmapReceiver(protocol);
+
+    // Claims a 4 byte bitmap but carries 6 bytes of data at offset 0
+    const uint8_t packet[] = {4, 0, 0, 0, 1, 2, 3, 4, 5, 6};
+    espNow.simulateReceiveData(static_cast<uint8_t>(PacketType::KeyBitmap), packet, sizeof(packet), SENDER_MAC);
+    const uint8_t header[] = {4, 0};
+    espNow.simulateReceiveData(static_cast<uint8_t>(PacketType::KeyBitmap), header, sizeof(header), SENDER_MAC);
+    TEST_ASSERT_EQUAL(0, receivedBitmaps.size());
+}
+
+void test_TransportProtocol_keyEventKeepsTimestamps()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    static std::vector<RawKeyEvent> receivedKeys;
+    receivedKeys.clear();
+    protocol.onKeyEvent([](RawKeyEvent &event, uint8_t senderId)
+                        { receivedKeys.push_back(event); });
+
+    RawKeyEvent keyEvent{};
+    keyEvent.keyIndex = 1023;
+    keyEvent.state = true;
+    keyEvent.scanSequence = 70000;
+    keyEvent.timestamps = {4000000000u, 4000000150u, 4000000400u, 123};
+    protocol.sendKeyEvent(keyEvent);
+    TEST_ASSERT_EQUAL(1, espNow.sentPackets.size());
+    TEST_ASSERT_EQUAL(TransportProtocol::KEY_EVENT_SIZE, espNow.sentPackets[0].data.size());
+
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_EQUAL(1, receivedKeys.size());
+    TEST_ASSERT_EQUAL_UINT16(1023, receivedKeys[0].keyIndex);
+    TEST_ASSERT_TRUE(receivedKeys[0].state);
+    TEST_ASSERT_EQUAL_UINT32(70000, receivedKeys[0].scanSequence);
+    TEST_ASSERT_EQUAL_UINT32(4000000000u, receivedKeys[0].timestamps.scanUs);
+    TEST_ASSERT_EQUAL_UINT32(4000000150u, receivedKeys[0].timestamps.busUs);
+    TEST_ASSERT_EQUAL_UINT32(4000000400u, receivedKeys[0].timestamps.txUs);
+    // The receive time is the receiver's to stamp
+    TEST_ASSERT_EQUAL_UINT32(0, receivedKeys[0].timestamps.rxUs);
+
+    // Index and state only, as sent before the timestamps
+    const uint8_t legacyPacket[] = {7, 0, 1, 0};
+    espNow.simulateReceiveData(static_cast<uint8_t>(PacketType::KeyEvent), legacyPacket,
+                               sizeof(legacyPacket), SENDER_MAC);
+    TEST_ASSERT_EQUAL(2, receivedKeys.size());
+    TEST_ASSERT_EQUAL_UINT16(7, receivedKeys[1].keyIndex);
+    TEST_ASSERT_TRUE(receivedKeys[1].state);
+    TEST_ASSERT_EQUAL_UINT32(0, receivedKeys[1].scanSequence);
+}
+
+void test_TransportProtocol_largeConfigIsChunked()
+{
+    FakeEspNow espNow;
+    TransportProtocol protocol(espNow);
+    static ConfigManager *receivedConfig;
+    receivedConfig = nullptr;
+    protocol.onConfigReceived([](ConfigManager *config, uint8_t senderId)
+                              { receivedConfig = config; });
+
+    // 16 x 32 = 512 keys, the HID map alone fills two packets
+    uint8_t rowPins[16];
+    uint8_t colPins[32];
+    for (uint8_t i = 0; i < sizeof(rowPins); i++)
+        rowPins[i] = i;
+    for (uint8_t i = 0; i < sizeof(colPins); i++)
+        colPins[i] = 16 + i;
+    uint8_t hidMap[512];
+    for (size_t i = 0; i < sizeof(hidMap); i++)
+        hidMap[i] = static_cast<uint8_t>(i % 251);
+
+    ConfigManager::registerConfig<KeyScannerConfig>();
+    ConfigManager sent;
+    sent.createConfig<KeyScannerConfig>();
+    KeyScannerConfig scannerCfg;
+    scannerCfg.setPins(rowPins, sizeof(rowPins), colPins, sizeof(colPins));
+    scannerCfg.setLocalToHidMap(hidMap, sizeof(hidMap));
+    sent.setConfig(scannerCfg);
+    protocol.sendConfig(TransportProtocol::MASTER_ID, &sent);
+
+    size_t size = sent.getSerializedSize();
+    size_t expectedPackets = (size + TransportProtocol::MAX_CONFIG_CHUNK - 1) / TransportProtocol::MAX_CONFIG_CHUNK;
+    TEST_ASSERT_TRUE(expectedPackets > 2);
+    TEST_ASSERT_EQUAL(expectedPackets, espNow.sentPackets.size());
+    for (const FakeEspNow::SentPacket &packet : espNow.sentPackets)
+        TEST_ASSERT_LESS_OR_EQUAL(250 - 8, packet.data.size());
+
+    // Nothing is unpacked before the last slice
+    FakeEspNow::SentPacket last = espNow.sentPackets.back();
+    espNow.sentPackets.pop_back();
+    espNow.loopbackSentPackets(SENDER_MAC);
+    TEST_ASSERT_NULL(receivedConfig);
+    espNow.simulateReceiveData(last.packetType, last.data.data(), last.data.size(), SENDER_MAC);
+    TEST_ASSERT_NOT_NULL(receivedConfig);
+
+    KeyScannerConfig *retrieved = receivedConfig->getConfig<KeyScannerConfig>();
+    TEST_ASSERT_NOT_NULL(retrieved);
+    TEST_ASSERT_EQUAL(16, retrieved->getRowsCount());
+    TEST_ASSERT_EQUAL(32, retrieved->getColCount());
+    TEST_ASSERT_EQUAL(512, retrieved->getLocalToHidMap().size());
+    TEST_ASSERT_EQUAL(hidMap[300], retrieved->getHIDCodeForIndex(300));
+    TEST_ASSERT_EQUAL(hidMap[511], retrieved->getHIDCodeForIndex(511));
+    delete receivedConfig;
+}
+
+void run_TransportProtocol_tests()
+{
+    RUN_TEST(test_TransportProtocol_smallBitmapSinglePacket);
+    RUN_TEST(test_TransportProtocol_largeBitmapIsChunked);
+    RUN_TEST(test_TransportProtocol_lostChunkDropsBitmap);
+    RUN_TEST(test_TransportProtocol_truncatedPacketIgnored);
+    RUN_TEST(test_TransportProtocol_keyEventKeepsTimestamps);
+    RUN_TEST(test_TransportProtocol_largeConfigIsChunked);
+}
+
+#endif
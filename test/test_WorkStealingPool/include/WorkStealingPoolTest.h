@@ -0,0 +1,349 @@
+#ifndef WORKSTEALINGPOOLTEST_H
+#define WORKSTEALINGPOOLTEST_H
+
+#include <submodules/EventChannel.h>
+#include <submodules/PayloadPool.h>
+#include <submodules/WorkStealingPool.h>
+#include <unity.h>
+#include <vector>
+
+#ifdef UNITY_NATIVE
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+static constexpr uint32_t CORE_0 = 1u << 0;
+static constexpr uint32_t CORE_1 = 1u << 1;
+
+static Event poolKey(uint32_t sequence)
+{
+    RawKeyEvent key{};
+    key.keyIndex = static_cast<uint16_t>(sequence % 64);
+    key.scanSequence = sequence;
+    return RawKeyChannel::wrap(key);
+}
+
+// Bitmap spilled to the RawBitmap pool, carries its sequence in the first
+// two bytes
+static Event poolBitmap(uint16_t sequence)
+{
+    uint8_t bitmap[48] = {static_cast<uint8_t>(sequence), static_cast<uint8_t>(sequence >> 8)};
+    RawBitmapEvent event{};
+    event.assign(EventType::RawBitmap, bitmap, sizeof(bitmap));
+    return RawBitmapChannel::wrap(event);
+}
+
+static uint32_t sequenceOf(const Event &event)
+{
+    if (event.type == EventType::RawKey)
+        return event.rawKeyEvt.scanSequence;
+    const uint8_t *data = event.rawBitmapEvt.data();
+    return data[0] | data[1] << 8;
+}
+
+static uint16_t poolBitmapsInUse()
+{
+    PayloadPool::Stats stats = PayloadPool::forType(EventType::RawBitmap).getStats();
+    return stats.inUse + stats.heapInUse;
+}
+
+// Submit like the bus task does: the pool shares the events, the bus
+// releases its own references after the handlers returned
+static bool submitAndRelease(WorkStealingPool &pool, WorkStealingPool::BatchCallback handler, uint32_t coreMask,
+                             Event *events, size_t count)
+{
+    bool taken = pool.submit(events[0].type, handler, coreMask, events, count);
+    for (size_t i = 0; i < count; i++)
+        events[i].cleanup(&events[i]);
+    return taken;
+}
+
+// Calls of the handlers in order, handler id and event sequence
+static std::vector<uint32_t> handlerLog;
+
+static void logFirst(const Event *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        handlerLog.push_back(1000 + sequenceOf(events[i]));
+}
+
+static void logSecond(const Event *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        handlerLog.push_back(2000 + sequenceOf(events[i]));
+}
+
+static uint32_t poolWakes[2];
+
+static void countPoolWake(void *arg)
+{
+    poolWakes[reinterpret_cast<uintptr_t>(arg)]++;
+}
+
+void test_WorkStealingPool_strandsKeepOrderAndTakeTurns()
+{
+    uint16_t inUse = poolBitmapsInUse();
+    {
+        WorkStealingPool pool;
+        TEST_ASSERT_EQUAL(0, pool.addWorker(0, nullptr, nullptr));
+        handlerLog.clear();
+
+        // One handler, two types: a strand each
+        Event keys[3] = {poolKey(0), poolKey(1), poolKey(2)};
+        Event bitmaps[2] = {poolBitmap(0), poolBitmap(1)};
+        TEST_ASSERT_TRUE(submitAndRelease(pool, logFirst, EventRegistry::ANY_CORE, keys, 3));
+        TEST_ASSERT_TRUE(submitAndRelease(pool, logFirst, EventRegistry::ANY_CORE, bitmaps, 2));
+        TEST_ASSERT_EQUAL_UINT16(inUse + 2, poolBitmapsInUse());
+
+        TEST_ASSERT_EQUAL(5, pool.work(0));
+        TEST_ASSERT_EQUAL(5, handlerLog.size());
+        for (uint32_t i = 0; i < 3; i++)
+            TEST_ASSERT_EQUAL_UINT32(1000 + i, handlerLog[i]);
+        TEST_ASSERT_EQUAL_UINT32(1001, handlerLog[4]);
+        TEST_ASSERT_EQUAL_UINT16(inUse, poolBitmapsInUse());
+
+        // A long strand gives the others a turn after MAX_STRAND_EVENTS
+        handlerLog.clear();
+        static constexpr uint32_t LONG = WorkStealingPool::MAX_STRAND_EVENTS + 8;
+        for (uint32_t i = 0; i < LONG; i += 8)
+        {
+            Event batch[8];
+            for (uint32_t j = 0; j < 8; j++)
+                batch[j] = poolKey(i + j);
+            submitAndRelease(pool, logFirst, EventRegistry::ANY_CORE, batch, 8);
+        }
+        Event other = poolKey(500);
+        submitAndRelease(pool, logSecond, EventRegistry::ANY_CORE, &other, 1);
+
+        TEST_ASSERT_EQUAL(LONG + 1, pool.work(0));
+        TEST_ASSERT_EQUAL_UINT32(1000 + WorkStealingPool::MAX_STRAND_EVENTS - 1,
+                                 handlerLog[WorkStealingPool::MAX_STRAND_EVENTS - 1]);
+        TEST_ASSERT_EQUAL_UINT32(2500, handlerLog[WorkStealingPool::MAX_STRAND_EVENTS]);
+        TEST_ASSERT_EQUAL_UINT32(1000 + LONG - 1, handlerLog[LONG]);
+        TEST_ASSERT_EQUAL_UINT32(LONG + 6, pool.getStats().executed);
+    }
+}
+
+void test_WorkStealingPool_coreMaskPicksWorkers()
+{
+    WorkStealingPool pool;
+    pool.addWorker(0, nullptr, nullptr);
+    pool.addWorker(1, nullptr, nullptr);
+    handlerLog.clear();
+
+    Event key = poolKey(1);
+    TEST_ASSERT_TRUE(submitAndRelease(pool, logFirst, CORE_1, &key, 1));
+    TEST_ASSERT_EQUAL(0, pool.work(0));
+    TEST_ASSERT_EQUAL(1, pool.work(1));
+
+    // No worker on core 2, the caller runs the handler itself
+    key = poolKey(2);
+    TEST_ASSERT_FALSE(submitAndRelease(pool, logSecond, 1u << 2, &key, 1));
+
+    // A full strand drops what does not fit
+    for (uint32_t i = 0; i < WorkStealingPool::STRAND_DEPTH + 3; i++)
+    {
+        key = poolKey(i);
+        submitAndRelease(pool, logSecond, CORE_0, &key, 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, pool.getStats().dropped);
+    TEST_ASSERT_EQUAL(WorkStealingPool::STRAND_DEPTH, pool.work(1) + pool.work(0));
+}
+
+void test_WorkStealingPool_idleWorkerStealsQueuedStrand()
+{
+    WorkStealingPool pool;
+    pool.addWorker(0, countPoolWake, reinterpret_cast<void *>(0));
+    pool.addWorker(0, countPoolWake, reinterpret_cast<void *>(1));
+    poolWakes[0] = poolWakes[1] = 0;
+    handlerLog.clear();
+
+    // Spread over both queues, each worker is woken for its own
+    Event first = poolKey(1);
+    Event second = poolKey(2);
+    submitAndRelease(pool, logFirst, CORE_0, &first, 1);
+    submitAndRelease(pool, logSecond, CORE_0, &second, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, poolWakes[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, poolWakes[1]);
+
+    // Worker 0 never gets to run, worker 1 takes its strand too
+    TEST_ASSERT_EQUAL(2, pool.work(1));
+    TEST_ASSERT_EQUAL_UINT32(2002, handlerLog[0]);
+    TEST_ASSERT_EQUAL_UINT32(1001, handlerLog[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.getStats().stolen);
+    TEST_ASSERT_EQUAL(0, pool.work(0));
+}
+
+#ifdef UNITY_NATIVE
+class PoolNotifier
+{
+public:
+    void give()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+        }
+        condition.notify_one();
+    }
+
+    void take()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return count > 0; });
+        count = 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t count = 0;
+};
+
+static thread_local int workerCore = -1;
+
+// Last sequence per type, only touched by the worker running the strand
+struct OrderCheck
+{
+    int64_t last[(size_t)EventType::COUNT];
+    std::atomic<uint32_t> received{0};
+    std::atomic<uint32_t> outOfOrder{0};
+    std::atomic<uint32_t> wrongCore{0};
+
+    void reset()
+    {
+        for (int64_t &sequence : last)
+            sequence = -1;
+        received = 0;
+        outOfOrder = 0;
+        wrongCore = 0;
+    }
+
+    void check(const Event *events, size_t count, uint32_t coreMask)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            int64_t &last = this->last[(size_t)events[i].type];
+            int64_t sequence = sequenceOf(events[i]);
+            if (sequence <= last)
+                outOfOrder++;
+            last = sequence;
+        }
+        if (((coreMask >> workerCore) & 1) == 0)
+            wrongCore++;
+        received += static_cast<uint32_t>(count);
+    }
+};
+
+static OrderCheck fastCheck;
+static OrderCheck slowCheck;
+
+static void fastHandler(const Event *events, size_t count)
+{
+    fastCheck.check(events, count, EventRegistry::ANY_CORE);
+}
+
+static void slowHandler(const Event *events, size_t count)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    slowCheck.check(events, count, CORE_0);
+}
+
+static void wakePoolNotifier(void *arg)
+{
+    static_cast<PoolNotifier *>(arg)->give();
+}
+#endif
+
+void test_WorkStealingPool_concurrentWorkersKeepOrderPerType()
+{
+#ifdef UNITY_NATIVE
+    static constexpr uint32_t EVENTS = 4000;
+    static constexpr size_t WORKERS = 3;
+    static constexpr uint8_t CORES[WORKERS] = {0, 1, 0};
+    uint16_t inUse = poolBitmapsInUse();
+    {
+        WorkStealingPool pool;
+        PoolNotifier notifiers[WORKERS];
+        for (size_t w = 0; w < WORKERS; w++)
+            pool.addWorker(CORES[w], wakePoolNotifier, &notifiers[w]);
+        fastCheck.reset();
+        slowCheck.reset();
+
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < WORKERS; w++)
+            workers.emplace_back([&, w]
+                                 {
+                                     workerCore = CORES[w];
+                                     for (;;)
+                                     {
+                                         notifiers[w].take();
+                                         if (stop.load())
+                                             break;
+                                         pool.work(w);
+                                     }
+                                 });
+
+        // Bus task: batches of one to four events of alternating types, each
+        // to both handlers
+        uint32_t sequence[2] = {0, 0};
+        uint32_t submitted = 0;
+        for (uint32_t batchIndex = 0; submitted < EVENTS; batchIndex++)
+        {
+            size_t typeIndex = batchIndex % 2;
+            size_t count = 1 + batchIndex % 4;
+            Event batch[4];
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t next = sequence[typeIndex]++;
+                batch[i] = typeIndex == 0 ? poolKey(next) : poolBitmap(static_cast<uint16_t>(next));
+                // The pool runs dry while the slow handler holds bitmaps, wait
+                // for the workers to return some
+                while (typeIndex == 1 && batch[i].rawBitmapEvt.bitmapSize == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    batch[i] = poolBitmap(static_cast<uint16_t>(next));
+                }
+            }
+            TEST_ASSERT_TRUE(pool.submit(batch[0].type, fastHandler, EventRegistry::ANY_CORE, batch, count));
+            TEST_ASSERT_TRUE(pool.submit(batch[0].type, slowHandler, CORE_0, batch, count));
+            for (size_t i = 0; i < count; i++)
+                batch[i].cleanup(&batch[i]);
+            submitted += static_cast<uint32_t>(count);
+            if (batchIndex % 8 == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        // Every event was handled or dropped by each handler
+        while (pool.getStats().executed + pool.getStats().dropped < 2 * submitted)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stop = true;
+        for (PoolNotifier &notifier : notifiers)
+            notifier.give();
+        for (std::thread &worker : workers)
+            worker.join();
+
+        WorkStealingPool::Stats stats = pool.getStats();
+        TEST_ASSERT_EQUAL_UINT32(stats.executed, fastCheck.received.load() + slowCheck.received.load());
+        TEST_ASSERT_EQUAL_UINT32(0, fastCheck.outOfOrder.load());
+        TEST_ASSERT_EQUAL_UINT32(0, slowCheck.outOfOrder.load());
+        TEST_ASSERT_EQUAL_UINT32(0, slowCheck.wrongCore.load());
+        TEST_ASSERT_TRUE(stats.stolen > 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(inUse, poolBitmapsInUse());
+#endif
+}
+
+void run_WorkStealingPool_tests()
+{
+    RUN_TEST(test_WorkStealingPool_strandsKeepOrderAndTakeTurns);
+    RUN_TEST(test_WorkStealingPool_coreMaskPicksWorkers);
+    RUN_TEST(test_WorkStealingPool_idleWorkerStealsQueuedStrand);
+    RUN_TEST(test_WorkStealingPool_concurrentWorkersKeepOrderPerType);
+}
+
+#endif